@@ -151,4 +151,24 @@
 
 #define NUM_I2S_CHANS (2)
 
+/* Number of cores sharing the ASRC of each direction. With 1 the phase
+ * computation is shared by all channels. With more the channels are split
+ * between the cores. See the asrc_mc benchmark for the cycles of each split. */
+#ifndef appconfI2S_TO_USB_ASRC_THREADS
+#define appconfI2S_TO_USB_ASRC_THREADS    2
+#endif
+
+#ifndef appconfUSB_TO_I2S_ASRC_THREADS
+#define appconfUSB_TO_I2S_ASRC_THREADS    2
+#endif
+
+/* Rate controller of the USB -> I2S direction, one of the rate_control_mode_t
+ * engines in shared/rate_control.h. RATE_CONTROL_P is the original
+ * proportional controller. RATE_CONTROL_PI removes its steady state buffer
+ * level offset, RATE_CONTROL_PID locks faster and RATE_CONTROL_PI_EST also
+ * filters the jitter of the measured rate ratio. */
+#ifndef appconfUSB_TO_I2S_RATE_CONTROL_MODE
+#define appconfUSB_TO_I2S_RATE_CONTROL_MODE    RATE_CONTROL_P
+#endif
+
 #endif /* APP_CONF_H_ */
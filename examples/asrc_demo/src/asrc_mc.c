@@ -0,0 +1,121 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+/* STD headers */
+#include <string.h>
+#include <stdint.h>
+#include <xcore/assert.h>
+
+/* App headers */
+#include "src.h"
+#include "asrc_mc.h"
+
+void asrc_mc_init(asrc_mc_t *mc,
+                  int32_t *storage,
+                  unsigned num_chans,
+                  unsigned num_groups,
+                  unsigned n_in_samples,
+                  unsigned max_out_samples)
+{
+    xassert((num_chans > 0) && (num_chans <= ASRC_MC_MAX_CHANS));
+    xassert((num_groups > 0) && (num_groups <= ASRC_MC_MAX_GROUPS) && (num_groups <= num_chans));
+    xassert(((uintptr_t)storage & 7) == 0);
+
+    memset(mc, 0, sizeof(asrc_mc_t));
+    mc->num_chans = num_chans;
+    mc->num_groups = num_groups;
+    mc->n_in_samples = n_in_samples;
+    mc->max_out_samples = max_out_samples;
+
+    int *next = (int *)storage;
+    unsigned first_chan = 0;
+    for(unsigned g=0; g<num_groups; g++)
+    {
+        asrc_mc_group_t *group = &mc->group[g];
+        group->first_chan = first_chan;
+        group->num_chans = num_chans / num_groups + ((g < num_chans % num_groups) ? 1 : 0);
+
+        for(unsigned ch=group->first_chan; ch<group->first_chan + group->num_chans; ch++)
+        {
+            //Set state, stack and coefs into ctrl structure. The channels of a group share the coefs.
+            mc->ctrl[ch].psState    = &mc->state[ch];
+            mc->ctrl[ch].piStack    = next;
+            mc->ctrl[ch].piADCoefs  = mc->adfir_coefs[g].iASRCADFIRCoefs;
+            next += ASRC_STACK_LENGTH_MULT * n_in_samples;
+        }
+        first_chan += group->num_chans;
+    }
+
+    if(num_groups > 1)
+    {
+        for(unsigned g=0; g<num_groups; g++)
+        {
+            mc->group[g].in = next;
+            next += mc->group[g].num_chans * n_in_samples;
+            mc->group[g].out = next;
+            next += mc->group[g].num_chans * max_out_samples;
+        }
+    }
+}
+
+uint64_t asrc_mc_set_rates(asrc_mc_t *mc, fs_code_t in_fs_code, fs_code_t out_fs_code, dither_flag_t dither)
+{
+    uint64_t nominal_fs_ratio = 0;
+
+    for(unsigned g=0; g<mc->num_groups; g++)
+    {
+        asrc_mc_group_t *group = &mc->group[g];
+        nominal_fs_ratio = asrc_init(in_fs_code, out_fs_code, &mc->ctrl[group->first_chan], group->num_chans, mc->n_in_samples, dither);
+    }
+    return nominal_fs_ratio;
+}
+
+unsigned asrc_mc_process_group(asrc_mc_t *mc,
+                               unsigned group_idx,
+                               const int32_t *in,
+                               int32_t *out,
+                               uint64_t fs_ratio)
+{
+    asrc_mc_group_t *group = &mc->group[group_idx];
+    const unsigned num_chans = mc->num_chans;
+    unsigned n_samps_out;
+
+    if(mc->num_groups == 1)
+    {
+        // The group is all the channels, so lib_src works on the interleaved blocks directly
+        return asrc_process((int *)in, (int *)out, fs_ratio, &mc->ctrl[0]);
+    }
+
+    // Gather the group's channels, interleaved
+    for(unsigned i=0; i<mc->n_in_samples; i++)
+    {
+        for(unsigned ch=0; ch<group->num_chans; ch++)
+        {
+            group->in[i * group->num_chans + ch] = in[i * num_chans + group->first_chan + ch];
+        }
+    }
+
+    n_samps_out = asrc_process(group->in, group->out, fs_ratio, &mc->ctrl[group->first_chan]);
+    xassert(n_samps_out <= mc->max_out_samples);
+
+    // Scatter them into the output block
+    for(unsigned i=0; i<n_samps_out; i++)
+    {
+        for(unsigned ch=0; ch<group->num_chans; ch++)
+        {
+            out[i * num_chans + group->first_chan + ch] = group->out[i * group->num_chans + ch];
+        }
+    }
+    return n_samps_out;
+}
+
+unsigned asrc_mc_process(asrc_mc_t *mc, const int32_t *in, int32_t *out, uint64_t fs_ratio)
+{
+    unsigned n_samps_out = asrc_mc_process_group(mc, 0, in, out, fs_ratio);
+
+    for(unsigned g=1; g<mc->num_groups; g++)
+    {
+        unsigned n_samps_out_group = asrc_mc_process_group(mc, g, in, out, fs_ratio);
+        xassert(n_samps_out_group == n_samps_out);
+    }
+    return n_samps_out;
+}
@@ -0,0 +1,106 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#ifndef ASRC_MC_H
+#define ASRC_MC_H
+
+#include <stdint.h>
+#include "src.h"
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+// Multi-channel ASRC engine.
+//
+// The channels are split into groups of consecutive channels. Each group is one lib_src ASRC instance, which
+// computes the fs ratio update and the adaptive filter phase once for all its channels and processes their
+// samples interleaved. The groups share no state, so each can run on its own core. With one group the
+// interleaved input and output blocks are passed to lib_src as they are. With more than one, each group
+// gathers its channels from the input block and scatters them into the output block.
+//
+// This file has no RTOS dependencies. asrc_mc_threads_process() in asrc_utils.c runs the groups on worker tasks.
+
+#define ASRC_MC_MAX_CHANS   (8)     /// Maximum number of channels
+#define ASRC_MC_MAX_GROUPS  (4)     /// Maximum number of groups, and so of cores sharing the work
+
+// ASRC_STACK_LENGTH_MULT is then the stack length multiplier of one channel, as each channel has its own stack
+#define ASRC_N_CHANNELS     (1)
+
+/// @brief Number of words of storage needed by asrc_mc_init(): an ASRC stack per channel, and with more than one
+/// group, each group's interleaved input and output blocks.
+#define ASRC_MC_STORAGE_WORDS(num_chans, num_groups, n_in_samples, max_out_samples) \
+    ((num_chans) * ASRC_STACK_LENGTH_MULT * (n_in_samples) + \
+     (((num_groups) > 1) ? (num_chans) * ((n_in_samples) + (max_out_samples)) : 0))
+
+typedef struct
+{
+    unsigned first_chan;    /// First channel of the group
+    unsigned num_chans;     /// Number of channels in the group
+    int *in;                /// Input block of the group's channels. Unused with one group
+    int *out;               /// Output block of the group's channels. Unused with one group
+}asrc_mc_group_t;
+
+typedef struct
+{
+    unsigned num_chans;         /// Channels in the interleaved blocks
+    unsigned num_groups;        /// Groups the channels are split into
+    unsigned n_in_samples;      /// Input samples per channel in each block
+    unsigned max_out_samples;   /// Maximum output samples per channel from each block
+
+    asrc_ctrl_t ctrl[ASRC_MC_MAX_CHANS];
+    asrc_state_t state[ASRC_MC_MAX_CHANS];
+    asrc_adfir_coefs_t adfir_coefs[ASRC_MC_MAX_GROUPS];     /// Shared by the channels of a group
+    asrc_mc_group_t group[ASRC_MC_MAX_GROUPS];
+}asrc_mc_t;
+
+/// @brief Set up an engine. asrc_mc_set_rates() must be called before the first block is processed.
+/// @param mc               The engine
+/// @param storage          ASRC_MC_STORAGE_WORDS(num_chans, num_groups, n_in_samples, max_out_samples) words,
+///                         8 byte aligned
+/// @param num_chans        Channels in the interleaved blocks, up to ASRC_MC_MAX_CHANS
+/// @param num_groups       Groups to split the channels into, up to ASRC_MC_MAX_GROUPS and at most num_chans.
+///                         The first num_chans % num_groups groups get one channel more than the others.
+/// @param n_in_samples     Input samples per channel in each block
+/// @param max_out_samples  Maximum output samples per channel from each block, for the highest output to input
+///                         rate ratio used
+void asrc_mc_init(asrc_mc_t *mc,
+                  int32_t *storage,
+                  unsigned num_chans,
+                  unsigned num_groups,
+                  unsigned n_in_samples,
+                  unsigned max_out_samples);
+
+/// @brief Initialise the ASRC instances of all groups for a pair of rates. This takes about 12500 cycles per group.
+/// @param mc           The engine
+/// @param in_fs_code   Input sample rate code
+/// @param out_fs_code  Output sample rate code
+/// @param dither       Dither setting
+/// @return The nominal fs ratio, to pass to the process functions until a measured ratio is available
+uint64_t asrc_mc_set_rates(asrc_mc_t *mc, fs_code_t in_fs_code, fs_code_t out_fs_code, dither_flag_t dither);
+
+/// @brief Process one block of one group. The groups of a block may run at the same time on different cores.
+/// @param mc           The engine
+/// @param group_idx    The group to process
+/// @param in           n_in_samples interleaved frames of num_chans channels
+/// @param out          Space for max_out_samples interleaved frames of num_chans channels. Only the group's
+///                     channels are written.
+/// @param fs_ratio     The fs ratio to use for this block
+/// @return The number of output samples per channel, which is the same for all groups of a block
+unsigned asrc_mc_process_group(asrc_mc_t *mc,
+                               unsigned group_idx,
+                               const int32_t *in,
+                               int32_t *out,
+                               uint64_t fs_ratio);
+
+/// @brief Process one block of all groups on the calling core.
+/// @param mc           The engine
+/// @param in           n_in_samples interleaved frames of num_chans channels
+/// @param out          Space for max_out_samples interleaved frames of num_chans channels
+/// @param fs_ratio     The fs ratio to use for this block
+/// @return The number of output samples per channel
+unsigned asrc_mc_process(asrc_mc_t *mc, const int32_t *in, int32_t *out, uint64_t fs_ratio);
+
+#ifdef __cplusplus
+ }
+#endif
+#endif
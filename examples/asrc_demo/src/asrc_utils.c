@@ -4,6 +4,7 @@
 #include <string.h>
 #include <stdint.h>
 #include <xcore/hwtimer.h>
+#include "rtos_printf.h"
 
 /* FreeRTOS headers */
 #include "FreeRTOS.h"
@@ -11,6 +12,7 @@
 #include "timers.h"
 #include "queue.h"
 #include "stream_buffer.h"
+#include "event_groups.h"
 
 /* App headers */
 #include "app_conf.h"
@@ -45,17 +47,78 @@ fs_code_t samp_rate_to_code(unsigned samp_rate){
 }
 
 
-void asrc_one_channel_task(void *args)
+/* Each thread has a bit in the barrier group. Thread 0 is the caller of asrc_mc_threads_process() */
+static void barrier_wait(asrc_mc_threads_t *ctx, unsigned thread)
 {
-    asrc_init_t *asrc_init_ctx = args;
+    xEventGroupSync(ctx->barrier_group, (EventBits_t)1 << thread, ctx->barrier_all_bits, portMAX_DELAY);
+}
+
+static void asrc_mc_worker_task(void *args)
+{
+    asrc_mc_worker_t *worker = args;
+    asrc_mc_threads_t *ctx = worker->ctx;
 
     for(;;)
     {
-        asrc_process_frame_ctx_t *asrc_ctx = NULL;
-        (void) rtos_osal_queue_receive(&asrc_init_ctx->asrc_queue, &asrc_ctx, RTOS_OSAL_WAIT_FOREVER);
+        /* Wait for the next block */
+        barrier_wait(ctx, worker->thread);
+
+        ctx->n_samps_out[worker->thread] = asrc_mc_process_group(ctx->mc, worker->thread, ctx->in, ctx->out, ctx->fs_ratio);
+
+        barrier_wait(ctx, worker->thread);
+    }
+}
+
+void asrc_mc_threads_init(asrc_mc_threads_t *ctx, asrc_mc_t *mc, const char *name, unsigned priority)
+{
+    memset(ctx, 0, sizeof(asrc_mc_threads_t));
+    ctx->mc = mc;
+    if(mc->num_groups == 1)
+    {
+        return;
+    }
+
+    ctx->barrier_group = xEventGroupCreate();
+    configASSERT(ctx->barrier_group != NULL);
+    ctx->barrier_all_bits = ((EventBits_t)1 << mc->num_groups) - 1;
+
+    for(unsigned thread = 1; thread < mc->num_groups; thread++)
+    {
+        ctx->worker[thread].ctx = ctx;
+        ctx->worker[thread].thread = thread;
+        (void) rtos_osal_thread_create(
+            NULL,
+            (char *) name,
+            (rtos_osal_entry_function_t) asrc_mc_worker_task,
+            (void *) &ctx->worker[thread],
+            (size_t) RTOS_THREAD_STACK_SIZE(asrc_mc_worker_task),
+            (unsigned int) priority);
+    }
+}
 
-        unsigned n_samps_out = asrc_process((int *)asrc_ctx->input_samples, (int *)asrc_ctx->output_samples, asrc_ctx->fs_ratio, asrc_init_ctx->asrc_ctrl_ptr);
+unsigned asrc_mc_threads_process(asrc_mc_threads_t *ctx, const int32_t *in, int32_t *out, uint64_t fs_ratio)
+{
+    if(ctx->mc->num_groups == 1)
+    {
+        return asrc_mc_process_group(ctx->mc, 0, in, out, fs_ratio);
+    }
+
+    ctx->in = in;
+    ctx->out = out;
+    ctx->fs_ratio = fs_ratio;
 
-        (void) rtos_osal_queue_send(&asrc_init_ctx->asrc_ret_queue, &n_samps_out, RTOS_OSAL_WAIT_FOREVER);
+    /* Release the workers, which are waiting for the next block */
+    barrier_wait(ctx, 0);
+    ctx->n_samps_out[0] = asrc_mc_process_group(ctx->mc, 0, in, out, fs_ratio);
+    barrier_wait(ctx, 0);
+
+    for(int g=1; g<ctx->mc->num_groups; g++)
+    {
+        if(ctx->n_samps_out[g] != ctx->n_samps_out[0])
+        {
+            rtos_printf("Error: ASRC groups returned different number of samples: group 0 %u, group %d %u\n", ctx->n_samps_out[0], g, ctx->n_samps_out[g]);
+            xassert(0);
+        }
     }
+    return ctx->n_samps_out[0];
 }
@@ -7,34 +7,61 @@
 /* FreeRTOS headers */
 #include "FreeRTOS.h"
 #include "queue.h"
+#include "event_groups.h"
 #include "src.h"
+#include "asrc_mc.h"
 
-typedef struct
-{
-    /* data */
-    int32_t *input_samples;
-    int32_t *output_samples;
-    uint64_t fs_ratio;
-    unsigned i2s_sampling_rate;
-}asrc_process_frame_ctx_t;
-
+typedef struct asrc_mc_threads asrc_mc_threads_t;
 
 typedef struct {
-    uint32_t fs_in;
-    uint32_t fs_out;
-    uint32_t n_in_samples;
-    asrc_ctrl_t *asrc_ctrl_ptr;
-    rtos_osal_queue_t asrc_queue;
-    rtos_osal_queue_t asrc_ret_queue;
-}asrc_init_t;
+    asrc_mc_threads_t *ctx;
+    unsigned thread;
+}asrc_mc_worker_t;
+
+struct asrc_mc_threads {
+    asrc_mc_t *mc;
+    const int32_t *in;
+    int32_t *out;
+    uint64_t fs_ratio;
+    unsigned n_samps_out[ASRC_MC_MAX_GROUPS];
+    asrc_mc_worker_t worker[ASRC_MC_MAX_GROUPS];
+    EventGroupHandle_t barrier_group;
+    EventBits_t barrier_all_bits;
+};
 
 #define USB_TO_I2S_ASRC_BLOCK_LENGTH (96)
 #define I2S_TO_USB_ASRC_BLOCK_LENGTH (244)  // Found out from simulation. Relatively jitter free average buffer levels seen with 244 samples block than 240 samples block size
-#define ASRC_N_CHANNELS              (1)
-#define ASRC_CHANNELS_PER_INSTANCE   (1)
 #define ASRC_DITHER_SETTING          OFF
 
+// Output samples per channel from a block at the highest output to input rate ratio, with some margin
+#define USB_TO_I2S_ASRC_MAX_OUT_SAMPLES (USB_TO_I2S_ASRC_BLOCK_LENGTH * 5)  // 48kHz to 192kHz
+#define I2S_TO_USB_ASRC_MAX_OUT_SAMPLES (I2S_TO_USB_ASRC_BLOCK_LENGTH * 2)  // 44.1kHz to 48kHz
+
 fs_code_t samp_rate_to_code(unsigned samp_rate);
-void asrc_one_channel_task(void *args);
+
+/**
+ * Create a worker task for each group of an engine but the first, which runs
+ * on the caller of asrc_mc_threads_process().
+ *
+ * \param ctx       Context shared by the caller and the workers.
+ * \param mc        The engine, already set up with asrc_mc_init().
+ * \param name      Name of the worker tasks.
+ * \param priority  Priority of the worker tasks. This should be the same as
+ *                  the task calling asrc_mc_threads_process().
+ */
+void asrc_mc_threads_init(asrc_mc_threads_t *ctx, asrc_mc_t *mc, const char *name, unsigned priority);
+
+/**
+ * Process one block of all groups of the engine, each on its own task. The
+ * caller and the workers meet at a barrier at the start and the end of the
+ * block, so no messages are passed per block.
+ *
+ * \param ctx       The context passed to asrc_mc_threads_init().
+ * \param in        Interleaved input block.
+ * \param out       Interleaved output block.
+ * \param fs_ratio  The fs ratio to use for this block.
+ * \return          The number of output samples per channel.
+ */
+unsigned asrc_mc_threads_process(asrc_mc_threads_t *ctx, const int32_t *in, int32_t *out, uint64_t fs_ratio);
 
 #endif
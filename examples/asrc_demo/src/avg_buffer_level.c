@@ -36,6 +36,7 @@ void calc_avg_buffer_level(buffer_calc_state_t *state, int current_level, bool r
     {
         int32_t prev_avg_buffer_level = state->avg_buffer_level;
         state->avg_buffer_level = state->error_accum >> state->window_len_log2;
+        state->avg_count += 1;
         if(state->flag_first_done == true) // So we know that prev_avg_buffer_level is valid
         {
             state->avg_buffer_level = (state->avg_buffer_level + prev_avg_buffer_level)/2;
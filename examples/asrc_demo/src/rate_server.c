@@ -26,6 +26,7 @@
 #include "i2s_audio.h"
 #include "rate_server.h"
 #include "avg_buffer_level.h"
+#include "rate_control.h"
 #include "tusb.h"
 #include "div.h"
 
@@ -39,6 +40,7 @@ static bool g_spkr_itf_close_to_open = false; // Flag tracking if a USB spkr int
                                        // USB. Cleared in usb_to_i2s_intertile, after it resets the i2s send buffer
 
 static buffer_calc_state_t g_i2s_send_buf_state;
+static rate_control_t g_usb_to_i2s_rate_control;
 
 bool get_spkr_itf_close_open_event()
 {
@@ -215,6 +217,10 @@ void rate_server(void *args)
     usb_rate_info_t usb_rate_info;
     i2s_to_usb_rate_info_t i2s_rate_info;
 
+    // The gains are set when the I2S rate is first known
+    const rate_control_gains_t no_gains = {0};
+    rate_control_init(&g_usb_to_i2s_rate_control, appconfUSB_TO_I2S_RATE_CONTROL_MODE, 0, &no_gains);
+
     for(;;)
     {
         // Get usb_rate_info from the other tile
@@ -236,6 +242,8 @@ void rate_server(void *args)
         if((prev_spkr_itf_open == false) && (usb_rate_info.spkr_itf_open == true))
         {
             set_spkr_itf_close_open_event(true);
+            // The I2S send buffer is refilled to a new stable level, which the old integral and estimate don't apply to
+            rate_control_reset(&g_usb_to_i2s_rate_control);
         }
         prev_spkr_itf_open = usb_rate_info.spkr_itf_open;
 
@@ -266,32 +274,29 @@ void rate_server(void *args)
         // Calculate usb_to_i2s_rate_ratio only when the host is playing data to the device
         if((i2s_rate.mant != 0) && (usb_rate.mant != 0) && (usb_rate_info.spkr_itf_open))
         {
-            const sw_pll_q24_t Kp = get_Kp_for_i2s_buffer_control(rtos_i2s_get_nominal_sampling_rate(i2s_ctx));
-            int64_t max_allowed_correction = (int64_t)1500 << 32;
-            int64_t total_error = 0;
+            const uint32_t nominal_i2s_rate = rtos_i2s_get_nominal_sampling_rate(i2s_ctx);
+            if(nominal_i2s_rate != g_usb_to_i2s_rate_control.nominal_rate)
+            {
+                rate_control_gains_t gains;
+                rate_control_gains_from_kp(get_Kp_for_i2s_buffer_control(nominal_i2s_rate), g_usb_to_i2s_rate_control.mode, &gains);
+                rate_control_set_rate(&g_usb_to_i2s_rate_control, nominal_i2s_rate, &gains);
+            }
 
             uint64_t fs_ratio64 = float_div_u64_fixed_output_q_format(usb_rate, i2s_rate, 28+32);
 
+            usb_to_i2s_rate_ratio = rate_control_update(&g_usb_to_i2s_rate_control,
+                                                        fs_ratio64,
+                                                        g_i2s_send_buf_state.flag_stable_avg,
+                                                        g_i2s_send_buf_state.avg_buffer_level - g_i2s_send_buf_state.stable_avg_level,
+                                                        g_i2s_send_buf_state.avg_count);
+#if LOG_USB_TO_I2S_SIDE
             if(g_i2s_send_buf_state.flag_stable_avg)
             {
-                int64_t error_p = ((int64_t)Kp * (int64_t)(g_i2s_send_buf_state.avg_buffer_level - g_i2s_send_buf_state.stable_avg_level));
-                total_error = (int64_t)(error_p << 8);
-                if(total_error > max_allowed_correction)
-                {
-                    total_error = max_allowed_correction;
-                }
-                else if(total_error < -(max_allowed_correction))
-                {
-                    total_error = -(max_allowed_correction);
-                }
-#if LOG_USB_TO_I2S_SIDE
-            printint(g_i2s_send_buf_state.avg_buffer_level);
-            printchar(',');
-            printintln((int32_t)(total_error >> 32)); // Print the upper 32 bits of the correction
-#endif
+                printint(g_i2s_send_buf_state.avg_buffer_level);
+                printchar(',');
+                printintln((int32_t)(g_usb_to_i2s_rate_control.correction >> 32)); // Print the upper 32 bits of the correction
             }
-            usb_to_i2s_rate_ratio = fs_ratio64 + total_error;
-
+#endif
         }
         else
         {
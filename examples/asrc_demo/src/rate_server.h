@@ -3,6 +3,7 @@
 #ifndef RATE_SERVER_H
 #define RATE_SERVER_H
 #include "xmath/xmath.h"
+#include "rate_control.h"
 
 void rate_server(void *args);
 
@@ -37,10 +38,6 @@ typedef struct
     uint64_t usb_to_i2s_rate_ratio;
 }i2s_to_usb_rate_info_t;
 
-typedef int32_t sw_pll_q24_t; // Type for 15.16 signed fixed point
-#define SW_PLL_NUM_FRAC_BITS 24
-#define SW_PLL_Q24(val) ((sw_pll_q24_t)((double)val * (1 << SW_PLL_NUM_FRAC_BITS)))
-
 // Kp constants for I2S buffer based control for the USB -> ASRC -> (buffer) -> I2S direction.
 #define KP_I2S_BUF_CONTROL_FS48     (SW_PLL_Q24(11.542724608))      // 0.000000043 * (2**28)
 #define KP_I2S_BUF_CONTROL_FS96     (SW_PLL_Q24(5.905580032))       // 0.000000022 * (2**28)
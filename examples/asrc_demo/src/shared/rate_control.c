@@ -0,0 +1,201 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#include <string.h>
+#include "rate_control.h"
+
+static inline int64_t clamp(int64_t val, int64_t limit)
+{
+    if(val > limit)
+    {
+        return limit;
+    }
+    else if(val < -limit)
+    {
+        return -limit;
+    }
+    return val;
+}
+
+static inline int64_t calc_p_term(const rate_control_t *rc, int32_t level_error)
+{
+    return clamp((int64_t)(((int64_t)rc->gains.Kp * (int64_t)level_error) << 8), RATE_CONTROL_MAX_CORRECTION);
+}
+
+static void update_estimate(rate_control_t *rc, uint64_t measured_ratio)
+{
+    if(rc->flag_est_valid == false)
+    {
+        rc->est_ratio = (int64_t)measured_ratio;
+        rc->est_drift = 0;
+        rc->flag_est_valid = true;
+        return;
+    }
+
+    int64_t predicted = rc->est_ratio + rc->est_drift;
+    int64_t residual = (int64_t)measured_ratio - predicted;
+
+    // Clamping the residual rejects outliers and keeps the products below within 64 bits
+    if(residual > RATE_CONTROL_EST_MAX_RESIDUAL)
+    {
+        residual = RATE_CONTROL_EST_MAX_RESIDUAL;
+    }
+    else if(residual < -RATE_CONTROL_EST_MAX_RESIDUAL)
+    {
+        residual = -RATE_CONTROL_EST_MAX_RESIDUAL;
+    }
+
+    rc->est_ratio = predicted + (((residual >> 8) * rc->gains.est_alpha) >> 8);
+    rc->est_drift += ((residual >> 8) * rc->gains.est_beta) >> 8;
+}
+
+void rate_control_gains_from_kp(sw_pll_q24_t Kp, rate_control_mode_t mode, rate_control_gains_t *gains)
+{
+    memset(gains, 0, sizeof(rate_control_gains_t));
+    if(mode == RATE_CONTROL_P)
+    {
+        gains->Kp = Kp;
+        return;
+    }
+
+    gains->Kp = Kp * RATE_CONTROL_PI_KP_MULT;
+    gains->Ki = Kp / RATE_CONTROL_PI_KI_DIV;
+    if(mode == RATE_CONTROL_PID)
+    {
+        gains->Ki = Kp / RATE_CONTROL_PID_KI_DIV;
+        gains->Kd = Kp * RATE_CONTROL_PID_KD_MULT;
+    }
+    // The estimate is kept up to date in all engines
+    gains->est_alpha = RATE_CONTROL_EST_ALPHA;
+    gains->est_beta = RATE_CONTROL_EST_BETA;
+}
+
+void rate_control_init(rate_control_t *rc, rate_control_mode_t mode, uint32_t nominal_rate, const rate_control_gains_t *gains)
+{
+    memset(rc, 0, sizeof(rate_control_t));
+    rc->mode = mode;
+    rc->nominal_rate = nominal_rate;
+    rc->gains = *gains;
+}
+
+void rate_control_reset(rate_control_t *rc)
+{
+    rc->integral = 0;
+    rc->p_term = 0;
+    rc->d_term = 0;
+    rc->correction = 0;
+    rc->flag_prev_error_valid = false;
+    rc->flag_est_valid = false;
+}
+
+// Preset the integral so that, with the current gains and the last level error, the correction carries on from its
+// last value
+static void preset_integral(rate_control_t *rc)
+{
+    rc->p_term = rc->flag_level_valid ? calc_p_term(rc, rc->level_error) : 0;
+    rc->d_term = 0;
+    rc->integral = clamp(rc->correction - rc->p_term, RATE_CONTROL_MAX_INTEGRAL);
+}
+
+void rate_control_set_mode(rate_control_t *rc, rate_control_mode_t mode)
+{
+    if(mode == rc->mode)
+    {
+        return;
+    }
+    rc->mode = mode;
+
+    if(mode == RATE_CONTROL_P)
+    {
+        // There is no integral to carry the correction on with
+        rc->integral = 0;
+        rc->d_term = 0;
+    }
+    else
+    {
+        // The feedforward ratio may change from the measured ratio to the estimate. That is not carried over,
+        // as it would hold the jitter of the last measurement in the integral.
+        preset_integral(rc);
+    }
+}
+
+void rate_control_set_rate(rate_control_t *rc, uint32_t nominal_rate, const rate_control_gains_t *gains)
+{
+    rc->gains = *gains;
+    if(nominal_rate == rc->nominal_rate)
+    {
+        // New gains for the same rate. Don't let them step the correction.
+        if(rc->mode != RATE_CONTROL_P)
+        {
+            preset_integral(rc);
+        }
+        return;
+    }
+
+    // The nominal ratio scales with 1 / nominal_rate. Scale the integral with it to keep the same relative
+    // correction. |integral| <= 3000 << 32 (RATE_CONTROL_MAX_INTEGRAL) so the product fits in 64 bits.
+    if((rc->nominal_rate != 0) && (nominal_rate != 0))
+    {
+        rc->integral = (rc->integral * (int64_t)rc->nominal_rate) / (int64_t)nominal_rate;
+    }
+    rc->nominal_rate = nominal_rate;
+    rc->flag_prev_error_valid = false;
+    rc->flag_est_valid = false;
+}
+
+uint64_t rate_control_update(rate_control_t *rc, uint64_t measured_ratio, bool level_valid, int32_t level_error, uint32_t avg_count)
+{
+    // The estimate is always updated, so that switching to RATE_CONTROL_PI_EST is bumpless
+    update_estimate(rc, measured_ratio);
+
+    bool new_avg = (avg_count != rc->prev_avg_count);
+    rc->prev_avg_count = avg_count;
+
+    rc->level_error = level_error;
+    rc->flag_level_valid = level_valid;
+
+    if(level_valid == false)
+    {
+        // Without a stable level there's no error to correct. The integral is held, as it still carries the
+        // measurement error of the ratio.
+        rc->p_term = 0;
+        rc->d_term = 0;
+        rc->flag_prev_error_valid = false;
+    }
+    else
+    {
+        rc->p_term = calc_p_term(rc, level_error);
+
+        if(new_avg && (rc->mode != RATE_CONTROL_P))
+        {
+            int64_t step = (int64_t)(((int64_t)rc->gains.Ki * (int64_t)level_error) << 8);
+
+            // Conditional integration: don't wind the integral further while the correction is saturated
+            if(!((rc->correction >= RATE_CONTROL_MAX_CORRECTION) && (step > 0)) &&
+               !((rc->correction <= -RATE_CONTROL_MAX_CORRECTION) && (step < 0)))
+            {
+                rc->integral = clamp(rc->integral + step, RATE_CONTROL_MAX_INTEGRAL);
+            }
+
+            if(rc->flag_prev_error_valid)
+            {
+                rc->d_term = (int64_t)(((int64_t)rc->gains.Kd * (int64_t)(level_error - rc->prev_level_error)) << 8);
+            }
+            rc->prev_level_error = level_error;
+            rc->flag_prev_error_valid = true;
+        }
+    }
+
+    int64_t correction = rc->p_term;
+    if(rc->mode != RATE_CONTROL_P)
+    {
+        correction += rc->integral;
+    }
+    if(rc->mode == RATE_CONTROL_PID)
+    {
+        correction += rc->d_term;
+    }
+    rc->correction = clamp(correction, RATE_CONTROL_MAX_CORRECTION);
+
+    int64_t feedforward = (rc->mode == RATE_CONTROL_PI_EST) ? rc->est_ratio : (int64_t)measured_ratio;
+    return (uint64_t)(feedforward + rc->correction);
+}
@@ -0,0 +1,140 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#ifndef RATE_CONTROL_H
+#define RATE_CONTROL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+// This file contains the rate ratio controller shared between the ASRC example application and the ASRC simulator code.
+//
+// The controller computes the ASRC rate ratio, in Q4.60, from a measured rate ratio and the windowed average buffer
+// level calculated by avg_buffer_level.c. The measured ratio is the feedforward term. A correction computed from the
+// error between the average and the stable buffer level is added to it. The engines are:
+//
+//  RATE_CONTROL_P      Proportional correction only. This is the original controller. The measurement error of the
+//                      ratio shows as a steady state buffer level offset of error / Kp.
+//  RATE_CONTROL_PI     Adds an integral term that removes the steady state offset.
+//  RATE_CONTROL_PID    Adds a derivative term, on the change of the average level, that damps the PI loop.
+//  RATE_CONTROL_PI_EST PI, with the measured ratio replaced by an alpha-beta (steady state Kalman) estimate of the
+//                      true ratio and its drift. This filters the jitter of the measured ratio.
+//
+// Gains are in the same units as the Kp constants in rate_server.h: a correction of (K * e) << 8 in Q4.60 for a
+// level error e. The integral and derivative terms are updated once per new windowed average, so Ki and Kd are per
+// averaging window. The estimator is updated on every call.
+//
+// The integral is not integrated further while the correction saturates (anti-windup), and is clamped to a limit
+// that lets it offset a P term at the correction limit. Switching engine and changing the nominal rate are bumpless: the integral is preset so that the
+// correction does not step, and is scaled to the new nominal ratio.
+
+typedef int32_t sw_pll_q24_t; // Type for 8.24 signed fixed point
+#define SW_PLL_NUM_FRAC_BITS 24
+#define SW_PLL_Q24(val) ((sw_pll_q24_t)((double)val * (1 << SW_PLL_NUM_FRAC_BITS)))
+
+#define RATE_CONTROL_Q16(val) ((int32_t)((double)val * (1 << 16)))
+
+#define RATE_CONTROL_MAX_CORRECTION     ((int64_t)1500 << 32)   /// Limit on the correction, in Q4.60
+#define RATE_CONTROL_MAX_INTEGRAL       ((int64_t)3000 << 32)   /// Limit on the integral, so that it can offset a P term at the limit
+#define RATE_CONTROL_EST_MAX_RESIDUAL   ((int64_t)1 << 50)      /// Limit on an estimator residual, about 1000 ppm in Q4.60
+
+// Gains of the PI, PID and PI_EST engines, relative to the Kp of the P engine. They were chosen with the model in
+// test/asrc_unit_tests/src/test_rate_control.c. A Kp multiplier of 16 is unstable at 48kHz because of the delay of
+// the windowed average.
+#define RATE_CONTROL_PI_KP_MULT     (8)
+#define RATE_CONTROL_PI_KI_DIV      (10)
+#define RATE_CONTROL_PID_KI_DIV     (5)
+#define RATE_CONTROL_PID_KD_MULT    (8)
+#define RATE_CONTROL_EST_ALPHA      RATE_CONTROL_Q16(1.0 / 128)
+#define RATE_CONTROL_EST_BETA       RATE_CONTROL_Q16((1.0 / 128) * (1.0 / 128) / (2 - 1.0 / 128))   // alpha^2 / (2 - alpha)
+
+typedef enum
+{
+    RATE_CONTROL_P = 0,
+    RATE_CONTROL_PI,
+    RATE_CONTROL_PID,
+    RATE_CONTROL_PI_EST,
+}rate_control_mode_t;
+
+typedef struct
+{
+    sw_pll_q24_t Kp;        /// Proportional gain
+    sw_pll_q24_t Ki;        /// Integral gain, per averaging window
+    sw_pll_q24_t Kd;        /// Derivative gain, per averaging window
+    int32_t est_alpha;      /// Estimator ratio gain in Q16, between 0 and 1
+    int32_t est_beta;       /// Estimator drift gain in Q16, between 0 and 1
+}rate_control_gains_t;
+
+/// @brief Structure containing the persistent variables that make up the rate controller state
+typedef struct
+{
+    rate_control_mode_t mode;
+    rate_control_gains_t gains;
+    uint32_t nominal_rate;      /// Nominal output rate the gains are for. The integral is scaled on a change
+
+    int64_t integral;           /// Integral term in Q4.60
+    int64_t p_term;             /// Proportional term of the last correction
+    int64_t d_term;             /// Derivative term of the last correction
+    int64_t correction;         /// Last correction in Q4.60
+
+    int32_t level_error;        /// Level error of the last update
+    bool flag_level_valid;      /// Flag indicating whether level_error is valid
+    int32_t prev_level_error;   /// Level error of the previous window, for the derivative
+    uint32_t prev_avg_count;    /// Window count of the last average used
+    bool flag_prev_error_valid; /// Flag indicating whether prev_level_error is valid
+
+    int64_t est_ratio;          /// Estimated ratio in Q4.60
+    int64_t est_drift;          /// Estimated change of the ratio per call in Q4.60
+    bool flag_est_valid;        /// Flag indicating whether the estimate has been seeded with a measurement
+}rate_control_t;
+
+/// @brief Get the gains of an engine from the Kp of the P engine
+/// @param Kp       Kp of the P engine
+/// @param mode     Controller engine
+/// @param gains    Gains of the engine
+void rate_control_gains_from_kp(sw_pll_q24_t Kp, rate_control_mode_t mode, rate_control_gains_t *gains);
+
+/// @brief Initialise a rate controller
+/// @param rc           Pointer to the rate_control_t state structure
+/// @param mode         Controller engine
+/// @param nominal_rate Nominal output rate
+/// @param gains        Gains for the nominal rate
+void rate_control_init(rate_control_t *rc, rate_control_mode_t mode, uint32_t nominal_rate, const rate_control_gains_t *gains);
+
+/// @brief Switch the controller engine. The integral is preset so that the correction carries on from its last value.
+/// RATE_CONTROL_P has no integral, so switching to it drops the integral part of the correction.
+/// The example application fixes the engine with appconfUSB_TO_I2S_RATE_CONTROL_MODE and doesn't call this; it is
+/// used by the engine switching tests in test/asrc_unit_tests.
+/// @param rc   Pointer to the rate_control_t state structure
+/// @param mode New controller engine
+void rate_control_set_mode(rate_control_t *rc, rate_control_mode_t mode);
+
+/// @brief Change the nominal output rate and the gains. The integral is scaled by the ratio of the old to the new
+/// rate, so that it keeps the same relative correction, and the estimator restarts. If the rate is unchanged, the
+/// integral is preset so that the new gains don't step the rate ratio.
+/// @param rc           Pointer to the rate_control_t state structure
+/// @param nominal_rate New nominal output rate
+/// @param gains        Gains for the new nominal rate
+void rate_control_set_rate(rate_control_t *rc, uint32_t nominal_rate, const rate_control_gains_t *gains);
+
+/// @brief Clear the integral, the derivative and the estimator state. Called by the rate server when the USB speaker
+/// interface is reopened.
+/// @param rc   Pointer to the rate_control_t state structure
+void rate_control_reset(rate_control_t *rc);
+
+/// @brief Compute the rate ratio to apply.
+/// @param rc               Pointer to the rate_control_t state structure
+/// @param measured_ratio   Measured rate ratio in Q4.60
+/// @param level_valid      Flag indicating that the stable average buffer level is known
+/// @param level_error      Average buffer level minus the stable average buffer level
+/// @param avg_count        Number of windowed averages calculated so far. A change marks a new average.
+/// @return The rate ratio in Q4.60
+uint64_t rate_control_update(rate_control_t *rc, uint64_t measured_ratio, bool level_valid, int32_t level_error, uint32_t avg_count);
+
+#ifdef __cplusplus
+ }
+#endif
+#endif
@@ -48,6 +48,7 @@
 #include "usb_audio.h"
 #include "asrc_utils.h"
 #include "rate_server.h"
+#include "profile.h"
 #include "dbcalc.h"
 #include "avg_buffer_level.h"
 #include "adaptive_rate_callback.h"
@@ -75,6 +76,9 @@ static StreamBufferHandle_t rx_buffer;
 static TaskHandle_t usb_audio_out_asrc_handle;
 
 static uint64_t g_usb_to_i2s_rate_ratio = 0;
+
+/* Both channels of the USB to I2S ASRC, including the deinterleaving and volume */
+PROFILE_PROBE_DEFINE(usb_to_i2s_asrc_probe, "asrc_usb_to_i2s");
 static uint32_t samples_to_host_stream_buf_size_bytes = 0;
 static bool g_i2s_sr_change_detected = false;
 static bool samples_to_host_buf_ready_to_read = false;
@@ -495,59 +499,23 @@ void usb_audio_out_asrc(void *arg)
 
     rtos_intertile_t *intertile_ctx = (rtos_intertile_t *)arg;
 
-    // Initialise channel 0 ASRC instance
-    asrc_state_t asrc_state[CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_RX][ASRC_CHANNELS_PER_INSTANCE];                                               // ASRC state machine state
-    int asrc_stack[CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_RX][ASRC_CHANNELS_PER_INSTANCE][ASRC_STACK_LENGTH_MULT * USB_TO_I2S_ASRC_BLOCK_LENGTH]; // Buffer between filter stages
-    asrc_ctrl_t asrc_ctrl[CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_RX][ASRC_CHANNELS_PER_INSTANCE];                                                 // Control structure
-    asrc_adfir_coefs_t asrc_adfir_coefs[CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_RX];
+    // All channels go through one engine, with the groups split between appconfUSB_TO_I2S_ASRC_THREADS cores
+    static asrc_mc_t asrc_mc;
+    static int32_t __attribute__((aligned(8))) asrc_storage[ASRC_MC_STORAGE_WORDS(CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_RX, appconfUSB_TO_I2S_ASRC_THREADS, USB_TO_I2S_ASRC_BLOCK_LENGTH, USB_TO_I2S_ASRC_MAX_OUT_SAMPLES)];
+    static asrc_mc_threads_t asrc_threads;
 
-    for (int ch = 0; ch < CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_RX; ch++)
-    {
-        for (int ui = 0; ui < ASRC_CHANNELS_PER_INSTANCE; ui++)
-        {
-            // Set state, stack and coefs into ctrl structure
-            asrc_ctrl[ch][ui].psState = &asrc_state[ch][ui];
-            asrc_ctrl[ch][ui].piStack = asrc_stack[ch][ui];
-            asrc_ctrl[ch][ui].piADCoefs = asrc_adfir_coefs[ch].iASRCADFIRCoefs;
-        }
-    }
+    asrc_mc_init(&asrc_mc, asrc_storage, CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_RX, appconfUSB_TO_I2S_ASRC_THREADS, USB_TO_I2S_ASRC_BLOCK_LENGTH, USB_TO_I2S_ASRC_MAX_OUT_SAMPLES);
+    asrc_mc_threads_init(&asrc_threads, &asrc_mc, "ASRC_usb_i2s", appconfAUDIO_PIPELINE_TASK_PRIORITY);
 
-    // Initialise ASRC
-    //  Create init ctx for the ch1 asrc running in another thread
-    asrc_init_t asrc_init_ctx;
-    asrc_init_ctx.fs_in = appconfUSB_AUDIO_SAMPLE_RATE;
-    asrc_init_ctx.fs_out = 0; // Will be notified at runtime
-    asrc_init_ctx.n_in_samples = USB_TO_I2S_ASRC_BLOCK_LENGTH;
-    asrc_init_ctx.asrc_ctrl_ptr = &asrc_ctrl[1][0];
-    (void)rtos_osal_queue_create(&asrc_init_ctx.asrc_queue, "asrc_q", 1, sizeof(asrc_process_frame_ctx_t *));
-    (void)rtos_osal_queue_create(&asrc_init_ctx.asrc_ret_queue, "asrc_ret_q", 1, sizeof(int));
-
-    rtos_osal_thread_t asrc_ch1_thread;
-
-    // Create 2nd channel ASRC task
-    (void)rtos_osal_thread_create(
-        (rtos_osal_thread_t *)&asrc_ch1_thread,
-        (char *)"ASRC_1ch",
-        (rtos_osal_entry_function_t)asrc_one_channel_task,
-        (void *)(&asrc_init_ctx),
-        (size_t)RTOS_THREAD_STACK_SIZE(asrc_one_channel_task),
-        (unsigned int)appconfAUDIO_PIPELINE_TASK_PRIORITY);
-
-    fs_code_t in_fs_code;
-    fs_code_t out_fs_code;
+    uint32_t asrc_fs_out = 0; // Will be notified at runtime
     uint64_t nominal_fs_ratio;
-#if PROFILE_ASRC
-    uint32_t max_time = 0;
-#endif
 
-    int32_t frame_samples[CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_RX][USB_TO_I2S_ASRC_BLOCK_LENGTH * 4 + USB_TO_I2S_ASRC_BLOCK_LENGTH];             // TODO calculate size properly
-    int32_t frame_samples_interleaved[USB_TO_I2S_ASRC_BLOCK_LENGTH * 4 + USB_TO_I2S_ASRC_BLOCK_LENGTH][CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_RX]; // TODO calculate size properly
+    int32_t frame_samples_interleaved[USB_TO_I2S_ASRC_MAX_OUT_SAMPLES][CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_RX];
 
-    asrc_process_frame_ctx_t asrc_ctx;
     for (;;)
     {
         samp_t usb_audio_out_frame[USB_TO_I2S_ASRC_BLOCK_LENGTH][CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_RX];
-        int32_t usb_audio_out_frame_deinterleaved[CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_RX][USB_TO_I2S_ASRC_BLOCK_LENGTH];
+        int32_t asrc_input_frame[USB_TO_I2S_ASRC_BLOCK_LENGTH][CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_RX];
         size_t bytes_received = 0;
 
         /*
@@ -562,19 +530,16 @@ void usb_audio_out_asrc(void *arg)
         {
             continue;
         }
-        if (asrc_init_ctx.fs_out != current_i2s_rate)
+        if (asrc_fs_out != current_i2s_rate)
         {
             // Time to initialise asrc
             g_usb_to_i2s_rate_ratio = (uint64_t)0;
-            asrc_init_ctx.fs_out = current_i2s_rate;
-            in_fs_code = samp_rate_to_code(asrc_init_ctx.fs_in); // Sample rate code 0..5
-            out_fs_code = samp_rate_to_code(asrc_init_ctx.fs_out);
-            rtos_printf("USB tile initialising ASRC for fs_in %lu, fs_out %lu\n", asrc_init_ctx.fs_in, asrc_init_ctx.fs_out);
-
-            // Initialise both channel ASRCs
-            nominal_fs_ratio = asrc_init(in_fs_code, out_fs_code, &asrc_ctrl[0][0], ASRC_CHANNELS_PER_INSTANCE, asrc_init_ctx.n_in_samples, ASRC_DITHER_SETTING);
-            nominal_fs_ratio = asrc_init(in_fs_code, out_fs_code, &asrc_ctrl[1][0], ASRC_CHANNELS_PER_INSTANCE, asrc_init_ctx.n_in_samples, ASRC_DITHER_SETTING);
-            // Skip this frame since we're too late anayway from 2 asrc_init() calls, each taking 12500 cycles
+            asrc_fs_out = current_i2s_rate;
+            rtos_printf("USB tile initialising ASRC for fs_in %lu, fs_out %lu\n", (uint32_t) appconfUSB_AUDIO_SAMPLE_RATE, asrc_fs_out);
+
+            // Initialise the ASRC of all channels
+            nominal_fs_ratio = asrc_mc_set_rates(&asrc_mc, samp_rate_to_code(appconfUSB_AUDIO_SAMPLE_RATE), samp_rate_to_code(asrc_fs_out), ASRC_DITHER_SETTING);
+            // Skip this frame since we're too late anayway from the asrc_init() calls, each taking 12500 cycles
             continue;
         }
 
@@ -584,59 +549,21 @@ void usb_audio_out_asrc(void *arg)
             current_rate_ratio = g_usb_to_i2s_rate_ratio;
         }
 
-#if PROFILE_ASRC
-        uint32_t start = get_reference_time();
-#endif
+        PROFILE_START(usb_to_i2s_asrc_probe);
 
-        for (int ch = 0; ch < CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_RX; ch++)
+        for (int i = 0; i < USB_TO_I2S_ASRC_BLOCK_LENGTH; i++)
         {
-            for (int i = 0; i < USB_TO_I2S_ASRC_BLOCK_LENGTH; i++)
+            for (int ch = 0; ch < CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_RX; ch++)
             {
-                usb_audio_out_frame_deinterleaved[ch][i] = usb_audio_out_frame[i][ch] << src_32_shift;
                 // This is taking 4 MIPS. Can be optimised if needed.
-                usb_audio_out_frame_deinterleaved[ch][i] = volume_scale(vol_mul_h2d[ch % CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_RX], usb_audio_out_frame_deinterleaved[ch][i]);
+                asrc_input_frame[i][ch] = volume_scale(vol_mul_h2d[ch], usb_audio_out_frame[i][ch] << src_32_shift);
             }
         }
 
-        // Send to the other channel ASRC task
-        asrc_ctx.input_samples = &usb_audio_out_frame_deinterleaved[1][0];
-        asrc_ctx.output_samples = &frame_samples[1][0];
-        asrc_ctx.fs_ratio = current_rate_ratio;
-        asrc_process_frame_ctx_t *ptr = &asrc_ctx;
-
-
-        (void)rtos_osal_queue_send(&asrc_init_ctx.asrc_queue, &ptr, RTOS_OSAL_WAIT_FOREVER);
-
-        // Call asrc on this block of samples. Reuse frame_samples now that its copied into aec_reference_audio_samples
-
-        unsigned n_samps_out = asrc_process((int *)&usb_audio_out_frame_deinterleaved[0][0], (int *)&frame_samples[0][0], current_rate_ratio, &asrc_ctrl[0][0]);
+        // Call asrc on this block of samples, interleaved as received from USB
+        unsigned n_samps_out = asrc_mc_threads_process(&asrc_threads, &asrc_input_frame[0][0], &frame_samples_interleaved[0][0], current_rate_ratio);
 
-
-        unsigned n_samps_out_ch1;
-        rtos_osal_queue_receive(&asrc_init_ctx.asrc_ret_queue, &n_samps_out_ch1, RTOS_OSAL_WAIT_FOREVER);
-
-        if (n_samps_out != n_samps_out_ch1)
-        {
-            rtos_printf("Error: USB to I2S ASRC. ch0 and ch1 returned different number of samples: ch0 %u, ch1 %u\n", n_samps_out, n_samps_out_ch1);
-            xassert(0);
-        }
-
-        for (int ch = 0; ch < CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_RX; ch++)
-        {
-            for (int i = 0; i < n_samps_out; i++)
-            {
-                frame_samples_interleaved[i][ch] = frame_samples[ch][i];
-            }
-        }
-#if PROFILE_ASRC
-        uint32_t end = get_reference_time();
-        if(max_time < (end - start))
-        {
-            max_time = end - start;
-            printchar('u');
-            printuintln(max_time);
-        }
-#endif
+        PROFILE_END(usb_to_i2s_asrc_probe);
 
         /*
          * This shouldn't normally be zero, but it could be possible that
@@ -32,8 +32,14 @@
 #define appconfAUDIO_PLAYBACK_ENABLED           1
 #endif
 
+/* Keep listening during audio responses, a keyword or command heard over a
+ * response stops it */
+#ifndef appconfINTENT_BARGE_IN_ENABLED
+#define appconfINTENT_BARGE_IN_ENABLED          0
+#endif
+
 /* Intent Engine Configuration */
-#define appconfINTENT_FRAME_BUFFER_MULT      (8*2)       /* total buffer size is this value * MIC_ARRAY_CONFIG_SAMPLES_PER_FRAME */
+#define appconfINTENT_FRAME_BUFFER_MULT      (8*2)       /* total buffer size is this value * the larger of MIC_ARRAY_CONFIG_SAMPLES_PER_FRAME and appconfINTENT_SAMPLE_BLOCK_LENGTH */
 #define appconfINTENT_SAMPLE_BLOCK_LENGTH    240
 
 /* Enable inference engine */
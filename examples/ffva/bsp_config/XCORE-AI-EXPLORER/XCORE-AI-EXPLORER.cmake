@@ -43,7 +43,7 @@ target_compile_definitions(sln_voice_app_ffva_board_support_xcore_ai_explorer
 
         MIC_ARRAY_CONFIG_MCLK_FREQ=24576000
         MIC_ARRAY_CONFIG_PDM_FREQ=3072000
-        MIC_ARRAY_CONFIG_SAMPLES_PER_FRAME=240
+        MIC_ARRAY_CONFIG_SAMPLES_PER_FRAME=${FFVA_FRAME_ADVANCE}
         MIC_ARRAY_CONFIG_MIC_COUNT=2
         MIC_ARRAY_CONFIG_CLOCK_BLOCK_A=XS1_CLKBLK_1
         MIC_ARRAY_CONFIG_CLOCK_BLOCK_B=XS1_CLKBLK_2
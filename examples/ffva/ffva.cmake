@@ -8,9 +8,15 @@ set(APP_INCLUDES
     ${CMAKE_CURRENT_LIST_DIR}/src
     ${CMAKE_CURRENT_LIST_DIR}/src/control
     ${CMAKE_CURRENT_LIST_DIR}/src/dfu_int
+    ${CMAKE_CURRENT_LIST_DIR}/src/profile_int
     ${CMAKE_CURRENT_LIST_DIR}/src/usb
 )
 
+# Pipeline frame advance in samples, a divisor or a multiple of the 240
+# sample block the DSP stages process. Shorter frames lower the latency of
+# the I/O and of stages that process samples, such as the fixed delay.
+set(FFVA_FRAME_ADVANCE 240 CACHE STRING "FFVA audio pipeline frame advance in samples")
+
 include(${CMAKE_CURRENT_LIST_DIR}/bsp_config/bsp_config.cmake)
 
 #**********************
@@ -48,6 +54,7 @@ set(APP_COMMON_LINK_LIBRARIES
     rtos::sw_services::device_control
     lib_src
     lib_sw_pll
+    sln_voice::app::profiling
 )
 
 #**********************
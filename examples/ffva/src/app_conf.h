@@ -29,6 +29,7 @@
 #define appconfWW_SAMPLES_PORT         6
 #define appconfAUDIOPIPELINE_PORT      7
 #define appconfI2S_OUTPUT_SLAVE_PORT   8
+#define appconfAUDIO_PIPELINE_GRAPH_PORT 9
 
 #ifndef appconfINTENT_ENGINE_READY_SYNC_PORT
 #define appconfINTENT_ENGINE_READY_SYNC_PORT      18
@@ -53,8 +54,14 @@
 #define appconfAUDIO_PLAYBACK_ENABLED           1
 #endif
 
+/* Keep listening during audio responses, a keyword or command heard over a
+ * response stops it */
+#ifndef appconfINTENT_BARGE_IN_ENABLED
+#define appconfINTENT_BARGE_IN_ENABLED          0
+#endif
+
 /* Intent Engine Configuration */
-#define appconfINTENT_FRAME_BUFFER_MULT      (8*2)       /* total buffer size is this value * MIC_ARRAY_CONFIG_SAMPLES_PER_FRAME */
+#define appconfINTENT_FRAME_BUFFER_MULT      (8*2)       /* total buffer size is this value * the larger of MIC_ARRAY_CONFIG_SAMPLES_PER_FRAME and appconfINTENT_SAMPLE_BLOCK_LENGTH */
 #define appconfINTENT_SAMPLE_BLOCK_LENGTH    240
 
 /* Maximum delay between a wake up phrase and command phrase */
@@ -186,6 +193,19 @@
 #define appconfI2S_MODE            appconfI2S_MODE_MASTER
 #endif
 
+/*
+ * Only send the pipeline output channels that are used by the enabled
+ * outputs from tile 1 to tile 0. The reference channels are used by USB,
+ * I2S TDM and I2S master. The microphone channels are used by USB and I2S TDM.
+ */
+#ifndef appconfAUDIO_PIPELINE_OUTPUT_REF_ENABLED
+#define appconfAUDIO_PIPELINE_OUTPUT_REF_ENABLED  (appconfUSB_ENABLED || (appconfI2S_ENABLED && (appconfI2S_MODE == appconfI2S_MODE_MASTER)))
+#endif
+
+#ifndef appconfAUDIO_PIPELINE_OUTPUT_MIC_ENABLED
+#define appconfAUDIO_PIPELINE_OUTPUT_MIC_ENABLED  (appconfUSB_ENABLED || (appconfI2S_ENABLED && (appconfI2S_MODE == appconfI2S_MODE_MASTER) && appconfI2S_TDM_ENABLED))
+#endif
+
 #define appconfAEC_REF_USB         0
 #define appconfAEC_REF_I2S         1
 #ifndef appconfAEC_REF_DEFAULT
@@ -239,6 +259,7 @@
 #define appconfUSB_AUDIO_TASK_PRIORITY            (configMAX_PRIORITIES/2 + 1)
 #define appconfSPI_TASK_PRIORITY                  (configMAX_PRIORITIES/2 + 1)
 #define appconfQSPI_FLASH_TASK_PRIORITY           (configMAX_PRIORITIES/2 + 0)
+#define appconfDFU_FLASH_TASK_PRIORITY            (configMAX_PRIORITIES/2 + 0)
 #define appconfINTENT_MODEL_RUNNER_TASK_PRIORITY  (configMAX_PRIORITIES - 2)
 #define appconfLED_TASK_PRIORITY                  (configMAX_PRIORITIES / 2 - 1)
 
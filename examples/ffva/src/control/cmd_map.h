@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 #include "device_control_shared.h"
 
@@ -17,6 +18,11 @@
 // Servicers will have commands in the above 4 categories.
 // Resources will have commands in the dedicated, reserved and broadcast categories.
 
+// Command IDs are 7 bits, the top bit of the command byte marks a read
+#define CONTROL_CMD_ID_COUNT (128)
+// Value of an unused entry in the command and resource index tables
+#define CONTROL_INDEX_NONE (0xFF)
+
 
 typedef enum
 {
@@ -25,15 +31,36 @@ typedef enum
     CMD_WRITE_ONLY
 }cmd_rw_type_t;
 
+struct control_resource_info;
+
+/* Only the xcore compiler needs the function pointer group */
+#if defined(__XS3A__)
+#define CONTROL_CMD_READ_FPTRGROUP  __attribute__((fptrgroup("control_cmd_read_fptr_grp")))
+#define CONTROL_CMD_WRITE_FPTRGROUP __attribute__((fptrgroup("control_cmd_write_fptr_grp")))
+#else
+#define CONTROL_CMD_READ_FPTRGROUP
+#define CONTROL_CMD_WRITE_FPTRGROUP
+#endif
+
+// Command handlers. The payload excludes the status byte of read commands.
+typedef control_ret_t (*control_cmd_read_fn_t)(struct control_resource_info *res_info, control_cmd_t cmd, uint8_t *payload, size_t payload_len);
+typedef control_ret_t (*control_cmd_write_fn_t)(struct control_resource_info *res_info, control_cmd_t cmd, const uint8_t *payload, size_t payload_len);
+
 typedef struct
 {
     uint8_t cmd_id;
     uint8_t num_vals;
     uint8_t bytes_per_val;
     uint8_t cmd_rw_type;
+    CONTROL_CMD_READ_FPTRGROUP
+    control_cmd_read_fn_t read_handler;     // NULL if the command cannot be read
+    CONTROL_CMD_WRITE_FPTRGROUP
+    control_cmd_write_fn_t write_handler;   // NULL if the command cannot be written
 }control_cmd_info_t;
 
 typedef struct {
     int32_t num_commands;
     control_cmd_info_t *commands;
+    // Position in commands of every command ID, CONTROL_INDEX_NONE for unused IDs
+    uint8_t cmd_index[CONTROL_CMD_ID_COUNT];
 }command_map_t;
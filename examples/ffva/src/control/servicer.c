@@ -6,11 +6,11 @@
 #endif
 #include "debug_print.h"
 #include <stdio.h>
+#include <string.h>
 #include <platform.h>
 #include "platform/platform_conf.h"
 #include "device_control_i2c.h"
 #include "servicer.h"
-#include "dfu_servicer.h"
 
 #if appconfI2C_DFU_ENABLED && ON_TILE(I2C_CTRL_TILE_NO)
 static device_control_t device_control_i2c_ctx_s;
@@ -34,6 +34,12 @@ control_ret_t read_cmd(control_resid_t resid, control_cmd_t cmd, uint8_t *payloa
     debug_printf("Servicer ID %d on tile %d received READ command %02x for resid %02x\n\t",servicer->id, THIS_XCORE_TILE, cmd, resid);
     debug_printf("The command is requesting %d bytes\n\t", payload_len);
 
+    if(CONTROL_CMD_CLEAR_READ(cmd) == SERVICER_CMD_BATCH_READ)
+    {
+        ret = servicer_batch_read(servicer, payload_ptr, payload_len);
+        payload[0] = ret;
+        return ret;
+    }
 
     control_resource_info_t *current_res_info = get_res_info(resid, servicer);
     xassert(current_res_info != NULL); // This should never happen
@@ -44,14 +50,9 @@ control_ret_t read_cmd(control_resid_t resid, control_cmd_t cmd, uint8_t *payloa
         payload[0] = ret; // Update status in byte 0
         return ret;
     }
-    // Check if command is for the servicer itself
-    if(current_res_info->resource == servicer->res_info[0].resource)
-    {
-        ret = servicer_read_cmd(current_res_info, cmd, payload_ptr, payload_len);
-        payload[0] = ret;
-        return ret;
-    }
-    return CONTROL_ERROR;
+    ret = current_cmd_info->read_handler(current_res_info, cmd, payload_ptr, payload_len);
+    payload[0] = ret;
+    return ret;
 }
 
 DEVICE_CONTROL_CALLBACK_ATTR
@@ -64,6 +65,11 @@ control_ret_t write_cmd(control_resid_t resid, control_cmd_t cmd, const uint8_t
     debug_printf("Servicer ID %d on tile %d received WRITE command %02x for resid %02x\n\t", servicer->id, THIS_XCORE_TILE, cmd, resid);
     debug_printf("The command has %d bytes\n\t", payload_len);
 
+    if(cmd == SERVICER_CMD_BATCH_SELECT)
+    {
+        return servicer_batch_select(servicer, payload, payload_len);
+    }
+
     control_resource_info_t *current_res_info = get_res_info(resid, servicer);
     xassert(current_res_info != NULL);
     control_cmd_info_t *current_cmd_info;
@@ -72,46 +78,62 @@ control_ret_t write_cmd(control_resid_t resid, control_cmd_t cmd, const uint8_t
     {
         return ret;
     }
-    // Check if command is for the servicer itself
-    if(current_res_info->resource == servicer->res_info[0].resource)
-    {
-        ret = servicer_write_cmd(current_res_info, cmd, payload, payload_len);
-        return ret;
-    }
-    return CONTROL_ERROR;
+    ret = current_cmd_info->write_handler(current_res_info, cmd, payload, payload_len);
+    return ret;
 }
 
-// Initialise packet payload pointers to point to valid memory.
+//-----------------Servicer helper functions-----------------------//
+// Fill in the lookup tables used by get_res_info() and get_cmd_info(), so that the commands
+// are resolved without searching the command maps.
+void servicer_index_init(servicer_t *servicer)
+{
+    xassert(servicer->num_resources < CONTROL_INDEX_NONE);
+    memset(servicer->res_index, CONTROL_INDEX_NONE, sizeof(servicer->res_index));
 
+    for(int res=0; res<servicer->num_resources; res++)
+    {
+        command_map_t *command_map = &servicer->res_info[res].command_map;
+
+        xassert(servicer->res_index[servicer->res_info[res].resource] == CONTROL_INDEX_NONE);
+        servicer->res_index[servicer->res_info[res].resource] = res;
+
+        xassert(command_map->num_commands < CONTROL_INDEX_NONE);
+        memset(command_map->cmd_index, CONTROL_INDEX_NONE, sizeof(command_map->cmd_index));
+        for(int i=0; i<command_map->num_commands; i++)
+        {
+            uint8_t cmd_id = command_map->commands[i].cmd_id;
+
+            // The shared command IDs are handled by the servicer
+            xassert(cmd_id < CONTROL_CMD_ID_COUNT);
+            xassert(cmd_id != SERVICER_CMD_BATCH_SELECT && cmd_id != SERVICER_CMD_BATCH_READ);
+            xassert(command_map->cmd_index[cmd_id] == CONTROL_INDEX_NONE);
+            command_map->cmd_index[cmd_id] = i;
+        }
+    }
+    servicer->num_batch_cmds = 0;
+    servicer->batch_payload_len = 0;
+}
 
-//-----------------Servicer helper functions-----------------------//
 // Return a pointer to the control_cmd_info_t structure for a given command ID. Return NULL if command not found in the
 // command map for the resource.
 control_cmd_info_t* get_cmd_info(uint8_t cmd_id, const control_resource_info_t *res_info)
 {
-    for(int i=0; i<res_info->command_map.num_commands; i++)
+    if(cmd_id >= CONTROL_CMD_ID_COUNT || res_info->command_map.cmd_index[cmd_id] == CONTROL_INDEX_NONE)
     {
-        if(res_info->command_map.commands[i].cmd_id == cmd_id)
-        {
-            return &res_info->command_map.commands[i];
-        }
+        return NULL;
     }
-    return NULL;
+    return &res_info->command_map.commands[res_info->command_map.cmd_index[cmd_id]];
 }
 
 // Return a pointer to the servicer's control_resource_info_t structure for a given resource ID.
 // Return NULL if the resource ID is not found in the list of resources serviced by the servicer.
 control_resource_info_t* get_res_info(control_resid_t resource, const servicer_t *servicer)
 {
-    for(int res=0; res<servicer->num_resources; res++)
+    if(servicer->res_index[resource] == CONTROL_INDEX_NONE)
     {
-        // Get the cmd_info for the current command
-        if(servicer->res_info[res].resource == resource)
-        {
-            return &servicer->res_info[res];
-        }
+        return NULL;
     }
-    return NULL;
+    return &servicer->res_info[servicer->res_index[resource]];
 }
 
 // Validate the command from the host against that commands information in the stored command_map
@@ -128,6 +150,12 @@ control_ret_t validate_cmd(control_cmd_info_t **cmd_info,
         return SERVICER_WRONG_COMMAND_ID;
     }
 
+    // Reject reads of write only commands and writes of read only commands
+    if(cmd != CONTROL_CMD_CLEAR_READ(cmd) ? (*cmd_info)->read_handler == NULL : (*cmd_info)->write_handler == NULL)
+    {
+        return SERVICER_WRONG_COMMAND_ID;
+    }
+
     // Validate non special command length
     // Don't do payload check for special commands since for the last filter chunk, host might request less than the payload length specified in the cmd_map
 
@@ -140,29 +168,61 @@ control_ret_t validate_cmd(control_cmd_info_t **cmd_info,
     return ret;
 }
 
-// Process write commands directed to the servicer resource
-control_ret_t servicer_write_cmd(control_resource_info_t *res_info, control_cmd_t cmd, const uint8_t *payload, size_t payload_len)
+// Select the commands returned by the next batch reads
+control_ret_t servicer_batch_select(servicer_t *servicer, const uint8_t *payload, size_t payload_len)
 {
-    // Handle write commands directed to a servicer resource
-    switch(res_info->resource)
+    size_t batch_payload_len = 0;
+    int num_cmds = payload_len / 2;
+
+    if(payload_len == 0 || payload_len % 2 != 0 || num_cmds > SERVICER_BATCH_MAX_CMDS)
+    {
+        return SERVICER_WRONG_COMMAND_LEN;
+    }
+
+    servicer->num_batch_cmds = 0;
+    servicer->batch_payload_len = 0;
+    for(int i=0; i<num_cmds; i++)
     {
-        case DFU_CONTROLLER_SERVICER_RESID:
-            return dfu_servicer_write_cmd(res_info, cmd, payload, payload_len);
-        break;
+        control_resource_info_t *res_info = get_res_info(payload[2 * i], servicer);
+        control_cmd_info_t *cmd_info = (res_info != NULL) ? get_cmd_info(payload[2 * i + 1], res_info) : NULL;
+
+        if(cmd_info == NULL || cmd_info->read_handler == NULL)
+        {
+            return SERVICER_WRONG_PAYLOAD;
+        }
+        servicer->batch_res_info[i] = res_info;
+        servicer->batch_cmds[i] = cmd_info;
+        // Each command returns its own status byte before its payload
+        batch_payload_len += 1 + cmd_info->bytes_per_val * cmd_info->num_vals;
     }
+    servicer->num_batch_cmds = num_cmds;
+    servicer->batch_payload_len = batch_payload_len;
     return CONTROL_SUCCESS;
 }
 
-// Process read commands directed to the servicer resource
-control_ret_t servicer_read_cmd(control_resource_info_t *res_info, control_cmd_t cmd, uint8_t *payload, size_t payload_len)
+// Read every selected command into one payload
+control_ret_t servicer_batch_read(servicer_t *servicer, uint8_t *payload, size_t payload_len)
 {
     control_ret_t ret = CONTROL_SUCCESS;
-     // Handle read commands directed to a servicer resource
-    switch(res_info->resource)
+
+    if(servicer->num_batch_cmds == 0 || payload_len != servicer->batch_payload_len)
     {
-        case DFU_CONTROLLER_SERVICER_RESID:
-            ret = dfu_servicer_read_cmd(res_info, cmd, payload, payload_len);
-            break;
+        return SERVICER_WRONG_COMMAND_LEN;
+    }
+
+    for(int i=0; i<servicer->num_batch_cmds; i++)
+    {
+        control_cmd_info_t *cmd_info = servicer->batch_cmds[i];
+        size_t cmd_payload_len = cmd_info->bytes_per_val * cmd_info->num_vals;
+        control_ret_t cmd_ret;
+
+        cmd_ret = cmd_info->read_handler(servicer->batch_res_info[i], CONTROL_CMD_SET_READ(cmd_info->cmd_id), &payload[1], cmd_payload_len);
+        payload[0] = cmd_ret;
+        if(ret == CONTROL_SUCCESS)
+        {
+            ret = cmd_ret;
+        }
+        payload += 1 + cmd_payload_len;
     }
     return ret;
 }
@@ -17,8 +17,29 @@ extern device_control_t *device_control_ctxs[1];
  */
 #define CONTROL_CMD_CLEAR_READ(c) ((c) & ~0x80)
 
+/**
+ * Sets the read bit on a command code
+ *
+ * \param[in,out] c The command code to set the read bit on.
+ */
+#define CONTROL_CMD_SET_READ(c) ((c) | 0x80)
+
+// Shared commands, accepted on every resource of a servicer.
+// A batch read returns the responses of up to SERVICER_BATCH_MAX_CMDS read commands
+// of the servicer's resources in one transaction. The host selects the commands by
+// writing SERVICER_CMD_BATCH_SELECT with a (resource ID, command ID) byte pair per
+// command, then reads SERVICER_CMD_BATCH_READ. After the status byte of the
+// transaction, the read returns a status byte and the payload of each command in
+// the order selected.
+#define SERVICER_CMD_BATCH_SELECT       (SHARED_COMMANDS_START_OFFSET + 0)
+#define SERVICER_CMD_BATCH_READ         (SHARED_COMMANDS_START_OFFSET + 1)
+#define SERVICER_BATCH_MAX_CMDS         (16)
+
+// Number of resource IDs, the size of a servicer's resource index table
+#define SERVICER_RESID_COUNT            (256)
+
 // Structure encapsulating all the information about a resource
-typedef struct
+typedef struct control_resource_info
 {
     control_resid_t resource;
     command_map_t command_map;
@@ -31,6 +52,14 @@ typedef struct {
     int32_t num_resources;
     // Resource ID and command map for every resource
     control_resource_info_t *res_info;
+    // Position in res_info of every resource ID, CONTROL_INDEX_NONE for IDs not serviced
+    uint8_t res_index[SERVICER_RESID_COUNT];
+    // Commands selected for SERVICER_CMD_BATCH_READ
+    int32_t num_batch_cmds;
+    control_cmd_info_t *batch_cmds[SERVICER_BATCH_MAX_CMDS];
+    control_resource_info_t *batch_res_info[SERVICER_BATCH_MAX_CMDS];
+    // Payload length of SERVICER_CMD_BATCH_READ for the selected commands
+    size_t batch_payload_len;
 }servicer_t;
 
 // Servicer device_control callback functions
@@ -63,6 +92,16 @@ extern DEVICE_CONTROL_CALLBACK_ATTR
 control_ret_t write_cmd(control_resid_t resid, control_cmd_t cmd, const uint8_t *payload, size_t payload_len, void *app_data);
 
 // Servicer helper functions
+/**
+ * @brief Build the resource and command index tables of a servicer.
+ *
+ * Must be called once all the resources of the servicer are set up and before the
+ * servicer receives commands. Resource and command IDs must be unique.
+ *
+ * @param servicer      Pointer to the servicer state structure.
+ */
+void servicer_index_init(servicer_t *servicer);
+
 /**
  * @brief Check if a command exists in the command map for a given resource and return the pointer to the cmd info object for the given command
  *
@@ -102,23 +141,23 @@ control_ret_t validate_cmd(control_cmd_info_t **cmd_info,
                             size_t payload_len);
 
 /**
- * @brief Function for handling write commands directed to the servicer resource itself.
+ * @brief Handle a write of SERVICER_CMD_BATCH_SELECT.
  *
- * @param resid         Command Resource ID
- * @param cmd           Command Command ID
- * @param payload       Command write payload buffer
+ * @param servicer      Pointer to the servicer state structure.
+ * @param payload       (resource ID, command ID) pair of each command to select
  * @param payload_len   Length of the payload buffer
- * @return              CONTROL_SUCCESS if write command processed successfully. contro_ret_t error status otherwise.
+ * @return              CONTROL_SUCCESS if every command can be read. control_ret_t error status otherwise,
+ *                      in which case no command is selected.
  */
-control_ret_t servicer_write_cmd(control_resource_info_t *res_info, control_cmd_t cmd, const uint8_t *payload, size_t payload_len);
+control_ret_t servicer_batch_select(servicer_t *servicer, const uint8_t *payload, size_t payload_len);
 
 /**
- * @brief               Function for handling read commands directed to the servicer resource itself.
+ * @brief Handle a read of SERVICER_CMD_BATCH_READ.
  *
- * @param resid         Command Resource ID
- * @param cmd           Command Command ID
- * @param payload       Payload buffer to populate with the read response
+ * @param servicer      Pointer to the servicer state structure.
+ * @param payload       Payload buffer to populate with the status byte and payload of every selected command
  * @param payload_len   Length of the payload buffer
- * @return              CONTROL_SUCCESS if read command processed successfully. contro_ret_t error status otherwise.
+ * @return              CONTROL_SUCCESS if every selected command was read successfully.
+ *                      control_ret_t error status of the first that failed otherwise.
  */
-control_ret_t servicer_read_cmd(control_resource_info_t *res_info, control_cmd_t cmd, uint8_t *payload, size_t payload_len);
+control_ret_t servicer_batch_read(servicer_t *servicer, uint8_t *payload, size_t payload_len);
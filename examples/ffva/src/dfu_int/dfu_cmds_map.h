@@ -9,16 +9,16 @@
 // Unused variable warnings are suppressed in this header file
 static control_cmd_info_t dfu_controller_servicer_resid_cmd_map[] =
 {
-    { DFU_CONTROLLER_SERVICER_RESID_DFU_DETACH, 1, sizeof(uint8_t), CMD_WRITE_ONLY },
-    { DFU_CONTROLLER_SERVICER_RESID_DFU_DNLOAD, 130, sizeof(uint8_t), CMD_WRITE_ONLY },
-    { DFU_CONTROLLER_SERVICER_RESID_DFU_UPLOAD, 130, sizeof(uint8_t), CMD_READ_ONLY },
-    { DFU_CONTROLLER_SERVICER_RESID_DFU_GETSTATUS, 5, sizeof(uint8_t), CMD_READ_ONLY },
-    { DFU_CONTROLLER_SERVICER_RESID_DFU_CLRSTATUS, 1, sizeof(uint8_t), CMD_WRITE_ONLY },
-    { DFU_CONTROLLER_SERVICER_RESID_DFU_GETSTATE, 1, sizeof(uint8_t), CMD_READ_ONLY },
-    { DFU_CONTROLLER_SERVICER_RESID_DFU_ABORT, 1, sizeof(uint8_t), CMD_WRITE_ONLY },
-    { DFU_CONTROLLER_SERVICER_RESID_DFU_SETALTERNATE, 1, sizeof(uint8_t), CMD_WRITE_ONLY },
-    { DFU_CONTROLLER_SERVICER_RESID_DFU_TRANSFERBLOCK, 2, sizeof(uint8_t), CMD_READ_WRITE },
-    { DFU_CONTROLLER_SERVICER_RESID_DFU_GETVERSION, 3, sizeof(uint8_t), CMD_READ_ONLY },
-    { DFU_CONTROLLER_SERVICER_RESID_DFU_REBOOT, 1, sizeof(uint8_t), CMD_WRITE_ONLY },
+    { DFU_CONTROLLER_SERVICER_RESID_DFU_DETACH, 1, sizeof(uint8_t), CMD_WRITE_ONLY, NULL, dfu_servicer_write_cmd },
+    { DFU_CONTROLLER_SERVICER_RESID_DFU_DNLOAD, 130, sizeof(uint8_t), CMD_WRITE_ONLY, NULL, dfu_servicer_write_cmd },
+    { DFU_CONTROLLER_SERVICER_RESID_DFU_UPLOAD, 130, sizeof(uint8_t), CMD_READ_ONLY, dfu_servicer_read_cmd, NULL },
+    { DFU_CONTROLLER_SERVICER_RESID_DFU_GETSTATUS, 5, sizeof(uint8_t), CMD_READ_ONLY, dfu_servicer_read_cmd, NULL },
+    { DFU_CONTROLLER_SERVICER_RESID_DFU_CLRSTATUS, 1, sizeof(uint8_t), CMD_WRITE_ONLY, NULL, dfu_servicer_write_cmd },
+    { DFU_CONTROLLER_SERVICER_RESID_DFU_GETSTATE, 1, sizeof(uint8_t), CMD_READ_ONLY, dfu_servicer_read_cmd, NULL },
+    { DFU_CONTROLLER_SERVICER_RESID_DFU_ABORT, 1, sizeof(uint8_t), CMD_WRITE_ONLY, NULL, dfu_servicer_write_cmd },
+    { DFU_CONTROLLER_SERVICER_RESID_DFU_SETALTERNATE, 1, sizeof(uint8_t), CMD_WRITE_ONLY, NULL, dfu_servicer_write_cmd },
+    { DFU_CONTROLLER_SERVICER_RESID_DFU_TRANSFERBLOCK, 2, sizeof(uint8_t), CMD_READ_WRITE, dfu_servicer_read_cmd, dfu_servicer_write_cmd },
+    { DFU_CONTROLLER_SERVICER_RESID_DFU_GETVERSION, 3, sizeof(uint8_t), CMD_READ_ONLY, dfu_servicer_read_cmd, NULL },
+    { DFU_CONTROLLER_SERVICER_RESID_DFU_REBOOT, 1, sizeof(uint8_t), CMD_WRITE_ONLY, NULL, dfu_servicer_write_cmd },
 };
 #pragma clang diagnostic pop
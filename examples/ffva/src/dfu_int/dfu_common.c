@@ -8,9 +8,17 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 #include "quadflashlib.h"
 
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+
+#include "app_conf.h"
 #include "dfu_common.h"
+#include "dfu_flash_writer.h"
 #include "rtos_dfu_image.h"
 #include "rtos_qspi_flash.h"
 #include "platform/driver_instances.h"
@@ -20,6 +28,125 @@ static size_t bytes_avail = 0;
 static uint32_t dn_base_addr = 0;
 static size_t total_len = 0;
 
+/*
+ * Downloaded blocks are written to flash by the DFU flash task, so that the
+ * next block can be transferred while a block is written. Blocks are passed
+ * to the task in a static double buffer. When the task has no block to write
+ * it erases the sector following the last one written, if the download is
+ * expected to write it.
+ */
+typedef struct {
+    uint8_t data[DFU_FLASH_BLOCK_SIZE_MAX];
+    size_t offset;
+    size_t len;
+} dfu_flash_block_t;
+
+static dfu_flash_block_t blocks[2];
+static int next_block = 0;
+static QueueHandle_t block_queue = NULL;
+static SemaphoreHandle_t free_blocks = NULL;
+static uint32_t write_status = 0;
+
+static dfu_flash_writer_t writer;
+static uint8_t sector_buf[DFU_FLASH_BLOCK_SIZE_MAX];
+static uint32_t erased_sectors[DFU_FLASH_WRITER_BITMAP_WORDS(DFU_FLASH_MAX_SECTORS)];
+
+DFU_FLASH_READ_FPTRGROUP
+static void flash_read(void *ctx, uint8_t *data, unsigned address, size_t len)
+{
+    rtos_qspi_flash_read(ctx, data, address, len);
+}
+
+DFU_FLASH_WRITE_FPTRGROUP
+static void flash_write(void *ctx, const uint8_t *data, unsigned address, size_t len)
+{
+    rtos_qspi_flash_write(ctx, (uint8_t *) data, address, len);
+}
+
+DFU_FLASH_ERASE_FPTRGROUP
+static void flash_erase(void *ctx, unsigned address, size_t len)
+{
+    rtos_qspi_flash_erase(ctx, address, len);
+}
+
+static dfu_flash_ops_t flash_ops = {flash_read, flash_write, flash_erase, NULL};
+
+static void dfu_flash_task(void *arg)
+{
+    int block_index = 0;
+    int erase_ahead = 0;
+
+    (void) arg;
+
+    for (;;) {
+        if (xQueueReceive(block_queue, &block_index, erase_ahead ? 0 : portMAX_DELAY) != pdTRUE) {
+            // No block is waiting, so erase the next sector while one is sent
+            rtos_qspi_flash_lock(qspi_flash_ctx);
+            dfu_flash_writer_erase_ahead(&writer);
+            rtos_qspi_flash_unlock(qspi_flash_ctx);
+            erase_ahead = 0;
+            continue;
+        }
+
+        dfu_flash_block_t *block = &blocks[block_index];
+
+        rtos_qspi_flash_lock(qspi_flash_ctx);
+        if (dfu_flash_writer_write(&writer, block->offset, block->data, block->len) != 0) {
+            write_status = 8; //DFU_STATUS_ERR_ADDRESS
+        }
+        rtos_qspi_flash_unlock(qspi_flash_ctx);
+
+        erase_ahead = 1;
+        xSemaphoreGive(free_blocks);
+    }
+}
+
+/* Wait until every block passed to the DFU flash task has been written */
+static void dfu_flash_flush(void)
+{
+    if (block_queue == NULL) {
+        return;
+    }
+    for (int i = 0; i < 2; i++) {
+        xSemaphoreTake(free_blocks, portMAX_DELAY);
+    }
+    for (int i = 0; i < 2; i++) {
+        xSemaphoreGive(free_blocks);
+    }
+}
+
+static void dfu_flash_begin(unsigned base, size_t size, size_t expected)
+{
+    if (block_queue == NULL) {
+        size_t sector_size = rtos_qspi_flash_sector_size_get(qspi_flash_ctx);
+
+        /* Read-backs of partly written sectors go into sector_buf */
+        xassert(sector_size <= DFU_FLASH_BLOCK_SIZE_MAX);
+
+        flash_ops.ctx = qspi_flash_ctx;
+        dfu_flash_writer_init(&writer,
+                              &flash_ops,
+                              sector_size,
+                              sector_buf,
+                              erased_sectors,
+                              DFU_FLASH_MAX_SECTORS);
+        block_queue = xQueueCreate(2, sizeof(int));
+        free_blocks = xSemaphoreCreateCounting(2, 2);
+        configASSERT(block_queue);
+        configASSERT(free_blocks);
+        xTaskCreate((TaskFunction_t) dfu_flash_task,
+                    "dfu_flash",
+                    RTOS_THREAD_STACK_SIZE(dfu_flash_task),
+                    NULL,
+                    appconfDFU_FLASH_TASK_PRIORITY,
+                    NULL);
+    }
+    dfu_flash_flush();
+    dfu_flash_writer_begin(&writer, base, size);
+    dfu_flash_writer_expect(&writer, expected);
+    write_status = 0;
+}
+
 uint32_t dfu_common_write_to_flash(uint8_t alt,
                                    uint16_t block_num,
                                    uint8_t const *data,
@@ -39,6 +166,9 @@ uint32_t dfu_common_write_to_flash(uint8_t alt,
                 total_len = 0;
                 dn_base_addr = rtos_dfu_image_get_upgrade_addr(dfu_image_ctx);
                 bytes_avail = data_partition_base_addr - dn_base_addr;
+                /* The upgrade partition only holds the image downloaded, so
+                 * any of it may be erased ahead */
+                dfu_flash_begin(dn_base_addr, bytes_avail, bytes_avail);
             }
             /* fallthrough */
         case 2:
@@ -46,38 +176,33 @@ uint32_t dfu_common_write_to_flash(uint8_t alt,
                 total_len = 0;
                 dn_base_addr = data_partition_base_addr;
                 bytes_avail = rtos_qspi_flash_size_get(qspi_flash_ctx) - dn_base_addr;
+                /* The download may be shorter than the data it replaces, and
+                 * the length is not known in advance, so nothing is erased
+                 * ahead of the blocks written */
+                dfu_flash_begin(dn_base_addr, bytes_avail, 0);
             }
             rtos_printf("Using addr 0x%x\nsize %u\n", dn_base_addr, bytes_avail);
             if(length > 0) {
-                unsigned cur_addr = dn_base_addr + (block_num * length);
+                size_t offset = block_num * length;
                 if((bytes_avail - total_len) >= length) {
-                    rtos_printf("write %d at 0x%x\n", length, cur_addr);
-
-                    size_t sector_size = rtos_qspi_flash_sector_size_get(qspi_flash_ctx);
-                    xassert(length == sector_size);
-
-                    uint8_t *tmp_buf = rtos_osal_malloc( sizeof(uint8_t) * sector_size);
-                    rtos_qspi_flash_lock(qspi_flash_ctx);
-                    {
-                        rtos_qspi_flash_read(
-                                qspi_flash_ctx,
-                                tmp_buf,
-                                cur_addr,
-                                sector_size);
-                        memcpy(tmp_buf, data, length);
-                        rtos_qspi_flash_erase(
-                                qspi_flash_ctx,
-                                cur_addr,
-                                sector_size);
-                        rtos_qspi_flash_write(
-                                qspi_flash_ctx,
-                                (uint8_t *) tmp_buf,
-                                cur_addr,
-                                sector_size);
-                    }
-                    rtos_qspi_flash_unlock(qspi_flash_ctx);
-                    rtos_osal_free(tmp_buf);
+                    rtos_printf("write %d at 0x%x\n", length, dn_base_addr + offset);
+
+                    xassert(length <= DFU_FLASH_BLOCK_SIZE_MAX);
+
+                    /* Hand the block to the DFU flash task, waiting if both
+                     * buffers hold blocks still to be written */
+                    xSemaphoreTake(free_blocks, portMAX_DELAY);
+                    dfu_flash_block_t *block = &blocks[next_block];
+                    memcpy(block->data, data, length);
+                    block->offset = offset;
+                    block->len = length;
+                    xQueueSend(block_queue, &next_block, portMAX_DELAY);
+                    next_block ^= 1;
                     total_len += length;
+
+                    /* A failed write is reported with the next block or at
+                     * manifestation */
+                    return_value = write_status;
                 } else {
                     rtos_printf("Insufficient space\n");
                     return_value = 8; //DFU_STATUS_ERR_ADDRESS;
@@ -94,6 +219,14 @@ uint32_t dfu_common_make_manifest()
 {
     debug_printf("Download completed, enter manifestation\n");
 
+    /* Wait for the DFU flash task to write the last blocks */
+    dfu_flash_flush();
+    rtos_printf("DFU flash: %u writes, %u read-backs, %u erases, %u erased ahead\n",
+                writer.stats.writes,
+                writer.stats.sector_reads,
+                writer.stats.sector_erases,
+                writer.stats.sectors_erased_ahead);
+
     /* Perform a read to ensure all writes have been flushed */
     uint32_t dummy = 0;
     rtos_qspi_flash_read(
@@ -108,7 +241,7 @@ uint32_t dfu_common_make_manifest()
     // flashing op for manifest is complete without error
     // Application can perform checksum.
     // Should it fail, return appropriate status such as errVERIFY.
-    return 0; // DFU_STATUS_OK
+    return write_status; // DFU_STATUS_OK unless a write failed
 }
 
 uint16_t dfu_common_read_from_flash(uint8_t alt,
@@ -13,6 +13,11 @@
 #define DOWNLOAD_TIMEOUT_WRITE_MS 3
 #define DOWNLOAD_TIMEOUT_BUFFER_MS 1
 
+// Largest block that can be written to flash at once, the flash sector size
+#define DFU_FLASH_BLOCK_SIZE_MAX 4096
+// Number of sectors of a partition whose erased state is tracked, 16 MiB of flash
+#define DFU_FLASH_MAX_SECTORS ((16 * 1024 * 1024) / DFU_FLASH_BLOCK_SIZE_MAX)
+
 /**
  * \brief Handle a DFU request to write some data to the flash memory.
  *
@@ -21,6 +26,10 @@
  *   the value of \p alt. The data is written to the flash memory at the
  *   address specified by \p block_num.
  *
+ * The data is copied and written by the DFU flash task, so this function
+ *   returns before the data is in flash. An error writing a block is returned
+ *   by the next call, or by dfu_common_make_manifest().
+ *
  * \param[in] alt           Interface to identify the memory partition to write to.
  * \param[in] block_num     The block number used to calculate the address to write to.
  * \param[in] data          Buffer containing \p length valid bytes of data.
@@ -0,0 +1,147 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "dfu_flash_writer.h"
+
+static int sector_erased(const dfu_flash_writer_t *writer, size_t sector)
+{
+    return sector < writer->max_sectors &&
+           (writer->erased[sector / 32] & (1u << (sector % 32))) != 0;
+}
+
+static void sector_erased_set(dfu_flash_writer_t *writer, size_t sector, int erased)
+{
+    if (sector >= writer->max_sectors) {
+        return;
+    }
+    if (erased) {
+        writer->erased[sector / 32] |= 1u << (sector % 32);
+    } else {
+        writer->erased[sector / 32] &= ~(1u << (sector % 32));
+    }
+}
+
+static unsigned sector_address(const dfu_flash_writer_t *writer, size_t sector)
+{
+    return writer->base + sector * writer->sector_size;
+}
+
+void dfu_flash_writer_init(dfu_flash_writer_t *writer,
+                           const dfu_flash_ops_t *ops,
+                           size_t sector_size,
+                           uint8_t *sector_buf,
+                           uint32_t *erased,
+                           size_t max_sectors)
+{
+    memset(writer, 0, sizeof(*writer));
+    writer->ops = ops;
+    writer->sector_size = sector_size;
+    writer->sector_buf = sector_buf;
+    writer->erased = erased;
+    writer->max_sectors = max_sectors;
+    writer->cur_sector = -1;
+}
+
+void dfu_flash_writer_begin(dfu_flash_writer_t *writer, unsigned base, size_t size)
+{
+    writer->base = base;
+    writer->size = size;
+    writer->expected = 0;
+    writer->cur_sector = -1;
+    writer->cur_mark = 0;
+    memset(writer->erased, 0, DFU_FLASH_WRITER_BITMAP_WORDS(writer->max_sectors) * sizeof(uint32_t));
+    memset(&writer->stats, 0, sizeof(writer->stats));
+}
+
+void dfu_flash_writer_expect(dfu_flash_writer_t *writer, size_t len)
+{
+    writer->expected = (len < writer->size) ? len : writer->size;
+}
+
+/* Write data that lies within one sector */
+static void write_in_sector(dfu_flash_writer_t *writer,
+                            size_t sector,
+                            size_t offset,
+                            const uint8_t *data,
+                            size_t len)
+{
+    const dfu_flash_ops_t *ops = writer->ops;
+    unsigned address = sector_address(writer, sector);
+
+    if ((int32_t)sector == writer->cur_sector && offset >= writer->cur_mark) {
+        /* Follows the data last written to this sector */
+        ops->write(ops->ctx, data, address + offset, len);
+    } else if (sector_erased(writer, sector)) {
+        /* Erased ahead, or erased with nothing written yet */
+        sector_erased_set(writer, sector, 0);
+        ops->write(ops->ctx, data, address + offset, len);
+    } else if (offset == 0 && len == writer->sector_size) {
+        /* Overwrites the whole sector, so there is nothing to keep */
+        ops->erase(ops->ctx, address, writer->sector_size);
+        ops->write(ops->ctx, data, address, len);
+        writer->stats.sector_erases++;
+    } else {
+        /* Keep the rest of the sector */
+        ops->read(ops->ctx, writer->sector_buf, address, writer->sector_size);
+        memcpy(writer->sector_buf + offset, data, len);
+        ops->erase(ops->ctx, address, writer->sector_size);
+        ops->write(ops->ctx, writer->sector_buf, address, writer->sector_size);
+        writer->stats.sector_reads++;
+        writer->stats.sector_erases++;
+        offset = 0;
+        len = writer->sector_size;
+    }
+    writer->stats.programs++;
+
+    if ((int32_t)sector != writer->cur_sector || offset + len > writer->cur_mark) {
+        writer->cur_mark = offset + len;
+    }
+    writer->cur_sector = sector;
+}
+
+int dfu_flash_writer_write(dfu_flash_writer_t *writer,
+                           size_t offset,
+                           const uint8_t *data,
+                           size_t len)
+{
+    if (offset > writer->size || len > writer->size - offset) {
+        return -1;
+    }
+    writer->stats.writes++;
+
+    while (len > 0) {
+        size_t sector = offset / writer->sector_size;
+        size_t sector_offset = offset % writer->sector_size;
+        size_t n = writer->sector_size - sector_offset;
+
+        if (n > len) {
+            n = len;
+        }
+        write_in_sector(writer, sector, sector_offset, data, n);
+        offset += n;
+        data += n;
+        len -= n;
+    }
+    return 0;
+}
+
+int dfu_flash_writer_erase_ahead(dfu_flash_writer_t *writer)
+{
+    size_t next = writer->cur_sector + 1;
+
+    if (writer->cur_sector < 0 ||
+        next >= writer->max_sectors ||
+        (next + 1) * writer->sector_size > writer->expected ||
+        sector_erased(writer, next)) {
+        return 0;
+    }
+
+    writer->ops->erase(writer->ops->ctx, sector_address(writer, next), writer->sector_size);
+    sector_erased_set(writer, next, 1);
+    writer->stats.sectors_erased_ahead++;
+    return 1;
+}
@@ -0,0 +1,140 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef DFU_FLASH_WRITER_H_
+#define DFU_FLASH_WRITER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Writes a DFU download to flash with as few flash operations as possible.
+ *
+ * The writer tracks which sectors of the partition being downloaded it has
+ * erased, and how far it has programmed the sector last written. Data that
+ * lands in erased flash is programmed without an erase. A sector that is
+ * overwritten completely is erased and programmed without reading it back
+ * first. Only a write that covers part of a sector holding other data reads
+ * the sector back, to preserve the rest of it.
+ *
+ * Between writes, dfu_flash_writer_erase_ahead() erases the sector following
+ * the one last written, so that the erase is done while the next block of the
+ * download is transferred rather than when it is written. Only sectors that
+ * the download is expected to write, as set by dfu_flash_writer_expect(), are
+ * erased ahead, so that a download shorter than the partition keeps whatever
+ * follows it.
+ *
+ * The writer does no locking, and has no RTOS dependencies, so that it can be
+ * tested on the host against a simulated flash.
+ */
+
+/* Only the xcore compiler needs the function pointer groups */
+#if defined(__XS3A__)
+#define DFU_FLASH_READ_FPTRGROUP    __attribute__((fptrgroup("dfu_flash_read_fptr_grp")))
+#define DFU_FLASH_WRITE_FPTRGROUP   __attribute__((fptrgroup("dfu_flash_write_fptr_grp")))
+#define DFU_FLASH_ERASE_FPTRGROUP   __attribute__((fptrgroup("dfu_flash_erase_fptr_grp")))
+#else
+#define DFU_FLASH_READ_FPTRGROUP
+#define DFU_FLASH_WRITE_FPTRGROUP
+#define DFU_FLASH_ERASE_FPTRGROUP
+#endif
+
+/* The flash operations, whose implementations must be in the matching
+ * function pointer groups so that the stack they need is known. */
+typedef struct {
+    DFU_FLASH_READ_FPTRGROUP
+    void (*read)(void *ctx, uint8_t *data, unsigned address, size_t len);
+
+    DFU_FLASH_WRITE_FPTRGROUP
+    void (*write)(void *ctx, const uint8_t *data, unsigned address, size_t len);
+
+    DFU_FLASH_ERASE_FPTRGROUP
+    void (*erase)(void *ctx, unsigned address, size_t len);
+
+    void *ctx;
+} dfu_flash_ops_t;
+
+typedef struct {
+    uint32_t writes;
+    uint32_t sector_reads;      // Read-backs of partly overwritten sectors
+    uint32_t sector_erases;     // Erases when a sector was written
+    uint32_t sectors_erased_ahead;
+    uint32_t programs;
+} dfu_flash_writer_stats_t;
+
+typedef struct {
+    const dfu_flash_ops_t *ops;
+    size_t sector_size;
+    uint8_t *sector_buf;        // sector_size bytes for read-backs
+    uint32_t *erased;           // Bitmap of the sectors that are erased
+    size_t max_sectors;         // Sectors beyond this are never known to be erased
+    unsigned base;
+    size_t size;
+    size_t expected;            // Bytes of the partition the download is expected to write
+    int32_t cur_sector;         // Sector last written, -1 for none
+    size_t cur_mark;            // The current sector is erased from here on
+    dfu_flash_writer_stats_t stats;
+} dfu_flash_writer_t;
+
+/* Words of bitmap needed to track max_sectors sectors */
+#define DFU_FLASH_WRITER_BITMAP_WORDS(max_sectors)  (((max_sectors) + 31) / 32)
+
+/**
+ * Initialize a writer.
+ *
+ * \param writer        The writer.
+ * \param ops           The flash operations, which must remain valid.
+ * \param sector_size   The flash sector size in bytes.
+ * \param sector_buf    A buffer of sector_size bytes.
+ * \param erased        A bitmap of DFU_FLASH_WRITER_BITMAP_WORDS(max_sectors)
+ *                      words.
+ * \param max_sectors   The number of sectors the bitmap tracks.
+ */
+void dfu_flash_writer_init(dfu_flash_writer_t *writer,
+                           const dfu_flash_ops_t *ops,
+                           size_t sector_size,
+                           uint8_t *sector_buf,
+                           uint32_t *erased,
+                           size_t max_sectors);
+
+/**
+ * Start a download to a partition. Nothing in the partition is known to be
+ * erased until the writer erases it, and no sectors are erased ahead until
+ * dfu_flash_writer_expect() is called. The statistics are reset.
+ *
+ * \param base          The address of the partition, a multiple of the
+ *                      sector size.
+ * \param size          The size of the partition in bytes.
+ */
+void dfu_flash_writer_begin(dfu_flash_writer_t *writer, unsigned base, size_t size);
+
+/**
+ * Set how much of the partition the download is expected to write, when this
+ * is known. Sectors that lie wholly within the first len bytes of the
+ * partition may be erased ahead.
+ *
+ * \param len           Bytes from the start of the partition.
+ */
+void dfu_flash_writer_expect(dfu_flash_writer_t *writer, size_t len);
+
+/**
+ * Write data to the partition.
+ *
+ * \param offset        The offset into the partition.
+ * \returns             0 on success, or -1 if the data does not fit the
+ *                      partition.
+ */
+int dfu_flash_writer_write(dfu_flash_writer_t *writer,
+                           size_t offset,
+                           const uint8_t *data,
+                           size_t len);
+
+/**
+ * Erase the sector following the sector last written, if the download is
+ * expected to write all of it and it is not already erased.
+ *
+ * \returns             1 if a sector was erased, otherwise 0.
+ */
+int dfu_flash_writer_erase_ahead(dfu_flash_writer_t *writer);
+
+#endif /* DFU_FLASH_WRITER_H_ */
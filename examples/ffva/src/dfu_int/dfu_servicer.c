@@ -14,6 +14,7 @@
 #include "platform/platform_conf.h"
 #include "servicer.h"
 #include "dfu_servicer.h"
+#include "profile_servicer.h"
 
 #include "dfu_cmds.h"
 #include "device_control_i2c.h"
@@ -37,6 +38,11 @@ void dfu_servicer_init(servicer_t *servicer)
     servicer->res_info[0].resource = DFU_CONTROLLER_SERVICER_RESID;
     servicer->res_info[0].command_map.num_commands = NUM_DFU_CONTROLLER_SERVICER_RESID_CMDS;
     servicer->res_info[0].command_map.commands = dfu_controller_servicer_resid_cmd_map;
+#if appconfPROFILE_ENABLED
+    // The profiling probes of this tile are read over the same transport
+    profile_servicer_res_info_init(&servicer->res_info[1]);
+#endif
+    servicer_index_init(servicer);
 }
 
 void dfu_servicer(void *args) {
@@ -76,6 +82,7 @@ void dfu_servicer(void *args) {
     }
 }
 
+CONTROL_CMD_READ_FPTRGROUP
 control_ret_t dfu_servicer_read_cmd(control_resource_info_t *res_info, control_cmd_t cmd, uint8_t *payload, size_t payload_len)
 {
     control_ret_t ret = CONTROL_SUCCESS;
@@ -160,6 +167,7 @@ control_ret_t dfu_servicer_read_cmd(control_resource_info_t *res_info, control_c
     return ret;
 }
 
+CONTROL_CMD_WRITE_FPTRGROUP
 control_ret_t dfu_servicer_write_cmd(control_resource_info_t *res_info, control_cmd_t cmd, const uint8_t *payload, size_t payload_len)
 {
     control_ret_t ret = CONTROL_SUCCESS;
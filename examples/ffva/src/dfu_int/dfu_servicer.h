@@ -3,9 +3,10 @@
 #pragma once
 
 #include "servicer.h"
+#include "profile.h"
 
 #define DFU_CONTROLLER_SERVICER_RESID   (240)
-#define NUM_RESOURCES_DFU_SERVICER      (1) // DFU servicer
+#define NUM_RESOURCES_DFU_SERVICER      (1 + appconfPROFILE_ENABLED) // DFU servicer, and profiling when enabled
 
 /**
  * @brief DFU servicer task.
@@ -29,10 +29,12 @@
 #if appconfINTENT_ENABLED
 #include "intent_engine.h"
 #include "intent_handler.h"
-#include "fs_support.h"
 #include "gpi_ctrl.h"
 #include "leds.h"
 #endif
+#if appconfINTENT_ENABLED || appconfAUDIO_PIPELINE_GRAPH_FILE_ENABLED
+#include "fs_support.h"
+#endif
 #include "gpio_test/gpio_test.h"
 
 /* Config headers for sw_pll */
@@ -378,7 +380,7 @@ void startup_task(void *arg)
 
 #if appconfI2C_DFU_ENABLED && ON_TILE(I2C_CTRL_TILE_NO)
     // Initialise control related things
-    servicer_t servicer_dfu;
+    static servicer_t servicer_dfu; // Holds the command index tables, too large for the stack
     dfu_servicer_init(&servicer_dfu);
 
     xTaskCreate(
@@ -399,15 +401,19 @@ void startup_task(void *arg)
     gpio_gpi_init(gpio_ctx_t0);
 #endif
 
-#if appconfINTENT_ENABLED && ON_TILE(FS_TILE_NO)
+#if (appconfINTENT_ENABLED || appconfAUDIO_PIPELINE_GRAPH_FILE_ENABLED) && ON_TILE(FS_TILE_NO)
+    // The pipeline graph file is read by audio_pipeline_init()
     rtos_fatfs_init(qspi_flash_ctx);
+#endif
+
+#if appconfINTENT_ENABLED && ON_TILE(FS_TILE_NO)
     // Setup flash low-level mode
     //   NOTE: must call rtos_qspi_flash_fast_read_shutdown_ll to use non low-level mode calls
     rtos_qspi_flash_fast_read_setup_ll(qspi_flash_ctx);
 #endif
 
 #if appconfINTENT_ENABLED && ON_TILE(ASR_TILE_NO)
-    QueueHandle_t q_intent = xQueueCreate(appconfINTENT_QUEUE_LEN, sizeof(int32_t));
+    QueueHandle_t q_intent = xQueueCreate(appconfINTENT_QUEUE_LEN, sizeof(intent_message_t));
     intent_handler_create(appconfINTENT_MODEL_RUNNER_TASK_PRIORITY, q_intent);
     intent_engine_create(appconfINTENT_MODEL_RUNNER_TASK_PRIORITY, q_intent);
 #endif
@@ -0,0 +1,32 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#pragma once
+
+#include <stdint.h>
+
+// PROFILE_SERVICER_RESID commands
+enum e_profile_servicer_resid_cmds
+{
+#ifndef PROFILE_SERVICER_RESID_NUM_PROBES
+    PROFILE_SERVICER_RESID_NUM_PROBES = 0,
+#endif
+#ifndef PROFILE_SERVICER_RESID_PROBE_INDEX
+    PROFILE_SERVICER_RESID_PROBE_INDEX = 1,
+#endif
+#ifndef PROFILE_SERVICER_RESID_PROBE_STATS
+    PROFILE_SERVICER_RESID_PROBE_STATS = 2,
+#endif
+#ifndef PROFILE_SERVICER_RESID_RESET
+    PROFILE_SERVICER_RESID_RESET = 3,
+#endif
+#ifndef PROFILE_SERVICER_RESID_DUMP
+    PROFILE_SERVICER_RESID_DUMP = 4,
+#endif
+    NUM_PROFILE_SERVICER_RESID_CMDS = 5
+};
+
+// PROFILE_SERVICER_RESID_PROBE_STATS payload: the probe name, NUL padded, then
+// count, min, avg, max and p99 as little endian uint32 values, in reference clock ticks
+#define PROFILE_SERVICER_RESID_PROBE_STATS_NAME_LEN     (16)
+#define PROFILE_SERVICER_RESID_PROBE_STATS_NUM_VALUES   (PROFILE_SERVICER_RESID_PROBE_STATS_NAME_LEN + 5 * sizeof(uint32_t))
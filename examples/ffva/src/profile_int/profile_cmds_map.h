@@ -0,0 +1,18 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunused-variable"
+
+// PROFILE_SERVICER_RESID command map
+// This array may be unused as servicers can be moved between tiles
+// Unused variable warnings are suppressed in this header file
+static control_cmd_info_t profile_servicer_resid_cmd_map[] =
+{
+    { PROFILE_SERVICER_RESID_NUM_PROBES, 1, sizeof(uint8_t), CMD_READ_ONLY, profile_servicer_read_cmd, NULL },
+    { PROFILE_SERVICER_RESID_PROBE_INDEX, 1, sizeof(uint8_t), CMD_READ_WRITE, profile_servicer_read_cmd, profile_servicer_write_cmd },
+    { PROFILE_SERVICER_RESID_PROBE_STATS, PROFILE_SERVICER_RESID_PROBE_STATS_NUM_VALUES, sizeof(uint8_t), CMD_READ_ONLY, profile_servicer_read_cmd, NULL },
+    { PROFILE_SERVICER_RESID_RESET, 1, sizeof(uint8_t), CMD_WRITE_ONLY, NULL, profile_servicer_write_cmd },
+    { PROFILE_SERVICER_RESID_DUMP, 1, sizeof(uint8_t), CMD_WRITE_ONLY, NULL, profile_servicer_write_cmd },
+};
+#pragma clang diagnostic pop
@@ -0,0 +1,113 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#define DEBUG_UNIT PROFILE_SERVICER
+#ifndef DEBUG_PRINT_ENABLE_PROFILE_SERVICER
+#define DEBUG_PRINT_ENABLE_PROFILE_SERVICER 0
+#endif
+#include "debug_print.h"
+
+#include <string.h>
+
+#include "app_conf.h"
+#include "servicer.h"
+#include "profile_servicer.h"
+#include "profile_cmds.h"
+#include "profile.h"
+
+static uint8_t probe_index;
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = (v >> 24) & 0xFF;
+}
+
+void profile_servicer_res_info_init(control_resource_info_t *res_info)
+{
+    #include "profile_cmds_map.h" // Included instead of directly adding code to match the other command maps.
+
+    res_info->resource = PROFILE_SERVICER_RESID;
+    res_info->command_map.num_commands = NUM_PROFILE_SERVICER_RESID_CMDS;
+    res_info->command_map.commands = profile_servicer_resid_cmd_map;
+}
+
+CONTROL_CMD_READ_FPTRGROUP
+control_ret_t profile_servicer_read_cmd(control_resource_info_t *res_info, control_cmd_t cmd, uint8_t *payload, size_t payload_len)
+{
+    control_ret_t ret = CONTROL_SUCCESS;
+    uint8_t cmd_id = CONTROL_CMD_CLEAR_READ(cmd);
+
+    memset(payload, 0, payload_len);
+
+    debug_printf("profile_servicer_read_cmd, cmd_id: %d.\n", cmd_id);
+
+    switch (cmd_id)
+    {
+    case PROFILE_SERVICER_RESID_NUM_PROBES:
+        payload[0] = (uint8_t)profile_probe_count();
+        break;
+
+    case PROFILE_SERVICER_RESID_PROBE_INDEX:
+        payload[0] = probe_index;
+        break;
+
+    case PROFILE_SERVICER_RESID_PROBE_STATS:
+    {
+        profile_stats_t stats;
+        uint8_t *values = &payload[PROFILE_SERVICER_RESID_PROBE_STATS_NAME_LEN];
+
+        if (profile_stats_get(probe_index, &stats) != 0) {
+            ret = CONTROL_ERROR;
+            break;
+        }
+        strncpy((char *)payload, stats.name, PROFILE_SERVICER_RESID_PROBE_STATS_NAME_LEN - 1);
+        put_u32(&values[0], stats.count);
+        put_u32(&values[4], stats.min_ticks);
+        put_u32(&values[8], stats.avg_ticks);
+        put_u32(&values[12], stats.max_ticks);
+        put_u32(&values[16], stats.p99_ticks);
+        break;
+    }
+
+    default:
+        debug_printf("PROFILE_SERVICER UNHANDLED COMMAND!!!\n");
+        ret = CONTROL_BAD_COMMAND;
+        break;
+    }
+
+    return ret;
+}
+
+CONTROL_CMD_WRITE_FPTRGROUP
+control_ret_t profile_servicer_write_cmd(control_resource_info_t *res_info, control_cmd_t cmd, const uint8_t *payload, size_t payload_len)
+{
+    control_ret_t ret = CONTROL_SUCCESS;
+    uint8_t cmd_id = CONTROL_CMD_CLEAR_READ(cmd);
+
+    debug_printf("profile_servicer_write_cmd cmd_id %d.\n", cmd_id);
+
+    switch (cmd_id)
+    {
+    case PROFILE_SERVICER_RESID_PROBE_INDEX:
+        probe_index = payload[0];
+        break;
+
+    case PROFILE_SERVICER_RESID_RESET:
+        profile_reset();
+        break;
+
+    case PROFILE_SERVICER_RESID_DUMP:
+        // Printed over xscope, for when the statistics of every probe are wanted at once
+        profile_dump();
+        break;
+
+    default:
+        debug_printf("PROFILE_SERVICER UNHANDLED COMMAND!!!\n");
+        ret = CONTROL_BAD_COMMAND;
+        break;
+    }
+
+    return ret;
+}
@@ -0,0 +1,41 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#pragma once
+
+#include "servicer.h"
+
+#define PROFILE_SERVICER_RESID          (241)
+
+/**
+ * @brief Set up the profiling resource.
+ *
+ * The resource gives the host access to the profiling probes of the tile the
+ * servicer runs on. It has no task of its own and is added to another servicer.
+ *
+ * \param res_info      Resource info to initialise
+ */
+void profile_servicer_res_info_init(control_resource_info_t *res_info);
+
+/**
+ * @brief Profiling resource read command handler
+ *
+ * @param res_info          Resource info of the current command
+ * @param cmd               Command ID of this command
+ * @param payload           Pointer to the payload to fill with the read data
+ * @param payload_len       Length in bytes of the read command payload
+ * @return control_ret_t    CONTROL_SUCCESS if command handled successfully,
+ *                          otherwise control_ret_t error status indicating the error.
+ */
+control_ret_t profile_servicer_read_cmd(control_resource_info_t *res_info, control_cmd_t cmd, uint8_t *payload, size_t payload_len);
+
+/**
+ * @brief Profiling resource write command handler
+ *
+ * @param res_info          Resource info of the current command
+ * @param cmd               Command ID of this command
+ * @param payload           Pointer to the payload that contains the write data
+ * @param payload_len       Length in bytes of the write command payload
+ * @return control_ret_t    CONTROL_SUCCESS if command handled successfully,
+ *                          otherwise control_ret_t error status indicating the error.
+ */
+control_ret_t profile_servicer_write_cmd(control_resource_info_t *res_info, control_cmd_t cmd, const uint8_t *payload, size_t payload_len);
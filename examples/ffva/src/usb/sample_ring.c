@@ -0,0 +1,232 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "sample_ring.h"
+
+/* Positions run over twice the capacity so that a full ring differs from an empty one */
+static inline uint32_t ring_advance(const sample_ring_t *ring, uint32_t pos, uint32_t n)
+{
+    pos += n;
+    return (pos >= 2 * ring->capacity) ? pos - 2 * ring->capacity : pos;
+}
+
+static inline uint32_t ring_distance(const sample_ring_t *ring, uint32_t head, uint32_t tail)
+{
+    return (head >= tail) ? head - tail : head + 2 * ring->capacity - tail;
+}
+
+static inline int32_t *ring_frame(const sample_ring_t *ring, uint32_t pos)
+{
+    return &ring->buf[((pos >= ring->capacity) ? pos - ring->capacity : pos) * ring->num_chans];
+}
+
+/* a + (b - a) * num / den */
+static inline int32_t xfade(int32_t a, int32_t b, int32_t num, int32_t den)
+{
+    return a + (int32_t)(((int64_t)b - a) * num / den);
+}
+
+/* Copy n frames from the ring starting at pos, in up to two pieces */
+static void ring_copy_out(const sample_ring_t *ring, int32_t *frames, uint32_t pos, uint32_t n)
+{
+    uint32_t idx = (pos >= ring->capacity) ? pos - ring->capacity : pos;
+    uint32_t first = ring->capacity - idx;
+
+    if (first > n) {
+        first = n;
+    }
+    memcpy(frames, &ring->buf[idx * ring->num_chans], first * ring->num_chans * sizeof(int32_t));
+    memcpy(&frames[first * ring->num_chans], ring->buf, (n - first) * ring->num_chans * sizeof(int32_t));
+}
+
+/* Fade from the last frame returned to silence over n frames */
+static void fade_out(sample_ring_t *ring, int32_t *frames, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        for (uint32_t ch = 0; ch < ring->num_chans; ch++) {
+            frames[i * ring->num_chans + ch] = xfade(ring->last[ch], 0, i + 1, n);
+        }
+    }
+    memset(ring->last, 0, sizeof(ring->last));
+}
+
+void sample_ring_init(sample_ring_t *ring,
+                      int32_t *storage,
+                      uint32_t capacity,
+                      uint32_t num_chans,
+                      uint32_t start_level,
+                      uint32_t target_level,
+                      uint32_t slack)
+{
+    assert(storage != NULL);
+    assert(capacity > 0);
+    assert((num_chans > 0) && (num_chans <= SAMPLE_RING_MAX_CHANS));
+    assert((start_level > 0) && (start_level <= capacity));
+
+    memset(ring, 0, sizeof(sample_ring_t));
+    ring->buf = storage;
+    ring->capacity = capacity;
+    ring->num_chans = num_chans;
+    ring->start_level = start_level;
+    ring->target_level = target_level;
+    ring->slack = slack;
+}
+
+size_t sample_ring_write(sample_ring_t *ring, const int32_t *frames, size_t n)
+{
+    uint32_t head = ring->head;
+    /* Acquire ensures the consumer has finished with the frames before they are overwritten */
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    uint32_t space = ring->capacity - ring_distance(ring, head, tail);
+    uint32_t count = (n < space) ? n : space;
+    uint32_t idx = (head >= ring->capacity) ? head - ring->capacity : head;
+    uint32_t first = ring->capacity - idx;
+
+    if (first > count) {
+        first = count;
+    }
+    memcpy(&ring->buf[idx * ring->num_chans], frames, first * ring->num_chans * sizeof(int32_t));
+    memcpy(ring->buf, &frames[first * ring->num_chans], (count - first) * ring->num_chans * sizeof(int32_t));
+
+    /* Release publishes the frames before the new head */
+    __atomic_store_n(&ring->head, ring_advance(ring, head, count), __ATOMIC_RELEASE);
+
+    ring->frames_written += count;
+    ring->overflow_frames += n - count;
+    return count;
+}
+
+size_t sample_ring_read(sample_ring_t *ring, int32_t *frames, size_t n)
+{
+    const uint32_t num_chans = ring->num_chans;
+    uint32_t tail = ring->tail;
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint32_t flush_req = __atomic_load_n(&ring->flush_req, __ATOMIC_ACQUIRE);
+    uint32_t level;
+    uint32_t consume;
+    int fade_in = 0;
+
+    assert(n >= 2);
+
+    if (flush_req != ring->flush_ack) {
+        ring->flush_ack = flush_req;
+        tail = head;
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+        ring->running = 0;
+    }
+
+    level = ring_distance(ring, head, tail);
+    ring->avg_level_q16 += (((int32_t)level << 16) - ring->avg_level_q16) >> SAMPLE_RING_AVG_SHIFT;
+
+    if (!ring->running) {
+        if (level < ring->start_level || level < n) {
+            fade_out(ring, frames, n);
+            return 0;
+        }
+        ring->running = 1;
+        ring->avg_level_q16 = (int32_t)level << 16;
+        ring->min_level = level;
+        ring->max_level = level;
+        fade_in = 1;
+    }
+
+    if (level < ring->min_level) {
+        ring->min_level = level;
+    }
+    if (level > ring->max_level) {
+        ring->max_level = level;
+    }
+
+    if (level < n) {
+        /* Out of frames: return what there is and fade the rest to silence */
+        if (level > 0) {
+            ring_copy_out(ring, frames, tail, level);
+            memcpy(ring->last, &frames[(level - 1) * num_chans], num_chans * sizeof(int32_t));
+        }
+        fade_out(ring, &frames[level * num_chans], n - level);
+        __atomic_store_n(&ring->tail, ring_advance(ring, tail, level), __ATOMIC_RELEASE);
+        ring->running = 0;
+        ring->underflow_count++;
+        ring->frames_read += level;
+        return level;
+    }
+
+    if (!fade_in && level > n && ring->avg_level_q16 > ((int32_t)ring->target_level + (int32_t)ring->slack) * 65536) {
+        /*
+         * Drop a frame: crossfade from the frames to the frames one later, so
+         * that the last frame returned is the last frame consumed.
+         */
+        for (size_t i = 0; i < n; i++) {
+            const int32_t *a = ring_frame(ring, ring_advance(ring, tail, i));
+            const int32_t *b = ring_frame(ring, ring_advance(ring, tail, i + 1));
+            for (uint32_t ch = 0; ch < num_chans; ch++) {
+                frames[i * num_chans + ch] = xfade(a[ch], b[ch], i + 1, n);
+            }
+        }
+        consume = n + 1;
+        ring->avg_level_q16 -= 1 << 16;
+        ring->drop_count++;
+    } else if (!fade_in && ring->avg_level_q16 < ((int32_t)ring->target_level - (int32_t)ring->slack) * 65536) {
+        /*
+         * Insert a frame: crossfade from the frames to the frames one earlier,
+         * starting from the last frame returned, so that the last frame
+         * returned is the last frame consumed.
+         */
+        for (size_t i = 0; i < n; i++) {
+            const int32_t *a = ring_frame(ring, ring_advance(ring, tail, (i < n - 1) ? i : n - 2));
+            const int32_t *b = (i == 0) ? ring->last : ring_frame(ring, ring_advance(ring, tail, i - 1));
+            for (uint32_t ch = 0; ch < num_chans; ch++) {
+                frames[i * num_chans + ch] = xfade(a[ch], b[ch], i + 1, n);
+            }
+        }
+        consume = n - 1;
+        ring->avg_level_q16 += 1 << 16;
+        ring->insert_count++;
+    } else {
+        ring_copy_out(ring, frames, tail, n);
+        consume = n;
+        if (fade_in) {
+            for (size_t i = 0; i < n; i++) {
+                for (uint32_t ch = 0; ch < num_chans; ch++) {
+                    frames[i * num_chans + ch] = xfade(0, frames[i * num_chans + ch], i + 1, n);
+                }
+            }
+        }
+    }
+
+    memcpy(ring->last, &frames[(n - 1) * num_chans], num_chans * sizeof(int32_t));
+    __atomic_store_n(&ring->tail, ring_advance(ring, tail, consume), __ATOMIC_RELEASE);
+    ring->frames_read += consume;
+    return consume;
+}
+
+void sample_ring_flush(sample_ring_t *ring)
+{
+    __atomic_fetch_add(&ring->flush_req, 1, __ATOMIC_RELEASE);
+}
+
+uint32_t sample_ring_level(const sample_ring_t *ring)
+{
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+    return ring_distance(ring, head, tail);
+}
+
+void sample_ring_stats_get(const sample_ring_t *ring, sample_ring_stats_t *stats)
+{
+    stats->level = sample_ring_level(ring);
+    stats->avg_level_q16 = ring->avg_level_q16;
+    stats->min_level = ring->min_level;
+    stats->max_level = ring->max_level;
+    stats->frames_written = ring->frames_written;
+    stats->frames_read = ring->frames_read;
+    stats->overflow_frames = ring->overflow_frames;
+    stats->underflow_count = ring->underflow_count;
+    stats->drop_count = ring->drop_count;
+    stats->insert_count = ring->insert_count;
+}
@@ -0,0 +1,156 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef SAMPLE_RING_H_
+#define SAMPLE_RING_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Single producer, single consumer ring of interleaved audio frames, used
+ * between the USB audio callbacks and the audio pipeline.
+ *
+ * The producer and consumer each own one position, so the ring takes no lock
+ * and one task may write while another reads. The positions are kept on
+ * separate cache lines on hosts that have them.
+ *
+ * The consumer always gets the number of frames it asks for, and keeps the
+ * level of the ring close to a target without hard resets:
+ * - Output starts once the ring holds start_level frames.
+ * - When the smoothed level is more than slack frames above the target, a
+ *   read consumes one frame more than it returns. When it is more than slack
+ *   frames below, a read consumes one frame fewer. The slip is crossfaded
+ *   over the frames returned.
+ * - A read that runs out of frames fades to silence and output restarts, with
+ *   a fade in, when the ring is back to start_level.
+ * Frames the producer writes into a full ring are dropped and counted.
+ *
+ * The ring has no RTOS dependencies so that it can be tested on the host.
+ */
+
+/* Maximum number of channels in a frame */
+#define SAMPLE_RING_MAX_CHANS       (8)
+
+/* The smoothed level moves 1/2^SAMPLE_RING_AVG_SHIFT of the way to the level at each read */
+#define SAMPLE_RING_AVG_SHIFT       (5)
+
+#if defined(__XS3A__)
+#define SAMPLE_RING_ALIGNED         __attribute__((aligned(8)))
+#else
+#define SAMPLE_RING_ALIGNED         __attribute__((aligned(64)))
+#endif
+
+typedef struct {
+    uint32_t level;             // Frames in the ring
+    int32_t avg_level_q16;      // Smoothed level in frames, Q16.16
+    uint32_t min_level;         // Lowest level at a read since output last started
+    uint32_t max_level;         // Highest level at a read since output last started
+    uint32_t frames_written;
+    uint32_t frames_read;       // Frames consumed, including dropped frames
+    uint32_t overflow_frames;   // Frames written into a full ring
+    uint32_t underflow_count;   // Reads that ran out of frames
+    uint32_t drop_count;        // Frames dropped to lower the level
+    uint32_t insert_count;      // Frames inserted to raise the level
+} sample_ring_stats_t;
+
+typedef struct {
+    int32_t *buf;
+    uint32_t capacity;          // In frames
+    uint32_t num_chans;
+    uint32_t start_level;
+    uint32_t target_level;
+    uint32_t slack;
+
+    /* Written by the producer. The positions are in [0, 2 * capacity) */
+    SAMPLE_RING_ALIGNED
+    volatile uint32_t head;
+    uint32_t frames_written;
+    uint32_t overflow_frames;
+    volatile uint32_t flush_req;    // Incremented by sample_ring_flush(), from either side
+
+    /* Written by the consumer */
+    SAMPLE_RING_ALIGNED
+    volatile uint32_t tail;
+    uint32_t flush_ack;
+    int running;
+    int32_t avg_level_q16;
+    int32_t last[SAMPLE_RING_MAX_CHANS];    // Last frame returned
+    uint32_t min_level;
+    uint32_t max_level;
+    uint32_t frames_read;
+    uint32_t underflow_count;
+    uint32_t drop_count;
+    uint32_t insert_count;
+} sample_ring_t;
+
+/**
+ * Initialize a ring over caller provided storage.
+ *
+ * \param ring          The ring to initialize.
+ * \param storage       capacity * num_chans samples.
+ * \param capacity      Size of the ring in frames.
+ * \param num_chans     Channels per frame, up to SAMPLE_RING_MAX_CHANS.
+ * \param start_level   Level at which output starts. At most capacity.
+ * \param target_level  Smoothed level kept by dropping and inserting frames.
+ * \param slack         Deviation of the smoothed level from target_level
+ *                      allowed before frames are dropped or inserted.
+ */
+void sample_ring_init(sample_ring_t *ring,
+                      int32_t *storage,
+                      uint32_t capacity,
+                      uint32_t num_chans,
+                      uint32_t start_level,
+                      uint32_t target_level,
+                      uint32_t slack);
+
+/**
+ * Write frames to the ring. Producer only.
+ *
+ * \param ring      The ring.
+ * \param frames    n interleaved frames.
+ * \param n         Number of frames.
+ * \return          The number of frames written. The rest did not fit and
+ *                  are dropped.
+ */
+size_t sample_ring_write(sample_ring_t *ring, const int32_t *frames, size_t n);
+
+/**
+ * Read frames from the ring. Consumer only.
+ *
+ * Always returns n frames, which are silence or faded while the ring is
+ * starting or has run out of frames.
+ *
+ * \param ring      The ring.
+ * \param frames    Filled with n interleaved frames.
+ * \param n         Number of frames, at least 2.
+ * \return          The number of frames consumed from the ring.
+ */
+size_t sample_ring_read(sample_ring_t *ring, int32_t *frames, size_t n);
+
+/**
+ * Discard the frames in the ring at the next read, which fades to silence.
+ * Output restarts when the ring is back to start_level. May be called from
+ * the producer or the consumer.
+ *
+ * \param ring      The ring.
+ */
+void sample_ring_flush(sample_ring_t *ring);
+
+/**
+ * Get the number of frames in the ring. May be called from any task.
+ *
+ * \param ring      The ring.
+ * \return          The number of frames in the ring.
+ */
+uint32_t sample_ring_level(const sample_ring_t *ring);
+
+/**
+ * Read the ring telemetry. May be called from any task.
+ *
+ * \param ring      The ring.
+ * \param stats     Filled with the current statistics.
+ */
+void sample_ring_stats_get(const sample_ring_t *ring, sample_ring_stats_t *stats);
+
+#endif /* SAMPLE_RING_H_ */
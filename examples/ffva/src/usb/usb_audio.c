@@ -42,10 +42,12 @@
 #include "tusb.h"
 
 #include "rtos_intertile.h"
+#include "usb_audio.h"
 
 #include "audio_pipeline.h"
 
 #include "app_conf.h"
+#include "profile.h"
 
 // Audio controls
 // Current states
@@ -64,15 +66,41 @@ volatile bool spkr_interface_open = false;
 static uint32_t prev_n_bytes_received = 0;
 static bool host_streaming_out = false;
 
-static StreamBufferHandle_t samples_to_host_stream_buf;
-static StreamBufferHandle_t samples_from_host_stream_buf;
+static sample_ring_t samples_to_host_ring;
+static sample_ring_t samples_from_host_ring;
 static StreamBufferHandle_t rx_buffer;
 static TaskHandle_t usb_audio_out_task_handle;
 
+/* Rate conversion between the 48 kHz USB streams and the 16 kHz pipeline */
+PROFILE_PROBE_DEFINE(usb_src_ds3_probe, "usb_src_ds3");
+PROFILE_PROBE_DEFINE(usb_src_us3_probe, "usb_src_us3");
+
 #define RATE_MULTIPLIER (appconfUSB_AUDIO_SAMPLE_RATE / appconfAUDIO_PIPELINE_SAMPLE_RATE)
 
 #define USB_FRAMES_PER_VFE_FRAME (appconfAUDIO_PIPELINE_FRAME_ADVANCE / (appconfAUDIO_PIPELINE_SAMPLE_RATE / 1000))
 
+/*
+ * The ring to the host holds up to 3 pipeline frames, and output to the host
+ * starts once it holds 2. As the pipeline writes a whole frame at a time, the
+ * level then averages 1.5 frames. Frames are dropped or inserted when the
+ * average drifts more than half a frame from that.
+ */
+#define TO_HOST_RING_FRAMES         (3 * appconfAUDIO_PIPELINE_FRAME_ADVANCE)
+#define TO_HOST_RING_START_LEVEL    (2 * appconfAUDIO_PIPELINE_FRAME_ADVANCE)
+#define TO_HOST_RING_TARGET_LEVEL   (3 * appconfAUDIO_PIPELINE_FRAME_ADVANCE / 2)
+#define TO_HOST_RING_SLACK          (appconfAUDIO_PIPELINE_FRAME_ADVANCE / 2)
+
+/*
+ * The ring from the host is read a pipeline frame at a time, when it holds one
+ * more USB frame than that, so the level at each read is fixed and no frames
+ * are dropped or inserted.
+ */
+#define FROM_HOST_RING_FRAMES       (2 * appconfAUDIO_PIPELINE_FRAME_ADVANCE)
+#define FROM_HOST_RING_NOTIFY_LEVEL (appconfAUDIO_PIPELINE_FRAME_ADVANCE + AUDIO_FRAMES_PER_USB_FRAME / RATE_MULTIPLIER)
+
+static int32_t samples_to_host_ring_buf[TO_HOST_RING_FRAMES * CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_TX];
+static int32_t samples_from_host_ring_buf[FROM_HOST_RING_FRAMES * CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_RX];
+
 //--------------------------------------------------------------------+
 // Device callbacks
 //--------------------------------------------------------------------+
@@ -121,7 +149,7 @@ void usb_audio_send(rtos_intertile_t *intertile_ctx,
                     int32_t **frame_buffers,
                     size_t num_chans)
 {
-    samp_t usb_audio_in_frame[appconfAUDIO_PIPELINE_FRAME_ADVANCE][CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_TX];
+    int32_t usb_audio_in_frame[appconfAUDIO_PIPELINE_FRAME_ADVANCE][CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_TX];
     int32_t *frame_buf_ptr = (int32_t *) frame_buffers;
 
 #if CFG_TUD_AUDIO_FUNC_1_N_BYTES_PER_SAMPLE_TX == 2
@@ -130,7 +158,7 @@ void usb_audio_send(rtos_intertile_t *intertile_ctx,
     const int src_32_shift = 0;
 #endif
 
-    memset(usb_audio_in_frame, 0, sizeof(samp_t) * appconfAUDIO_PIPELINE_FRAME_ADVANCE * CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_TX);
+    memset(usb_audio_in_frame, 0, sizeof(usb_audio_in_frame));
 
     xassert(frame_count == appconfAUDIO_PIPELINE_FRAME_ADVANCE);
 
@@ -143,12 +171,9 @@ void usb_audio_send(rtos_intertile_t *intertile_ctx,
     }
 
     if (mic_interface_open) {
-        if (xStreamBufferSpacesAvailable(samples_to_host_stream_buf) >= sizeof(usb_audio_in_frame)) {
-            xStreamBufferSend(samples_to_host_stream_buf, usb_audio_in_frame, sizeof(usb_audio_in_frame), 0);
-        } else {
+        if (sample_ring_write(&samples_to_host_ring, &usb_audio_in_frame[0][0], appconfAUDIO_PIPELINE_FRAME_ADVANCE) < appconfAUDIO_PIPELINE_FRAME_ADVANCE) {
             rtos_printf("lost VFE output samples\n");
         }
-
     }
 }
 
@@ -201,29 +226,31 @@ void usb_audio_out_task(void *arg)
 
 
     for (;;) {
+        int32_t ring_frames[appconfAUDIO_PIPELINE_FRAME_ADVANCE][CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_RX];
         samp_t usb_audio_out_frame[appconfAUDIO_PIPELINE_FRAME_ADVANCE][CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_RX];
-        size_t bytes_received = 0;
 
         /*
-         * Only wake up when the stream buffer contains a whole audio
+         * Only wake up when the ring contains a whole audio
          * pipeline frame.
          */
         (void) ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
 
-        bytes_received = xStreamBufferReceive(samples_from_host_stream_buf, usb_audio_out_frame, sizeof(usb_audio_out_frame), 0);
-
         /*
-         * This shouldn't normally be zero, but it could be possible that
-         * the stream buffer is reset after this task has been notified.
+         * This shouldn't normally consume nothing, but it could be possible
+         * that the ring is flushed after this task has been notified.
          */
-        if (bytes_received > 0) {
-            xassert(bytes_received == sizeof(usb_audio_out_frame));
+        if (sample_ring_read(&samples_from_host_ring, &ring_frames[0][0], appconfAUDIO_PIPELINE_FRAME_ADVANCE) > 0) {
+            for (int i = 0; i < appconfAUDIO_PIPELINE_FRAME_ADVANCE; i++) {
+                for (int j = 0; j < CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_RX; j++) {
+                    usb_audio_out_frame[i][j] = ring_frames[i][j];
+                }
+            }
 
             rtos_intertile_tx(
                     intertile_ctx,
                     appconfUSB_AUDIO_PORT,
                     usb_audio_out_frame,
-                    bytes_received);
+                    sizeof(usb_audio_out_frame));
         }
     }
 }
@@ -508,7 +535,9 @@ bool tud_audio_rx_done_post_read_cb(uint8_t rhport,
 
     uint8_t rx_data[CFG_TUD_AUDIO_FUNC_1_EP_OUT_SW_BUF_SZ];
     samp_t usb_audio_frames[AUDIO_FRAMES_PER_USB_FRAME][CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_RX];
-    const size_t stream_buffer_send_byte_count = sizeof(usb_audio_frames) / RATE_MULTIPLIER;
+    int32_t ring_frames[AUDIO_FRAMES_PER_USB_FRAME / RATE_MULTIPLIER][CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_RX];
+    const size_t ring_send_frame_count = AUDIO_FRAMES_PER_USB_FRAME / RATE_MULTIPLIER;
+    uint32_t level;
 
     host_streaming_out = true;
     prev_n_bytes_received = n_bytes_received;
@@ -562,49 +591,46 @@ bool tud_audio_rx_done_post_read_cb(uint8_t rhport,
         return true;
     }
 
-    if (xStreamBufferSpacesAvailable(samples_from_host_stream_buf) >= stream_buffer_send_byte_count)
-    {
-        if (RATE_MULTIPLIER == 3) {
+    if (RATE_MULTIPLIER == 3) {
 
-            static int32_t __attribute__((aligned (8))) src_data[CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_RX][SRC_FF3V_FIR_NUM_PHASES][SRC_FF3V_FIR_TAPS_PER_PHASE];
-            samp_t src_audio_frames[AUDIO_FRAMES_PER_USB_FRAME / RATE_MULTIPLIER][CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_RX];
+        static int32_t __attribute__((aligned (8))) src_data[CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_RX][SRC_FF3V_FIR_NUM_PHASES][SRC_FF3V_FIR_TAPS_PER_PHASE];
 
-            for (int i = 0; i < AUDIO_FRAMES_PER_USB_FRAME / RATE_MULTIPLIER; i++) {
-                for (int j = 0; j < CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_RX; j++) {
-                    int64_t sum = 0;
-                    sum = src_ds3_voice_add_sample(sum, src_data[j][0], src_ff3v_fir_coefs[0], usb_audio_frames[3*i + 0][j]);
-                    sum = src_ds3_voice_add_sample(sum, src_data[j][1], src_ff3v_fir_coefs[1], usb_audio_frames[3*i + 1][j]);
-                    src_audio_frames[i][j] = src_ds3_voice_add_final_sample(sum, src_data[j][2], src_ff3v_fir_coefs[2], usb_audio_frames[3*i + 2][j]);
-                }
+        PROFILE_START(usb_src_ds3_probe);
+        for (int i = 0; i < AUDIO_FRAMES_PER_USB_FRAME / RATE_MULTIPLIER; i++) {
+            for (int j = 0; j < CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_RX; j++) {
+                int64_t sum = 0;
+                sum = src_ds3_voice_add_sample(sum, src_data[j][0], src_ff3v_fir_coefs[0], usb_audio_frames[3*i + 0][j]);
+                sum = src_ds3_voice_add_sample(sum, src_data[j][1], src_ff3v_fir_coefs[1], usb_audio_frames[3*i + 1][j]);
+                ring_frames[i][j] = (samp_t)src_ds3_voice_add_final_sample(sum, src_data[j][2], src_ff3v_fir_coefs[2], usb_audio_frames[3*i + 2][j]);
             }
-            xStreamBufferSend(samples_from_host_stream_buf, src_audio_frames, stream_buffer_send_byte_count, 0);
-        } else {
-            xStreamBufferSend(samples_from_host_stream_buf, usb_audio_frames, stream_buffer_send_byte_count, 0);
-        }
-
-        /*
-         * Wake up the task waiting on this buffer whenever there is one more
-         * USB frame worth of audio data than the amount of data required to
-         * be input into the pipeline.
-         *
-         * This way the task will not wake up each time this task puts another
-         * milliseconds of audio into the stream buffer, but rather once every
-         * pipeline frame time.
-         */
-        const size_t buffer_notify_level = stream_buffer_send_byte_count * (1 + USB_FRAMES_PER_VFE_FRAME);
-
-        /*
-         * TODO: If the above is modified such that not exactly AUDIO_FRAMES_PER_USB_FRAME / RATE_MULTIPLIER
-         * frames are written to the stream buffer at a time, then this will need to change to >=.
-         */
-
-        if (xStreamBufferBytesAvailable(samples_from_host_stream_buf) == buffer_notify_level) {
-            xTaskNotifyGive(usb_audio_out_task_handle);
         }
+        PROFILE_END(usb_src_ds3_probe);
     } else {
+        for (int i = 0; i < ring_send_frame_count; i++) {
+            for (int j = 0; j < CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_RX; j++) {
+                ring_frames[i][j] = usb_audio_frames[i][j];
+            }
+        }
+    }
+
+    level = sample_ring_level(&samples_from_host_ring);
+    if (sample_ring_write(&samples_from_host_ring, &ring_frames[0][0], ring_send_frame_count) < ring_send_frame_count) {
         rtos_printf("lost USB output samples\n");
     }
 
+    /*
+     * Wake up the task waiting on this ring whenever there is one more
+     * USB frame worth of audio data than the amount of data required to
+     * be input into the pipeline.
+     *
+     * This way the task will not wake up each time this task puts another
+     * milliseconds of audio into the ring, but rather once every
+     * pipeline frame time.
+     */
+    if (level < FROM_HOST_RING_NOTIFY_LEVEL && sample_ring_level(&samples_from_host_ring) >= FROM_HOST_RING_NOTIFY_LEVEL) {
+        xTaskNotifyGive(usb_audio_out_task_handle);
+    }
+
     return true;
 }
 
@@ -618,14 +644,14 @@ bool tud_audio_tx_done_pre_load_cb(uint8_t rhport,
     (void) ep_in;
     (void) cur_alt_setting;
 
-    static int ready = 0;
-    size_t bytes_available;
     size_t tx_size_bytes;
     size_t tx_size_frames;
+    uint32_t underflow_count;
     /*
-     * This buffer needs to be large enough to hold any size of transaction,
-     * but if it's any bigger than twice nominal then we have bigger issues
+     * These buffers need to be large enough to hold any size of transaction,
+     * but if they're any bigger than twice nominal then we have bigger issues
      */
+    int32_t ring_frames[2 * AUDIO_FRAMES_PER_USB_FRAME / RATE_MULTIPLIER][CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_TX];
     samp_t stream_buffer_audio_frames[2 * AUDIO_FRAMES_PER_USB_FRAME / RATE_MULTIPLIER][CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_TX];
 
     /* This buffer has to be large enough to contain any size transaction */
@@ -651,74 +677,41 @@ bool tud_audio_tx_done_pre_load_cb(uint8_t rhport,
     tx_size_frames = tx_size_bytes / (sizeof(samp_t) * CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_TX);
 
     if (!mic_interface_open) {
-        ready = 0;
         mic_interface_open = true;
     }
 
-    /*
-     * If the buffer becomes full, reset it in an attempt to
-     * maintain a good fill level again.
-     */
-
-    if (xStreamBufferIsFull(samples_to_host_stream_buf)) {
-        xStreamBufferReset(samples_to_host_stream_buf);
-        ready = 0;
-        rtos_printf("Oops buffer is full\n");
-        return true;
-    }
-
-    bytes_available = xStreamBufferBytesAvailable(samples_to_host_stream_buf);
-
-    if (bytes_available >= 2 * sizeof(samp_t) * appconfAUDIO_PIPELINE_FRAME_ADVANCE * CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_TX) {
-        /* wait until we have 2 full audio pipeline output frames in the buffer */
-        ready = 1;
-    }
-
-    if (!ready) {
-        // we need to send something despite not being fully ready
-        //  so, send all zeros
-        memset(usb_audio_frames, 0, tx_size_bytes);
-        tud_audio_write(usb_audio_frames, tx_size_bytes);
-        return true;
-    }
-
-    size_t tx_size_bytes_rate_adjusted = tx_size_bytes / RATE_MULTIPLIER;
     size_t tx_size_frames_rate_adjusted = tx_size_frames / RATE_MULTIPLIER;
 
-    /* We must always output samples equal to what we recv in adaptive
-     * In the event we underflow send 0's. */
-    size_t ready_data_bytes = 0;
-    if (bytes_available >= tx_size_bytes_rate_adjusted) {
-        ready_data_bytes = tx_size_bytes_rate_adjusted;
-    } else {
-        ready_data_bytes = bytes_available;
-        if (RATE_MULTIPLIER == 3) {
-            ready_data_bytes /= RATE_MULTIPLIER;
-            memset(usb_audio_frames, 0, tx_size_bytes);
-        } else {
-            memset(stream_buffer_audio_frames, 0, tx_size_bytes);
-        }
+    /*
+     * We must always output samples equal to what we recv in adaptive.
+     * The ring returns silence until it has filled to 2 audio pipeline
+     * output frames, and fades out if it underflows.
+     */
+    underflow_count = samples_to_host_ring.underflow_count;
+    sample_ring_read(&samples_to_host_ring, &ring_frames[0][0], tx_size_frames_rate_adjusted);
+    if (samples_to_host_ring.underflow_count != underflow_count) {
         rtos_printf("Oops tx buffer underflowed!\n");
     }
 
-    size_t num_rx_total = 0;
-    while(num_rx_total < ready_data_bytes){
-        size_t num_rx =  xStreamBufferReceive(samples_to_host_stream_buf, &stream_buffer_audio_frames[num_rx_total], ready_data_bytes-num_rx_total, 0);
-        num_rx_total += num_rx;
-    }
-
     if (RATE_MULTIPLIER == 3) {
         static int32_t __attribute__((aligned (8))) src_data[CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_TX][SRC_FF3V_FIR_TAPS_PER_PHASE];
 
+        PROFILE_START(usb_src_us3_probe);
         for (int i = 0; i < tx_size_frames_rate_adjusted ; i++) {
             for (int j = 0; j < CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_TX; j++) {
-                usb_audio_frames[3*i + 0][j] = src_us3_voice_input_sample(src_data[j], src_ff3v_fir_coefs[2], (int32_t)stream_buffer_audio_frames[i][j]);
+                usb_audio_frames[3*i + 0][j] = src_us3_voice_input_sample(src_data[j], src_ff3v_fir_coefs[2], ring_frames[i][j]);
                 usb_audio_frames[3*i + 1][j] = src_us3_voice_get_next_sample(src_data[j], src_ff3v_fir_coefs[1]);
                 usb_audio_frames[3*i + 2][j] = src_us3_voice_get_next_sample(src_data[j], src_ff3v_fir_coefs[0]);
             }
         }
+        PROFILE_END(usb_src_us3_probe);
         tud_audio_write(usb_audio_frames, tx_size_bytes);
     } else {
+        for (int i = 0; i < tx_size_frames_rate_adjusted; i++) {
+            for (int j = 0; j < CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_TX; j++) {
+                stream_buffer_audio_frames[i][j] = ring_frames[i][j];
+            }
+        }
         tud_audio_write(stream_buffer_audio_frames, tx_size_bytes);
     }
     return true;
@@ -753,7 +746,7 @@ bool tud_audio_set_itf_cb(uint8_t rhport,
         /* In case the interface is reset without
          * closing it first */
         spkr_interface_open = false;
-        xStreamBufferReset(samples_from_host_stream_buf);
+        sample_ring_flush(&samples_from_host_ring);
         xStreamBufferReset(rx_buffer);
     }
 #endif
@@ -762,7 +755,7 @@ bool tud_audio_set_itf_cb(uint8_t rhport,
         /* In case the interface is reset without
          * closing it first */
         mic_interface_open = false;
-        xStreamBufferReset(samples_to_host_stream_buf);
+        sample_ring_flush(&samples_to_host_ring);
     }
 #endif
 
@@ -809,20 +802,27 @@ void usb_audio_init(rtos_intertile_t *intertile_ctx,
 
     rx_buffer = xStreamBufferCreate(2 * CFG_TUD_AUDIO_FUNC_1_EP_OUT_SW_BUF_SZ, 0);
 
-    /*
-     * Note: Given the way that the USB callback notifies usb_audio_out_task,
-     * the size of this buffer MUST NOT be greater than 2 VFE frames.
-     */
-    samples_from_host_stream_buf = xStreamBufferCreate(2 * sizeof(samp_t) * appconfAUDIO_PIPELINE_FRAME_ADVANCE * CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_RX,
-                                            0);
-
-    /*
-     * Note: The USB callback waits until there are at least 2 VFE frames
-     * in this buffer before starting to send to the host, so the size of
-     * this buffer MUST be AT LEAST 2 VFE frames.
-     */
-    samples_to_host_stream_buf = xStreamBufferCreate(3 * sizeof(samp_t) * appconfAUDIO_PIPELINE_FRAME_ADVANCE * CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_TX,
-                                            0);
+    sample_ring_init(&samples_from_host_ring,
+                     samples_from_host_ring_buf,
+                     FROM_HOST_RING_FRAMES,
+                     CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_RX,
+                     FROM_HOST_RING_NOTIFY_LEVEL,
+                     FROM_HOST_RING_NOTIFY_LEVEL,
+                     FROM_HOST_RING_FRAMES);
+
+    sample_ring_init(&samples_to_host_ring,
+                     samples_to_host_ring_buf,
+                     TO_HOST_RING_FRAMES,
+                     CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_TX,
+                     TO_HOST_RING_START_LEVEL,
+                     TO_HOST_RING_TARGET_LEVEL,
+                     TO_HOST_RING_SLACK);
 
     xTaskCreate((TaskFunction_t) usb_audio_out_task, "usb_audio_out_task", portTASK_STACK_DEPTH(usb_audio_out_task), intertile_ctx, priority, &usb_audio_out_task_handle);
 }
+
+void usb_audio_ring_stats_get(sample_ring_stats_t *to_host, sample_ring_stats_t *from_host)
+{
+    sample_ring_stats_get(&samples_to_host_ring, to_host);
+    sample_ring_stats_get(&samples_from_host_ring, from_host);
+}
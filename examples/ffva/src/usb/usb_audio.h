@@ -4,6 +4,8 @@
 #ifndef USB_AUDIO_H_
 #define USB_AUDIO_H_
 
+#include "sample_ring.h"
+
 /*
  * frame_buffers format assumes:
  *   processed_audio_frame
@@ -27,5 +29,11 @@ void usb_audio_recv(rtos_intertile_t *intertile_ctx,
 
 void usb_audio_init(rtos_intertile_t *intertile_ctx, unsigned priority);
 
+/*
+ * Level telemetry of the rings between the USB audio callbacks
+ * and the audio pipeline, for the audio to and from the host.
+ */
+void usb_audio_ring_stats_get(sample_ring_stats_t *to_host, sample_ring_stats_t *from_host);
+
 
 #endif /* USB_AUDIO_H_ */
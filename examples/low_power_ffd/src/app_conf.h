@@ -100,6 +100,16 @@
 #define appconfAUDIO_PIPELINE_BUFFER_NUM_FRAMES 20
 #endif
 
+/* The number of buffered frames sent to the intent engine for each new frame
+ * after waking, until the ring buffer has drained. Values above 1 let an ASR
+ * that runs faster than real time catch up on the buffered audio sooner. The
+ * intent engine stream buffer is then enlarged by the ring buffer's
+ * appconfAUDIO_PIPELINE_BUFFER_NUM_FRAMES frames, so that the frames sent in
+ * excess are not lost while the ASR catches up. */
+#ifndef appconfAUDIO_PIPELINE_LP_BUF_DEQUEUE_FRAMES
+#define appconfAUDIO_PIPELINE_LP_BUF_DEQUEUE_FRAMES 1
+#endif
+
 #ifndef appconfLOW_POWER_SWITCH_CLK_DIV_ENABLE
 #define appconfLOW_POWER_SWITCH_CLK_DIV_ENABLE  1
 #endif
@@ -20,6 +20,7 @@
 #include "platform/driver_instances.h"
 #include "power/power_state.h"
 #include "power/power_control.h"
+#include "profile.h"
 
 #if ON_TILE(ASR_TILE_NO)
 
@@ -43,6 +44,8 @@ extern const unsigned short SEARCH_VAR[];
 #define IS_COMMAND(id)      ((id) > 0)
 #define SAMPLES_PER_ASR     (appconfINTENT_SAMPLE_BLOCK_LENGTH)
 
+PROFILE_PROBE_DEFINE(asr_probe, "intent_asr");
+
 typedef enum intent_power_state {
     STATE_REQUESTING_LOW_POWER,
     STATE_ENTERING_LOW_POWER,
@@ -247,7 +250,9 @@ void intent_engine_task(void *args)
         if (run_asr == 0)
             continue;
 
+        PROFILE_START(asr_probe);
         asr_error = asr_process(asr_ctx, buf, SAMPLES_PER_ASR);
+        PROFILE_END(asr_probe);
 
         if (asr_error == ASR_OK) {
             asr_error = asr_get_result(asr_ctx, &asr_result);
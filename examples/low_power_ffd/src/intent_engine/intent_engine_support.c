@@ -18,6 +18,14 @@
 
 #if ON_TILE(ASR_TILE_NO)
 
+/* Draining the low power ring buffer faster than real time sends up to the
+ * whole ring buffer more than the ASR consumes in the meantime */
+#if appconfAUDIO_PIPELINE_LP_BUF_DEQUEUE_FRAMES > 1
+#define INTENT_BUFFER_DRAIN_SIZE    (appconfAUDIO_PIPELINE_BUFFER_NUM_FRAMES * appconfAUDIO_PIPELINE_FRAME_ADVANCE * sizeof(asr_sample_t))
+#else
+#define INTENT_BUFFER_DRAIN_SIZE    0
+#endif
+
 static StreamBufferHandle_t samples_to_engine_stream_buf = 0;
 
 #endif /* ON_TILE(ASR_TILE_NO) */
@@ -29,12 +37,21 @@ void intent_engine_samples_send_remote(
         size_t frame_count,
         asr_sample_t *processed_audio_frame)
 {
-    configASSERT(frame_count == appconfAUDIO_PIPELINE_FRAME_ADVANCE);
+    const size_t max_samples = appconfAUDIO_PIPELINE_LP_BUF_DEQUEUE_FRAMES * appconfAUDIO_PIPELINE_FRAME_ADVANCE;
+
+    configASSERT(frame_count % appconfAUDIO_PIPELINE_FRAME_ADVANCE == 0);
 
-    rtos_intertile_tx(intertile,
-                      appconfINTENT_MODEL_RUNNER_SAMPLES_PORT,
-                      processed_audio_frame,
-                      sizeof(asr_sample_t) * frame_count);
+    // Runs of frames are sent as few messages as the receiver allows.
+    while (frame_count > 0) {
+        size_t samples = (frame_count < max_samples) ? frame_count : max_samples;
+
+        rtos_intertile_tx(intertile,
+                          appconfINTENT_MODEL_RUNNER_SAMPLES_PORT,
+                          processed_audio_frame,
+                          sizeof(asr_sample_t) * samples);
+        processed_audio_frame += samples;
+        frame_count -= samples;
+    }
 }
 
 #else /* ON_TILE(AUDIO_PIPELINE_OUTPUT_TILE_NO) */
@@ -44,7 +61,7 @@ static void intent_engine_intertile_samples_in_task(void *arg)
     (void) arg;
 
     for (;;) {
-        asr_sample_t samples[appconfAUDIO_PIPELINE_FRAME_ADVANCE];
+        asr_sample_t samples[appconfAUDIO_PIPELINE_LP_BUF_DEQUEUE_FRAMES * appconfAUDIO_PIPELINE_FRAME_ADVANCE];
         size_t bytes_received;
 
         bytes_received = rtos_intertile_rx_len(
@@ -52,14 +69,15 @@ static void intent_engine_intertile_samples_in_task(void *arg)
                 appconfINTENT_MODEL_RUNNER_SAMPLES_PORT,
                 portMAX_DELAY);
 
-        xassert(bytes_received == sizeof(samples));
+        xassert(bytes_received <= sizeof(samples));
+        xassert(bytes_received % (sizeof(asr_sample_t) * appconfAUDIO_PIPELINE_FRAME_ADVANCE) == 0);
 
         rtos_intertile_rx_data(
                 intertile_ap_ctx,
                 samples,
                 bytes_received);
 
-        if (xStreamBufferSend(samples_to_engine_stream_buf, samples, sizeof(samples), 0) != sizeof(samples)) {
+        if (xStreamBufferSend(samples_to_engine_stream_buf, samples, bytes_received, 0) != bytes_received) {
             rtos_printf("lost output samples for intent\n");
         }
     }
@@ -75,7 +93,7 @@ void intent_engine_stream_buf_reset(void)
 void intent_engine_intertile_task_create(uint32_t priority)
 {
     samples_to_engine_stream_buf = xStreamBufferCreate(
-                                           appconfINTENT_FRAME_BUFFER_MULT * appconfAUDIO_PIPELINE_FRAME_ADVANCE,
+                                           appconfINTENT_FRAME_BUFFER_MULT * appconfAUDIO_PIPELINE_FRAME_ADVANCE + INTENT_BUFFER_DRAIN_SIZE,
                                            appconfINTENT_SAMPLE_BLOCK_LENGTH);
 
     xTaskCreate((TaskFunction_t)intent_engine_intertile_samples_in_task,
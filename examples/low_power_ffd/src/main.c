@@ -109,7 +109,7 @@ int audio_pipeline_output(void *output_app_data,
     for (int i = 0; i < frame_count; i++) {
         asr_buf[i] = ((int32_t *)output_audio_frames)[i] >> 16;
     }
-    vPortFree(output_audio_frames);
+    audio_pipeline_frame_release(output_audio_frames);
 
     wakeword_result_t ww_res = wakeword_handler((asr_sample_t *)asr_buf, frame_count);
 
@@ -126,10 +126,12 @@ int audio_pipeline_output(void *output_app_data,
     }
 
 #if LOW_POWER_AUDIO_BUFFER_ENABLED
-    const uint32_t max_dequeue_packets = 1;
+    const uint32_t max_dequeue_packets = appconfAUDIO_PIPELINE_LP_BUF_DEQUEUE_FRAMES;
     const uint32_t max_dequeued_samples = (max_dequeue_packets * appconfAUDIO_PIPELINE_FRAME_ADVANCE);
 
     if (power_control_state_get() == POWER_STATE_FULL) {
+        // Dequeuing more than one packet drains the buffered audio faster
+        // than real time, so that the ASR catches up after waking.
         if (low_power_audio_buffer_dequeue(max_dequeue_packets) == max_dequeued_samples) {
             // Max data has been dequeued, enqueue the newest data.
             low_power_audio_buffer_enqueue(asr_buf, frame_count);
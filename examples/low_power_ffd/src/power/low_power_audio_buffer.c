@@ -1,4 +1,4 @@
-// Copyright 2022-2023 XMOS LIMITED.
+// Copyright 2022-2024 XMOS LIMITED.
 // This Software is subject to the terms of the XMOS Public Licence: Version 1.
 
 /* System headers */
@@ -80,62 +80,66 @@ void low_power_audio_buffer_enqueue(asr_sample_t *samples, size_t num_samples)
     ring_buf.empty = (ring_buf.count == 0);
 }
 
-uint32_t low_power_audio_buffer_dequeue(uint32_t num_frames)
+size_t low_power_audio_buffer_peek(const asr_sample_t **samples)
 {
-    uint32_t ret = 0;
     const uint32_t tail_addr = ((uint32_t)ring_buf.buf + ring_buf.size);
+    size_t tail_samples = (tail_addr - (uint32_t)ring_buf.get_ptr) / sizeof(asr_sample_t);
 
-    if ((ring_buf.count < appconfAUDIO_PIPELINE_FRAME_ADVANCE) || (num_frames == 0)) {
-        // No data to dequeue.
-        return ret;
-    }
+    *samples = (const asr_sample_t *)ring_buf.get_ptr;
 
-    ring_buf.full = 0;
+    return (ring_buf.count < tail_samples) ? ring_buf.count : tail_samples;
+}
 
-    uint32_t bufferred_audio_bytes = ring_buf.count * sizeof(asr_sample_t);
-    int32_t tail_bytes = ring_buf.size - ((uint32_t)ring_buf.get_ptr - (uint32_t)ring_buf.buf);
+void low_power_audio_buffer_commit(size_t num_samples)
+{
+    const uint32_t tail_addr = ((uint32_t)ring_buf.buf + ring_buf.size);
 
-    int32_t samples_to_dequeue =
-        ((num_frames * appconfAUDIO_PIPELINE_FRAME_ADVANCE) > ring_buf.count) ?
-        ring_buf.count :
-        (num_frames * appconfAUDIO_PIPELINE_FRAME_ADVANCE);
+    assert(num_samples <= ring_buf.count);
 
-    ring_buf.empty = ((ring_buf.count - samples_to_dequeue) == 0);
-    ret = (uint32_t)samples_to_dequeue;
+    if (num_samples == 0)
+        return;
 
-    if ((uint32_t)tail_bytes > bufferred_audio_bytes)
-        tail_bytes = bufferred_audio_bytes;
+    ring_buf.get_ptr += num_samples * sizeof(asr_sample_t);
 
-    int32_t head_bytes = bufferred_audio_bytes - tail_bytes;
+    if ((uint32_t)ring_buf.get_ptr >= tail_addr)
+        ring_buf.get_ptr -= ring_buf.size;
 
-    while (tail_bytes > 0) {
-        if (samples_to_dequeue <= 0)
-            break;
+    ring_buf.count -= num_samples;
+    ring_buf.full = 0;
+    ring_buf.empty = (ring_buf.count == 0);
+}
 
-        intent_engine_sample_push((asr_sample_t *)ring_buf.get_ptr, appconfAUDIO_PIPELINE_FRAME_ADVANCE);
-        ring_buf.get_ptr += (appconfAUDIO_PIPELINE_FRAME_ADVANCE * sizeof(asr_sample_t));
-        tail_bytes -= (appconfAUDIO_PIPELINE_FRAME_ADVANCE * sizeof(asr_sample_t));
-        samples_to_dequeue -= appconfAUDIO_PIPELINE_FRAME_ADVANCE;
-        ring_buf.count -= appconfAUDIO_PIPELINE_FRAME_ADVANCE;
-    }
+uint32_t low_power_audio_buffer_dequeue(uint32_t num_frames)
+{
+    const size_t frame_samples = appconfAUDIO_PIPELINE_FRAME_ADVANCE;
+    size_t samples_to_dequeue = num_frames * frame_samples;
+    uint32_t ret = 0;
 
-    if ((uint32_t)ring_buf.get_ptr >= tail_addr)
-        ring_buf.get_ptr = (char *)ring_buf.buf;
+    while ((samples_to_dequeue > 0) && (ring_buf.count >= frame_samples)) {
+        const asr_sample_t *span;
+        size_t span_samples = low_power_audio_buffer_peek(&span);
 
-    if (head_bytes == 0) {
-        // No data left to dequeue, return now.
-        return ret;
-    }
+        if (span_samples >= frame_samples) {
+            // Pass the whole frames of the span to the intent engine in place.
+            span_samples -= span_samples % frame_samples;
+            if (span_samples > samples_to_dequeue)
+                span_samples = samples_to_dequeue;
+
+            intent_engine_sample_push((asr_sample_t *)span, span_samples);
+        } else {
+            // The frame wraps around the end of the buffer, so it is copied.
+            asr_sample_t frame[appconfAUDIO_PIPELINE_FRAME_ADVANCE];
+
+            memcpy(frame, span, span_samples * sizeof(asr_sample_t));
+            memcpy(frame + span_samples, ring_buf.buf, (frame_samples - span_samples) * sizeof(asr_sample_t));
+            span_samples = frame_samples;
 
-    while (head_bytes > 0) {
-        if (samples_to_dequeue <= 0)
-            break;
+            intent_engine_sample_push(frame, span_samples);
+        }
 
-        intent_engine_sample_push((asr_sample_t *)ring_buf.get_ptr, appconfAUDIO_PIPELINE_FRAME_ADVANCE);
-        ring_buf.get_ptr += (appconfAUDIO_PIPELINE_FRAME_ADVANCE * sizeof(asr_sample_t));
-        head_bytes -= (appconfAUDIO_PIPELINE_FRAME_ADVANCE * sizeof(asr_sample_t));
-        samples_to_dequeue -= appconfAUDIO_PIPELINE_FRAME_ADVANCE;
-        ring_buf.count -= appconfAUDIO_PIPELINE_FRAME_ADVANCE;
+        low_power_audio_buffer_commit(span_samples);
+        samples_to_dequeue -= span_samples;
+        ret += span_samples;
     }
 
     return ret;
@@ -27,15 +27,35 @@
  */
 void low_power_audio_buffer_enqueue(asr_sample_t *samples, size_t num_samples);
 
+/**
+ * Get the oldest samples in the ring buffer that are contiguous in memory,
+ * without removing them. The samples remain valid until they are committed or
+ * overwritten by an enqueue.
+ *
+ * \param samples       Set to the oldest sample in the buffer.
+ * \return              The number of contiguous samples, which is less than
+ *                      the number of samples in the buffer when they wrap
+ *                      around the end of the buffer.
+ */
+size_t low_power_audio_buffer_peek(const asr_sample_t **samples);
+
+/**
+ * Remove samples returned by low_power_audio_buffer_peek() from the ring
+ * buffer.
+ *
+ * \param num_samples   The number of samples to remove.
+ */
+void low_power_audio_buffer_commit(size_t num_samples);
+
 /**
  * Dequeue audio frames out of a ring buffer. These frames are sent onward to
- * the inference engine.
+ * the inference engine, as many at a time as are contiguous in the buffer.
  *
  * \param num_frames    The requested number of frames to dequeue, where
  *                      one frame is appconfAUDIO_PIPELINE_FRAME_ADVANCE
  *                      samples.
  * \return              The number of samples actually dequeued from the buffer.
  */
-uint32_t low_power_audio_buffer_dequeue(uint32_t num_packets);
+uint32_t low_power_audio_buffer_dequeue(uint32_t num_frames);
 
 #endif // LOW_POWER_AUDIO_BUFFER_H_
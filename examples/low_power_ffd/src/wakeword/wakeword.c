@@ -15,6 +15,7 @@
 #include "device_memory_impl.h"
 #include "wakeword/wakeword.h"
 #include "platform/driver_instances.h"
+#include "profile.h"
 
 // This define is referenced by the model source/header files.
 #ifndef ALIGNED
@@ -46,6 +47,8 @@ extern const unsigned short WAKEWORD_SEARCH_VAR[];
 
 #define SAMPLES_PER_ASR     (appconfINTENT_SAMPLE_BLOCK_LENGTH)
 
+PROFILE_PROBE_DEFINE(asr_probe, "wakeword_asr");
+
 static asr_port_t asr_ctx;
 static devmem_manager_t devmem_ctx;
 
@@ -62,7 +65,9 @@ wakeword_result_t wakeword_handler(asr_sample_t *buf, size_t num_frames)
     asr_error_t asr_error;
     wakeword_result_t retval = WAKEWORD_NOT_FOUND;
 
+    PROFILE_START(asr_probe);
     asr_error = asr_process(asr_ctx, buf, num_frames);
+    PROFILE_END(asr_probe);
 
     if (asr_error == ASR_OK) {
         asr_error = asr_get_result(asr_ctx, &asr_result);
@@ -43,6 +43,7 @@ set(APP_LINK_LIBRARIES
     lib_xcore_math
     lib_qspi_fast_read
     xscope_fileio
+    sln_voice::app::profiling
 )
 
 #**********************
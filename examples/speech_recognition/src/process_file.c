@@ -11,6 +11,7 @@
 #include "app_conf.h"
 #include "asr.h"
 #include "device_memory_impl.h"
+#include "profile.h"
 #include "wav_utils.h"
 #include "xscope_io_device.h"
 
@@ -21,6 +22,8 @@
 #define BRICK_SIZE_SAMPLES   (240) 
 #define BRICK_SIZE_BYTES     (BRICK_SIZE_SAMPLES*sizeof(int16_t))
 
+PROFILE_PROBE_DEFINE(asr_probe, "asr_process");
+
 const char* word_id2text(int word_id) {
     switch (word_id) {
         case 100:
@@ -90,6 +93,7 @@ void process_file() {
         timer_start = get_reference_time();
         asr_error = asr_process(asr_port, brick, BRICK_SIZE_SAMPLES);
         timer_end = get_reference_time();
+        PROFILE_RECORD(asr_probe, timer_end - timer_start);
         //printf("Duration: %lu (us)\n", timer_duration);
 
         timer_duration = (timer_end - timer_start) / 100;
@@ -114,6 +118,7 @@ void process_file() {
     if (avg_duration > 15000) {
        printf("WARNING: Avg duration exceeds 15 (ms)\n");
     }
+    profile_dump();
 
     asr_release(asr_port);
     xscope_close_all_files();
@@ -29,7 +29,7 @@ void devmem_read_ext(devmem_manager_t *ctx, void *dest, const void * src, size_t
 
 int devmem_read_ext_async(devmem_manager_t *ctx, void *dest, const void * src, size_t n) {
     xassert(ctx);    
-    xassert(ctx->read_ext);    
+    xassert(ctx->read_ext_async);    
     xassert((intptr_t)src % 4 == 0);
     return ctx->read_ext_async(dest, src, n);
 }
@@ -12,6 +12,8 @@
 
 /* FreeRTOS headers */
 #include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
 
 /* Library headers */
 #include "rtos_printf.h"
@@ -22,6 +24,59 @@
 #include "platform/driver_instances.h"
 #include "device_memory.h"
 #include "device_memory_impl.h"
+#include "devmem_async.h"
+#include "devmem_cache.h"
+
+/* The flash reader runs below the audio pipeline, which must not wait on ASR
+ * model reads */
+#ifndef appconfDEVMEM_READER_TASK_PRIORITY
+#ifdef appconfAUDIO_PIPELINE_TASK_PRIORITY
+#define appconfDEVMEM_READER_TASK_PRIORITY  (appconfAUDIO_PIPELINE_TASK_PRIORITY - 1)
+#else
+#define appconfDEVMEM_READER_TASK_PRIORITY  (configMAX_PRIORITIES / 2 - 1)
+#endif
+#endif
+
+/* Size of each of the two prefetch buffers, 0 disables prefetching */
+#ifndef appconfDEVMEM_PREFETCH_SIZE
+#define appconfDEVMEM_PREFETCH_SIZE         (0)
+#endif
+
+/* Number of tasks that may wait for flash reads at the same time */
+#ifndef appconfDEVMEM_MAX_WAITERS
+#define appconfDEVMEM_MAX_WAITERS           (4)
+#endif
+
+/* Number of blocks of the flash read cache, 0 disables the cache */
+#ifndef appconfDEVMEM_CACHE_BLOCKS
+#define appconfDEVMEM_CACHE_BLOCKS          (0)
+#endif
+
+#ifndef appconfDEVMEM_CACHE_BLOCK_SIZE
+#define appconfDEVMEM_CACHE_BLOCK_SIZE      (512)
+#endif
+
+/* Print the address and size of each flash read, for test_devmem_cache */
+#ifndef appconfDEVMEM_TRACE_ENABLED
+#define appconfDEVMEM_TRACE_ENABLED         (0)
+#endif
+
+typedef struct {
+    SemaphoreHandle_t work;
+    SemaphoreHandle_t lock;     // Serialises the ASR tasks using the reader
+    TaskHandle_t waiter[appconfDEVMEM_MAX_WAITERS];  // Notified of each completion
+} devmem_async_port_t;
+
+static devmem_async_t devmem_async_ctx;
+static devmem_async_port_t devmem_async_port;
+#if (appconfDEVMEM_PREFETCH_SIZE > 0)
+static uint32_t devmem_prefetch_storage[2 * appconfDEVMEM_PREFETCH_SIZE / sizeof(uint32_t)];
+#else
+#define devmem_prefetch_storage NULL
+#endif
+#if (appconfDEVMEM_CACHE_BLOCKS > 0)
+static devmem_cache_t devmem_cache;
+#endif
 
 void asr_printf(const char * format, ...) {
     va_list args;
@@ -41,9 +96,8 @@ void devmem_free_local(void *ptr) {
     vPortFree(ptr);
 }
 
-__attribute__((fptrgroup("devmem_read_ext_fptr_grp")))
-void devmem_read_ext_local(void *dest, const void *src, size_t n) {
-    //rtos_printf("devmem_read_ext_local  dest=0x%x    src=0x%x    size=%d\n", dest, src, n);
+DEVMEM_ASYNC_BACKEND_FPTRGROUP
+static void devmem_backend_read(void *dest, const void *src, size_t n) {
     if (IS_FLASH(src)) {
         //uint32_t s = get_reference_time();
         int retval = -1; 
@@ -58,11 +112,186 @@ void devmem_read_ext_local(void *dest, const void *src, size_t n) {
     }    
 }
 
+void devmem_async_port_signal_work(void *port_ctx) {
+    xSemaphoreGive(((devmem_async_port_t *)port_ctx)->work);
+}
+
+void devmem_async_port_wait_work(void *port_ctx) {
+    xSemaphoreTake(((devmem_async_port_t *)port_ctx)->work, portMAX_DELAY);
+}
+
+void devmem_async_port_signal_done(void *port_ctx) {
+    devmem_async_port_t *port = port_ctx;
+
+    taskENTER_CRITICAL();
+    for (int i = 0; i < appconfDEVMEM_MAX_WAITERS; i++) {
+        if (port->waiter[i] != NULL) {
+            xTaskNotifyGive(port->waiter[i]);
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+
+void devmem_async_port_wait_begin(void *port_ctx) {
+    devmem_async_port_t *port = port_ctx;
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    int i;
+
+    taskENTER_CRITICAL();
+    for (i = 0; i < appconfDEVMEM_MAX_WAITERS; i++) {
+        if (port->waiter[i] == NULL) {
+            port->waiter[i] = self;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL();
+    xassert(i < appconfDEVMEM_MAX_WAITERS);
+}
+
+void devmem_async_port_wait_done(void *port_ctx) {
+    (void)port_ctx;
+    (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+}
+
+void devmem_async_port_wait_end(void *port_ctx) {
+    devmem_async_port_t *port = port_ctx;
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+
+    taskENTER_CRITICAL();
+    for (int i = 0; i < appconfDEVMEM_MAX_WAITERS; i++) {
+        if (port->waiter[i] == self) {
+            port->waiter[i] = NULL;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    /* Drop the notifications of completions since the last check */
+    (void)ulTaskNotifyTake(pdTRUE, 0);
+}
+
+#if (appconfDEVMEM_CACHE_BLOCKS > 0)
+DEVMEM_CACHE_FILL_FPTRGROUP
+static void devmem_cache_fill(void *fill_ctx, void *dest, const void *src, size_t n) {
+    devmem_async_read((devmem_async_t *)fill_ctx, dest, src, n);
+}
+#endif
+
+__attribute__((fptrgroup("devmem_read_ext_fptr_grp")))
+void devmem_read_ext_local(void *dest, const void *src, size_t n) {
+    if (IS_FLASH(src)) {
+#if appconfDEVMEM_TRACE_ENABLED
+        rtos_printf("devmem_trace: 0x%x %u\n", (unsigned)(src - XS1_SWMEM_BASE), (unsigned)n);
+#endif
+        xSemaphoreTake(devmem_async_port.lock, portMAX_DELAY);
+#if (appconfDEVMEM_CACHE_BLOCKS > 0)
+        devmem_cache_read(&devmem_cache, dest, src, n);
+#else
+        devmem_async_read(&devmem_async_ctx, dest, src, n);
+#endif
+        xSemaphoreGive(devmem_async_port.lock);
+    } else {
+        memcpy(dest, src, n);
+    }
+}
+
+__attribute__((fptrgroup("devmem_read_ext_async_fptr_grp")))
+int devmem_read_ext_async_local(void *dest, const void *src, size_t n) {
+    int handle;
+
+    xSemaphoreTake(devmem_async_port.lock, portMAX_DELAY);
+    handle = devmem_async_read_start(&devmem_async_ctx, dest, src, n);
+    xSemaphoreGive(devmem_async_port.lock);
+    return handle;
+}
+
+__attribute__((fptrgroup("devmem_read_ext_wait_fptr_grp")))
+void devmem_read_ext_wait_local(int handle) {
+    devmem_async_read_wait(&devmem_async_ctx, handle);
+}
+
+static void devmem_reader_task(void *arg) {
+    devmem_async_reader_run((devmem_async_t *)arg);
+    vTaskDelete(NULL);
+}
+
+static void devmem_async_start(void) {
+    static volatile int state = 0;  // 0: stopped, 1: starting, 2: running
+    int start = 0;
+
+    taskENTER_CRITICAL();
+    if (state == 0) {
+        state = 1;
+        start = 1;
+    }
+    taskEXIT_CRITICAL();
+
+    if (!start) {
+        /* Another ASR task on this tile is starting the reader */
+        while (state != 2) {
+            vTaskDelay(1);
+        }
+        return;
+    }
+
+    devmem_async_port.work = xSemaphoreCreateCounting(DEVMEM_ASYNC_QUEUE_DEPTH + 1, 0);
+    devmem_async_port.lock = xSemaphoreCreateMutex();
+    xassert(devmem_async_port.work && devmem_async_port.lock);
+
+    devmem_async_init(&devmem_async_ctx,
+                      devmem_backend_read,
+                      devmem_prefetch_storage,
+                      appconfDEVMEM_PREFETCH_SIZE,
+                      (const void *)XS1_SWMEM_BASE,
+                      XS1_SWMEM_SIZE,
+                      &devmem_async_port);
+
+#if (appconfDEVMEM_CACHE_BLOCKS > 0)
+    void *cache_storage = pvPortMalloc(devmem_cache_storage_size(appconfDEVMEM_CACHE_BLOCKS, appconfDEVMEM_CACHE_BLOCK_SIZE));
+    xassert(cache_storage);
+    devmem_cache_init(&devmem_cache,
+                      cache_storage,
+                      appconfDEVMEM_CACHE_BLOCKS,
+                      appconfDEVMEM_CACHE_BLOCK_SIZE,
+                      devmem_cache_fill,
+                      &devmem_async_ctx,
+                      (const void *)XS1_SWMEM_BASE,
+                      XS1_SWMEM_SIZE);
+#endif
+
+    xTaskCreate((TaskFunction_t) devmem_reader_task,
+                "devmem_reader",
+                RTOS_THREAD_STACK_SIZE(devmem_reader_task),
+                &devmem_async_ctx,
+                appconfDEVMEM_READER_TASK_PRIORITY,
+                NULL);
+    state = 2;
+}
+
+void devmem_read_stats_get(devmem_async_stats_t *stats) {
+    xassert(stats);
+    xSemaphoreTake(devmem_async_port.lock, portMAX_DELAY);
+    devmem_async_stats_get(&devmem_async_ctx, stats);
+    xSemaphoreGive(devmem_async_port.lock);
+}
+
+void devmem_read_cache_stats_get(devmem_cache_stats_t *stats) {
+    xassert(stats);
+#if (appconfDEVMEM_CACHE_BLOCKS > 0)
+    xSemaphoreTake(devmem_async_port.lock, portMAX_DELAY);
+    devmem_cache_stats_get(&devmem_cache, stats);
+    xSemaphoreGive(devmem_async_port.lock);
+#else
+    memset(stats, 0, sizeof(*stats));
+#endif
+}
+
 void devmem_init(devmem_manager_t *devmem_ctx) {
     xassert(devmem_ctx);    
+    devmem_async_start();
     devmem_ctx->malloc = devmem_malloc_local;
     devmem_ctx->free = devmem_free_local;
     devmem_ctx->read_ext = devmem_read_ext_local;
-    devmem_ctx->read_ext_async = NULL;  // not supported in this application
-    devmem_ctx->read_ext_wait = NULL;   // not supported in this application
+    devmem_ctx->read_ext_async = devmem_read_ext_async_local;
+    devmem_ctx->read_ext_wait = devmem_read_ext_wait_local;
 }
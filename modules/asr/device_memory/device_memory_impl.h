@@ -4,7 +4,29 @@
 #define DEVICE_MEMORY_IMPL_H
 
 #include "device_memory.h"
+#include "devmem_async.h"
+#include "devmem_cache.h"
 
+/**
+ * Initialise a device memory context. Flash reads are performed by a reader
+ * task, started by the first call on each tile. When
+ * appconfDEVMEM_PREFETCH_SIZE is not 0, the task also prefetches the region
+ * following each read into two buffers of that many bytes.
+ * When appconfDEVMEM_CACHE_BLOCKS is not 0, flash reads also go through an
+ * LRU cache of that many appconfDEVMEM_CACHE_BLOCK_SIZE byte blocks, which
+ * is allocated from the heap.
+ */
 void devmem_init(devmem_manager_t *devmem_ctx);
 
+/**
+ * Get the flash read and prefetch statistics of this tile.
+ */
+void devmem_read_stats_get(devmem_async_stats_t *stats);
+
+/**
+ * Get the flash read cache statistics of this tile. All counters are 0 when
+ * the cache is disabled.
+ */
+void devmem_read_cache_stats_get(devmem_cache_stats_t *stats);
+
 #endif // DEVICE_MEMORY_IMPL_H
\ No newline at end of file
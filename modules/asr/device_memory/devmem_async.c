@@ -0,0 +1,188 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "devmem_async.h"
+
+#define DEVMEM_PREFETCH_EMPTY      (0)
+#define DEVMEM_PREFETCH_FILLING    (1)
+#define DEVMEM_PREFETCH_READY      (2)
+
+#define DEVMEM_ASYNC_QUEUE_MASK    (DEVMEM_ASYNC_QUEUE_DEPTH - 1)
+
+_Static_assert((DEVMEM_ASYNC_QUEUE_DEPTH & DEVMEM_ASYNC_QUEUE_MASK) == 0,
+               "DEVMEM_ASYNC_QUEUE_DEPTH must be a power of 2");
+
+void devmem_async_init(devmem_async_t *ctx,
+                       devmem_async_backend_read_t backend_read,
+                       void *prefetch_storage,
+                       size_t prefetch_size,
+                       const void *region_start,
+                       size_t region_size,
+                       void *port_ctx)
+{
+    assert(ctx);
+    assert(backend_read);
+
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->backend_read = backend_read;
+    ctx->port_ctx = port_ctx;
+    ctx->region_start = region_start;
+    ctx->region_end = (const uint8_t *)region_start + region_size;
+
+    if (prefetch_storage != NULL) {
+        ctx->prefetch_size = prefetch_size;
+        ctx->prefetch[0].data = prefetch_storage;
+        ctx->prefetch[1].data = (uint8_t *)prefetch_storage + prefetch_size;
+    }
+}
+
+int devmem_async_read_start(devmem_async_t *ctx, void *dest, const void *src, size_t n)
+{
+    uint32_t head = ctx->req_head;
+
+    /* Wait for a free slot if the queue is full */
+    devmem_async_read_wait(ctx, (int)(head - DEVMEM_ASYNC_QUEUE_DEPTH + 1));
+
+    devmem_async_req_t *req = &ctx->req[head & DEVMEM_ASYNC_QUEUE_MASK];
+    req->dest = dest;
+    req->src = src;
+    req->n = n;
+    __atomic_store_n(&ctx->req_head, head + 1, __ATOMIC_RELEASE);
+    ctx->stats.async_count++;
+
+    devmem_async_port_signal_work(ctx->port_ctx);
+
+    /* The handle is the number of requests that must have completed */
+    return (int)(head + 1);
+}
+
+int devmem_async_read_done(devmem_async_t *ctx, int handle)
+{
+    uint32_t tail = __atomic_load_n(&ctx->req_tail, __ATOMIC_ACQUIRE);
+
+    return (int32_t)(tail - (uint32_t)handle) >= 0;
+}
+
+void devmem_async_read_wait(devmem_async_t *ctx, int handle)
+{
+    if (devmem_async_read_done(ctx, handle)) {
+        return;
+    }
+
+    /* Register before checking again, so that a completion in between still
+     * wakes this task */
+    devmem_async_port_wait_begin(ctx->port_ctx);
+    while (!devmem_async_read_done(ctx, handle)) {
+        devmem_async_port_wait_done(ctx->port_ctx);
+    }
+    devmem_async_port_wait_end(ctx->port_ctx);
+}
+
+/* Returns 0 if the region could not be requested yet */
+static int prefetch_region(devmem_async_t *ctx, const uint8_t *src, int avoid)
+{
+    if (ctx->prefetch_size == 0 || src < ctx->region_start || src >= ctx->region_end) {
+        return 1;
+    }
+
+    /* Nothing to do if the region is already held or on its way */
+    for (int i = 0; i < 2; i++) {
+        if (ctx->prefetch[i].state != DEVMEM_PREFETCH_EMPTY && ctx->prefetch[i].src == src) {
+            return 1;
+        }
+    }
+
+    int i = (avoid >= 0) ? 1 - avoid : 1 - ctx->last_hit;
+    devmem_prefetch_buf_t *buf = &ctx->prefetch[i];
+
+    /* The data of a request in flight cannot be replaced */
+    if (buf->state == DEVMEM_PREFETCH_FILLING && !devmem_async_read_done(ctx, buf->handle)) {
+        return 0;
+    }
+
+    size_t len = ctx->prefetch_size;
+    if ((size_t)(ctx->region_end - src) < len) {
+        len = (size_t)(ctx->region_end - src);
+    }
+
+    buf->src = src;
+    buf->len = len;
+    buf->next_issued = 0;
+    buf->state = DEVMEM_PREFETCH_FILLING;
+    buf->handle = devmem_async_read_start(ctx, buf->data, src, len);
+    ctx->stats.prefetch_count++;
+    return 1;
+}
+
+void devmem_async_read(devmem_async_t *ctx, void *dest, const void *src, size_t n)
+{
+    const uint8_t *s = src;
+
+    ctx->stats.read_count++;
+
+    if (n > ctx->prefetch_size) {
+        devmem_async_read_wait(ctx, devmem_async_read_start(ctx, dest, src, n));
+        return;
+    }
+
+    for (int i = 0; i < 2; i++) {
+        devmem_prefetch_buf_t *buf = &ctx->prefetch[i];
+
+        if (buf->state == DEVMEM_PREFETCH_EMPTY || s < buf->src || s + n > buf->src + buf->len) {
+            continue;
+        }
+        if (buf->state == DEVMEM_PREFETCH_FILLING) {
+            if (!devmem_async_read_done(ctx, buf->handle)) {
+                ctx->stats.prefetch_wait_count++;
+                devmem_async_read_wait(ctx, buf->handle);
+            }
+            buf->state = DEVMEM_PREFETCH_READY;
+        }
+        memcpy(dest, buf->data + (s - buf->src), n);
+        ctx->stats.prefetch_hit_count++;
+        ctx->last_hit = i;
+
+        /* Stay one buffer ahead of the reads */
+        if (!buf->next_issued) {
+            buf->next_issued = prefetch_region(ctx, buf->src + buf->len, i);
+        }
+        return;
+    }
+
+    devmem_async_read_wait(ctx, devmem_async_read_start(ctx, dest, src, n));
+    (void)prefetch_region(ctx, s + n, -1);
+}
+
+void devmem_async_reader_run(devmem_async_t *ctx)
+{
+    for (;;) {
+        uint32_t tail = ctx->req_tail;
+
+        while (__atomic_load_n(&ctx->req_head, __ATOMIC_ACQUIRE) == tail) {
+            if (__atomic_load_n(&ctx->stop, __ATOMIC_ACQUIRE)) {
+                return;
+            }
+            devmem_async_port_wait_work(ctx->port_ctx);
+        }
+
+        devmem_async_req_t *req = &ctx->req[tail & DEVMEM_ASYNC_QUEUE_MASK];
+        ctx->backend_read(req->dest, req->src, req->n);
+
+        __atomic_store_n(&ctx->req_tail, tail + 1, __ATOMIC_RELEASE);
+        devmem_async_port_signal_done(ctx->port_ctx);
+    }
+}
+
+void devmem_async_stop(devmem_async_t *ctx)
+{
+    __atomic_store_n(&ctx->stop, 1, __ATOMIC_RELEASE);
+    devmem_async_port_signal_work(ctx->port_ctx);
+}
+
+void devmem_async_stats_get(devmem_async_t *ctx, devmem_async_stats_t *stats)
+{
+    *stats = ctx->stats;
+}
@@ -0,0 +1,167 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#ifndef DEVMEM_ASYNC_H
+#define DEVMEM_ASYNC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * \addtogroup devmem_async devmem_async
+ *
+ * Asynchronous and prefetching extended memory reads.
+ *
+ * Reads are queued to a dedicated reader task which performs them with a
+ * blocking backend read, so the caller can keep computing while the flash
+ * transfer is in progress. On top of the request queue, devmem_async_read()
+ * keeps two prefetch buffers: whenever a read is served from one buffer the
+ * region that follows it is fetched into the other. ASR models are read
+ * mostly sequentially, so the next read is usually already in SRAM.
+ *
+ * The module is OS independent. The platform provides the reader task, which
+ * calls devmem_async_reader_run(), and the devmem_async_port_*() signalling
+ * functions. Requests must be made from one task at a time.
+ * @{
+ */
+
+/* Number of outstanding requests, must be a power of 2 */
+#define DEVMEM_ASYNC_QUEUE_DEPTH    (8)
+
+/* Only the xcore compiler needs the function pointer group */
+#if defined(__XS3A__)
+#define DEVMEM_ASYNC_BACKEND_FPTRGROUP  __attribute__((fptrgroup("devmem_async_backend_fptr_grp")))
+#else
+#define DEVMEM_ASYNC_BACKEND_FPTRGROUP
+#endif
+
+/**
+ * Blocking read of n bytes at src into dest, performed by the reader task.
+ */
+typedef void (*devmem_async_backend_read_t)(void *dest, const void *src, size_t n);
+
+typedef struct {
+    void *dest;
+    const void *src;
+    size_t n;
+} devmem_async_req_t;
+
+typedef struct {
+    uint8_t *data;
+    const uint8_t *src;     // Address of data[0] in the backend
+    size_t len;
+    int state;              // DEVMEM_PREFETCH_EMPTY, _FILLING or _READY
+    int handle;             // Request filling the buffer
+    int next_issued;        // The region following this one has been requested
+} devmem_prefetch_buf_t;
+
+typedef struct {
+    uint32_t read_count;            // devmem_async_read() calls
+    uint32_t prefetch_hit_count;    // Reads served from a prefetch buffer
+    uint32_t prefetch_wait_count;   // Hits that waited for the prefetch to land
+    uint32_t prefetch_count;        // Prefetches issued
+    uint32_t async_count;           // Requests queued, including prefetches
+} devmem_async_stats_t;
+
+typedef struct {
+    DEVMEM_ASYNC_BACKEND_FPTRGROUP
+    devmem_async_backend_read_t backend_read;
+
+    devmem_async_req_t req[DEVMEM_ASYNC_QUEUE_DEPTH];
+    volatile uint32_t req_head;     // Requests queued, written by the caller
+    volatile uint32_t req_tail;     // Requests completed, written by the reader
+    volatile int stop;
+
+    devmem_prefetch_buf_t prefetch[2];
+    size_t prefetch_size;
+    int last_hit;
+    const uint8_t *region_start;    // Prefetches are clipped to this region
+    const uint8_t *region_end;
+
+    devmem_async_stats_t stats;
+    void *port_ctx;
+} devmem_async_t;
+
+/**
+ * Initialise the asynchronous reader state.
+ *
+ * \param ctx               The state to initialise.
+ * \param backend_read      The blocking read, called from the reader task.
+ * \param prefetch_storage  2 * prefetch_size bytes for the prefetch buffers,
+ *                          or NULL to disable prefetching.
+ * \param prefetch_size     Size of each prefetch buffer in bytes.
+ * \param region_start      First backend address that may be prefetched.
+ * \param region_size       Size of the region that may be prefetched.
+ * \param port_ctx          Passed to the devmem_async_port_*() functions.
+ */
+void devmem_async_init(devmem_async_t *ctx,
+                       devmem_async_backend_read_t backend_read,
+                       void *prefetch_storage,
+                       size_t prefetch_size,
+                       const void *region_start,
+                       size_t region_size,
+                       void *port_ctx);
+
+/**
+ * Queue a read of n bytes at src into dest.
+ *
+ * Blocks only if DEVMEM_ASYNC_QUEUE_DEPTH requests are already outstanding.
+ *
+ * \returns A handle to pass to devmem_async_read_wait().
+ */
+int devmem_async_read_start(devmem_async_t *ctx, void *dest, const void *src, size_t n);
+
+/**
+ * Check whether a queued read has completed.
+ */
+int devmem_async_read_done(devmem_async_t *ctx, int handle);
+
+/**
+ * Block until a queued read has completed.
+ */
+void devmem_async_read_wait(devmem_async_t *ctx, int handle);
+
+/**
+ * Synchronous read that is served from the prefetch buffers when possible,
+ * and that prefetches the region following each read.
+ *
+ * Reads larger than the prefetch buffers are queued and waited for.
+ */
+void devmem_async_read(devmem_async_t *ctx, void *dest, const void *src, size_t n);
+
+/**
+ * The reader task body. Performs queued reads in order until
+ * devmem_async_stop() is called.
+ */
+void devmem_async_reader_run(devmem_async_t *ctx);
+
+/**
+ * Make devmem_async_reader_run() return once the queue is empty.
+ */
+void devmem_async_stop(devmem_async_t *ctx);
+
+/**
+ * Get a copy of the read statistics.
+ */
+void devmem_async_stats_get(devmem_async_t *ctx, devmem_async_stats_t *stats);
+
+/*
+ * Signalling provided by the platform. Work signals must be counted so that
+ * none is lost if it is given before the reader waits.
+ *
+ * More than one task may wait for completions. A waiter calls
+ * devmem_async_port_wait_begin() before checking its request, then
+ * devmem_async_port_wait_done() until the request has completed, then
+ * devmem_async_port_wait_end(). Each devmem_async_port_signal_done() must wake
+ * every task between wait_begin and wait_end, including one that has not
+ * reached wait_done yet.
+ */
+void devmem_async_port_signal_work(void *port_ctx);
+void devmem_async_port_wait_work(void *port_ctx);
+void devmem_async_port_signal_done(void *port_ctx);
+void devmem_async_port_wait_begin(void *port_ctx);
+void devmem_async_port_wait_done(void *port_ctx);
+void devmem_async_port_wait_end(void *port_ctx);
+
+/**@}*/
+
+#endif // DEVMEM_ASYNC_H
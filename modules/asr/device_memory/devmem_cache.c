@@ -0,0 +1,218 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "devmem_cache.h"
+
+#define NO_BLOCK    (-1)
+
+#define ALIGN_UP(x, a)  (((x) + (a) - 1) & ~((size_t)(a) - 1))
+
+static unsigned hash_buckets(unsigned num_blocks)
+{
+    unsigned buckets = 1;
+
+    while (buckets < num_blocks) {
+        buckets <<= 1;
+    }
+    return buckets;
+}
+
+size_t devmem_cache_storage_size(unsigned num_blocks, size_t block_size)
+{
+    size_t size = num_blocks * block_size;
+
+    size = ALIGN_UP(size, sizeof(void *)) + num_blocks * sizeof(const uint8_t *);
+    size += 3 * num_blocks * sizeof(int16_t);
+    size += hash_buckets(num_blocks) * sizeof(int16_t);
+    return size;
+}
+
+static unsigned block_hash(const devmem_cache_t *cache, const uint8_t *addr)
+{
+    uint32_t block = (uint32_t)((uintptr_t)addr >> cache->block_shift);
+
+    /* Consecutive blocks land in consecutive buckets */
+    return (block ^ (block >> 11)) & cache->hash_mask;
+}
+
+static void lru_unlink(devmem_cache_t *cache, int i)
+{
+    int prev = cache->lru_prev[i];
+    int next = cache->lru_next[i];
+
+    if (prev != NO_BLOCK) {
+        cache->lru_next[prev] = next;
+    } else {
+        cache->lru_head = next;
+    }
+    if (next != NO_BLOCK) {
+        cache->lru_prev[next] = prev;
+    } else {
+        cache->lru_tail = prev;
+    }
+}
+
+static void lru_push_head(devmem_cache_t *cache, int i)
+{
+    cache->lru_prev[i] = NO_BLOCK;
+    cache->lru_next[i] = cache->lru_head;
+    if (cache->lru_head != NO_BLOCK) {
+        cache->lru_prev[cache->lru_head] = i;
+    } else {
+        cache->lru_tail = i;
+    }
+    cache->lru_head = i;
+}
+
+static void hash_remove(devmem_cache_t *cache, int i)
+{
+    int16_t *link = &cache->hash_head[block_hash(cache, cache->tag[i])];
+
+    while (*link != i) {
+        assert(*link != NO_BLOCK);
+        link = &cache->hash_next[*link];
+    }
+    *link = cache->hash_next[i];
+}
+
+static int lookup(devmem_cache_t *cache, const uint8_t *addr)
+{
+    int i = cache->hash_head[block_hash(cache, addr)];
+
+    while (i != NO_BLOCK && cache->tag[i] != addr) {
+        i = cache->hash_next[i];
+    }
+    return i;
+}
+
+void devmem_cache_invalidate(devmem_cache_t *cache)
+{
+    cache->lru_head = NO_BLOCK;
+    cache->lru_tail = NO_BLOCK;
+    for (unsigned i = 0; i < cache->num_blocks; i++) {
+        cache->tag[i] = NULL;
+        lru_push_head(cache, i);
+    }
+    for (unsigned b = 0; b <= cache->hash_mask; b++) {
+        cache->hash_head[b] = NO_BLOCK;
+    }
+}
+
+void devmem_cache_init(devmem_cache_t *cache,
+                       void *storage,
+                       unsigned num_blocks,
+                       size_t block_size,
+                       devmem_cache_fill_t fill,
+                       void *fill_ctx,
+                       const void *region_start,
+                       size_t region_size)
+{
+    assert(cache);
+    assert(storage);
+    assert(fill);
+    assert(num_blocks > 0 && num_blocks <= INT16_MAX);
+    assert(block_size > 0 && (block_size & (block_size - 1)) == 0);
+
+    memset(cache, 0, sizeof(*cache));
+    cache->fill = fill;
+    cache->fill_ctx = fill_ctx;
+    cache->block_size = block_size;
+    while (((size_t)1 << cache->block_shift) < block_size) {
+        cache->block_shift++;
+    }
+    cache->num_blocks = num_blocks;
+    cache->hash_mask = hash_buckets(num_blocks) - 1;
+    cache->region_start = region_start;
+    cache->region_end = (const uint8_t *)region_start + region_size;
+
+    uint8_t *p = storage;
+    cache->data = p;
+    p += ALIGN_UP(num_blocks * block_size, sizeof(void *));
+    cache->tag = (const uint8_t **)p;
+    p += num_blocks * sizeof(const uint8_t *);
+    cache->lru_prev = (int16_t *)p;
+    cache->lru_next = cache->lru_prev + num_blocks;
+    cache->hash_next = cache->lru_next + num_blocks;
+    cache->hash_head = cache->hash_next + num_blocks;
+
+    devmem_cache_invalidate(cache);
+}
+
+/* Get the block holding addr, filling it if needed */
+static const uint8_t *get_block(devmem_cache_t *cache, const uint8_t *addr)
+{
+    int i = lookup(cache, addr);
+
+    if (i != NO_BLOCK) {
+        cache->stats.hit_count++;
+        if (cache->lru_head != i) {
+            lru_unlink(cache, i);
+            lru_push_head(cache, i);
+        }
+        return &cache->data[(size_t)i << cache->block_shift];
+    }
+
+    cache->stats.miss_count++;
+    i = cache->lru_tail;
+    if (cache->tag[i] != NULL) {
+        cache->stats.eviction_count++;
+        hash_remove(cache, i);
+    }
+
+    /* Clip the fill to the readable region */
+    const uint8_t *start = addr < cache->region_start ? cache->region_start : addr;
+    const uint8_t *end = addr + cache->block_size;
+    if (end > cache->region_end) {
+        end = cache->region_end;
+    }
+    uint8_t *data = &cache->data[(size_t)i << cache->block_shift];
+    cache->fill(cache->fill_ctx, data + (start - addr), start, (size_t)(end - start));
+
+    cache->tag[i] = addr;
+    unsigned b = block_hash(cache, addr);
+    cache->hash_next[i] = cache->hash_head[b];
+    cache->hash_head[b] = i;
+    lru_unlink(cache, i);
+    lru_push_head(cache, i);
+
+    return data;
+}
+
+void devmem_cache_read(devmem_cache_t *cache, void *dest, const void *src, size_t n)
+{
+    const uint8_t *s = src;
+    uint8_t *d = dest;
+
+    if (n > (cache->num_blocks * cache->block_size) / 2) {
+        cache->stats.bypass_count++;
+        cache->fill(cache->fill_ctx, dest, src, n);
+        return;
+    }
+
+    while (n > 0) {
+        const uint8_t *addr = (const uint8_t *)((uintptr_t)s & ~(uintptr_t)(cache->block_size - 1));
+        size_t offset = (size_t)(s - addr);
+        size_t len = cache->block_size - offset;
+
+        if (len > n) {
+            len = n;
+        }
+        memcpy(d, get_block(cache, addr) + offset, len);
+        s += len;
+        d += len;
+        n -= len;
+    }
+}
+
+void devmem_cache_stats_get(devmem_cache_t *cache, devmem_cache_stats_t *stats)
+{
+    *stats = cache->stats;
+}
+
+void devmem_cache_stats_reset(devmem_cache_t *cache)
+{
+    memset(&cache->stats, 0, sizeof(cache->stats));
+}
@@ -0,0 +1,119 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#ifndef DEVMEM_CACHE_H
+#define DEVMEM_CACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * \addtogroup devmem_cache devmem_cache
+ *
+ * Block granular LRU cache for extended memory reads.
+ *
+ * The backend address space is divided into blocks of block_size bytes. A
+ * read is served block by block from SRAM, and a block that is not cached
+ * is filled with one backend read, replacing the least recently used block.
+ * Reads larger than half the cache bypass it so that one large read does not
+ * flush the blocks that are reused.
+ *
+ * The cache is OS independent and not thread safe.
+ * @{
+ */
+
+/* Only the xcore compiler needs the function pointer group */
+#if defined(__XS3A__)
+#define DEVMEM_CACHE_FILL_FPTRGROUP  __attribute__((fptrgroup("devmem_cache_fill_fptr_grp")))
+#else
+#define DEVMEM_CACHE_FILL_FPTRGROUP
+#endif
+
+/**
+ * Read n bytes at src into dest from the backend.
+ */
+typedef void (*devmem_cache_fill_t)(void *fill_ctx, void *dest, const void *src, size_t n);
+
+typedef struct {
+    uint32_t hit_count;         // Blocks served from the cache
+    uint32_t miss_count;        // Blocks filled from the backend
+    uint32_t eviction_count;    // Valid blocks replaced
+    uint32_t bypass_count;      // Reads too large to cache
+} devmem_cache_stats_t;
+
+typedef struct {
+    DEVMEM_CACHE_FILL_FPTRGROUP
+    devmem_cache_fill_t fill;
+    void *fill_ctx;
+
+    size_t block_size;
+    unsigned block_shift;
+    unsigned num_blocks;
+    unsigned hash_mask;
+    const uint8_t *region_start;    // Fills are clipped to this region
+    const uint8_t *region_end;
+
+    uint8_t *data;                  // num_blocks * block_size
+    const uint8_t **tag;            // Backend address of each block, NULL if invalid
+    int16_t *lru_prev;              // LRU list, most recent at lru_head
+    int16_t *lru_next;
+    int16_t *hash_head;             // Hash chains of the valid blocks
+    int16_t *hash_next;
+    int16_t lru_head;
+    int16_t lru_tail;
+
+    devmem_cache_stats_t stats;
+} devmem_cache_t;
+
+/**
+ * Get the size of the storage needed by a cache.
+ *
+ * \param num_blocks  Number of blocks, at most 32767.
+ * \param block_size  Size of a block in bytes, a power of 2.
+ * \returns           The storage size in bytes, including the block data.
+ */
+size_t devmem_cache_storage_size(unsigned num_blocks, size_t block_size);
+
+/**
+ * Initialise a cache.
+ *
+ * \param cache         The cache to initialise.
+ * \param storage       Word aligned storage of devmem_cache_storage_size() bytes.
+ * \param num_blocks    Number of blocks, at most 32767.
+ * \param block_size    Size of a block in bytes, a power of 2.
+ * \param fill          The backend read.
+ * \param fill_ctx      Passed to fill.
+ * \param region_start  First backend address that may be read.
+ * \param region_size   Size of the region that may be read.
+ */
+void devmem_cache_init(devmem_cache_t *cache,
+                       void *storage,
+                       unsigned num_blocks,
+                       size_t block_size,
+                       devmem_cache_fill_t fill,
+                       void *fill_ctx,
+                       const void *region_start,
+                       size_t region_size);
+
+/**
+ * Read n bytes at src into dest through the cache.
+ */
+void devmem_cache_read(devmem_cache_t *cache, void *dest, const void *src, size_t n);
+
+/**
+ * Drop all cached blocks, for example after the backend has been written.
+ */
+void devmem_cache_invalidate(devmem_cache_t *cache);
+
+/**
+ * Get a copy of the cache statistics.
+ */
+void devmem_cache_stats_get(devmem_cache_t *cache, devmem_cache_stats_t *stats);
+
+/**
+ * Clear the cache statistics.
+ */
+void devmem_cache_stats_reset(devmem_cache_t *cache);
+
+/**@}*/
+
+#endif // DEVMEM_CACHE_H
@@ -19,23 +19,19 @@
 #include "asr.h"
 #include "device_memory_impl.h"
 #include "leds.h"
+#include "profile.h"
 
 #if ON_TILE(ASR_TILE_NO)
 
-#if ASR_SENSORY
-    #define IS_KEYWORD(id)    (id == 17)
-    #define IS_COMMAND(id)    (id > 0 && id != 17)
-#elif ASR_CYBERON
-    #define IS_KEYWORD(id)    (id == 1)
-    #define IS_COMMAND(id)    (id >= 2)
-#else
-#error "Model has to be either Sensory or Cyberon"
-#endif
+#define IS_KEYWORD(intent)    ((intent)->type == INTENT_TYPE_KEYWORD)
+#define IS_COMMAND(intent)    ((intent)->type == INTENT_TYPE_COMMAND)
 
 
 #define SAMPLES_PER_ASR                 (appconfINTENT_SAMPLE_BLOCK_LENGTH)
 #define STOP_LISTENING_SOUND_WAV_ID     (0)
 
+PROFILE_PROBE_DEFINE(asr_probe, "asr_process");
+
 // SEARCH model file is specified in the CMakeLists SENSORY_COMMAND_SEARCH_SOURCE_FILE variable
 #ifdef COMMAND_SEARCH_SOURCE_FILE
 extern const unsigned short gs_grammarLabel[];
@@ -141,7 +137,7 @@ void intent_engine_task(void *args)
 
     asr_error_t asr_error;
     asr_result_t asr_result;
-    int word_id;
+    const intent_entry_t *intent;
 
     size_t buf_short_index = 0;
 
@@ -157,12 +153,21 @@ void intent_engine_task(void *args)
                              // Note, we do not need to overlap the window of samples.
                              // This is handled in the ASR ports.
 
-        // this application does not support barge-in
+#if appconfINTENT_BARGE_IN_ENABLED
+        // keep listening while an audio response plays, results are only
+        //   accepted when the barge-in gate has heard talk over the playback,
+        //   so that the playback does not trigger the ASR.
+        bool accept_result = intent_handler_response_barge_in(buf_short, SAMPLES_PER_ASR);
+#else
+        // barge-in is disabled
         //   so, we need to check if an audio response is playing and skip to the next
         //   audio frame because the playback may trigger the ASR.
         if (intent_handler_response_playing()) continue;
+#endif
 
+        PROFILE_START(asr_probe);
         asr_error = asr_process(asr_ctx, buf_short, SAMPLES_PER_ASR);
+        PROFILE_END(asr_probe);
         if (asr_error == ASR_EVALUATION_EXPIRED) {
             led_indicate_end_of_eval();
             continue;
@@ -174,34 +179,42 @@ void intent_engine_task(void *args)
 
         if (asr_error != ASR_OK) continue;
 
-        word_id = asr_result.id;
+        intent = intent_table_lookup(intent_table_active(), asr_result.id);
+
+        if (intent == NULL || !intent->enabled) continue;
 
-        if (!IS_KEYWORD(word_id) && !IS_COMMAND(word_id)) continue;
+#if appconfINTENT_BARGE_IN_ENABLED
+        if (!accept_result) continue;
 
+        // the talker has barged in, cut the response short
+        if (IS_KEYWORD(intent) || intent_state != STATE_EXPECTING_WAKEWORD) {
+            intent_handler_response_stop();
+        }
+#endif
 
     #if appconfINTENT_RAW_OUTPUT
-        intent_engine_process_asr_result(word_id);
+        intent_engine_process_asr_result(intent);
     #else
-        if (intent_state == STATE_EXPECTING_WAKEWORD && IS_KEYWORD(word_id)) {
+        if (intent_state == STATE_EXPECTING_WAKEWORD && IS_KEYWORD(intent)) {
             led_indicate_listening();
             xTimerStart(int_eng_tmr, 0);
-            intent_engine_process_asr_result(word_id);
+            intent_engine_process_asr_result(intent);
             intent_state = STATE_EXPECTING_COMMAND;
-        } else if (intent_state == STATE_EXPECTING_COMMAND && IS_COMMAND(word_id)) {
+        } else if (intent_state == STATE_EXPECTING_COMMAND && IS_COMMAND(intent)) {
             xTimerReset(int_eng_tmr, 0);
-            intent_engine_process_asr_result(word_id);
+            intent_engine_process_asr_result(intent);
             intent_state = STATE_PROCESSING_COMMAND;
-        } else if (intent_state == STATE_EXPECTING_COMMAND && IS_KEYWORD(word_id)) {
+        } else if (intent_state == STATE_EXPECTING_COMMAND && IS_KEYWORD(intent)) {
             xTimerReset(int_eng_tmr, 0);
-            intent_engine_process_asr_result(word_id);
+            intent_engine_process_asr_result(intent);
             // remain in STATE_EXPECTING_COMMAND state
-        } else if (intent_state == STATE_PROCESSING_COMMAND && IS_KEYWORD(word_id)) {
+        } else if (intent_state == STATE_PROCESSING_COMMAND && IS_KEYWORD(intent)) {
             xTimerReset(int_eng_tmr, 0);
-            intent_engine_process_asr_result(word_id);
+            intent_engine_process_asr_result(intent);
             intent_state = STATE_EXPECTING_COMMAND;
-        } else if (intent_state == STATE_PROCESSING_COMMAND && IS_COMMAND(word_id)) {
+        } else if (intent_state == STATE_PROCESSING_COMMAND && IS_COMMAND(intent)) {
             xTimerReset(int_eng_tmr, 0);
-            intent_engine_process_asr_result(word_id);
+            intent_engine_process_asr_result(intent);
             // remain in STATE_PROCESSING_COMMAND state
         }
     #endif
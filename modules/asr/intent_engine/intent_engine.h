@@ -10,6 +10,29 @@
 
 #include "asr.h"
 #include "rtos_intertile.h"
+#include "intent_table.h"
+
+/* Load the intents from a file in the filesystem at startup, if it exists,
+ * in place of the default intents of the model. See intent_table.h for the
+ * file format. */
+#ifndef appconfINTENT_TABLE_FILE_ENABLED
+#define appconfINTENT_TABLE_FILE_ENABLED    0
+#endif
+
+#ifndef appconfINTENT_TABLE_FILE
+#define appconfINTENT_TABLE_FILE            "intents.txt"
+#endif
+
+/* Maximum number of intents in the file */
+#ifndef appconfINTENT_TABLE_MAX_ENTRIES
+#define appconfINTENT_TABLE_MAX_ENTRIES     512
+#endif
+
+/* Size of the index of the file intents, in entries. A direct index is used
+ * if the ASR IDs span no more than this, otherwise a sorted index. */
+#ifndef appconfINTENT_TABLE_INDEX_SIZE
+#define appconfINTENT_TABLE_INDEX_SIZE      1024
+#endif
 
 int32_t intent_engine_create(uint32_t priority, void *args);
 void intent_engine_ready_sync(void);
@@ -30,6 +53,6 @@ void intent_engine_samples_send_remote(
 
 void intent_engine_stream_buf_reset(void);
 void intent_engine_play_response(int wav_id);
-void intent_engine_process_asr_result(int word_id);
+void intent_engine_process_asr_result(const intent_entry_t *intent);
 
 #endif /* INTENT_ENGINE_H_ */
@@ -16,101 +16,152 @@
 #include "app_conf.h"
 #include "platform/driver_instances.h"
 #include "intent_engine.h"
+#include "intent_handler.h"
+#include "intent_table.h"
+#if appconfINTENT_TABLE_FILE_ENABLED
+#include "ff.h"
+#endif
 
 static QueueHandle_t q_intent = 0;
 
-// look up table to converting ASR IDs to wav file IDs or strings
-#define ASR_NUMBER_OF_COMMANDS  (17)
-
-typedef struct asr_lut_struct
-{
-    int     asr_id;    // ASR response IDs
-    int     wav_id;    // Wav file IDs corresponding to audio_files_en[] array in audio_response.c
-    const char* text;  // String output
-} asr_lut_t;
-
+/* Default intents of the models. The wav IDs index the audio_files_en[] array
+ * in audio_response.c, and are also the codes sent to the host. */
 #if ASR_CYBERON
-static asr_lut_t asr_lut[ASR_NUMBER_OF_COMMANDS] = {
-    {1, 1, "Hello XMOS"},
-    {2, 2, "Switch on the TV"},
-    {3, 3, "Switch off the TV"},
-    {4, 4, "Channel up"},
-    {5, 5, "Channel down"},
-    {6, 6, "Volume up"},
-    {7, 7, "Volume down"},
-    {8, 8, "Switch on the lights"},
-    {9, 9, "Switch off the lights"},
-    {10, 10, "Brightness up"},
-    {11, 11, "Brightness down"},
-    {12, 12, "Switch on the fan"},
-    {13, 13, "Switch off the fan"},
-    {14, 14, "Speed up the fan"},
-    {15, 15, "Slow down the fan"},
-    {16, 16, "Set higher temperature"},
-    {17, 17, "Set lower temperature"}
+static const intent_entry_t default_intents[] = {
+    {1, 1, 1, INTENT_TYPE_KEYWORD, 1, "Hello XMOS"},
+    {2, 2, 2, INTENT_TYPE_COMMAND, 1, "Switch on the TV"},
+    {3, 3, 3, INTENT_TYPE_COMMAND, 1, "Switch off the TV"},
+    {4, 4, 4, INTENT_TYPE_COMMAND, 1, "Channel up"},
+    {5, 5, 5, INTENT_TYPE_COMMAND, 1, "Channel down"},
+    {6, 6, 6, INTENT_TYPE_COMMAND, 1, "Volume up"},
+    {7, 7, 7, INTENT_TYPE_COMMAND, 1, "Volume down"},
+    {8, 8, 8, INTENT_TYPE_COMMAND, 1, "Switch on the lights"},
+    {9, 9, 9, INTENT_TYPE_COMMAND, 1, "Switch off the lights"},
+    {10, 10, 10, INTENT_TYPE_COMMAND, 1, "Brightness up"},
+    {11, 11, 11, INTENT_TYPE_COMMAND, 1, "Brightness down"},
+    {12, 12, 12, INTENT_TYPE_COMMAND, 1, "Switch on the fan"},
+    {13, 13, 13, INTENT_TYPE_COMMAND, 1, "Switch off the fan"},
+    {14, 14, 14, INTENT_TYPE_COMMAND, 1, "Speed up the fan"},
+    {15, 15, 15, INTENT_TYPE_COMMAND, 1, "Slow down the fan"},
+    {16, 16, 16, INTENT_TYPE_COMMAND, 1, "Set higher temperature"},
+    {17, 17, 17, INTENT_TYPE_COMMAND, 1, "Set lower temperature"}
 };
 #elif ASR_SENSORY
-static asr_lut_t asr_lut[ASR_NUMBER_OF_COMMANDS] = {
-    {1, 2, "Switch on the TV"},
-    {2, 4, "Channel up"},
-    {3, 5, "Channel down"},
-    {4, 6, "Volume up"},
-    {5, 7, "Volume down"},
-    {6, 3, "Switch off the TV"},
-    {7, 8, "Switch on the lights"},
-    {8, 10, "Brightness up"},
-    {9, 11, "Brightness down"},
-    {10, 9, "Switch off the lights"},
-    {11, 12, "Switch on the fan"},
-    {12, 14, "Speed up the fan"},
-    {13, 15, "Slow down the fan"},
-    {14, 16, "Set higher temperature"},
-    {15, 17, "Set lower temperature"},
-    {16, 13, "Switch off the fan"},
-    {17, 1, "Hello XMOS"}
+static const intent_entry_t default_intents[] = {
+    {1, 2, 2, INTENT_TYPE_COMMAND, 1, "Switch on the TV"},
+    {2, 4, 4, INTENT_TYPE_COMMAND, 1, "Channel up"},
+    {3, 5, 5, INTENT_TYPE_COMMAND, 1, "Channel down"},
+    {4, 6, 6, INTENT_TYPE_COMMAND, 1, "Volume up"},
+    {5, 7, 7, INTENT_TYPE_COMMAND, 1, "Volume down"},
+    {6, 3, 3, INTENT_TYPE_COMMAND, 1, "Switch off the TV"},
+    {7, 8, 8, INTENT_TYPE_COMMAND, 1, "Switch on the lights"},
+    {8, 10, 10, INTENT_TYPE_COMMAND, 1, "Brightness up"},
+    {9, 11, 11, INTENT_TYPE_COMMAND, 1, "Brightness down"},
+    {10, 9, 9, INTENT_TYPE_COMMAND, 1, "Switch off the lights"},
+    {11, 12, 12, INTENT_TYPE_COMMAND, 1, "Switch on the fan"},
+    {12, 14, 14, INTENT_TYPE_COMMAND, 1, "Speed up the fan"},
+    {13, 15, 15, INTENT_TYPE_COMMAND, 1, "Slow down the fan"},
+    {14, 16, 16, INTENT_TYPE_COMMAND, 1, "Set higher temperature"},
+    {15, 17, 17, INTENT_TYPE_COMMAND, 1, "Set lower temperature"},
+    {16, 13, 13, INTENT_TYPE_COMMAND, 1, "Switch off the fan"},
+    {17, 1, 1, INTENT_TYPE_KEYWORD, 1, "Hello XMOS"}
 };
 #else
 #error "Model has to be either Sensory or Cyberon"
 #endif
 
+#define NUM_DEFAULT_INTENTS (sizeof(default_intents) / sizeof(default_intents[0]))
 
+static intent_table_t default_table;
+static uint16_t default_index[NUM_DEFAULT_INTENTS];
 
 void intent_engine_play_response(int wav_id)
 {
+    intent_message_t msg = {wav_id, wav_id};
+
     if(q_intent != 0) {
-        if(xQueueSend(q_intent, (void *)&wav_id, (TickType_t)0) != pdPASS) {
+        if(xQueueSend(q_intent, (void *)&msg, (TickType_t)0) != pdPASS) {
             rtos_printf("Lost wav playback.  Queue was full.\n");
         }
     }
 }
 
-void intent_engine_process_asr_result(int word_id)
+void intent_engine_process_asr_result(const intent_entry_t *intent)
 {
-    int wav_id = 0;
-    const char* text = "";
+    intent_message_t msg = {intent->wav_id, intent->code};
 
-    for (int i=0; i<ASR_NUMBER_OF_COMMANDS; i++) {
-        if (asr_lut[i].asr_id == word_id) {
-            wav_id = asr_lut[i].wav_id;
-            text = asr_lut[i].text;
-        }
-    }
-    rtos_printf("RECOGNIZED: 0x%x, %s\n", (int) word_id, (char*)text);
+    rtos_printf("RECOGNIZED: 0x%x, %s\n", (int) intent->asr_id, (char*)intent->text);
 #if appconfINTENT_UART_DEBUG_INFO_ENABLED
     static char res_info[128];
-    snprintf(res_info, sizeof(res_info)-1, "Cmd:%s\r\n", text);
+    snprintf(res_info, sizeof(res_info)-1, "Cmd:%s\r\n", intent->text);
     // Enable the printout below to see the information sent over UART
     // rtos_printf(res_info);
     rtos_uart_tx_write(uart_tx_ctx, (uint8_t*)&res_info, strlen(res_info));
 #endif
-    intent_engine_play_response(wav_id);
+    if(q_intent != 0) {
+        if(xQueueSend(q_intent, (void *)&msg, (TickType_t)0) != pdPASS) {
+            rtos_printf("Lost ASR result.  Queue was full.\n");
+        }
+    }
 }
 
+#if appconfINTENT_TABLE_FILE_ENABLED && ON_TILE(ASR_TILE_NO)
+/* Replace the default table with the one in appconfINTENT_TABLE_FILE, if the
+ * filesystem has one. The table is kept for the life of the application. */
+static void intent_engine_table_load(void)
+{
+    static intent_table_t file_table;
+    FIL file;
+    UINT bytes_read = 0;
+
+    if (f_open(&file, appconfINTENT_TABLE_FILE, FA_READ) != FR_OK) {
+        return;
+    }
+
+    size_t size = f_size(&file);
+    char *text = pvPortMalloc(size + 1);
+    intent_entry_t *entries = pvPortMalloc(appconfINTENT_TABLE_MAX_ENTRIES * sizeof(intent_entry_t));
+    uint16_t *index = pvPortMalloc(appconfINTENT_TABLE_INDEX_SIZE * sizeof(uint16_t));
+    int count = -1;
+
+    if (text != NULL && entries != NULL && index != NULL &&
+        f_read(&file, text, size, &bytes_read) == FR_OK && bytes_read == size) {
+        text[size] = '\0';
+        count = intent_table_parse(text, entries, appconfINTENT_TABLE_MAX_ENTRIES);
+    }
+    f_close(&file);
+
+    if (count > 0 && intent_table_init(&file_table, entries, count, index, appconfINTENT_TABLE_INDEX_SIZE) == 0) {
+        intent_table_set(&file_table);
+        rtos_printf("Loaded %d intents from %s\n", count, appconfINTENT_TABLE_FILE);
+        return;
+    }
+
+    if (count < 0) {
+        rtos_printf("%s: error on line %d, using the default intents\n", appconfINTENT_TABLE_FILE, -count);
+    } else {
+        rtos_printf("%s: invalid intents, using the default intents\n", appconfINTENT_TABLE_FILE);
+    }
+    vPortFree(text);
+    vPortFree(entries);
+    vPortFree(index);
+}
+#endif
+
 #if appconfINTENT_ENABLED && ON_TILE(ASR_TILE_NO)
 int32_t intent_engine_create(uint32_t priority, void *args)
 {
     q_intent = (QueueHandle_t) args;
 
+    int ret = intent_table_init(&default_table, default_intents, NUM_DEFAULT_INTENTS,
+                                default_index, NUM_DEFAULT_INTENTS);
+    configASSERT(ret == 0);
+    (void) ret;
+    intent_table_set(&default_table);
+#if appconfINTENT_TABLE_FILE_ENABLED
+    intent_engine_table_load();
+#endif
+
 #if ASR_TILE_NO == AUDIO_PIPELINE_OUTPUT_TILE_NO
     intent_engine_task_create(priority);
 #else
@@ -16,6 +16,14 @@
 #include "platform/driver_instances.h"
 #include "intent_engine.h"
 
+/* The engine reads blocks of appconfINTENT_SAMPLE_BLOCK_LENGTH samples, which
+ * may be shorter or longer than the pipeline frames written to the buffer */
+#if appconfAUDIO_PIPELINE_FRAME_ADVANCE > appconfINTENT_SAMPLE_BLOCK_LENGTH
+#define INTENT_BUFFER_SIZE  (appconfINTENT_FRAME_BUFFER_MULT * appconfAUDIO_PIPELINE_FRAME_ADVANCE)
+#else
+#define INTENT_BUFFER_SIZE  (appconfINTENT_FRAME_BUFFER_MULT * appconfINTENT_SAMPLE_BLOCK_LENGTH)
+#endif
+
 #if ON_TILE(ASR_TILE_NO)
 
 static StreamBufferHandle_t samples_to_engine_stream_buf = 0;
@@ -76,7 +84,7 @@ static void intent_engine_intertile_samples_in_task(void *arg)
 void intent_engine_intertile_task_create(uint32_t priority)
 {
     samples_to_engine_stream_buf = xStreamBufferCreate(
-                                           appconfINTENT_FRAME_BUFFER_MULT * appconfAUDIO_PIPELINE_FRAME_ADVANCE,
+                                           INTENT_BUFFER_SIZE,
                                            appconfINTENT_SAMPLE_BLOCK_LENGTH);
 
     xTaskCreate((TaskFunction_t)intent_engine_intertile_samples_in_task,
@@ -119,7 +127,7 @@ void intent_engine_samples_send_local(
 void intent_engine_task_create(unsigned priority)
 {
     samples_to_engine_stream_buf = xStreamBufferCreate(
-                                           appconfINTENT_FRAME_BUFFER_MULT * appconfAUDIO_PIPELINE_FRAME_ADVANCE,
+                                           INTENT_BUFFER_SIZE,
                                            appconfINTENT_SAMPLE_BLOCK_LENGTH);
 
     xTaskCreate((TaskFunction_t)intent_engine_task,
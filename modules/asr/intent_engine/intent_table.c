@@ -0,0 +1,216 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "intent_table.h"
+
+static const intent_table_t *active_table = NULL;
+
+/* Insertion sort of the entry indices by ID, tables are built rarely */
+static void sort_index(const intent_entry_t *entries, uint16_t *index, size_t count)
+{
+    for (size_t i = 1; i < count; i++) {
+        uint16_t e = index[i];
+        size_t j = i;
+
+        while (j > 0 && entries[index[j - 1]].asr_id > entries[e].asr_id) {
+            index[j] = index[j - 1];
+            j--;
+        }
+        index[j] = e;
+    }
+}
+
+int intent_table_init(intent_table_t *table,
+                      const intent_entry_t *entries,
+                      size_t count,
+                      uint16_t *index,
+                      size_t index_capacity)
+{
+    int32_t min_id = INT32_MAX;
+    int32_t max_id = INT32_MIN;
+
+    memset(table, 0, sizeof(*table));
+    if (count > UINT16_MAX) {
+        return -1;
+    }
+    for (size_t i = 0; i < count; i++) {
+        min_id = entries[i].asr_id < min_id ? entries[i].asr_id : min_id;
+        max_id = entries[i].asr_id > max_id ? entries[i].asr_id : max_id;
+    }
+
+    table->entries = entries;
+    table->count = count;
+    table->min_id = min_id;
+    table->index = index;
+
+    if (count == 0) {
+        return 0;
+    }
+
+    uint32_t range = (uint32_t)max_id - (uint32_t)min_id + 1;
+
+    if (range != 0 && range <= index_capacity) {
+        /* Direct map, 0 for no entry, otherwise the entry index plus one */
+        table->direct = 1;
+        table->index_len = range;
+        memset(index, 0, range * sizeof(uint16_t));
+        for (size_t i = 0; i < count; i++) {
+            uint16_t *slot = &index[entries[i].asr_id - min_id];
+            if (*slot != 0) {
+                return -1;
+            }
+            *slot = i + 1;
+        }
+        return 0;
+    }
+
+    if (count > index_capacity) {
+        return -1;
+    }
+    table->index_len = count;
+    for (size_t i = 0; i < count; i++) {
+        index[i] = i;
+    }
+    sort_index(entries, index, count);
+    for (size_t i = 1; i < count; i++) {
+        if (entries[index[i]].asr_id == entries[index[i - 1]].asr_id) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+const intent_entry_t *intent_table_lookup(const intent_table_t *table, int32_t asr_id)
+{
+    if (table == NULL || table->count == 0) {
+        return NULL;
+    }
+
+    if (table->direct) {
+        uint32_t offset = (uint32_t)asr_id - (uint32_t)table->min_id;
+
+        if (offset >= table->index_len || table->index[offset] == 0) {
+            return NULL;
+        }
+        return &table->entries[table->index[offset] - 1];
+    }
+
+    size_t lo = 0;
+    size_t hi = table->index_len;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        const intent_entry_t *entry = &table->entries[table->index[mid]];
+
+        if (entry->asr_id == asr_id) {
+            return entry;
+        } else if (entry->asr_id < asr_id) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return NULL;
+}
+
+static char *skip_space(char *p)
+{
+    while (*p == ' ' || *p == '\t' || *p == '\r') {
+        p++;
+    }
+    return p;
+}
+
+/* Parse a decimal or 0x prefixed field, returns NULL if there is none */
+static char *parse_int(char *p, int32_t *value)
+{
+    char *end;
+
+    p = skip_space(p);
+    *value = (int32_t)strtol(p, &end, 0);
+    return end == p ? NULL : end;
+}
+
+static char *parse_word(char *p, const char *word)
+{
+    size_t len = strlen(word);
+
+    p = skip_space(p);
+    if (strncmp(p, word, len) != 0 || (p[len] != ' ' && p[len] != '\t')) {
+        return NULL;
+    }
+    return p + len;
+}
+
+static int parse_line(char *p, intent_entry_t *entry)
+{
+    int32_t enabled;
+    char *q;
+
+    if ((p = parse_int(p, &entry->asr_id)) == NULL) {
+        return -1;
+    }
+    if ((q = parse_word(p, "keyword")) != NULL) {
+        entry->type = INTENT_TYPE_KEYWORD;
+    } else if ((q = parse_word(p, "command")) != NULL) {
+        entry->type = INTENT_TYPE_COMMAND;
+    } else {
+        return -1;
+    }
+    if ((p = parse_int(q, &entry->wav_id)) == NULL ||
+        (p = parse_int(p, &entry->code)) == NULL ||
+        (p = parse_int(p, &enabled)) == NULL) {
+        return -1;
+    }
+    entry->enabled = enabled != 0;
+
+    /* The rest of the line, without trailing space */
+    p = skip_space(p);
+    q = p + strlen(p);
+    while (q > p && (q[-1] == ' ' || q[-1] == '\t' || q[-1] == '\r')) {
+        *--q = '\0';
+    }
+    entry->text = p;
+    return 0;
+}
+
+int intent_table_parse(char *text, intent_entry_t *entries, size_t max_entries)
+{
+    size_t count = 0;
+    int line = 0;
+
+    while (*text != '\0') {
+        char *end = strchr(text, '\n');
+        char *next = end != NULL ? end + 1 : text + strlen(text);
+        char *p;
+
+        if (end != NULL) {
+            *end = '\0';
+        }
+        line++;
+
+        p = skip_space(text);
+        if (*p != '\0' && *p != '#') {
+            if (count == max_entries || parse_line(p, &entries[count]) != 0) {
+                return -line;
+            }
+            count++;
+        }
+        text = next;
+    }
+    return (int)count;
+}
+
+void intent_table_set(const intent_table_t *table)
+{
+    __atomic_store_n(&active_table, table, __ATOMIC_RELEASE);
+}
+
+const intent_table_t *intent_table_active(void)
+{
+    return __atomic_load_n(&active_table, __ATOMIC_ACQUIRE);
+}
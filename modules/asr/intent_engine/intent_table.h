@@ -0,0 +1,106 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef INTENT_TABLE_H_
+#define INTENT_TABLE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * \addtogroup intent_table intent_table
+ *
+ * Table of the intents that ASR result IDs map to.
+ *
+ * Each entry gives what an ASR result means and what to do with it: whether
+ * it is a keyword or a command, the audio response to play, the code sent to
+ * the host over I2C and UART, and whether it is enabled. A table is indexed
+ * when it is initialized. If the IDs span no more than the index capacity,
+ * which is the case for the dense IDs of the Sensory and Cyberon models, the
+ * index is a direct map from ID to entry. Otherwise the index holds the
+ * entries sorted by ID and a lookup is a binary search.
+ *
+ * The intent engine uses the active table, which can be replaced at any time
+ * with intent_table_set(). A replaced table must remain valid until the
+ * result being handled has been processed.
+ * @{
+ */
+
+typedef enum {
+    INTENT_TYPE_COMMAND = 0,
+    INTENT_TYPE_KEYWORD = 1,
+} intent_type_t;
+
+typedef struct {
+    int32_t asr_id;         // ASR result ID
+    int32_t wav_id;         // Audio response, -1 for none
+    int32_t code;           // Code sent to the host over I2C and UART
+    uint8_t type;           // intent_type_t
+    uint8_t enabled;        // Disabled entries are ignored
+    const char *text;       // Printed when recognized
+} intent_entry_t;
+
+typedef struct {
+    const intent_entry_t *entries;
+    size_t count;
+    int32_t min_id;
+    size_t index_len;
+    uint16_t *index;
+    int direct;
+} intent_table_t;
+
+/**
+ * Initialize a table.
+ *
+ * \param table           The table.
+ * \param entries         The entries, in any order, which must remain valid.
+ * \param count           The number of entries, at most UINT16_MAX.
+ * \param index           Storage for the index.
+ * \param index_capacity  Number of elements of index. A direct index needs
+ *                        the maximum ID less the minimum ID plus one, a
+ *                        sorted index needs count.
+ * \returns               0 on success, or -1 if an ID is repeated or the
+ *                        index is too small.
+ */
+int intent_table_init(intent_table_t *table,
+                      const intent_entry_t *entries,
+                      size_t count,
+                      uint16_t *index,
+                      size_t index_capacity);
+
+/**
+ * Find the entry of an ASR result ID.
+ *
+ * \returns  The entry, or NULL if the table has no entry for the ID.
+ */
+const intent_entry_t *intent_table_lookup(const intent_table_t *table, int32_t asr_id);
+
+/**
+ * Parse entries from text, one per line in the form
+ *
+ *     <asr_id> <keyword|command> <wav_id> <code> <enabled> <text>
+ *
+ * Blank lines and lines starting with # are skipped. The text is modified in
+ * place and the entry text points into it, so it must remain valid.
+ *
+ * \param text         The null terminated text.
+ * \param entries      Filled with the entries.
+ * \param max_entries  The number of elements of entries.
+ * \returns            The number of entries, or minus the number of the
+ *                     first line in error.
+ */
+int intent_table_parse(char *text, intent_entry_t *entries, size_t max_entries);
+
+/**
+ * Make a table the active table.
+ */
+void intent_table_set(const intent_table_t *table);
+
+/**
+ * Get the active table.
+ */
+const intent_table_t *intent_table_active(void);
+
+/**@}*/
+
+#endif /* INTENT_TABLE_H_ */
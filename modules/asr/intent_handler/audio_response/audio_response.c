@@ -2,19 +2,24 @@
 // This Software is subject to the terms of the XMOS Public Licence: Version 1.
 
 /* STD headers */
+#include <string.h>
 #include <platform.h>
 #include <xs1.h>
+#include <xcore/hwtimer.h>
 
 /* FreeRTOS headers */
 #include "FreeRTOS.h"
 #include "task.h"
 #include "queue.h"
+#include "semphr.h"
 
 /* App headers */
 #include "app_conf.h"
 #include "platform/driver_instances.h"
 #include "intent_handler.h"
 #include "audio_response.h"
+#include "barge_in.h"
+#include "profile.h"
 #include "fs_support.h"
 #include "ff.h"
 #include "dr_wav_freertos_port.h"
@@ -42,81 +47,306 @@ static const char *audio_files_en[] = {
 
 #define NUM_FILES (sizeof(audio_files_en) / sizeof(char *))
 
-static int16_t file_audio[appconfAUDIO_PIPELINE_FRAME_ADVANCE];
-static int32_t i2s_audio[2*(appconfAUDIO_PIPELINE_FRAME_ADVANCE)];
-static drwav *wav_files = NULL;
+#define BLOCK_FRAMES    (appconfAUDIO_PIPELINE_FRAME_ADVANCE)
+#define NO_RESPONSE     (-1)
 
+typedef struct {
+    int32_t id;
+    uint32_t seq;           // Sequence number of the response, 0 for a preload
+    uint32_t request_time;
+} request_t;
+
+typedef struct {
+    int32_t id;             // NO_RESPONSE if the entry is empty
+    uint32_t last_used;
+    FIL file;
+    drwav wav;
+    int16_t first_block[BLOCK_FRAMES];
+    size_t first_frames;
+} cache_entry_t;
+
+typedef struct {
+    int16_t samples[BLOCK_FRAMES];
+    size_t frames;
+    uint32_t seq;
+    uint32_t request_time;
+    int first;
+    int last;
+} block_t;
+
+static cache_entry_t cache[appconfAUDIO_RESPONSE_CACHE_SIZE];
+static uint32_t cache_clock;
+
+/* Double buffer from the player task to the sink task */
+static block_t blocks[2];
+static SemaphoreHandle_t free_blocks;
+static SemaphoreHandle_t full_blocks;
+
+static QueueHandle_t request_queue;
+static SemaphoreHandle_t response_done;
+
+/* Responses are numbered as they are requested. A response is stopped when
+ * its number is no later than stopped_seq. */
+static uint32_t requested_seq;
+static uint32_t completed_seq;
+static uint32_t stopped_seq;
+
+static const audio_response_sink_t *sink;
+static audio_response_stats_t stats;
+static barge_in_t barge_in_ctx;
+
+PROFILE_PROBE_DEFINE(latency_probe, "response_start");
+
+static int response_stopped(uint32_t seq)
+{
+    return (int32_t)(seq - __atomic_load_n(&stopped_seq, __ATOMIC_ACQUIRE)) <= 0;
+}
+
+/* Find a response in the cache, opening it in place of the least recently
+ * used entry if it is not there */
 #pragma stackfunction 3000
+static cache_entry_t *cache_get(int32_t id)
+{
+    cache_entry_t *entry = &cache[0];
 
-int32_t audio_response_init(void) {
-    FRESULT result = 0;
-    FIL *files = pvPortMalloc(NUM_FILES * sizeof(FIL));
-    wav_files = pvPortMalloc(NUM_FILES * sizeof(drwav));
-
-    configASSERT(files);
-    configASSERT(wav_files);
-    configASSERT(file_audio);
-    configASSERT(i2s_audio);
-
-    for (int i=0; i<NUM_FILES; i++) {
-        result = f_open(&files[i], audio_files_en[i], FA_READ);
-        if (result == FR_OK) {
-            drwav_init(
-                    &wav_files[i],
+    for (int i = 0; i < appconfAUDIO_RESPONSE_CACHE_SIZE; i++) {
+        if (cache[i].id == id) {
+            cache[i].last_used = ++cache_clock;
+            stats.cache_hits++;
+            return &cache[i];
+        }
+        if (entry->id != NO_RESPONSE &&
+            (cache[i].id == NO_RESPONSE || cache[i].last_used < entry->last_used)) {
+            entry = &cache[i];
+        }
+    }
+
+    stats.cache_misses++;
+    if (entry->id != NO_RESPONSE) {
+        drwav_uninit(&entry->wav);
+        f_close(&entry->file);
+        entry->id = NO_RESPONSE;
+    }
+    if (f_open(&entry->file, audio_files_en[id], FA_READ) != FR_OK) {
+        rtos_printf("Cannot open %s\n", audio_files_en[id]);
+        return NULL;
+    }
+    if (!drwav_init(&entry->wav,
                     drwav_read_proc_port,
                     drwav_seek_proc_port,
-                    &files[i],
-                    &drwav_memory_cbs);
-        } else {
-            configASSERT(0);
-        }
+                    &entry->file,
+                    &drwav_memory_cbs)) {
+        rtos_printf("Cannot read %s\n", audio_files_en[id]);
+        f_close(&entry->file);
+        return NULL;
     }
-    return 0;
+    entry->first_frames = drwav_read_pcm_frames_s16(&entry->wav, BLOCK_FRAMES, entry->first_block);
+    entry->id = id;
+    entry->last_used = ++cache_clock;
+    return entry;
 }
 
+/* Reads each requested response a block ahead of the sink task */
 #pragma stackfunction 3000
-void audio_response_play(int32_t id) {
-    drwav tmp;
-    size_t framesRead = 0;
-
-    if (wav_files != NULL) {
-        if (id < NUM_FILES){  //max id should be (NUM_FILES - 1)
-            tmp = wav_files[id];
-        } else {
-            rtos_printf("No audio response for id %d\n", id);
-            return;
+static void audio_response_player_task(void *arg)
+{
+    const int32_t preload_ids[] = appconfAUDIO_RESPONSE_PRELOAD_IDS;
+    request_t req;
+    int k = 0;
+
+    (void) arg;
+
+    for (int i = 0; i < sizeof(preload_ids) / sizeof(preload_ids[0]); i++) {
+        audio_response_preload(preload_ids[i]);
+    }
+
+    while (1) {
+        cache_entry_t *entry = NULL;
+
+        xQueueReceive(request_queue, &req, portMAX_DELAY);
+
+        if (req.id < 0 || req.id >= (int32_t)NUM_FILES) {
+            rtos_printf("No audio response for id %d\n", req.id);
+        } else if (req.seq == 0 || !response_stopped(req.seq)) {
+            entry = cache_get(req.id);
+        }
+        if (req.seq == 0) {
+            continue;
         }
 
-        while(1) {
-            memset(file_audio, 0x00, sizeof(file_audio));
-            framesRead = drwav_read_pcm_frames_s16(&tmp, appconfAUDIO_PIPELINE_FRAME_ADVANCE, file_audio);
-            memset(i2s_audio, 0x00, sizeof(i2s_audio));
-            for (int i=0; i<framesRead; i++) {
-                i2s_audio[(2*i)+0] = (int32_t) file_audio[i] << 16;
-                i2s_audio[(2*i)+1] = (int32_t) file_audio[i] << 16;
-            }
-            if (appconfI2S_MODE == appconfI2S_MODE_MASTER)
-            {
-                rtos_i2s_tx(i2s_ctx,
-                            (int32_t*) i2s_audio,
-                            appconfAUDIO_PIPELINE_FRAME_ADVANCE,
-                            portMAX_DELAY);
-            } else if (appconfI2S_MODE == appconfI2S_MODE_SLAVE)
-            {
-                rtos_intertile_tx(intertile_ctx,
-                            appconfI2S_OUTPUT_SLAVE_PORT,
-                            i2s_audio,
-                            sizeof(i2s_audio));
+        /* The first block comes from the cache, then the file is read from
+         * where the first block ends */
+        size_t frames = entry != NULL ? entry->first_frames : 0;
+        if (frames == BLOCK_FRAMES) {
+            drwav_seek_to_pcm_frame(&entry->wav, BLOCK_FRAMES);
+        }
+
+        for (int first = 1; ; first = 0) {
+            block_t *block = &blocks[k];
+
+            xSemaphoreTake(free_blocks, portMAX_DELAY);
+            if (first) {
+                if (frames > 0) {
+                    memcpy(block->samples, entry->first_block, frames * sizeof(int16_t));
+                }
             } else {
-                // Invalid I2S mode
-                xassert(0);
+                frames = drwav_read_pcm_frames_s16(&entry->wav, BLOCK_FRAMES, block->samples);
             }
-            if (framesRead != appconfAUDIO_PIPELINE_FRAME_ADVANCE) {
-                drwav_seek_to_pcm_frame(&tmp, 0);
+            block->frames = frames;
+            block->seq = req.seq;
+            block->request_time = req.request_time;
+            block->first = first;
+            block->last = frames < BLOCK_FRAMES || response_stopped(req.seq);
+
+            int last = block->last;
+            xSemaphoreGive(full_blocks);
+            k ^= 1;
+            if (last) {
                 break;
             }
         }
+    }
+}
+
+/* Writes each block to the sink as soon as the sink can take it */
+static void audio_response_sink_task(void *arg)
+{
+    int playing = 0;
+    int k = 0;
+
+    (void) arg;
+
+    while (1) {
+        if (xSemaphoreTake(full_blocks, 0) != pdTRUE) {
+            if (playing) {
+                stats.underruns++;
+            }
+            xSemaphoreTake(full_blocks, portMAX_DELAY);
+        }
+
+        block_t *block = &blocks[k];
+        uint32_t seq = block->seq;
+        int last = block->last;
+
+        if (block->frames > 0 && !response_stopped(seq)) {
+            if (block->first) {
+                uint32_t latency = get_reference_time() - block->request_time;
+
+                PROFILE_RECORD(latency_probe, latency);
+                stats.play_count++;
+                stats.last_latency_us = latency / 100;
+                if (stats.last_latency_us > stats.max_latency_us) {
+                    stats.max_latency_us = stats.last_latency_us;
+                }
+            }
+            barge_in_reference(&barge_in_ctx, block->samples, block->frames);
+
+            const audio_response_sink_t *s = __atomic_load_n(&sink, __ATOMIC_ACQUIRE);
+            s->write(s->ctx, block->samples, block->frames);
+        }
+        playing = !last;
+
+        xSemaphoreGive(free_blocks);
+        k ^= 1;
+
+        if (last) {
+            __atomic_store_n(&completed_seq, seq, __ATOMIC_RELEASE);
+            xSemaphoreGive(response_done);
+        }
+    }
+}
+
+int32_t audio_response_init(void) {
+    barge_in_init(&barge_in_ctx);
+
+    for (int i = 0; i < appconfAUDIO_RESPONSE_CACHE_SIZE; i++) {
+        cache[i].id = NO_RESPONSE;
+    }
+    if (appconfI2S_MODE == appconfI2S_MODE_MASTER) {
+        sink = &audio_response_sink_i2s;
+    } else if (appconfI2S_MODE == appconfI2S_MODE_SLAVE) {
+        sink = &audio_response_sink_intertile;
     } else {
-        rtos_printf("wav files not initialized\n");
+        // Invalid I2S mode
+        xassert(0);
     }
+
+    request_queue = xQueueCreate(appconfAUDIO_RESPONSE_QUEUE_LEN, sizeof(request_t));
+    free_blocks = xSemaphoreCreateCounting(2, 2);
+    full_blocks = xSemaphoreCreateCounting(2, 0);
+    response_done = xSemaphoreCreateBinary();
+
+    configASSERT(request_queue);
+    configASSERT(free_blocks);
+    configASSERT(full_blocks);
+    configASSERT(response_done);
+
+    xTaskCreate((TaskFunction_t)audio_response_player_task,
+                "audio_response",
+                RTOS_THREAD_STACK_SIZE(audio_response_player_task),
+                NULL,
+                appconfAUDIO_RESPONSE_TASK_PRIORITY - 1,
+                NULL);
+    xTaskCreate((TaskFunction_t)audio_response_sink_task,
+                "audio_response_sink",
+                RTOS_THREAD_STACK_SIZE(audio_response_sink_task),
+                NULL,
+                appconfAUDIO_RESPONSE_TASK_PRIORITY,
+                NULL);
+    return 0;
+}
+
+void audio_response_start(int32_t id) {
+    request_t req = {
+        .id = id,
+        .seq = __atomic_add_fetch(&requested_seq, 1, __ATOMIC_ACQ_REL),
+        .request_time = get_reference_time(),
+    };
+
+    /* Waits if the queue is full, so that every numbered response completes */
+    xQueueSend(request_queue, &req, portMAX_DELAY);
+}
+
+void audio_response_play(int32_t id) {
+    audio_response_start(id);
+
+    uint32_t seq = __atomic_load_n(&requested_seq, __ATOMIC_ACQUIRE);
+    while ((int32_t)(__atomic_load_n(&completed_seq, __ATOMIC_ACQUIRE) - seq) < 0) {
+        xSemaphoreTake(response_done, portMAX_DELAY);
+    }
+}
+
+void audio_response_preload(int32_t id) {
+    request_t req = {.id = id, .seq = 0};
+
+    /* A preload only warms the cache, so it is dropped rather than waited for
+     * when the queue is full */
+    if (xQueueSend(request_queue, &req, 0) != pdTRUE) {
+        __atomic_add_fetch(&stats.preload_drops, 1, __ATOMIC_RELAXED);
+        rtos_printf("Audio response %d not preloaded, the queue is full\n", id);
+    }
+}
+
+void audio_response_stop(void) {
+    __atomic_store_n(&stopped_seq, __atomic_load_n(&requested_seq, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+}
+
+bool audio_response_busy(void) {
+    return __atomic_load_n(&completed_seq, __ATOMIC_ACQUIRE) != __atomic_load_n(&requested_seq, __ATOMIC_ACQUIRE);
+}
+
+void audio_response_sink_set(const audio_response_sink_t *new_sink) {
+    __atomic_store_n(&sink, new_sink, __ATOMIC_RELEASE);
+}
+
+void audio_response_stats_get(audio_response_stats_t *s) {
+    *s = stats;
+}
+
+int audio_response_barge_in(const int16_t *samples, size_t n) {
+    return barge_in_process(&barge_in_ctx, samples, n) != BARGE_IN_ECHO;
+}
+
+void audio_response_barge_in_stats(barge_in_stats_t *s) {
+    barge_in_stats_get(&barge_in_ctx, s);
 }
@@ -5,9 +5,101 @@
 #define AUDIO_RESPONSE_H_
 
 #include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
 
+#include "barge_in.h"
+
+/*
+ * Audio responses are played by two tasks. The player task opens the wav
+ * files as they are requested and reads them a block ahead into a double
+ * buffer, and the sink task writes each block to the output sink.
+ *
+ * The most recently played files are kept open in a cache together with
+ * their first block, so that a cached response starts without waiting for
+ * the filesystem.
+ */
+
+/* Number of wav files kept open, with their first block */
+#ifndef appconfAUDIO_RESPONSE_CACHE_SIZE
+#define appconfAUDIO_RESPONSE_CACHE_SIZE        4
+#endif
+
+/* Responses loaded into the cache at startup: the wakeup and sleep sounds */
+#ifndef appconfAUDIO_RESPONSE_PRELOAD_IDS
+#define appconfAUDIO_RESPONSE_PRELOAD_IDS       {1, 0}
+#endif
+
+/* Number of responses that can be waiting to play */
+#ifndef appconfAUDIO_RESPONSE_QUEUE_LEN
+#define appconfAUDIO_RESPONSE_QUEUE_LEN         4
+#endif
+
+/* The sink task runs above the player task so that the output is fed first */
+#ifndef appconfAUDIO_RESPONSE_TASK_PRIORITY
+#define appconfAUDIO_RESPONSE_TASK_PRIORITY     (configMAX_PRIORITIES / 2 + 1)
+#endif
+
+/* Only the xcore compiler needs the function pointer group */
+#if defined(__XS3A__)
+#define AUDIO_RESPONSE_SINK_FPTRGROUP   __attribute__((fptrgroup("audio_response_sink_fptr_grp")))
+#else
+#define AUDIO_RESPONSE_SINK_FPTRGROUP
+#endif
+
+typedef struct {
+    /* Write a block of mono samples to the output. A block may be shorter than
+     * appconfAUDIO_PIPELINE_FRAME_ADVANCE at the end of a response. */
+    AUDIO_RESPONSE_SINK_FPTRGROUP
+    void (*write)(void *ctx, const int16_t *samples, size_t frames);
+    void *ctx;
+} audio_response_sink_t;
+
+typedef struct {
+    uint32_t play_count;
+    uint32_t cache_hits;
+    uint32_t cache_misses;
+    uint32_t underruns;         // Blocks not read by the time the sink needed them
+    uint32_t last_latency_us;   // From the request to the first block written to the sink
+    uint32_t max_latency_us;
+    uint32_t preload_drops;     // Preloads not queued because the queue was full
+} audio_response_stats_t;
+
+/* Stereo output to I2S, and to the I2S tile when in I2S slave mode */
+extern const audio_response_sink_t audio_response_sink_i2s;
+extern const audio_response_sink_t audio_response_sink_intertile;
+
+/* Create the player tasks and preload the cache, must be called once before
+ * any other function */
 int32_t audio_response_init(void);
 
+/* Queue a response to play after any responses already queued. Returns at once. */
+void audio_response_start(int32_t id);
+
+/* Queue a response and wait until it has played */
 void audio_response_play(int32_t id);
 
+/* Load a response into the cache without playing it. Returns at once, and
+ * the preload is dropped and counted in the stats if the queue is full. */
+void audio_response_preload(int32_t id);
+
+/* Stop the response that is playing and any that are queued, at the end of
+ * the current block */
+void audio_response_stop(void);
+
+/* Returns true while a response is playing or queued */
+bool audio_response_busy(void);
+
+/* Set the output sink. The default is audio_response_sink_i2s in I2S master
+ * mode, and audio_response_sink_intertile in I2S slave mode. */
+void audio_response_sink_set(const audio_response_sink_t *sink);
+
+void audio_response_stats_get(audio_response_stats_t *stats);
+
+/* Pass a block of ASR input to the barge-in gate, returns 0 if ASR results
+ * are to be rejected because only the response is heard */
+int audio_response_barge_in(const int16_t *samples, size_t n);
+
+void audio_response_barge_in_stats(barge_in_stats_t *stats);
+
 #endif /* AUDIO_RESPONSE_H_ */
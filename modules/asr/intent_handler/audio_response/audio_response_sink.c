@@ -0,0 +1,53 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+/* STD headers */
+#include <string.h>
+#include <platform.h>
+#include <xs1.h>
+
+/* FreeRTOS headers */
+#include "FreeRTOS.h"
+
+/* App headers */
+#include "app_conf.h"
+#include "platform/driver_instances.h"
+#include "audio_response.h"
+
+/* Both sinks are written from the audio response sink task only */
+static int32_t i2s_audio[2 * appconfAUDIO_PIPELINE_FRAME_ADVANCE];
+
+/* Copy a block to both channels, padding a short block with silence */
+static void to_stereo(const int16_t *samples, size_t frames)
+{
+    memset(i2s_audio, 0x00, sizeof(i2s_audio));
+    for (int i = 0; i < frames; i++) {
+        i2s_audio[(2 * i) + 0] = (int32_t) samples[i] << 16;
+        i2s_audio[(2 * i) + 1] = (int32_t) samples[i] << 16;
+    }
+}
+
+AUDIO_RESPONSE_SINK_FPTRGROUP
+static void i2s_write(void *ctx, const int16_t *samples, size_t frames)
+{
+    (void) ctx;
+    to_stereo(samples, frames);
+    rtos_i2s_tx(i2s_ctx,
+                (int32_t*) i2s_audio,
+                appconfAUDIO_PIPELINE_FRAME_ADVANCE,
+                portMAX_DELAY);
+}
+
+AUDIO_RESPONSE_SINK_FPTRGROUP
+static void intertile_write(void *ctx, const int16_t *samples, size_t frames)
+{
+    (void) ctx;
+    to_stereo(samples, frames);
+    rtos_intertile_tx(intertile_ctx,
+                      appconfI2S_OUTPUT_SLAVE_PORT,
+                      i2s_audio,
+                      sizeof(i2s_audio));
+}
+
+const audio_response_sink_t audio_response_sink_i2s = {i2s_write, NULL};
+const audio_response_sink_t audio_response_sink_intertile = {intertile_write, NULL};
@@ -81,7 +81,11 @@ drwav_bool32 drwav_seek_proc_port(void* pUserData, int offset, drwav_seek_origin
     FIL *file = (FIL*)pUserData;
     FRESULT result;
 
-    result = f_lseek(file, offset);
+    if (origin == drwav_seek_origin_current) {
+        result = f_lseek(file, f_tell(file) + offset);
+    } else {
+        result = f_lseek(file, offset);
+    }
 
     return (result == FR_OK) ? DRWAV_TRUE : DRWAV_FALSE;;
 }
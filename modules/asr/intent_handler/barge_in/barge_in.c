@@ -0,0 +1,108 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "barge_in.h"
+
+/* The coupling settles on the loudest echo. It rises by at most
+ * COUPLING_RISE_DB per block, slower than a talker starts, and otherwise
+ * falls by COUPLING_DECAY_DB per block. */
+#define COUPLING_RISE_DB        0.5f
+#define COUPLING_DECAY_DB       0.25f
+
+static float db_to_power(float db)
+{
+    return powf(10.0f, db / 10.0f);
+}
+
+static float power_to_db(float power)
+{
+    return 10.0f * log10f(power);
+}
+
+static uint32_t mean_square(const int16_t *samples, size_t n)
+{
+    uint64_t sum = 0;
+
+    if (n == 0) {
+        return 0;
+    }
+    for (size_t i = 0; i < n; i++) {
+        sum += (int32_t)samples[i] * samples[i];
+    }
+    return (uint32_t)(sum / n);
+}
+
+void barge_in_init(barge_in_t *state)
+{
+    memset(state, 0, sizeof(*state));
+    state->coupling = db_to_power(appconfBARGE_IN_INITIAL_COUPLING_DB);
+    state->threshold = db_to_power(appconfBARGE_IN_THRESHOLD_DB);
+}
+
+void barge_in_reference(barge_in_t *state, const int16_t *samples, size_t n)
+{
+    uint32_t level = mean_square(samples, n);
+    uint32_t pending = __atomic_load_n(&state->ref_pending, __ATOMIC_RELAXED);
+
+    /* Keep the loudest frame played since the last ASR block */
+    while (level > pending &&
+           !__atomic_compare_exchange_n(&state->ref_pending, &pending, level, 1,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    }
+}
+
+barge_in_decision_t barge_in_process(barge_in_t *state, const int16_t *samples, size_t n)
+{
+    uint32_t ref_level = 0;
+
+    state->ref_history[state->ref_pos] = __atomic_exchange_n(&state->ref_pending, 0, __ATOMIC_ACQUIRE);
+    state->ref_pos = (state->ref_pos + 1) % appconfBARGE_IN_REF_HISTORY;
+    for (int i = 0; i < appconfBARGE_IN_REF_HISTORY; i++) {
+        if (state->ref_history[i] > ref_level) {
+            ref_level = state->ref_history[i];
+        }
+    }
+
+    state->stats.block_count++;
+    if (state->hold > 0) {
+        state->hold--;
+    }
+
+    if (ref_level < appconfBARGE_IN_REF_FLOOR) {
+        return BARGE_IN_IDLE;
+    }
+
+    float ratio = (float)mean_square(samples, n) / ref_level;
+
+    if (ratio > state->coupling * state->threshold) {
+        /* Talk over the playback, the coupling is not updated */
+        state->hold = appconfBARGE_IN_HOLD_BLOCKS;
+        state->stats.talk_count++;
+        return BARGE_IN_TALK;
+    }
+
+    if (state->hold > 0) {
+        /* The talker may still be heard below the threshold, so the coupling
+         * is held until the gate closes */
+        return BARGE_IN_TALK;
+    }
+
+    if (ratio > state->coupling) {
+        float rise = ratio / state->coupling;
+        state->coupling *= rise < db_to_power(COUPLING_RISE_DB) ? rise : db_to_power(COUPLING_RISE_DB);
+    } else {
+        state->coupling *= db_to_power(-COUPLING_DECAY_DB);
+    }
+    state->stats.echo_count++;
+    return BARGE_IN_ECHO;
+}
+
+void barge_in_stats_get(const barge_in_t *state, barge_in_stats_t *stats)
+{
+    *stats = state->stats;
+    stats->coupling_db = power_to_db(state->coupling);
+}
@@ -0,0 +1,114 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef BARGE_IN_H_
+#define BARGE_IN_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * \addtogroup barge_in barge_in
+ *
+ * Barge-in gate for keeping the ASR running while an audio response plays.
+ *
+ * The audio response player passes each frame it plays to
+ * barge_in_reference(), and the intent engine passes each block of ASR
+ * input to barge_in_process(). The gate compares the level of the ASR input
+ * with the loudest playback level over the last appconfBARGE_IN_REF_HISTORY
+ * blocks, which covers the delay from the player to the microphones. While
+ * only the echo of the playback is heard this ratio settles at the echo
+ * coupling, which is tracked. A ratio appconfBARGE_IN_THRESHOLD_DB above
+ * the coupling means that someone is talking over the playback, and the gate
+ * then opens for appconfBARGE_IN_HOLD_BLOCKS blocks, long enough for the ASR
+ * to report a keyword at the end of the utterance.
+ *
+ * barge_in_reference() and barge_in_process() may be called from different
+ * tasks on the same tile.
+ * @{
+ */
+
+/* Number of ASR blocks of playback level compared with the ASR input */
+#ifndef appconfBARGE_IN_REF_HISTORY
+#define appconfBARGE_IN_REF_HISTORY         8
+#endif
+
+/* Level of the ASR input above the echo, in dB, at which the gate opens */
+#ifndef appconfBARGE_IN_THRESHOLD_DB
+#define appconfBARGE_IN_THRESHOLD_DB        9.0f
+#endif
+
+/* Number of ASR blocks the gate stays open after talk is last heard */
+#ifndef appconfBARGE_IN_HOLD_BLOCKS
+#define appconfBARGE_IN_HOLD_BLOCKS         64
+#endif
+
+/* Echo coupling, in dB, assumed at the start of the first response. A high
+ * value keeps the gate closed until the coupling has been measured. */
+#ifndef appconfBARGE_IN_INITIAL_COUPLING_DB
+#define appconfBARGE_IN_INITIAL_COUPLING_DB 0.0f
+#endif
+
+/* Mean square playback level, of 16 bit samples, below which the playback
+ * is treated as silent (about -60 dBFS) */
+#ifndef appconfBARGE_IN_REF_FLOOR
+#define appconfBARGE_IN_REF_FLOOR           1000
+#endif
+
+typedef enum {
+    BARGE_IN_IDLE = 0,  // No playback is heard, results are accepted
+    BARGE_IN_ECHO,      // Only the playback is heard, results are rejected
+    BARGE_IN_TALK,      // Talk is heard over the playback, results are accepted
+} barge_in_decision_t;
+
+typedef struct {
+    uint32_t block_count;
+    uint32_t echo_count;        // Blocks with playback heard and the gate closed
+    uint32_t talk_count;        // Blocks with talk heard over the playback
+    float coupling_db;          // Estimated echo level relative to the playback
+} barge_in_stats_t;
+
+typedef struct {
+    uint32_t ref_pending;       // Loudest playback frame since the last block
+    uint32_t ref_history[appconfBARGE_IN_REF_HISTORY];
+    unsigned ref_pos;
+    float coupling;
+    float threshold;
+    unsigned hold;
+    barge_in_stats_t stats;
+} barge_in_t;
+
+/**
+ * Initialize the gate.
+ */
+void barge_in_init(barge_in_t *state);
+
+/**
+ * Pass a frame of playback to the gate.
+ *
+ * \param state    The gate.
+ * \param samples  The mono playback samples.
+ * \param n        The number of samples.
+ */
+void barge_in_reference(barge_in_t *state, const int16_t *samples, size_t n);
+
+/**
+ * Pass a block of ASR input to the gate, called for every block whether or
+ * not a response is playing.
+ *
+ * \param state    The gate.
+ * \param samples  The ASR input samples.
+ * \param n        The number of samples.
+ * \returns        BARGE_IN_ECHO if ASR results from around this block should
+ *                 be rejected, otherwise BARGE_IN_IDLE or BARGE_IN_TALK.
+ */
+barge_in_decision_t barge_in_process(barge_in_t *state, const int16_t *samples, size_t n);
+
+/**
+ * Get the gate statistics.
+ */
+void barge_in_stats_get(const barge_in_t *state, barge_in_stats_t *stats);
+
+/**@}*/
+
+#endif /* BARGE_IN_H_ */
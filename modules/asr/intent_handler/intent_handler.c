@@ -25,11 +25,9 @@
 
 #if ON_TILE(ASR_TILE_NO)
 
-static bool audio_response_playing = 0;
-
 static void proc_keyword_res(void *args) {
     QueueHandle_t q_intent = (QueueHandle_t) args;
-    int32_t id = 0;
+    intent_message_t msg = {0};
     int32_t host_status = 0;
 
     configASSERT(q_intent != 0);
@@ -46,7 +44,7 @@ static void proc_keyword_res(void *args) {
     audio_response_init();
 #endif
     while(1) {
-        xQueueReceive(q_intent, &id, portMAX_DELAY);
+        xQueueReceive(q_intent, &msg, portMAX_DELAY);
 
         host_status = rtos_gpio_port_in(gpio_ctx_t0, p_in_host_status);
 
@@ -58,7 +56,7 @@ static void proc_keyword_res(void *args) {
         }
 #if appconfINTENT_I2C_MASTER_OUTPUT_ENABLED
         i2c_res_t ret;
-        uint32_t buf = id;
+        uint32_t buf = msg.code;
         size_t sent = 0;
 
         ret = rtos_i2c_master_write(
@@ -75,19 +73,37 @@ static void proc_keyword_res(void *args) {
         }
 #endif
 #if appconfINTENT_UART_OUTPUT_ENABLED && (UART_TILE_NO == ASR_TILE_NO)
-        uint32_t buf_uart = id;
+        uint32_t buf_uart = msg.code;
         rtos_uart_tx_write(uart_tx_ctx, (uint8_t*)&buf_uart, sizeof(uint32_t));
 #endif
 #if appconfAUDIO_PLAYBACK_ENABLED
-        audio_response_playing = true;
-        audio_response_play(id);
-        audio_response_playing = false;
+        if (msg.wav_id >= 0) {
+            audio_response_start(msg.wav_id);
+        }
 #endif
     }
 }
 
 bool intent_handler_response_playing() {
-    return audio_response_playing;
+#if appconfAUDIO_PLAYBACK_ENABLED
+    return audio_response_busy();
+#else
+    return false;
+#endif
+}
+
+bool intent_handler_response_barge_in(const int16_t *samples, size_t n) {
+#if appconfAUDIO_PLAYBACK_ENABLED
+    return audio_response_barge_in(samples, n) != 0;
+#else
+    return true;
+#endif
+}
+
+void intent_handler_response_stop(void) {
+#if appconfAUDIO_PLAYBACK_ENABLED
+    audio_response_stop();
+#endif
 }
 
 int32_t intent_handler_create(uint32_t priority, void *args)
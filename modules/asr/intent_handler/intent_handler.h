@@ -5,6 +5,14 @@
 #define INTENT_HANDLER_H_
 
 #include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/* Keep the ASR running while an audio response plays, and stop the response
+ * when a keyword or command is heard over it */
+#ifndef appconfINTENT_BARGE_IN_ENABLED
+#define appconfINTENT_BARGE_IN_ENABLED  0
+#endif
 
 #if XK_VOICE_L71
 #define GPIO_OUT_HOST_WAKEUP_PORT   XS1_PORT_1D  /* PORT_SPI_MOSI */
@@ -19,8 +27,20 @@
 #define GPIO_IN_HOST_STATUS_PORT    0
 #endif
 
+/* Queue message from the intent engine */
+typedef struct {
+    int32_t wav_id;     // Audio response to play, -1 for none
+    int32_t code;       // Code sent to the host over I2C and UART
+} intent_message_t;
+
 int32_t intent_handler_create(uint32_t priority, void *args);
 
 bool intent_handler_response_playing();
 
+/* Pass a block of ASR input to the barge-in gate. Returns false if ASR results
+ * are to be rejected because only the audio response is heard. */
+bool intent_handler_response_barge_in(const int16_t *samples, size_t n);
+
+void intent_handler_response_stop(void);
+
 #endif /* INTENT_HANDLER_H_ */
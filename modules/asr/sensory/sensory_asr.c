@@ -11,6 +11,7 @@
 #include "asr.h"
 #include "device_memory.h"
 #include "sensory_conf.h"
+#include "profile.h"
 
 typedef struct sensory_asr_struct
 {
@@ -23,6 +24,8 @@ typedef struct sensory_asr_struct
 
 } sensory_asr_t;
 
+PROFILE_PROBE_DEFINE(sensory_probe, "sensory_process");
+
 static devmem_manager_t *devmem_ctx = NULL;
 static sensory_asr_t sensory_asr;
 
@@ -129,14 +132,10 @@ asr_error_t asr_process(asr_port_t *ctx, int16_t *audio_buf, size_t buf_len)
     sensory_asr->brick_count++;
     sensory_asr->word_id = -1;
 
-    // Uncomment the line below to compute MIPS usage.
-    // uint32_t timer_start = get_reference_time();
-
+    // Build with appconfPROFILE_ENABLED=1 to measure the MIPS usage
+    PROFILE_START(sensory_probe);
     error = SensoryProcessData((s16 *) audio_buf, app);
-
-    // Uncomment the two lines below to compute MIPS usage.
-    // uint32_t timer_end = get_reference_time();
-    // asr_printf("Sensory processing time: %lu (us)\n", (timer_end - timer_start) / 100);
+    PROFILE_END(sensory_probe);
 
     // if (t->tokensPruned) {
     //     asr_printf("Search for recognizer was limited by maxTokens count %d\n"
@@ -0,0 +1,85 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "frame_pool.h"
+
+#define FRAME_POOL_RING_MASK    (FRAME_POOL_MAX_DEPTH - 1)
+
+void frame_pool_init(frame_pool_t *pool, void *storage, size_t frame_size, uint32_t depth)
+{
+    assert(storage != NULL);
+    assert(((uintptr_t)storage & 0x7) == 0);
+    assert((depth > 0) && (depth <= FRAME_POOL_MAX_DEPTH));
+
+    memset(pool, 0, sizeof(frame_pool_t));
+    pool->storage = storage;
+    pool->block_size = FRAME_POOL_BLOCK_SIZE(frame_size);
+    pool->depth = depth;
+
+    for (uint32_t i = 0; i < depth; i++) {
+        pool->free_ring[i] = (uint8_t)i;
+    }
+    pool->free_head = 0;
+    pool->free_tail = depth;
+}
+
+void *frame_pool_alloc(frame_pool_t *pool)
+{
+    uint32_t head = pool->free_head;
+    /* Acquire ensures the ring slot written by the releasing task is visible before it is read */
+    uint32_t tail = __atomic_load_n(&pool->free_tail, __ATOMIC_ACQUIRE);
+
+    if (head == tail) {
+        pool->alloc_fail_count++;
+        return NULL;
+    }
+
+    uint8_t idx = pool->free_ring[head & FRAME_POOL_RING_MASK];
+    __atomic_store_n(&pool->free_head, head + 1, __ATOMIC_RELEASE);
+
+    uint32_t in_use = pool->depth - (tail - (head + 1));
+    if (in_use > pool->high_water_mark) {
+        pool->high_water_mark = in_use;
+    }
+    pool->alloc_count++;
+
+    return pool->storage + (idx * pool->block_size);
+}
+
+void frame_pool_release(frame_pool_t *pool, void *frame)
+{
+    assert(frame_pool_owns(pool, frame));
+
+    uint32_t offset = (uint32_t)((uint8_t *)frame - pool->storage);
+    uint32_t tail = pool->free_tail;
+
+    pool->free_ring[tail & FRAME_POOL_RING_MASK] = (uint8_t)(offset / pool->block_size);
+    /* Release ensures the ring slot is written before the allocating task can see it */
+    __atomic_store_n(&pool->free_tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+int frame_pool_owns(const frame_pool_t *pool, const void *frame)
+{
+    const uint8_t *p = frame;
+
+    if ((p < pool->storage) || (p >= pool->storage + (pool->depth * pool->block_size))) {
+        return 0;
+    }
+    return (((size_t)(p - pool->storage) % pool->block_size) == 0);
+}
+
+void frame_pool_stats_get(const frame_pool_t *pool, frame_pool_stats_t *stats)
+{
+    uint32_t head = __atomic_load_n(&pool->free_head, __ATOMIC_ACQUIRE);
+    uint32_t tail = __atomic_load_n(&pool->free_tail, __ATOMIC_ACQUIRE);
+
+    stats->depth = pool->depth;
+    stats->in_use = pool->depth - (tail - head);
+    stats->high_water_mark = pool->high_water_mark;
+    stats->alloc_count = pool->alloc_count;
+    stats->alloc_fail_count = pool->alloc_fail_count;
+}
@@ -0,0 +1,89 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef FRAME_POOL_H_
+#define FRAME_POOL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Maximum number of frames a single pool can hold. Must be a power of 2. */
+#define FRAME_POOL_MAX_DEPTH    (32)
+
+/* Blocks are rounded up to a multiple of 8 bytes so that every frame is double word aligned */
+#define FRAME_POOL_BLOCK_SIZE(frame_size)           ( ((frame_size) + 7) & ~((size_t)7) )
+#define FRAME_POOL_STORAGE_SIZE(frame_size, depth)  ( FRAME_POOL_BLOCK_SIZE(frame_size) * (depth) )
+
+typedef struct {
+    uint32_t depth;             // Number of frames in the pool
+    uint32_t in_use;            // Number of frames currently allocated
+    uint32_t high_water_mark;   // Maximum number of frames that have been allocated at the same time
+    uint32_t alloc_count;       // Number of successful allocations
+    uint32_t alloc_fail_count;  // Number of allocations attempted while the pool was exhausted
+} frame_pool_stats_t;
+
+/**
+ * Fixed capacity pool of equally sized frame buffers.
+ *
+ * Free frames are tracked in a single producer, single consumer ring of block
+ * indices, so allocation and release are O(1) and never take a lock. One task
+ * may allocate while one other task releases. In the audio pipelines these are
+ * the pipeline input and output tasks respectively.
+ */
+typedef struct {
+    uint8_t *storage;
+    size_t block_size;
+    uint32_t depth;
+    uint8_t free_ring[FRAME_POOL_MAX_DEPTH];
+    volatile uint32_t free_head;    // Written only by the allocating task
+    volatile uint32_t free_tail;    // Written only by the releasing task
+    uint32_t high_water_mark;
+    uint32_t alloc_count;
+    uint32_t alloc_fail_count;
+} frame_pool_t;
+
+/**
+ * Initialize a frame pool over caller provided storage.
+ *
+ * \param pool        The pool to initialize.
+ * \param storage     Double word aligned memory of at least
+ *                    FRAME_POOL_STORAGE_SIZE(frame_size, depth) bytes.
+ * \param frame_size  Size in bytes of one frame.
+ * \param depth       Number of frames in the pool, up to FRAME_POOL_MAX_DEPTH.
+ */
+void frame_pool_init(frame_pool_t *pool, void *storage, size_t frame_size, uint32_t depth);
+
+/**
+ * Take a frame from the pool. The contents of the frame are not cleared.
+ *
+ * \param pool  The pool to allocate from.
+ * \return      A pointer to the frame, or NULL if every frame is in use.
+ */
+void *frame_pool_alloc(frame_pool_t *pool);
+
+/**
+ * Return a frame previously obtained with frame_pool_alloc() to the pool.
+ *
+ * \param pool   The pool the frame was allocated from.
+ * \param frame  The frame to return.
+ */
+void frame_pool_release(frame_pool_t *pool, void *frame);
+
+/**
+ * Check whether a pointer refers to a frame owned by the pool.
+ *
+ * \param pool   The pool to check.
+ * \param frame  The pointer to check.
+ * \return       1 if the frame belongs to the pool, otherwise 0.
+ */
+int frame_pool_owns(const frame_pool_t *pool, const void *frame);
+
+/**
+ * Read the pool usage statistics. May be called from any task.
+ *
+ * \param pool   The pool to query.
+ * \param stats  Filled with the current statistics.
+ */
+void frame_pool_stats_get(const frame_pool_t *pool, frame_pool_stats_t *stats);
+
+#endif /* FRAME_POOL_H_ */
@@ -0,0 +1,86 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "frame_trace.h"
+#include "profile.h"
+
+/* Bare metal applications and host builds print with printf */
+#if __has_include("rtos_printf.h")
+#include "rtos_printf.h"
+#define trace_printf    rtos_printf
+#else
+#define trace_printf    printf
+#endif
+
+/* Like every other probe, only recorded when appconfPROFILE_ENABLED is set.
+ * Frames over the latency budget are counted and logged either way. */
+PROFILE_PROBE_DEFINE(latency_probe, "latency");
+PROFILE_PROBE_DEFINE(hop_probe, "lat_hop");
+PROFILE_PROBE_DEFINE(tx_wait_probe, "lat_tx_wait");
+
+static uint32_t frame_count;
+static uint32_t overrun_count;
+
+void frame_trace_capture(frame_trace_t *trace, uint32_t now)
+{
+    memset(trace, 0, sizeof(*trace));
+    trace->capture_ticks = now;
+}
+
+void frame_trace_tx_done(const frame_trace_t *trace, uint32_t now)
+{
+    PROFILE_RECORD(tx_wait_probe, now - trace->capture_ticks - trace->tx_ticks);
+    (void)trace;
+    (void)now;
+}
+
+void frame_trace_rx(frame_trace_t *trace, uint32_t rx_start, uint32_t now)
+{
+    trace->capture_ticks = rx_start - trace->tx_ticks;
+    trace->rx_ticks = now - trace->capture_ticks;
+}
+
+static void trace_log(const frame_trace_t *trace, uint32_t latency, uint32_t budget_ticks)
+{
+    char line[128] = "";
+    int len = 0;
+
+    for (unsigned s = 0; s < PIPELINE_STAGE_COUNT; s++) {
+        if (trace->stage_ticks[s] != 0) {
+            len += snprintf(&line[len], sizeof(line) - len, " %s=%u",
+                            pipeline_graph_stage_name(s),
+                            (unsigned)trace->stage_ticks[s]);
+        }
+    }
+    trace_printf("frame %u latency %u over budget %u: tx=%u rx=%u%s ticks\n",
+                 (unsigned)frame_count,
+                 (unsigned)latency,
+                 (unsigned)budget_ticks,
+                 (unsigned)trace->tx_ticks,
+                 (unsigned)trace->rx_ticks,
+                 line);
+}
+
+uint32_t frame_trace_output(frame_trace_t *trace, uint32_t now, uint32_t budget_ticks)
+{
+    uint32_t latency = now - trace->capture_ticks;
+
+    PROFILE_RECORD(latency_probe, latency);
+    PROFILE_RECORD(hop_probe, trace->rx_ticks);
+
+    if (budget_ticks != 0 && latency > budget_ticks) {
+        overrun_count++;
+        trace_log(trace, latency, budget_ticks);
+    }
+    frame_count++;
+    return latency;
+}
+
+uint32_t frame_trace_overrun_count(void)
+{
+    return overrun_count;
+}
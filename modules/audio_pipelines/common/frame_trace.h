@@ -0,0 +1,101 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef FRAME_TRACE_H_
+#define FRAME_TRACE_H_
+
+#include <stdint.h>
+
+#include "pipeline_graph.h"
+
+/**
+ * \addtogroup frame_trace frame_trace
+ *
+ * Per frame latency tracing for the audio pipelines.
+ *
+ * A frame carries a trace from its capture by the pipeline input to the
+ * pipeline output. The trace holds the capture time and, for each point the
+ * frame passes, the latency at that point: the time since capture. Stage
+ * latencies are indexed by pipeline_stage_id_t.
+ *
+ * The reference timers of the tiles are not synchronised, so a frame sent to
+ * another tile carries the latency at which it was sent. The receiving tile
+ * rebases the capture time onto its own timer from the time the message
+ * started to arrive, which keeps the transfer itself in the latency. Any time
+ * the sending tile waits for the receiver to start taking the message is not
+ * in the frame latency, so the time taken to send each frame, wait included,
+ * is recorded on the sending tile in the "lat_tx_wait" profiling probe.
+ *
+ * The pipeline output records the end to end latency, and the latency at
+ * which the frame reached the output tile, in the "latency" and "lat_hop"
+ * profiling probes, from which the min, average, max and 99th percentile can
+ * be read with profile_stats_get(). The probes are only recorded when
+ * appconfPROFILE_ENABLED is set. Frames over a latency budget are counted
+ * and logged with their per point latencies whether or not it is.
+ *
+ * Times are in 100 MHz reference clock ticks and are passed in by the caller,
+ * so the module is OS independent.
+ * @{
+ */
+
+typedef struct {
+    uint32_t capture_ticks;                     // Capture time, on the timer of the tile holding the frame
+    uint32_t stage_ticks[PIPELINE_STAGE_COUNT]; // Latency at the end of each stage, 0 for stages not run
+    uint32_t tx_ticks;                          // Latency when sent to the output tile
+    uint32_t rx_ticks;                          // Latency when received by the output tile
+} frame_trace_t;
+
+/**
+ * Start the trace of a frame captured at now.
+ */
+void frame_trace_capture(frame_trace_t *trace, uint32_t now);
+
+/**
+ * Record the end of a stage.
+ */
+static inline void frame_trace_stage(frame_trace_t *trace, unsigned stage, uint32_t now)
+{
+    trace->stage_ticks[stage] = now - trace->capture_ticks;
+}
+
+/**
+ * Record that the frame is being sent to the output tile.
+ */
+static inline void frame_trace_tx(frame_trace_t *trace, uint32_t now)
+{
+    trace->tx_ticks = now - trace->capture_ticks;
+}
+
+/**
+ * Record that the frame has been sent to the output tile.
+ */
+void frame_trace_tx_done(const frame_trace_t *trace, uint32_t now);
+
+/**
+ * Rebase a trace received from another tile onto the timer of this tile.
+ *
+ * \param trace     The received trace.
+ * \param rx_start  Time the message started to arrive.
+ * \param now       Time the frame was received.
+ */
+void frame_trace_rx(frame_trace_t *trace, uint32_t rx_start, uint32_t now);
+
+/**
+ * Record the end to end latency of a frame at the pipeline output.
+ *
+ * \param trace         The trace.
+ * \param now           Time the frame is output.
+ * \param budget_ticks  Latency budget, frames over it are counted and
+ *                      logged. 0 for no budget.
+ * \returns             The latency.
+ */
+uint32_t frame_trace_output(frame_trace_t *trace, uint32_t now, uint32_t budget_ticks);
+
+/**
+ * Get the number of frames output over the latency budget.
+ */
+uint32_t frame_trace_overrun_count(void);
+
+/**@}*/
+
+#endif /* FRAME_TRACE_H_ */
@@ -0,0 +1,75 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "frame_transport.h"
+
+static size_t field_message_size(const frame_transport_field_t *field)
+{
+    if (field->encoding == FRAME_TRANSPORT_INT16) {
+        return field->size / 2;
+    }
+    return field->size;
+}
+
+size_t frame_transport_size(const frame_transport_desc_t *desc)
+{
+    size_t len = 0;
+
+    for (size_t i = 0; i < desc->num_fields; i++) {
+        len += field_message_size(&desc->fields[i]);
+    }
+    return len;
+}
+
+size_t frame_transport_pack(const frame_transport_desc_t *desc, void *msg, const void *frame)
+{
+    uint8_t *dst = msg;
+
+    for (size_t i = 0; i < desc->num_fields; i++) {
+        const frame_transport_field_t *field = &desc->fields[i];
+        const uint8_t *src = (const uint8_t *)frame + field->offset;
+
+        if (field->encoding == FRAME_TRANSPORT_INT16) {
+            const int32_t *in = (const int32_t *)src;
+            int16_t *out = (int16_t *)dst;
+
+            assert((field->size % sizeof(int32_t)) == 0);
+            assert(((uintptr_t)out & 0x1) == 0);
+            for (size_t j = 0; j < field->size / sizeof(int32_t); j++) {
+                out[j] = (int16_t)(in[j] >> 16);
+            }
+        } else {
+            memcpy(dst, src, field->size);
+        }
+        dst += field_message_size(field);
+    }
+    return (size_t)(dst - (uint8_t *)msg);
+}
+
+size_t frame_transport_unpack(const frame_transport_desc_t *desc, void *frame, const void *msg)
+{
+    const uint8_t *src = msg;
+
+    for (size_t i = 0; i < desc->num_fields; i++) {
+        const frame_transport_field_t *field = &desc->fields[i];
+        uint8_t *dst = (uint8_t *)frame + field->offset;
+
+        if (field->encoding == FRAME_TRANSPORT_INT16) {
+            const int16_t *in = (const int16_t *)src;
+            int32_t *out = (int32_t *)dst;
+
+            assert(((uintptr_t)in & 0x1) == 0);
+            for (size_t j = 0; j < field->size / sizeof(int32_t); j++) {
+                out[j] = (int32_t)((uint32_t)(uint16_t)in[j] << 16);
+            }
+        } else {
+            memcpy(dst, src, field->size);
+        }
+        src += field_message_size(field);
+    }
+    return (size_t)(src - (const uint8_t *)msg);
+}
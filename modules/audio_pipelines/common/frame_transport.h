@@ -0,0 +1,66 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef FRAME_TRANSPORT_H_
+#define FRAME_TRANSPORT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Transfer the field as is */
+#define FRAME_TRANSPORT_RAW     (0)
+/* Transfer the int32_t samples of the field as their upper 16 bits. The lower
+ * 16 bits of each sample are zero after unpacking. */
+#define FRAME_TRANSPORT_INT16   (1)
+
+/* Describe member of frame type type, transferred using encoding */
+#define FRAME_TRANSPORT_FIELD(type, member, encoding) \
+    { (uint16_t)offsetof(type, member), (uint16_t)sizeof(((type *)0)->member), (uint16_t)(encoding) }
+
+typedef struct {
+    uint16_t offset;    // Byte offset of the field in the frame
+    uint16_t size;      // Size of the field in the frame, in bytes
+    uint16_t encoding;  // FRAME_TRANSPORT_RAW or FRAME_TRANSPORT_INT16
+} frame_transport_field_t;
+
+/**
+ * Description of the parts of a frame that are sent between tiles.
+ *
+ * Only the listed fields are serialised, in order, into one contiguous
+ * message. Fields not listed are left untouched by frame_transport_unpack(),
+ * so the receiver should clear the frame first if it reads them.
+ */
+typedef struct {
+    const frame_transport_field_t *fields;
+    size_t num_fields;
+} frame_transport_desc_t;
+
+/**
+ * Get the size of the message produced by frame_transport_pack().
+ *
+ * \param desc  The frame description.
+ * \return      The message size in bytes.
+ */
+size_t frame_transport_size(const frame_transport_desc_t *desc);
+
+/**
+ * Serialise the described fields of a frame into a message.
+ *
+ * \param desc   The frame description.
+ * \param msg    Buffer of at least frame_transport_size(desc) bytes.
+ * \param frame  The frame to serialise.
+ * \return       The number of bytes written to msg.
+ */
+size_t frame_transport_pack(const frame_transport_desc_t *desc, void *msg, const void *frame);
+
+/**
+ * Deserialise a message produced by frame_transport_pack() into a frame.
+ *
+ * \param desc   The frame description, which must match the sender's.
+ * \param frame  The frame to write the described fields to.
+ * \param msg    The received message.
+ * \return       The number of bytes read from msg.
+ */
+size_t frame_transport_unpack(const frame_transport_desc_t *desc, void *frame, const void *msg);
+
+#endif /* FRAME_TRANSPORT_H_ */
@@ -0,0 +1,206 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pipeline_graph.h"
+
+static const char * const stage_names[PIPELINE_STAGE_COUNT] = {
+    [PIPELINE_STAGE_DELAY] = "delay",
+    [PIPELINE_STAGE_AEC] = "aec",
+    [PIPELINE_STAGE_IC_VNR] = "ic_vnr",
+    [PIPELINE_STAGE_NS] = "ns",
+    [PIPELINE_STAGE_AGC] = "agc",
+};
+
+const char *pipeline_graph_stage_name(unsigned stage)
+{
+    return stage < PIPELINE_STAGE_COUNT ? stage_names[stage] : NULL;
+}
+
+/* Plan a tile that implements the stages in the implemented mask. With no
+ * stage_fns the graph is only checked. */
+static int plan_tile(pipeline_graph_plan_t *plan,
+                     const pipeline_graph_t *graph,
+                     unsigned tile,
+                     uint32_t implemented,
+                     const pipeline_graph_stage_t *stage_fns)
+{
+    uint32_t stages_seen = 0;
+    int prev_thread = -1;       // Thread of the previous entry of the tile
+    int prev_run_thread = -1;   // Thread of the previous entry of the tile that is run
+
+    memset(plan, 0, sizeof(*plan));
+    if (graph->count > PIPELINE_GRAPH_MAX_ENTRIES) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < graph->count; i++) {
+        const pipeline_graph_entry_t *entry = &graph->entries[i];
+
+        if (entry->stage >= PIPELINE_STAGE_COUNT || entry->thread >= PIPELINE_GRAPH_MAX_THREADS ||
+            (stages_seen & (1u << entry->stage))) {
+            return -1;
+        }
+        stages_seen |= 1u << entry->stage;
+
+        if (entry->tile != tile) {
+            continue;
+        }
+        if (!(implemented & (1u << entry->stage)) || entry->thread < prev_thread) {
+            return -1;
+        }
+        prev_thread = entry->thread;
+        if (entry->bypass) {
+            continue;
+        }
+
+        /* A new thread of the graph starts a new thread of the plan */
+        if (entry->thread != prev_run_thread) {
+            plan->thread_count++;
+            prev_run_thread = entry->thread;
+        }
+        pipeline_graph_thread_t *t = &plan->threads[plan->thread_count - 1];
+        t->stages[t->stage_count++] = stage_fns != NULL ? stage_fns[entry->stage] : NULL;
+    }
+    return 0;
+}
+
+int pipeline_graph_plan(pipeline_graph_plan_t *plan,
+                        const pipeline_graph_t *graph,
+                        unsigned tile,
+                        const pipeline_graph_stage_t stage_fns[PIPELINE_STAGE_COUNT])
+{
+    uint32_t implemented = 0;
+
+    for (unsigned s = 0; s < PIPELINE_STAGE_COUNT; s++) {
+        if (stage_fns[s] != NULL) {
+            implemented |= 1u << s;
+        }
+    }
+    return plan_tile(plan, graph, tile, implemented, stage_fns);
+}
+
+int pipeline_graph_check(const pipeline_graph_t *graph,
+                         const uint32_t *tile_stages,
+                         unsigned tile_count)
+{
+    pipeline_graph_plan_t plan;
+
+    for (size_t i = 0; i < graph->count && i < PIPELINE_GRAPH_MAX_ENTRIES; i++) {
+        if (graph->entries[i].tile >= tile_count) {
+            return -1;
+        }
+    }
+    for (unsigned tile = 0; tile < tile_count; tile++) {
+        if (plan_tile(&plan, graph, tile, tile_stages[tile], NULL) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+uint32_t pipeline_graph_tile_stages(const pipeline_graph_t *graph, unsigned tile)
+{
+    uint32_t stages = 0;
+
+    for (size_t i = 0; i < graph->count && i < PIPELINE_GRAPH_MAX_ENTRIES; i++) {
+        if (graph->entries[i].tile == tile && graph->entries[i].stage < PIPELINE_STAGE_COUNT) {
+            stages |= 1u << graph->entries[i].stage;
+        }
+    }
+    return stages;
+}
+
+static char *skip_space(char *p)
+{
+    while (*p == ' ' || *p == '\t' || *p == '\r') {
+        p++;
+    }
+    return p;
+}
+
+/* Parse a word, returns the character after it */
+static char *parse_word(char *p, char **word)
+{
+    p = skip_space(p);
+    *word = p;
+    while (*p != '\0' && *p != ' ' && *p != '\t' && *p != '\r') {
+        p++;
+    }
+    if (*p != '\0') {
+        *p++ = '\0';
+    }
+    return p;
+}
+
+static char *parse_uint8(char *p, uint8_t *value)
+{
+    char *end;
+
+    p = skip_space(p);
+    unsigned long v = strtoul(p, &end, 0);
+    if (end == p || v > UINT8_MAX) {
+        return NULL;
+    }
+    *value = (uint8_t)v;
+    return end;
+}
+
+static int parse_line(char *p, pipeline_graph_entry_t *entry)
+{
+    char *word;
+
+    memset(entry, 0, sizeof(*entry));
+    p = parse_word(p, &word);
+    entry->stage = PIPELINE_STAGE_COUNT;
+    for (unsigned s = 0; s < PIPELINE_STAGE_COUNT; s++) {
+        if (strcmp(word, stage_names[s]) == 0) {
+            entry->stage = s;
+        }
+    }
+    if (entry->stage == PIPELINE_STAGE_COUNT) {
+        return -1;
+    }
+    if ((p = parse_uint8(p, &entry->tile)) == NULL ||
+        (p = parse_uint8(p, &entry->thread)) == NULL) {
+        return -1;
+    }
+
+    p = parse_word(p, &word);
+    if (strcmp(word, "bypass") == 0) {
+        entry->bypass = 1;
+        p = parse_word(p, &word);
+    }
+    return *word == '\0' ? 0 : -1;
+}
+
+int pipeline_graph_parse(char *text, pipeline_graph_t *graph)
+{
+    int line = 0;
+
+    memset(graph, 0, sizeof(*graph));
+    while (*text != '\0') {
+        char *end = strchr(text, '\n');
+        char *next = end != NULL ? end + 1 : text + strlen(text);
+        char *p;
+
+        if (end != NULL) {
+            *end = '\0';
+        }
+        line++;
+
+        p = skip_space(text);
+        if (*p != '\0' && *p != '#') {
+            if (graph->count == PIPELINE_GRAPH_MAX_ENTRIES ||
+                parse_line(p, &graph->entries[graph->count]) != 0) {
+                return -line;
+            }
+            graph->count++;
+        }
+        text = next;
+    }
+    return graph->count;
+}
@@ -0,0 +1,177 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef PIPELINE_GRAPH_H_
+#define PIPELINE_GRAPH_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * \addtogroup pipeline_graph pipeline_graph
+ *
+ * Descriptor of the stages of an audio pipeline.
+ *
+ * A graph lists the stages in the order a frame passes through them, with
+ * the tile and the pipeline thread that runs each one and a bypass flag.
+ * Consecutive stages given the same thread run one after the other in that
+ * thread, so stages can be spread over more threads for throughput or merged
+ * into fewer to save threads and frame hand-overs.
+ *
+ * Each tile turns the graph into a plan with pipeline_graph_plan(). The plan
+ * holds, for each thread, the functions of the stages it runs. Bypassed stages
+ * are left out of the plan, and threads left with no stage are not created,
+ * so a bypassed stage costs no cycles. A stage can only be placed on a tile
+ * whose pipeline implements it.
+ *
+ * The tiles of a pipeline must run the same graph, as the frames of one tile
+ * are passed to the next. pipeline_graph_check() checks a graph for all the
+ * tiles at once, so that they agree on whether to use it.
+ *
+ * The module is OS independent.
+ * @{
+ */
+
+#define PIPELINE_GRAPH_MAX_ENTRIES  (8)
+#define PIPELINE_GRAPH_MAX_THREADS  (4)
+
+typedef enum {
+    PIPELINE_STAGE_DELAY = 0,   // Fixed mic or reference delay
+    PIPELINE_STAGE_AEC,         // AEC, with ADEC in the ADEC pipelines
+    PIPELINE_STAGE_IC_VNR,      // IC and VNR
+    PIPELINE_STAGE_NS,          // NS
+    PIPELINE_STAGE_AGC,         // AGC
+    PIPELINE_STAGE_COUNT,
+} pipeline_stage_id_t;
+
+typedef struct {
+    uint8_t stage;      // pipeline_stage_id_t
+    uint8_t tile;       // Tile that runs the stage
+    uint8_t thread;     // Pipeline thread of the tile that runs the stage
+    uint8_t bypass;     // Bypassed stages are not run
+} pipeline_graph_entry_t;
+
+typedef struct {
+    pipeline_graph_entry_t entries[PIPELINE_GRAPH_MAX_ENTRIES];
+    size_t count;
+} pipeline_graph_t;
+
+/* Only the xcore compiler needs the function pointer group */
+#if defined(__XS3A__)
+#define PIPELINE_GRAPH_STAGE_FPTRGROUP  __attribute__((fptrgroup("pipeline_graph_stage_fptr_grp")))
+#else
+#define PIPELINE_GRAPH_STAGE_FPTRGROUP
+#endif
+
+/**
+ * Process a frame. Stage functions must be defined with
+ * PIPELINE_GRAPH_STAGE_FPTRGROUP so that the stack they need is known.
+ */
+typedef void (*pipeline_graph_stage_t)(void *frame);
+
+typedef struct {
+    PIPELINE_GRAPH_STAGE_FPTRGROUP pipeline_graph_stage_t stages[PIPELINE_GRAPH_MAX_ENTRIES];
+    size_t stage_count;
+} pipeline_graph_thread_t;
+
+typedef struct {
+    pipeline_graph_thread_t threads[PIPELINE_GRAPH_MAX_THREADS];
+    size_t thread_count;    // 0 if the tile runs no stage
+} pipeline_graph_plan_t;
+
+/**
+ * Plan the threads of a tile.
+ *
+ * The entries of the tile must give their threads in non-decreasing order.
+ * Threads are numbered from 0 in the plan, in order, skipping threads left
+ * with no stage. A tile that runs no stage has no threads in the plan.
+ *
+ * \param plan       Filled with the plan.
+ * \param graph      The graph.
+ * \param tile       The tile to plan.
+ * \param stage_fns  The stage functions of the tile's pipeline, indexed by
+ *                   pipeline_stage_id_t, NULL for the stages it does not
+ *                   implement.
+ * \returns          0 on success, or -1 if the graph is invalid for the tile.
+ *                   The graph is invalid if it repeats a stage, places a stage
+ *                   the tile does not implement on the tile, or has a stage ID
+ *                   or thread out of range or threads out of order.
+ */
+int pipeline_graph_plan(pipeline_graph_plan_t *plan,
+                        const pipeline_graph_t *graph,
+                        unsigned tile,
+                        const pipeline_graph_stage_t stage_fns[PIPELINE_STAGE_COUNT]);
+
+/**
+ * Check that a graph is valid for every tile of a pipeline, as
+ * pipeline_graph_plan() would find it, and places no stage on another tile.
+ *
+ * \param graph        The graph.
+ * \param tile_stages  For each tile, a mask of the stages its pipeline
+ *                     implements, with bit n set for pipeline_stage_id_t n.
+ * \param tile_count   The number of tiles.
+ * \returns            0 if the graph is valid for all the tiles, or -1.
+ */
+int pipeline_graph_check(const pipeline_graph_t *graph,
+                         const uint32_t *tile_stages,
+                         unsigned tile_count);
+
+/**
+ * Get the mask of the stages a graph places on a tile, with bit n set for
+ * pipeline_stage_id_t n, whether they are bypassed or not.
+ */
+uint32_t pipeline_graph_tile_stages(const pipeline_graph_t *graph, unsigned tile);
+
+/**
+ * Run the stages of a planned thread on a frame.
+ */
+static inline void pipeline_graph_run_thread(const pipeline_graph_plan_t *plan, unsigned thread, void *frame)
+{
+    const pipeline_graph_thread_t *t = &plan->threads[thread];
+
+    for (size_t i = 0; i < t->stage_count; i++) {
+        t->stages[i](frame);
+    }
+}
+
+/**
+ * Define a plan and the PIPELINE_GRAPH_MAX_THREADS thread functions that run
+ * it, name_thread_0 to name_thread_3, to pass to the generic pipeline.
+ */
+#define PIPELINE_GRAPH_THREAD_DEFINE(name, n) \
+    static void name##_thread_##n(void *frame) { pipeline_graph_run_thread(&name, n, frame); }
+
+#define PIPELINE_GRAPH_PLAN_DEFINE(name) \
+    static pipeline_graph_plan_t name; \
+    PIPELINE_GRAPH_THREAD_DEFINE(name, 0) \
+    PIPELINE_GRAPH_THREAD_DEFINE(name, 1) \
+    PIPELINE_GRAPH_THREAD_DEFINE(name, 2) \
+    PIPELINE_GRAPH_THREAD_DEFINE(name, 3)
+
+_Static_assert(PIPELINE_GRAPH_MAX_THREADS == 4, "PIPELINE_GRAPH_PLAN_DEFINE defines 4 thread functions");
+
+/**
+ * Parse a graph from text, one entry per line in the form
+ *
+ *     <stage> <tile> <thread> [bypass]
+ *
+ * where stage is one of delay, aec, ic_vnr, ns and agc. Blank lines and lines
+ * starting with # are skipped. The text is modified in place.
+ *
+ * \param text   The null terminated text.
+ * \param graph  Filled with the graph.
+ * \returns      The number of entries, or minus the number of the first line
+ *               in error.
+ */
+int pipeline_graph_parse(char *text, pipeline_graph_t *graph);
+
+/**
+ * Get the name of a stage, as used by pipeline_graph_parse().
+ *
+ * \returns  The name, or NULL if the stage ID is out of range.
+ */
+const char *pipeline_graph_stage_name(unsigned stage);
+
+/**@}*/
+
+#endif /* PIPELINE_GRAPH_H_ */
@@ -0,0 +1,75 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <string.h>
+
+#include "stage_blocks.h"
+
+void stage_blocks_init(stage_blocks_t *sb,
+                       uint32_t frame_advance,
+                       int32_t *input,
+                       uint32_t input_channels,
+                       int32_t *output,
+                       uint32_t output_channels)
+{
+    sb->input = input;
+    sb->output = output;
+    sb->input_channels = input_channels;
+    sb->output_channels = output_channels;
+    sb->frame_advance = frame_advance;
+    sb->blocks = STAGE_BLOCKS_PER_FRAME(frame_advance);
+    sb->fill = 0;
+
+    memset(input, 0, STAGE_BLOCKS_STORAGE_SIZE(frame_advance, input_channels) * sizeof(int32_t));
+    memset(output, 0, STAGE_BLOCKS_STORAGE_SIZE(frame_advance, output_channels) * sizeof(int32_t));
+}
+
+/* Copy a frame of one channel to or from the blocks, starting fill samples
+ * into them. A frame spans more than one block when it is longer than one. */
+static void stage_blocks_copy(stage_blocks_t *sb, int32_t *blocks, uint32_t channels, uint32_t ch,
+                              int32_t *samples, int to_blocks)
+{
+    uint32_t pos = sb->fill;
+    uint32_t done = 0;
+
+    while (done < sb->frame_advance) {
+        uint32_t block = pos / STAGE_BLOCK_ADVANCE;
+        uint32_t offset = pos % STAGE_BLOCK_ADVANCE;
+        uint32_t n = STAGE_BLOCK_ADVANCE - offset;
+        if (n > sb->frame_advance - done) {
+            n = sb->frame_advance - done;
+        }
+
+        int32_t *block_samples = &blocks[(block * channels + ch) * STAGE_BLOCK_ADVANCE + offset];
+        if (to_blocks) {
+            memcpy(block_samples, &samples[done], n * sizeof(int32_t));
+        } else {
+            memcpy(&samples[done], block_samples, n * sizeof(int32_t));
+        }
+        pos += n;
+        done += n;
+    }
+}
+
+void stage_blocks_write(stage_blocks_t *sb, uint32_t ch, const int32_t *samples)
+{
+    stage_blocks_copy(sb, sb->input, sb->input_channels, ch, (int32_t *)samples, 1);
+}
+
+uint32_t stage_blocks_advance(stage_blocks_t *sb)
+{
+    sb->fill += sb->frame_advance;
+    if (sb->fill < sb->blocks * STAGE_BLOCK_ADVANCE) {
+        return 0;
+    }
+    sb->fill = 0;
+    return sb->blocks;
+}
+
+void stage_blocks_read(stage_blocks_t *sb, uint32_t ch, int32_t *samples)
+{
+    /* Frames shorter than a block read the output of the previous block,
+     * from where this frame's input ended, or the start of the block just
+     * processed */
+    stage_blocks_copy(sb, sb->output, sb->output_channels, ch, samples, 0);
+}
@@ -0,0 +1,125 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef STAGE_BLOCKS_H_
+#define STAGE_BLOCKS_H_
+
+#include <stdint.h>
+
+/*
+ * Adapts the pipeline frame advance to the block size of the DSP stages.
+ *
+ * The AEC, ADEC, IC, VNR, NS and AGC libraries process blocks of
+ * STAGE_BLOCK_ADVANCE samples, while the pipeline frame advance,
+ * appconfAUDIO_PIPELINE_FRAME_ADVANCE, may be a divisor or a multiple of it.
+ * A stage writes the channels it reads from each frame with
+ * stage_blocks_write(), calls stage_blocks_advance() and processes each of the
+ * blocks it returns from stage_blocks_input() into stage_blocks_output(), then
+ * reads the channels it writes back into the frame with stage_blocks_read().
+ *
+ * Frames longer than a block are split into blocks, which are all processed
+ * in the same frame. Frames shorter than a block are gathered until the block
+ * is full, and the output of each block is spread over the frames that
+ * follow, so the stage delays its channels by STAGE_BLOCKS_LATENCY() samples
+ * and only processes on one frame in every STAGE_BLOCK_ADVANCE / frame advance.
+ */
+
+/* Block size of the DSP libraries, 15 ms at 16 kHz */
+#define STAGE_BLOCK_ADVANCE     (240)
+
+/* Number of blocks stored for a frame advance */
+#define STAGE_BLOCKS_PER_FRAME(frame_advance)   ( ((frame_advance) + STAGE_BLOCK_ADVANCE - 1) / STAGE_BLOCK_ADVANCE )
+
+/* Number of samples of input or output storage needed for the given channels */
+#define STAGE_BLOCKS_STORAGE_SIZE(frame_advance, channels)  ( STAGE_BLOCKS_PER_FRAME(frame_advance) * (channels) * STAGE_BLOCK_ADVANCE )
+
+/* Nonzero if a frame advance can be adapted to the block size */
+#define STAGE_BLOCKS_FRAME_ADVANCE_VALID(frame_advance) \
+    ( ((frame_advance) > 0) && \
+      ((STAGE_BLOCK_ADVANCE % (frame_advance) == 0) || ((frame_advance) % STAGE_BLOCK_ADVANCE == 0)) )
+
+/* Samples by which a stage delays its channels */
+#define STAGE_BLOCKS_LATENCY(frame_advance) \
+    ( ((frame_advance) < STAGE_BLOCK_ADVANCE) ? (STAGE_BLOCK_ADVANCE - (frame_advance)) : 0 )
+
+#ifdef appconfAUDIO_PIPELINE_FRAME_ADVANCE
+#if !STAGE_BLOCKS_FRAME_ADVANCE_VALID(appconfAUDIO_PIPELINE_FRAME_ADVANCE)
+#error appconfAUDIO_PIPELINE_FRAME_ADVANCE must be a divisor or a multiple of STAGE_BLOCK_ADVANCE
+#endif
+
+/* Set when the stages must adapt the frames to blocks. Stages process frames
+ * directly when the frame advance is the block size. */
+#define STAGE_BLOCKS_ADAPTED    (appconfAUDIO_PIPELINE_FRAME_ADVANCE != STAGE_BLOCK_ADVANCE)
+#endif
+
+typedef struct {
+    int32_t *input;             // Blocks of input_channels channels
+    int32_t *output;            // Blocks of output_channels channels
+    uint32_t input_channels;
+    uint32_t output_channels;
+    uint32_t frame_advance;
+    uint32_t blocks;            // Number of blocks stored
+    uint32_t fill;              // Samples of each channel written since the blocks were last processed
+} stage_blocks_t;
+
+/**
+ * Initialize the block adapter of a stage. The storage is cleared, so the
+ * first STAGE_BLOCKS_LATENCY() samples read are 0.
+ *
+ * \param sb               The block adapter.
+ * \param frame_advance    Pipeline frame advance, a divisor or a multiple of
+ *                         STAGE_BLOCK_ADVANCE.
+ * \param input            Storage of STAGE_BLOCKS_STORAGE_SIZE(frame_advance,
+ *                         input_channels) samples, double word aligned.
+ * \param input_channels   Number of channels the stage reads.
+ * \param output           Storage of STAGE_BLOCKS_STORAGE_SIZE(frame_advance,
+ *                         output_channels) samples, double word aligned.
+ * \param output_channels  Number of channels the stage writes.
+ */
+void stage_blocks_init(stage_blocks_t *sb,
+                       uint32_t frame_advance,
+                       int32_t *input,
+                       uint32_t input_channels,
+                       int32_t *output,
+                       uint32_t output_channels);
+
+/**
+ * Write one channel of a frame into the input blocks.
+ *
+ * \param sb       The block adapter.
+ * \param ch       Input channel.
+ * \param samples  frame_advance samples.
+ */
+void stage_blocks_write(stage_blocks_t *sb, uint32_t ch, const int32_t *samples);
+
+/**
+ * Advance by one frame, after its input channels have been written.
+ *
+ * \param sb  The block adapter.
+ * \return    The number of blocks to process before the output is read.
+ *            0 for frames that complete no block.
+ */
+uint32_t stage_blocks_advance(stage_blocks_t *sb);
+
+/**
+ * Read one channel of the output for the frame.
+ *
+ * \param sb       The block adapter.
+ * \param ch       Output channel.
+ * \param samples  Set to frame_advance samples.
+ */
+void stage_blocks_read(stage_blocks_t *sb, uint32_t ch, int32_t *samples);
+
+/* Channel ch of a block. The channels of a block are consecutive, so
+ * stage_blocks_input(sb, block, 0) may be used as an array of channels. */
+static inline int32_t *stage_blocks_input(stage_blocks_t *sb, uint32_t block, uint32_t ch)
+{
+    return &sb->input[(block * sb->input_channels + ch) * STAGE_BLOCK_ADVANCE];
+}
+
+static inline int32_t *stage_blocks_output(stage_blocks_t *sb, uint32_t block, uint32_t ch)
+{
+    return &sb->output[(block * sb->output_channels + ch) * STAGE_BLOCK_ADVANCE];
+}
+
+#endif /* STAGE_BLOCKS_H_ */
@@ -0,0 +1,33 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef STAGE_BUFFERS_H_
+#define STAGE_BUFFERS_H_
+
+#include <string.h>
+
+/*
+ * Ping-pong buffering of the processed channel of a frame.
+ *
+ * Stages read the processed channel from FRAME_STAGE_INPUT() and write their
+ * result to FRAME_STAGE_OUTPUT(), then call FRAME_STAGE_SWAP(). The channel
+ * alternates between samples[0] and proc_buf, so no stage copies its output
+ * back. Stages that can run in-place read and write FRAME_STAGE_INPUT() and do
+ * not swap. FRAME_STAGE_SETTLE() is called once before output to move the
+ * result into samples[0], which only copies if an odd number of stages swapped.
+ *
+ * The frame type must have samples[][], proc_buf[] and proc_buf_active members.
+ */
+#define FRAME_STAGE_INPUT(f)    ( (f)->proc_buf_active ? (f)->proc_buf : (f)->samples[0] )
+#define FRAME_STAGE_OUTPUT(f)   ( (f)->proc_buf_active ? (f)->samples[0] : (f)->proc_buf )
+#define FRAME_STAGE_SWAP(f)     ( (f)->proc_buf_active = !(f)->proc_buf_active )
+
+#define FRAME_STAGE_SETTLE(f) \
+    do { \
+        if ((f)->proc_buf_active) { \
+            memcpy((f)->samples[0], (f)->proc_buf, sizeof((f)->proc_buf)); \
+            (f)->proc_buf_active = 0; \
+        } \
+    } while (0)
+
+#endif /* STAGE_BUFFERS_H_ */
@@ -21,31 +21,68 @@
 #include "app_conf.h"
 #include "audio_pipeline.h"
 #include "audio_pipeline_dsp.h"
+#include "audio_pipeline_transport.h"
 #include "platform/driver_instances.h"
 #include "stage_1.h"
-
-#if appconfAUDIO_PIPELINE_FRAME_ADVANCE != 240
-#error This pipeline is only configured for 240 frame advance
-#endif
+#include "aec_process_frame_threads.h"
+#include "stage_blocks.h"
+#include "profile.h"
 
 #if ON_TILE(1)
+static frame_pool_t frame_pool;
+static uint8_t DWORD_ALIGNED frame_pool_storage[FRAME_POOL_STORAGE_SIZE(sizeof(frame_data_t), appconfAUDIO_PIPELINE_FRAME_POOL_DEPTH)];
+static uint8_t DWORD_ALIGNED frame_transport_buf[FRAME_DATA_TRANSPORT_MAX_BYTES];
+PROFILE_PROBE_DEFINE(aec_probe, "aec");
+
 // Stage1 - AEC, DE, ADEC
 static stage_1_state_t DWORD_ALIGNED stage_1_state;
 static aec_conf_t aec_de_mode_conf;
 static aec_conf_t aec_non_de_mode_conf;
 static adec_config_t adec_conf;
 
+#if STAGE_BLOCKS_ADAPTED
+/* Stage 1 processes blocks of AP_FRAME_ADVANCE samples, with the mic
+ * channels followed by the reference channels */
+static stage_blocks_t aec_blocks;
+static int32_t DWORD_ALIGNED aec_blocks_input[STAGE_BLOCKS_STORAGE_SIZE(appconfAUDIO_PIPELINE_FRAME_ADVANCE, AP_MAX_Y_CHANNELS + AP_MAX_X_CHANNELS)];
+static int32_t DWORD_ALIGNED aec_blocks_output[STAGE_BLOCKS_STORAGE_SIZE(appconfAUDIO_PIPELINE_FRAME_ADVANCE, AEC_MAX_Y_CHANNELS)];
+
+/* Context of the last block, for the frames that complete no block */
+static float_s32_t aec_max_ref_energy;
+static float_s32_t aec_corr_factor[AP_MAX_Y_CHANNELS];
+static int32_t aec_ref_active_flag;
+#endif
+
+void audio_pipeline_frame_release(void *frame)
+{
+    if (frame_pool_owns(&frame_pool, frame)) {
+        frame_pool_release(&frame_pool, frame);
+    } else {
+        vPortFree(frame);
+    }
+}
+
+void audio_pipeline_frame_pool_stats_get(frame_pool_stats_t *stats)
+{
+    frame_pool_stats_get(&frame_pool, stats);
+}
+
 static void *audio_pipeline_input_i(void *input_app_data)
 {
     frame_data_t *frame_data;
 
-    frame_data = pvPortMalloc(sizeof(frame_data_t));
+    frame_data = frame_pool_alloc(&frame_pool);
+    if (frame_data == NULL) {
+        /* Pool exhausted by a downstream stall, fall back to the heap rather than drop input */
+        frame_data = pvPortMalloc(sizeof(frame_data_t));
+    }
     memset(frame_data, 0x00, sizeof(frame_data_t));
 
     audio_pipeline_input(input_app_data,
                        (int32_t **)frame_data->aec_reference_audio_samples,
                        4,
                        appconfAUDIO_PIPELINE_FRAME_ADVANCE);
+    AUDIO_PIPELINE_TRACE_CAPTURE(frame_data);
 
     frame_data->vnr_pred_flag = 0;
 
@@ -57,29 +94,64 @@ static void *audio_pipeline_input_i(void *input_app_data)
 static int audio_pipeline_output_i(frame_data_t *frame_data,
                                    void *output_app_data)
 {
+    AUDIO_PIPELINE_TRACE_TX(frame_data);
+    size_t len = frame_transport_pack(&frame_data_transport, frame_transport_buf, frame_data);
+
     rtos_intertile_tx(intertile_ctx,
                       appconfAUDIOPIPELINE_PORT,
-                      frame_data,
-                      sizeof(frame_data_t));
-    return AUDIO_PIPELINE_FREE_FRAME;
+                      frame_transport_buf,
+                      len);
+    AUDIO_PIPELINE_TRACE_TX_DONE(frame_data);
+
+    audio_pipeline_frame_release(frame_data);
+    return AUDIO_PIPELINE_DONT_FREE_FRAME;
 }
 
+PIPELINE_GRAPH_STAGE_FPTRGROUP
 static void stage_aec(frame_data_t *frame_data)
 {
 #if appconfAUDIO_PIPELINE_SKIP_AEC
+#elif STAGE_BLOCKS_ADAPTED
+    PROFILE_START(aec_probe);
+    for (int ch = 0; ch < AP_MAX_Y_CHANNELS; ch++) {
+        stage_blocks_write(&aec_blocks, ch, frame_data->samples[ch]);
+    }
+    for (int ch = 0; ch < AP_MAX_X_CHANNELS; ch++) {
+        stage_blocks_write(&aec_blocks, AP_MAX_Y_CHANNELS + ch, frame_data->aec_reference_audio_samples[ch]);
+    }
+    uint32_t blocks = stage_blocks_advance(&aec_blocks);
+    for (uint32_t b = 0; b < blocks; b++) {
+        stage_1_process_frame(&stage_1_state,
+                              (int32_t (*)[AP_FRAME_ADVANCE])stage_blocks_output(&aec_blocks, b, 0),
+                              &aec_max_ref_energy,
+                              aec_corr_factor,
+                              &aec_ref_active_flag,
+                              (int32_t (*)[AP_FRAME_ADVANCE])stage_blocks_input(&aec_blocks, b, 0),
+                              (int32_t (*)[AP_FRAME_ADVANCE])stage_blocks_input(&aec_blocks, b, AP_MAX_Y_CHANNELS));
+    }
+    for (int ch = 0; ch < AEC_MAX_Y_CHANNELS; ch++) {
+        stage_blocks_read(&aec_blocks, ch, frame_data->samples[ch]);
+    }
+    PROFILE_END(aec_probe);
+    frame_data->max_ref_energy = aec_max_ref_energy;
+    memcpy(frame_data->aec_corr_factor, aec_corr_factor, sizeof(aec_corr_factor));
+    frame_data->ref_active_flag = aec_ref_active_flag;
 #else
     int32_t DWORD_ALIGNED stage_1_out[AEC_MAX_Y_CHANNELS][appconfAUDIO_PIPELINE_FRAME_ADVANCE];
 
+    PROFILE_START(aec_probe);
     stage_1_process_frame(&stage_1_state,
                           &stage_1_out[0],
                           &frame_data->max_ref_energy,
-                          &frame_data->aec_corr_factor,
+                          frame_data->aec_corr_factor,
                           &frame_data->ref_active_flag,
                           frame_data->samples,
                           frame_data->aec_reference_audio_samples);
+    PROFILE_END(aec_probe);
 
     memcpy(frame_data->samples, stage_1_out, AEC_MAX_Y_CHANNELS * appconfAUDIO_PIPELINE_FRAME_ADVANCE * sizeof(int32_t));
 #endif
+    AUDIO_PIPELINE_TRACE_STAGE(frame_data, PIPELINE_STAGE_AEC);
 }
 
 static void initialize_pipeline_stages(void)
@@ -96,27 +168,68 @@ static void initialize_pipeline_stages(void)
 
     // Disable ADEC's automatic mode. We only want to estimate and correct for the delay at startup
     adec_conf.bypass = 1; // Bypass automatic DE correction
+#if appconfDELAY_ESTIMATOR_ENABLED
+    adec_conf.force_de_cycle_trigger = 0; // The standalone delay estimator aligns the mic and reference instead
+#else
     adec_conf.force_de_cycle_trigger = 1; // Force a delay correction cycle, so that delay correction happens once after initialisation. Make sure this is set back to 0 after adec has requested a transition into DE mode once, to stop any further delay correction (automatic or forced) by ADEC
+#endif
     stage_1_init(&stage_1_state, &aec_de_mode_conf, &aec_non_de_mode_conf, &adec_conf);
+
+    aec_process_frame_threads_init(appconfAUDIO_PIPELINE_AEC_THREADS, appconfAUDIO_PIPELINE_TASK_PRIORITY);
+
+#if STAGE_BLOCKS_ADAPTED
+    stage_blocks_init(&aec_blocks,
+                      appconfAUDIO_PIPELINE_FRAME_ADVANCE,
+                      aec_blocks_input,
+                      AP_MAX_Y_CHANNELS + AP_MAX_X_CHANNELS,
+                      aec_blocks_output,
+                      AEC_MAX_Y_CHANNELS);
+#endif
 }
 
+PIPELINE_GRAPH_PLAN_DEFINE(graph_plan)
+
 void audio_pipeline_init(
     void *input_app_data,
     void *output_app_data)
 {
-    const int stage_count = 1;
-
-    const pipeline_stage_t stages[] = {
-        (pipeline_stage_t)stage_aec,
+    const pipeline_graph_stage_t stage_fns[PIPELINE_STAGE_COUNT] = {
+        [PIPELINE_STAGE_AEC] = (pipeline_graph_stage_t)stage_aec,
     };
 
-    const configSTACK_DEPTH_TYPE stage_stack_sizes[] = {
-        configMINIMAL_STACK_SIZE + RTOS_THREAD_STACK_SIZE(stage_aec) + RTOS_THREAD_STACK_SIZE(audio_pipeline_output_i) + RTOS_THREAD_STACK_SIZE(audio_pipeline_input_i),
+    /* The threads run the stages the pipeline graph places in them */
+    const pipeline_stage_t stages[PIPELINE_GRAPH_MAX_THREADS] = {
+        (pipeline_stage_t)graph_plan_thread_0,
+        (pipeline_stage_t)graph_plan_thread_1,
+        (pipeline_stage_t)graph_plan_thread_2,
+        (pipeline_stage_t)graph_plan_thread_3,
+    };
 
+    configSTACK_DEPTH_TYPE stage_stack_sizes[PIPELINE_GRAPH_MAX_THREADS] = {
+        configMINIMAL_STACK_SIZE + RTOS_THREAD_STACK_SIZE(graph_plan_thread_0),
+        configMINIMAL_STACK_SIZE + RTOS_THREAD_STACK_SIZE(graph_plan_thread_1),
+        configMINIMAL_STACK_SIZE + RTOS_THREAD_STACK_SIZE(graph_plan_thread_2),
+        configMINIMAL_STACK_SIZE + RTOS_THREAD_STACK_SIZE(graph_plan_thread_3),
     };
 
+    frame_pool_init(&frame_pool,
+                    frame_pool_storage,
+                    sizeof(frame_data_t),
+                    appconfAUDIO_PIPELINE_FRAME_POOL_DEPTH);
+
     initialize_pipeline_stages();
 
+    audio_pipeline_graph_plan(&graph_plan, THIS_XCORE_TILE, stage_fns);
+
+    /* The input runs in the first thread and the output in the last. A tile
+     * that runs no stage has one thread, that only runs the input and output. */
+    const int thread_count = graph_plan.thread_count > 0 ? graph_plan.thread_count : 1;
+    if (graph_plan.thread_count == 0) {
+        stage_stack_sizes[0] = configMINIMAL_STACK_SIZE;
+    }
+    stage_stack_sizes[0] += RTOS_THREAD_STACK_SIZE(audio_pipeline_input_i);
+    stage_stack_sizes[thread_count - 1] += RTOS_THREAD_STACK_SIZE(audio_pipeline_output_i);
+
     generic_pipeline_init((pipeline_input_t)audio_pipeline_input_i,
                         (pipeline_output_t)audio_pipeline_output_i,
                         input_app_data,
@@ -124,6 +237,7 @@ void audio_pipeline_init(
                         stages,
                         (const size_t*) stage_stack_sizes,
                         appconfAUDIO_PIPELINE_TASK_PRIORITY,
-                        stage_count);
+                        thread_count);
 }
+
 #endif /* ON_TILE(1) */
@@ -1,8 +1,13 @@
-// Copyright 2022-2023 XMOS LIMITED.
+// Copyright 2022-2024 XMOS LIMITED.
 // This Software is subject to the terms of the XMOS Public Licence: Version 1.
 
+#include <string.h>
+#include <math.h>
+
 #include "audio_pipeline_dsp.h"
 #include "stage_1.h"
+#include "profile.h"
+#include "aec_process_frame_threads.h"
 
 extern void aec_process_frame_1thread(
         aec_state_t *main_state,
@@ -12,12 +17,20 @@ extern void aec_process_frame_1thread(
         const int32_t (*y_data)[AEC_FRAME_ADVANCE],
         const int32_t (*x_data)[AEC_FRAME_ADVANCE]);
 
+PROFILE_PROBE_DEFINE(aec_filter_probe, "aec_filter");
+PROFILE_PROBE_DEFINE(aec_idle_probe, "aec_idle");
+PROFILE_PROBE_DEFINE(adec_probe, "adec");
+
 static void aec_switch_configuration(stage_1_state_t *state, aec_conf_t *conf)
 {
+    int to_de_mode = (conf == &state->aec_de_mode_conf);
+
+    aec_switch_begin(&state->aec_switch, &state->aec_main_state, to_de_mode, state->delay_state.delay_samples);
     aec_init(&state->aec_main_state, &state->aec_shadow_state, &state->aec_shared_state,
             &state->aec_main_memory_pool[0], &state->aec_shadow_memory_pool[0],
             conf->num_y_channels, conf->num_x_channels,
             conf->num_main_filt_phases, conf->num_shadow_filt_phases);
+    aec_switch_end(&state->aec_switch, &state->aec_main_state, to_de_mode, state->delay_state.delay_samples);
 }
 
 static inline void get_delayed_frame(
@@ -28,16 +41,12 @@ static inline void get_delayed_frame(
     int num_channels = (delay_state->delay_samples) > 0 ? AP_MAX_Y_CHANNELS : AP_MAX_X_CHANNELS;
     if (delay_state->delay_samples >= 0) {/** Requested Mic delay +ve => delay mic*/
         for(int ch=0; ch<num_channels; ch++) {
-            for(int i=0; i<AP_FRAME_ADVANCE; i++) {
-                get_delayed_sample(delay_state, &input_y_data[ch][i], ch);
-            }
+            get_delayed_block(delay_state, input_y_data[ch], AP_FRAME_ADVANCE, ch);
         }
     }
     else if (delay_state->delay_samples < 0) {/* Requested Mic delay negative => advance mic which can't be done, so delay reference*/
         for(int ch=0; ch<num_channels; ch++) {
-            for(int i=0; i<AP_FRAME_ADVANCE; i++) {
-                get_delayed_sample(delay_state, &input_x_data[ch][i], ch);
-            }
+            get_delayed_block(delay_state, input_x_data[ch], AP_FRAME_ADVANCE, ch);
         }
     }
     return;
@@ -48,13 +57,27 @@ void stage_1_init(stage_1_state_t *state, aec_conf_t *de_conf, aec_conf_t *non_d
     state->ref_active_threshold =  f64_to_float_s32(pow(10, REF_ACTIVE_THRESHOLD_dB/20.0)); //-60dB
     state->hold_aec_count = 0; //No. of consecutive frames reference has been absent for
     state->hold_aec_limit = (16000*HOLD_AEC_LIMIT_SECONDS)/AP_FRAME_ADVANCE; //bypass AEC only when reference has been absent for atleast 3 seconds (200 frames)
+    state->idle_hold_threshold = f64_to_float_s32(pow(10, appconfAEC_IDLE_GATE_HOLD_dB/20.0));
+    state->idle_resume_threshold = f64_to_float_s32(pow(10, appconfAEC_IDLE_GATE_RESUME_dB/20.0));
+    // Keep the AEC running for at least the echo tail modelled by the main filter after the reference stops
+    int32_t idle_hold_frames = (16*appconfAEC_IDLE_GATE_HOLD_MS)/AP_FRAME_ADVANCE;
+    if(idle_hold_frames < non_de_conf->num_main_filt_phases) {
+        idle_hold_frames = non_de_conf->num_main_filt_phases;
+    }
+    aec_idle_gate_init(&state->aec_idle_gate, idle_hold_frames);
 
     delay_buffer_init(&state->delay_state, 0/*Initialise with 0 delay_samples*/);
     memcpy(&state->aec_de_mode_conf, de_conf, sizeof(aec_conf_t));
     memcpy(&state->aec_non_de_mode_conf, non_de_conf, sizeof(aec_conf_t));
 
     adec_init(&state->adec_state, adec_config);
+#if appconfDELAY_ESTIMATOR_ENABLED
+    delay_alignment_init(&state->delay_alignment, state->ref_active_threshold);
+#endif
+    aec_switch_init(&state->aec_switch);
     aec_switch_configuration(state, &state->aec_non_de_mode_conf);
+    // The initial configuration is not counted as a switch
+    aec_switch_init(&state->aec_switch);
 }
 
 /** Process a frame of data through AEC and ADEC*/
@@ -66,6 +89,13 @@ void stage_1_process_frame(stage_1_state_t *state, int32_t (*output_frame)[AP_FR
     //printf("frame %d\n",framenum);
     framenum++;
 
+#if appconfDELAY_ESTIMATOR_ENABLED
+    if(delay_alignment_frame(&state->delay_alignment, &state->delay_state, input_y, input_x)) {
+        // The filters model the echo path at the old alignment
+        aec_reset_state(&state->aec_main_state, &state->aec_shadow_state);
+    }
+#endif
+
     delay_buf_state_t *delay_state_ptr = &state->delay_state;
     get_delayed_frame(
             input_y,
@@ -77,15 +107,35 @@ void stage_1_process_frame(stage_1_state_t *state, int32_t (*output_frame)[AP_FR
     *ref_active_flag = aec_detect_input_activity(input_x, state->ref_active_threshold, state->aec_main_state.shared_state->num_x_channels);
 
     /** AEC*/
-    aec_process_frame_1thread(&state->aec_main_state, &state->aec_shadow_state, output_frame, NULL, input_y, input_x);
+    // Delay estimation needs every frame
+    int aec_run = aec_idle_gate_frame(&state->aec_idle_gate, state->idle_hold_threshold, state->idle_resume_threshold,
+                                      &state->aec_main_state, input_x, state->delay_estimator_enabled);
+    if(aec_run) {
+        PROFILE_START(aec_filter_probe);
+#if (appconfAUDIO_PIPELINE_AEC_THREADS > 1)
+        aec_process_frame_threads(&state->aec_main_state, &state->aec_shadow_state, output_frame, NULL, input_y, input_x);
+#else
+        aec_process_frame_1thread(&state->aec_main_state, &state->aec_shadow_state, output_frame, NULL, input_y, input_x);
+#endif
+        PROFILE_END(aec_filter_probe);
+    } else {
+        // The reference is quiet, pass the mic input through and leave the filters as they are
+        PROFILE_START(aec_idle_probe);
+        aec_process_frame_idle(&state->aec_main_state, &state->aec_shadow_state, output_frame, input_y, input_x);
+        PROFILE_END(aec_idle_probe);
+    }
 
     /** Update metadata*/
     *max_ref_energy = aec_calc_max_input_energy(input_x, state->aec_main_state.shared_state->num_x_channels);
     for(int ch=0; ch<state->aec_main_state.shared_state->num_y_channels; ch++) {
-        aec_corr_factor[ch] = aec_calc_corr_factor(&state->aec_main_state, ch);
+        // The filters were not run on an idle frame, so there is no echo estimate to correlate with
+        aec_corr_factor[ch] = aec_run ? aec_calc_corr_factor(&state->aec_main_state, ch) : (float_s32_t){0, 0};
     }
 
+    aec_switch_track_recovery(&state->aec_switch, &state->aec_main_state, state->delay_estimator_enabled, *ref_active_flag);
+
     /** Delay Estimation*/
+    PROFILE_START(adec_probe);
     adec_input_t adec_in;
     adec_estimate_delay(
             &adec_in.from_de,
@@ -108,6 +158,7 @@ void stage_1_process_frame(stage_1_state_t *state, int32_t (*output_frame)[AP_FR
             &adec_output,
             &adec_in
             );
+    PROFILE_END(adec_probe);
 
     //** Reset AEC state if needed*/
     if(adec_output.reset_aec_flag) {
@@ -27,24 +27,62 @@
 #include "app_conf.h"
 #include "audio_pipeline.h"
 #include "audio_pipeline_dsp.h"
-
-#if appconfAUDIO_PIPELINE_FRAME_ADVANCE != 240
-#error This pipeline is only configured for 240 frame advance
-#endif
+#include "audio_pipeline_transport.h"
+#include "stage_buffers.h"
+#include "stage_blocks.h"
+#include "profile.h"
 
 #define VNR_AGC_THRESHOLD (0.5)
 
 #if ON_TILE(0)
+static frame_pool_t frame_pool;
+static uint8_t DWORD_ALIGNED frame_pool_storage[FRAME_POOL_STORAGE_SIZE(sizeof(frame_data_t), appconfAUDIO_PIPELINE_FRAME_POOL_DEPTH)];
+static uint8_t DWORD_ALIGNED frame_transport_buf[FRAME_DATA_TRANSPORT_MAX_BYTES];
+
 static ic_stage_ctx_t DWORD_ALIGNED ic_stage_state = {};
 static vnr_pred_stage_ctx_t DWORD_ALIGNED vnr_pred_stage_state = {};
 static ns_stage_ctx_t DWORD_ALIGNED ns_stage_state = {};
 static agc_stage_ctx_t DWORD_ALIGNED agc_stage_state = {};
+PROFILE_PROBE_DEFINE(ic_probe, "ic_vnr");
+PROFILE_PROBE_DEFINE(ns_probe, "ns");
+PROFILE_PROBE_DEFINE(agc_probe, "agc");
+
+#if STAGE_BLOCKS_ADAPTED
+/* The stages process blocks of STAGE_BLOCK_ADVANCE samples */
+static stage_blocks_t ic_blocks;
+static stage_blocks_t ns_blocks;
+static stage_blocks_t agc_blocks;
+static int32_t DWORD_ALIGNED ic_blocks_input[STAGE_BLOCKS_STORAGE_SIZE(appconfAUDIO_PIPELINE_FRAME_ADVANCE, 2)];
+static int32_t DWORD_ALIGNED ic_blocks_output[STAGE_BLOCKS_STORAGE_SIZE(appconfAUDIO_PIPELINE_FRAME_ADVANCE, 1)];
+static int32_t DWORD_ALIGNED ns_blocks_input[STAGE_BLOCKS_STORAGE_SIZE(appconfAUDIO_PIPELINE_FRAME_ADVANCE, 1)];
+static int32_t DWORD_ALIGNED ns_blocks_output[STAGE_BLOCKS_STORAGE_SIZE(appconfAUDIO_PIPELINE_FRAME_ADVANCE, 1)];
+static int32_t DWORD_ALIGNED agc_blocks_input[STAGE_BLOCKS_STORAGE_SIZE(appconfAUDIO_PIPELINE_FRAME_ADVANCE, 1)];
+static int32_t DWORD_ALIGNED agc_blocks_output[STAGE_BLOCKS_STORAGE_SIZE(appconfAUDIO_PIPELINE_FRAME_ADVANCE, 1)];
+#endif
+
+void audio_pipeline_frame_release(void *frame)
+{
+    if (frame_pool_owns(&frame_pool, frame)) {
+        frame_pool_release(&frame_pool, frame);
+    } else {
+        vPortFree(frame);
+    }
+}
+
+void audio_pipeline_frame_pool_stats_get(frame_pool_stats_t *stats)
+{
+    frame_pool_stats_get(&frame_pool, stats);
+}
 
 static void *audio_pipeline_input_i(void *input_app_data)
 {
     frame_data_t *frame_data;
 
-    frame_data = pvPortMalloc(sizeof(frame_data_t));
+    frame_data = frame_pool_alloc(&frame_pool);
+    if (frame_data == NULL) {
+        /* Pool exhausted by a downstream stall, fall back to the heap rather than drop input */
+        frame_data = pvPortMalloc(sizeof(frame_data_t));
+    }
     memset(frame_data, 0x00, sizeof(frame_data_t));
 
     size_t bytes_received = 0;
@@ -52,26 +90,40 @@ static void *audio_pipeline_input_i(void *input_app_data)
             intertile_ctx,
             appconfAUDIOPIPELINE_PORT,
             portMAX_DELAY);
+#if appconfAUDIO_PIPELINE_LATENCY_TRACE
+    uint32_t rx_start = get_reference_time();
+#endif
 
-    xassert(bytes_received == sizeof(frame_data_t));
+    xassert(bytes_received == frame_transport_size(&frame_data_transport));
 
     rtos_intertile_rx_data(
             intertile_ctx,
-            frame_data,
+            frame_transport_buf,
             bytes_received);
 
+    frame_transport_unpack(&frame_data_transport, frame_data, frame_transport_buf);
+    AUDIO_PIPELINE_TRACE_RX(frame_data, rx_start);
+
     return frame_data;
 }
 
 static int audio_pipeline_output_i(frame_data_t *frame_data,
                                    void *output_app_data)
 {
-    return audio_pipeline_output(output_app_data,
+    FRAME_STAGE_SETTLE(frame_data);
+    AUDIO_PIPELINE_TRACE_OUTPUT(frame_data);
+
+    int ret = audio_pipeline_output(output_app_data,
                                (int32_t **)frame_data->samples,
                                6,
                                appconfAUDIO_PIPELINE_FRAME_ADVANCE);
+    if (ret == AUDIO_PIPELINE_FREE_FRAME) {
+        audio_pipeline_frame_release(frame_data);
+    }
+    return AUDIO_PIPELINE_DONT_FREE_FRAME;
 }
 
+PIPELINE_GRAPH_STAGE_FPTRGROUP
 static void stage_vnr_and_ic(frame_data_t *frame_data)
 {
 #if appconfAUDIO_PIPELINE_SKIP_IC_AND_VNR
@@ -84,11 +136,32 @@ static void stage_vnr_and_ic(frame_data_t *frame_data)
         ic_stage_state.state.config_params.bypass = 0;
     }
 
-    int32_t DWORD_ALIGNED ic_output[appconfAUDIO_PIPELINE_FRAME_ADVANCE];
+    PROFILE_START(ic_probe);
+#if STAGE_BLOCKS_ADAPTED
+    vnr_pred_state_t *vnr_pred_state = &vnr_pred_stage_state.vnr_pred_state;
+
+    stage_blocks_write(&ic_blocks, 0, FRAME_STAGE_INPUT(frame_data));
+    stage_blocks_write(&ic_blocks, 1, frame_data->samples[1]);
+    uint32_t blocks = stage_blocks_advance(&ic_blocks);
+    for (uint32_t b = 0; b < blocks; b++) {
+        ic_filter(&ic_stage_state.state,
+                  stage_blocks_input(&ic_blocks, b, 0),
+                  stage_blocks_input(&ic_blocks, b, 1),
+                  stage_blocks_output(&ic_blocks, b, 0));
+        ic_calc_vnr_pred(&ic_stage_state.state, &vnr_pred_state->input_vnr_pred, &vnr_pred_state->output_vnr_pred);
+        ic_adapt(&ic_stage_state.state, vnr_pred_state->input_vnr_pred);
+    }
+    /* Intentionally ignoring comms ch from here on out */
+    stage_blocks_read(&ic_blocks, 0, FRAME_STAGE_INPUT(frame_data));
+
+    /* Frames that complete no block keep the prediction of the last block */
+    float_s32_t agc_vnr_threshold = f32_to_float_s32(VNR_AGC_THRESHOLD);
+    frame_data->vnr_pred_flag = float_s32_gt(vnr_pred_state->output_vnr_pred, agc_vnr_threshold);
+#else
     ic_filter(&ic_stage_state.state,
-              frame_data->samples[0],
+              FRAME_STAGE_INPUT(frame_data),
               frame_data->samples[1],
-              ic_output);
+              FRAME_STAGE_OUTPUT(frame_data));
 
     vnr_pred_state_t *vnr_pred_state = &vnr_pred_stage_state.vnr_pred_state;
     ic_calc_vnr_pred(&ic_stage_state.state, &vnr_pred_state->input_vnr_pred, &vnr_pred_state->output_vnr_pred);
@@ -99,42 +172,76 @@ static void stage_vnr_and_ic(frame_data_t *frame_data)
     ic_adapt(&ic_stage_state.state, vnr_pred_stage_state.vnr_pred_state.input_vnr_pred);
 
     /* Intentionally ignoring comms ch from here on out */
-    memcpy(frame_data->samples, ic_output, appconfAUDIO_PIPELINE_FRAME_ADVANCE * sizeof(int32_t));
+    FRAME_STAGE_SWAP(frame_data);
+#endif /* STAGE_BLOCKS_ADAPTED */
+    PROFILE_END(ic_probe);
 #endif
+    AUDIO_PIPELINE_TRACE_STAGE(frame_data, PIPELINE_STAGE_IC_VNR);
 }
 
+PIPELINE_GRAPH_STAGE_FPTRGROUP
 static void stage_ns(frame_data_t *frame_data)
 {
 #if appconfAUDIO_PIPELINE_SKIP_NS
 #else
-    int32_t DWORD_ALIGNED ns_output[appconfAUDIO_PIPELINE_FRAME_ADVANCE];
-    configASSERT(NS_FRAME_ADVANCE == appconfAUDIO_PIPELINE_FRAME_ADVANCE);
+    PROFILE_START(ns_probe);
+    configASSERT(NS_FRAME_ADVANCE == STAGE_BLOCK_ADVANCE);
+#if STAGE_BLOCKS_ADAPTED
+    stage_blocks_write(&ns_blocks, 0, FRAME_STAGE_INPUT(frame_data));
+    uint32_t blocks = stage_blocks_advance(&ns_blocks);
+    for (uint32_t b = 0; b < blocks; b++) {
+        ns_process_frame(
+                    &ns_stage_state.state,
+                    stage_blocks_output(&ns_blocks, b, 0),
+                    stage_blocks_input(&ns_blocks, b, 0));
+    }
+    stage_blocks_read(&ns_blocks, 0, FRAME_STAGE_INPUT(frame_data));
+#else
     ns_process_frame(
                 &ns_stage_state.state,
-                ns_output,
-                frame_data->samples[0]);
-    memcpy(frame_data->samples, ns_output, appconfAUDIO_PIPELINE_FRAME_ADVANCE * sizeof(int32_t));
+                FRAME_STAGE_OUTPUT(frame_data),
+                FRAME_STAGE_INPUT(frame_data));
+    FRAME_STAGE_SWAP(frame_data);
+#endif
+    PROFILE_END(ns_probe);
 #endif
+    AUDIO_PIPELINE_TRACE_STAGE(frame_data, PIPELINE_STAGE_NS);
 }
 
+PIPELINE_GRAPH_STAGE_FPTRGROUP
 static void stage_agc(frame_data_t *frame_data)
 {
 #if appconfAUDIO_PIPELINE_SKIP_AGC
 #else
-    int32_t DWORD_ALIGNED agc_output[appconfAUDIO_PIPELINE_FRAME_ADVANCE];
-    configASSERT(AGC_FRAME_ADVANCE == appconfAUDIO_PIPELINE_FRAME_ADVANCE);
+    PROFILE_START(agc_probe);
+    configASSERT(AGC_FRAME_ADVANCE == STAGE_BLOCK_ADVANCE);
 
     agc_stage_state.md.vnr_flag = frame_data->vnr_pred_flag;
     agc_stage_state.md.aec_ref_power = frame_data->max_ref_energy;
-    agc_stage_state.md.aec_corr_factor = frame_data->aec_corr_factor;
-
+    agc_stage_state.md.aec_corr_factor = frame_data->aec_corr_factor[0];
+
+#if STAGE_BLOCKS_ADAPTED
+    stage_blocks_write(&agc_blocks, 0, FRAME_STAGE_INPUT(frame_data));
+    uint32_t blocks = stage_blocks_advance(&agc_blocks);
+    for (uint32_t b = 0; b < blocks; b++) {
+        agc_process_frame(
+                &agc_stage_state.state,
+                stage_blocks_output(&agc_blocks, b, 0),
+                stage_blocks_input(&agc_blocks, b, 0),
+                &agc_stage_state.md);
+    }
+    stage_blocks_read(&agc_blocks, 0, FRAME_STAGE_INPUT(frame_data));
+#else
+    /* AGC supports in-place processing, so the processed channel stays where it is */
     agc_process_frame(
             &agc_stage_state.state,
-            agc_output,
-            frame_data->samples[0],
+            FRAME_STAGE_INPUT(frame_data),
+            FRAME_STAGE_INPUT(frame_data),
             &agc_stage_state.md);
-    memcpy(frame_data->samples, agc_output, appconfAUDIO_PIPELINE_FRAME_ADVANCE * sizeof(int32_t));
 #endif
+    PROFILE_END(agc_probe);
+#endif
+    AUDIO_PIPELINE_TRACE_STAGE(frame_data, PIPELINE_STAGE_AGC);
 }
 
 static void initialize_pipeline_stages(void)
@@ -147,28 +254,59 @@ static void initialize_pipeline_stages(void)
 
     agc_stage_state.md.aec_ref_power = AGC_META_DATA_NO_AEC;
     agc_stage_state.md.aec_corr_factor = AGC_META_DATA_NO_AEC;
+
+#if STAGE_BLOCKS_ADAPTED
+    stage_blocks_init(&ic_blocks, appconfAUDIO_PIPELINE_FRAME_ADVANCE, ic_blocks_input, 2, ic_blocks_output, 1);
+    stage_blocks_init(&ns_blocks, appconfAUDIO_PIPELINE_FRAME_ADVANCE, ns_blocks_input, 1, ns_blocks_output, 1);
+    stage_blocks_init(&agc_blocks, appconfAUDIO_PIPELINE_FRAME_ADVANCE, agc_blocks_input, 1, agc_blocks_output, 1);
+#endif
 }
 
+PIPELINE_GRAPH_PLAN_DEFINE(graph_plan)
+
 void audio_pipeline_init(
     void *input_app_data,
     void *output_app_data)
 {
-    const int stage_count = 3;
+    const pipeline_graph_stage_t stage_fns[PIPELINE_STAGE_COUNT] = {
+        [PIPELINE_STAGE_IC_VNR] = (pipeline_graph_stage_t)stage_vnr_and_ic,
+        [PIPELINE_STAGE_NS] = (pipeline_graph_stage_t)stage_ns,
+        [PIPELINE_STAGE_AGC] = (pipeline_graph_stage_t)stage_agc,
+    };
 
-    const pipeline_stage_t stages[] = {
-        (pipeline_stage_t)stage_vnr_and_ic,
-        (pipeline_stage_t)stage_ns,
-        (pipeline_stage_t)stage_agc,
+    /* The threads run the stages the pipeline graph places in them */
+    const pipeline_stage_t stages[PIPELINE_GRAPH_MAX_THREADS] = {
+        (pipeline_stage_t)graph_plan_thread_0,
+        (pipeline_stage_t)graph_plan_thread_1,
+        (pipeline_stage_t)graph_plan_thread_2,
+        (pipeline_stage_t)graph_plan_thread_3,
     };
 
-    const configSTACK_DEPTH_TYPE stage_stack_sizes[] = {
-        configMINIMAL_STACK_SIZE + RTOS_THREAD_STACK_SIZE(stage_vnr_and_ic) + RTOS_THREAD_STACK_SIZE(audio_pipeline_input_i),
-        configMINIMAL_STACK_SIZE + RTOS_THREAD_STACK_SIZE(stage_ns),
-        configMINIMAL_STACK_SIZE + RTOS_THREAD_STACK_SIZE(stage_agc) + RTOS_THREAD_STACK_SIZE(audio_pipeline_output_i),
+    configSTACK_DEPTH_TYPE stage_stack_sizes[PIPELINE_GRAPH_MAX_THREADS] = {
+        configMINIMAL_STACK_SIZE + RTOS_THREAD_STACK_SIZE(graph_plan_thread_0),
+        configMINIMAL_STACK_SIZE + RTOS_THREAD_STACK_SIZE(graph_plan_thread_1),
+        configMINIMAL_STACK_SIZE + RTOS_THREAD_STACK_SIZE(graph_plan_thread_2),
+        configMINIMAL_STACK_SIZE + RTOS_THREAD_STACK_SIZE(graph_plan_thread_3),
     };
 
+    frame_pool_init(&frame_pool,
+                    frame_pool_storage,
+                    sizeof(frame_data_t),
+                    appconfAUDIO_PIPELINE_FRAME_POOL_DEPTH);
+
     initialize_pipeline_stages();
 
+    audio_pipeline_graph_plan(&graph_plan, THIS_XCORE_TILE, stage_fns);
+
+    /* The input runs in the first thread and the output in the last. A tile
+     * that runs no stage has one thread, that only runs the input and output. */
+    const int thread_count = graph_plan.thread_count > 0 ? graph_plan.thread_count : 1;
+    if (graph_plan.thread_count == 0) {
+        stage_stack_sizes[0] = configMINIMAL_STACK_SIZE;
+    }
+    stage_stack_sizes[0] += RTOS_THREAD_STACK_SIZE(audio_pipeline_input_i);
+    stage_stack_sizes[thread_count - 1] += RTOS_THREAD_STACK_SIZE(audio_pipeline_output_i);
+
     generic_pipeline_init((pipeline_input_t)audio_pipeline_input_i,
                         (pipeline_output_t)audio_pipeline_output_i,
                         input_app_data,
@@ -176,7 +314,7 @@ void audio_pipeline_init(
                         stages,
                         (const size_t*) stage_stack_sizes,
                         appconfAUDIO_PIPELINE_TASK_PRIORITY,
-                        stage_count);
+                        thread_count);
 }
 
 #endif /* ON_TILE(0)*/
@@ -1,4 +1,4 @@
-// Copyright 2022-2023 XMOS LIMITED.
+// Copyright 2022-2024 XMOS LIMITED.
 // This Software is subject to the terms of the XMOS Public Licence: Version 1.
 
 #ifndef STAGE1_STATE_H
@@ -8,6 +8,9 @@
 #include "aec_memory_pool.h"
 #include "adec_api.h"
 #include "delay_buffer.h"
+#include "aec_idle_gate.h"
+#include "aec_switch.h"
+#include "delay_alignment.h"
 #include "audio_pipeline_dsp.h"
 
 #define REF_ACTIVE_THRESHOLD_dB (-60) // Reference input level above which it is considered active
@@ -40,6 +43,19 @@ typedef struct {
     int32_t delay_estimator_enabled;
     float_s32_t ref_active_threshold; //-60dB
 
+    // AEC idle gating, see appconfAEC_IDLE_GATE_ENABLED
+    aec_idle_gate_t aec_idle_gate;
+    float_s32_t idle_hold_threshold; // Reference input level below which an active AEC counts down to going idle
+    float_s32_t idle_resume_threshold; // Reference input level above which an idle AEC resumes
+
+    // AEC configuration switch
+    aec_switch_t aec_switch;
+
+#if appconfDELAY_ESTIMATOR_ENABLED
+    // Standalone delay estimator
+    delay_alignment_t delay_alignment;
+#endif
+
     //alt-arch
     int32_t hold_aec_count;
     int32_t hold_aec_limit;
@@ -0,0 +1,41 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <string.h>
+
+#include "aec_idle_gate.h"
+
+void aec_idle_gate_init(aec_idle_gate_t *gate, uint32_t hold_frames)
+{
+    memset(gate, 0, sizeof(*gate));
+    gate->hold_frames = hold_frames;
+}
+
+void aec_idle_gate_reset(aec_idle_gate_t *gate)
+{
+    gate->quiet_frames = 0;
+    gate->idle = 0;
+}
+
+int aec_idle_gate_update(aec_idle_gate_t *gate, int ref_present)
+{
+    if (gate->idle) {
+        if (ref_present) {
+            /* Resume on this frame, the filters are as they were left */
+            gate->idle = 0;
+            gate->quiet_frames = 0;
+            gate->stats.resume_count++;
+        }
+    } else if (ref_present) {
+        gate->quiet_frames = 0;
+    } else if (++gate->quiet_frames >= gate->hold_frames) {
+        gate->idle = 1;
+    }
+
+    if (gate->idle) {
+        gate->stats.idle_frames++;
+        return 0;
+    }
+    gate->stats.active_frames++;
+    return 1;
+}
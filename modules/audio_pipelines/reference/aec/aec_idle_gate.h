@@ -0,0 +1,82 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef AEC_IDLE_GATE_H_
+#define AEC_IDLE_GATE_H_
+
+#include <stdint.h>
+
+/**
+ * \addtogroup aec_idle_gate aec_idle_gate
+ *
+ * Decides, frame by frame, whether the AEC needs to run.
+ *
+ * While the reference is quiet there is no echo to cancel, so the pipelines
+ * skip the AEC and pass the mic input through, which leaves the adaptive
+ * filters as they were. The gate goes idle once the reference has stayed
+ * below a hold threshold for a hold time, which lets the AEC cancel the echo
+ * tail of the last reference activity first. It resumes on the first frame in
+ * which the reference reaches a resume threshold. The resume threshold is set
+ * above the hold threshold, so that a reference around either threshold does
+ * not toggle the gate, and both are set below the level at which the
+ * pipelines consider the reference active.
+ *
+ * The gate only sees the results of the threshold comparisons, so it does not
+ * depend on the AEC library.
+ * @{
+ */
+
+typedef struct {
+    uint32_t active_frames; // Frames the AEC ran
+    uint32_t idle_frames;   // Frames the AEC was skipped
+    uint32_t resume_count;  // Number of times the gate left the idle state
+} aec_idle_gate_stats_t;
+
+typedef struct {
+    uint32_t hold_frames;       // Consecutive frames below the hold threshold before going idle
+    uint32_t quiet_frames;      // Consecutive frames below the hold threshold so far
+    int32_t idle;               // 1 while the AEC is skipped
+    aec_idle_gate_stats_t stats;
+} aec_idle_gate_t;
+
+/**
+ * Initialise a gate in the active state.
+ *
+ * \param gate          The gate.
+ * \param hold_frames   Number of consecutive frames with the reference below
+ *                      the hold threshold after which the gate goes idle.
+ *                      This should cover the echo tail modelled by the AEC
+ *                      main filter.
+ */
+void aec_idle_gate_init(aec_idle_gate_t *gate, uint32_t hold_frames);
+
+/**
+ * Return the gate to the active state without clearing its statistics, for
+ * example while the AEC is estimating the delay and must see every frame.
+ */
+void aec_idle_gate_reset(aec_idle_gate_t *gate);
+
+/**
+ * Check whether the gate is idle, which selects the threshold the reference
+ * is compared against for the next update.
+ */
+static inline int aec_idle_gate_is_idle(const aec_idle_gate_t *gate)
+{
+    return gate->idle;
+}
+
+/**
+ * Update the gate with the reference level of a frame.
+ *
+ * \param gate          The gate.
+ * \param ref_present   Non-zero if the reference is above the resume threshold
+ *                      when the gate is idle, or above the hold threshold when
+ *                      it is not.
+ * \returns             1 if the AEC must process the frame, 0 if it can be
+ *                      skipped.
+ */
+int aec_idle_gate_update(aec_idle_gate_t *gate, int ref_present);
+
+/**@}*/
+
+#endif /* AEC_IDLE_GATE_H_ */
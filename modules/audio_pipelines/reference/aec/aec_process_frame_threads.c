@@ -0,0 +1,312 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <stdint.h>
+#include <string.h>
+
+/* FreeRTOS headers */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "event_groups.h"
+
+/* Library headers */
+#include "aec_defines.h"
+#include "aec_api.h"
+
+#include "aec_process_frame_threads.h"
+
+/* The same AEC steps as aec_process_frame_1thread(), grouped into phases.
+ * Within a phase the work is split into jobs that share no state, which are
+ * dealt round robin to the threads. All threads meet at a barrier between
+ * phases. Steps that cannot be split run on the calling thread only.
+ *
+ * The jobs are per channel and per filter, the finest split the AEC library
+ * API allows. The main filter jobs are listed first so that the heavier
+ * main filter work is spread over the threads. */
+
+/* Jobs for the steps that are done for the main and shadow filter of each channel */
+#define FILTER_JOB_STATE(job, num_ch)   (((job) < (num_ch)) ? frame.main_state : frame.shadow_state)
+#define FILTER_JOB_IS_MAIN(job, num_ch) ((job) < (num_ch))
+#define FILTER_JOB_CH(job, num_ch)      ((job) % (num_ch))
+
+/* Only the xcore compiler needs the function pointer group */
+#if defined(__XS3A__)
+#define AEC_JOB_FPTRGROUP   __attribute__((fptrgroup("aec_job_fptr_grp")))
+#else
+#define AEC_JOB_FPTRGROUP
+#endif
+
+typedef struct {
+    aec_state_t *main_state;
+    aec_state_t *shadow_state;
+    int32_t (*output_main)[AEC_FRAME_ADVANCE];
+    int32_t (*output_shadow)[AEC_FRAME_ADVANCE];
+} aec_frame_t;
+
+static aec_frame_t frame;
+static unsigned X_energy_recalc_bin = 0;
+
+static unsigned aec_num_threads = 1;
+static EventGroupHandle_t barrier_group;
+static EventBits_t barrier_all_bits;
+
+static void barrier_wait(unsigned thread)
+{
+    if (aec_num_threads > 1) {
+        xEventGroupSync(barrier_group, (EventBits_t)1 << thread, barrier_all_bits, portMAX_DELAY);
+    }
+}
+
+AEC_JOB_FPTRGROUP
+static void input_spectrum_job(int job)
+{
+    aec_shared_state_t *shared_state = frame.main_state->shared_state;
+    int num_y_channels = shared_state->num_y_channels;
+
+    // EMA energy of the time domain input, then its spectrum in place
+    if (job < num_y_channels) {
+        int ch = job;
+        aec_calc_time_domain_ema_energy(&shared_state->y_ema_energy[ch], &shared_state->y[ch],
+                AEC_PROC_FRAME_LENGTH - AEC_FRAME_ADVANCE, AEC_FRAME_ADVANCE, &shared_state->config_params);
+        aec_forward_fft(&shared_state->Y[ch], &shared_state->y[ch]);
+    } else {
+        int ch = job - num_y_channels;
+        aec_calc_time_domain_ema_energy(&shared_state->x_ema_energy[ch], &shared_state->x[ch],
+                AEC_PROC_FRAME_LENGTH - AEC_FRAME_ADVANCE, AEC_FRAME_ADVANCE, &shared_state->config_params);
+        aec_forward_fft(&shared_state->X[ch], &shared_state->x[ch]);
+    }
+}
+
+AEC_JOB_FPTRGROUP
+static void X_fifo_energy_job(int job)
+{
+    int num_x_channels = frame.main_state->shared_state->num_x_channels;
+
+    aec_calc_X_fifo_energy(FILTER_JOB_STATE(job, num_x_channels), FILTER_JOB_CH(job, num_x_channels), X_energy_recalc_bin);
+}
+
+AEC_JOB_FPTRGROUP
+static void X_fifo_update_job(int job)
+{
+    aec_update_X_fifo_and_calc_sigmaXX(frame.main_state, job);
+}
+
+AEC_JOB_FPTRGROUP
+static void error_job(int job)
+{
+    int num_y_channels = frame.main_state->shared_state->num_y_channels;
+    aec_state_t *state = FILTER_JOB_STATE(job, num_y_channels);
+    int ch = FILTER_JOB_CH(job, num_y_channels);
+
+    aec_calc_Error_and_Y_hat(state, ch);
+    aec_inverse_fft(&state->error[ch], &state->Error[ch]);
+
+    if (FILTER_JOB_IS_MAIN(job, num_y_channels)) {
+        bfp_s32_t temp;
+
+        aec_inverse_fft(&state->y_hat[ch], &state->Y_hat[ch]);
+        aec_calc_coherence(state, ch);
+        aec_calc_output(state, &frame.output_main[ch], ch);
+
+        bfp_s32_init(&temp, &frame.output_main[ch][0], -31, AEC_FRAME_ADVANCE, 1);
+        aec_calc_time_domain_ema_energy(&state->error_ema_energy[ch], &temp, 0, AEC_FRAME_ADVANCE, &state->shared_state->config_params);
+    } else {
+        // Still needed without an output as it windows the error
+        aec_calc_output(state, (frame.output_shadow != NULL) ? &frame.output_shadow[ch] : NULL, ch);
+    }
+
+    aec_forward_fft(&state->Error[ch], &state->error[ch]);
+    aec_calc_freq_domain_energy(&state->overall_Error[ch], &state->Error[ch]);
+
+    if (FILTER_JOB_IS_MAIN(job, num_y_channels)) {
+        aec_calc_freq_domain_energy(&state->shared_state->overall_Y[ch], &state->shared_state->Y[ch]);
+    }
+}
+
+AEC_JOB_FPTRGROUP
+static void normalisation_job(int job)
+{
+    int num_x_channels = frame.main_state->shared_state->num_x_channels;
+    int is_main = FILTER_JOB_IS_MAIN(job, num_x_channels);
+
+    aec_calc_normalisation_spectrum(FILTER_JOB_STATE(job, num_x_channels), FILTER_JOB_CH(job, num_x_channels), !is_main);
+}
+
+AEC_JOB_FPTRGROUP
+static void filter_adapt_job(int job)
+{
+    // T is shared by all the y channels of a filter, so a filter is adapted by one thread
+    aec_state_t *state = (job == 0) ? frame.main_state : frame.shadow_state;
+    int num_y_channels = state->shared_state->num_y_channels;
+    int num_x_channels = state->shared_state->num_x_channels;
+
+    for (int ych = 0; ych < num_y_channels; ych++) {
+        for (int xch = 0; xch < num_x_channels; xch++) {
+            aec_calc_T(state, ych, xch);
+        }
+        aec_filter_adapt(state, ych);
+    }
+}
+
+typedef void (*aec_job_fn_t)(int job);
+
+static void run_jobs(unsigned thread, AEC_JOB_FPTRGROUP aec_job_fn_t job_fn, int num_jobs)
+{
+    for (int job = thread; job < num_jobs; job += aec_num_threads) {
+        job_fn(job);
+    }
+}
+
+/* Everything after aec_frame_init(), run by every thread */
+static void process_frame_phases(unsigned thread)
+{
+    int num_y_channels = frame.main_state->shared_state->num_y_channels;
+    int num_x_channels = frame.main_state->shared_state->num_x_channels;
+
+    run_jobs(thread, input_spectrum_job, num_y_channels + num_x_channels);
+    barrier_wait(thread);
+
+    /* As in aec_process_frame_1thread(), the X FIFO energy of every channel
+     * uses the FIFO before this frame is added to it */
+    run_jobs(thread, X_fifo_energy_job, 2 * num_x_channels);
+    barrier_wait(thread);
+
+    run_jobs(thread, X_fifo_update_job, num_x_channels);
+    barrier_wait(thread);
+
+    if (thread == 0) {
+        X_energy_recalc_bin += 1;
+        if (X_energy_recalc_bin == (AEC_PROC_FRAME_LENGTH/2) + 1) {
+            X_energy_recalc_bin = 0;
+        }
+        aec_update_X_fifo_1d(frame.main_state);
+        aec_update_X_fifo_1d(frame.shadow_state);
+    }
+    barrier_wait(thread);
+
+    run_jobs(thread, error_job, 2 * num_y_channels);
+    barrier_wait(thread);
+
+    if (thread == 0) {
+        aec_compare_filters_and_calc_mu(frame.main_state, frame.shadow_state);
+    }
+    barrier_wait(thread);
+
+    run_jobs(thread, normalisation_job, 2 * num_x_channels);
+    barrier_wait(thread);
+
+    run_jobs(thread, filter_adapt_job, 2);
+    barrier_wait(thread);
+}
+
+static void aec_worker_task(void *arg)
+{
+    unsigned thread = (unsigned)(uintptr_t)arg;
+
+    for (;;) {
+        /* Wait for the next frame */
+        barrier_wait(thread);
+        process_frame_phases(thread);
+    }
+}
+
+void aec_process_frame_threads_init(unsigned num_threads, unsigned priority)
+{
+    configASSERT((num_threads >= 1) && (num_threads <= AEC_THREADS_MAX));
+
+    aec_num_threads = num_threads;
+    if (num_threads == 1) {
+        return;
+    }
+
+    barrier_group = xEventGroupCreate();
+    configASSERT(barrier_group != NULL);
+    barrier_all_bits = ((EventBits_t)1 << num_threads) - 1;
+
+    for (unsigned thread = 1; thread < num_threads; thread++) {
+        xTaskCreate((TaskFunction_t) aec_worker_task,
+                    "aec_worker",
+                    RTOS_THREAD_STACK_SIZE(aec_worker_task),
+                    (void *)(uintptr_t)thread,
+                    priority,
+                    NULL);
+    }
+}
+
+void aec_process_frame_threads(
+        aec_state_t *main_state,
+        aec_state_t *shadow_state,
+        int32_t (*output_main)[AEC_FRAME_ADVANCE],
+        int32_t (*output_shadow)[AEC_FRAME_ADVANCE],
+        const int32_t (*y_data)[AEC_FRAME_ADVANCE],
+        const int32_t (*x_data)[AEC_FRAME_ADVANCE])
+{
+    aec_frame_init(main_state, shadow_state, y_data, x_data);
+
+    frame.main_state = main_state;
+    frame.shadow_state = shadow_state;
+    frame.output_main = output_main;
+    frame.output_shadow = output_shadow;
+
+    /* Release the workers, which are waiting for the next frame */
+    barrier_wait(0);
+    process_frame_phases(0);
+}
+
+void aec_process_frame_idle(
+        aec_state_t *main_state,
+        aec_state_t *shadow_state,
+        int32_t (*output_main)[AEC_FRAME_ADVANCE],
+        const int32_t (*y_data)[AEC_FRAME_ADVANCE],
+        const int32_t (*x_data)[AEC_FRAME_ADVANCE])
+{
+    aec_shared_state_t *shared_state = main_state->shared_state;
+
+    /* Shifts the new frame into the previous frame buffers */
+    aec_frame_init(main_state, shadow_state, y_data, x_data);
+
+    for (int ch = 0; ch < shared_state->num_y_channels; ch++) {
+        aec_calc_time_domain_ema_energy(&shared_state->y_ema_energy[ch], &shared_state->y[ch],
+                AEC_PROC_FRAME_LENGTH - AEC_FRAME_ADVANCE, AEC_FRAME_ADVANCE, &shared_state->config_params);
+    }
+    for (int ch = 0; ch < shared_state->num_x_channels; ch++) {
+        aec_calc_time_domain_ema_energy(&shared_state->x_ema_energy[ch], &shared_state->x[ch],
+                AEC_PROC_FRAME_LENGTH - AEC_FRAME_ADVANCE, AEC_FRAME_ADVANCE, &shared_state->config_params);
+    }
+
+    /* With no echo the error is the mic input */
+    for (int ch = 0; ch < shared_state->num_y_channels; ch++) {
+        bfp_s32_t temp;
+
+        memcpy(&output_main[ch][0], &y_data[ch][0], AEC_FRAME_ADVANCE * sizeof(int32_t));
+        bfp_s32_init(&temp, &output_main[ch][0], -31, AEC_FRAME_ADVANCE, 1);
+        aec_calc_time_domain_ema_energy(&main_state->error_ema_energy[ch], &temp, 0, AEC_FRAME_ADVANCE, &shared_state->config_params);
+    }
+}
+
+int aec_idle_gate_frame(
+        aec_idle_gate_t *gate,
+        float_s32_t hold_threshold,
+        float_s32_t resume_threshold,
+        aec_state_t *main_state,
+        int32_t (*x_data)[AEC_FRAME_ADVANCE],
+        int must_run)
+{
+#if appconfAEC_IDLE_GATE_ENABLED
+    if (must_run) {
+        aec_idle_gate_reset(gate);
+        return 1;
+    }
+    float_s32_t threshold = aec_idle_gate_is_idle(gate) ? resume_threshold : hold_threshold;
+    int32_t ref_present = aec_detect_input_activity(x_data, threshold, main_state->shared_state->num_x_channels);
+    return aec_idle_gate_update(gate, ref_present);
+#else
+    (void)gate;
+    (void)hold_threshold;
+    (void)resume_threshold;
+    (void)main_state;
+    (void)x_data;
+    (void)must_run;
+    return 1;
+#endif
+}
@@ -0,0 +1,121 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef AEC_PROCESS_FRAME_THREADS_H_
+#define AEC_PROCESS_FRAME_THREADS_H_
+
+#include <stdint.h>
+#include "app_conf.h"
+#include "aec_defines.h"
+#include "aec_api.h"
+#include "aec_idle_gate.h"
+
+/* Number of threads that process each AEC frame, including the calling
+ * pipeline stage. When greater than 1 the pipelines call
+ * aec_process_frame_threads() instead of aec_process_frame_1thread(). */
+#ifndef appconfAUDIO_PIPELINE_AEC_THREADS
+#define appconfAUDIO_PIPELINE_AEC_THREADS   1
+#endif
+
+/* Set to 1 to skip the AEC while the reference is silent. See aec_idle_gate.h */
+#ifndef appconfAEC_IDLE_GATE_ENABLED
+#define appconfAEC_IDLE_GATE_ENABLED    0
+#endif
+
+/* Time the reference must stay quiet before the AEC is skipped. This is
+ * raised to the length of the echo tail modelled by the main filter if it is
+ * shorter. */
+#ifndef appconfAEC_IDLE_GATE_HOLD_MS
+#define appconfAEC_IDLE_GATE_HOLD_MS    500
+#endif
+
+/* Reference levels, in dBFS, below which an active AEC counts down the hold
+ * time and above which an idle AEC resumes. They are below the -60 dB level
+ * at which the ADEC pipelines consider the reference active, so that the AEC
+ * runs on every frame flagged as having an active reference. */
+#ifndef appconfAEC_IDLE_GATE_HOLD_dB
+#define appconfAEC_IDLE_GATE_HOLD_dB    (-72)
+#endif
+#ifndef appconfAEC_IDLE_GATE_RESUME_dB
+#define appconfAEC_IDLE_GATE_RESUME_dB  (-66)
+#endif
+
+/* Maximum number of threads supported by aec_process_frame_threads() */
+#define AEC_THREADS_MAX     (4)
+
+/**
+ * Create the worker tasks used by aec_process_frame_threads().
+ *
+ * Must be called once, on the tile running the AEC, before the first call
+ * to aec_process_frame_threads().
+ *
+ * \param num_threads  Number of threads sharing the work, including the
+ *                     caller of aec_process_frame_threads(). Between 1 and
+ *                     AEC_THREADS_MAX. num_threads - 1 worker tasks are created.
+ * \param priority     Priority of the worker tasks. This should be the same
+ *                     as the pipeline stage calling aec_process_frame_threads().
+ */
+void aec_process_frame_threads_init(unsigned num_threads, unsigned priority);
+
+/**
+ * Process one frame through the AEC, sharing the per channel and per filter
+ * work between the caller and the worker tasks. The output is the same as
+ * aec_process_frame_1thread().
+ *
+ * The threads meet at a barrier at each point where the next step needs the
+ * results of all channels of the previous one.
+ */
+void aec_process_frame_threads(
+        aec_state_t *main_state,
+        aec_state_t *shadow_state,
+        int32_t (*output_main)[AEC_FRAME_ADVANCE],
+        int32_t (*output_shadow)[AEC_FRAME_ADVANCE],
+        const int32_t (*y_data)[AEC_FRAME_ADVANCE],
+        const int32_t (*x_data)[AEC_FRAME_ADVANCE]);
+
+/**
+ * Pass a frame through while the AEC is skipped, in place of
+ * aec_process_frame_threads() or aec_process_frame_1thread().
+ *
+ * The mic input is copied to the output. The adaptive filters, the X FIFO and
+ * the filter comparison state are left as they are, so that echo cancellation
+ * resumes where it stopped. Only the cheap per frame state that is read
+ * outside the AEC is kept up to date: the previous frame buffers, so that the
+ * first frame processed on resuming does not overlap stale input, and the mic,
+ * reference and error EMA energies, which give an ERLE of 1 while idle.
+ *
+ * The output windowing overlap is not updated, so the first samples output on
+ * resuming overlap the end of the last frame processed before going idle.
+ */
+void aec_process_frame_idle(
+        aec_state_t *main_state,
+        aec_state_t *shadow_state,
+        int32_t (*output_main)[AEC_FRAME_ADVANCE],
+        const int32_t (*y_data)[AEC_FRAME_ADVANCE],
+        const int32_t (*x_data)[AEC_FRAME_ADVANCE]);
+
+/**
+ * Update an AEC idle gate with the reference input of a frame, comparing the
+ * reference level with the threshold for the current state of the gate.
+ *
+ * \param gate              The gate.
+ * \param hold_threshold    Level below which an active AEC counts down the hold time.
+ * \param resume_threshold  Level at or above which an idle AEC resumes.
+ * \param main_state        The AEC main filter state.
+ * \param x_data            The reference input of the frame.
+ * \param must_run          Non-zero if the AEC must process every frame for
+ *                          now, for example while it is estimating the delay.
+ *                          The gate is returned to the active state.
+ * \returns                 1 if the AEC must process the frame, 0 if
+ *                          aec_process_frame_idle() can be called instead.
+ *                          Always 1 when appconfAEC_IDLE_GATE_ENABLED is 0.
+ */
+int aec_idle_gate_frame(
+        aec_idle_gate_t *gate,
+        float_s32_t hold_threshold,
+        float_s32_t resume_threshold,
+        aec_state_t *main_state,
+        int32_t (*x_data)[AEC_FRAME_ADVANCE],
+        int must_run);
+
+#endif /* AEC_PROCESS_FRAME_THREADS_H_ */
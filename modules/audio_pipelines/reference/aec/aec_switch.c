@@ -0,0 +1,137 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <xcore/assert.h>
+#include <xcore/hwtimer.h>
+
+#include "profile.h"
+#include "aec_switch.h"
+
+#if appconfPROFILE_ENABLED
+#include "rtos_printf.h"
+#endif
+
+static float aec_erle_ch0(aec_state_t *main_state)
+{
+    float y_energy = float_s32_to_float(main_state->shared_state->y_ema_energy[0]);
+    float error_energy = float_s32_to_float(main_state->error_ema_energy[0]);
+    return (error_energy > 0) ? (y_energy / error_energy) : 1.0f;
+}
+
+#if appconfAEC_DE_SWITCH_RETAIN_FILTER
+static void aec_retain_filter(aec_retained_filter_t *retained, aec_state_t *main_state, int32_t delay_samples)
+{
+    int num_y_channels = main_state->shared_state->num_y_channels;
+    int num_phases = main_state->num_phases * main_state->shared_state->num_x_channels;
+
+    xassert(num_phases <= AEC_MAX_X_CHANNELS*AEC_MAIN_FILTER_PHASES);
+    for(int ych=0; ych<num_y_channels; ych++) {
+        for(int ph=0; ph<num_phases; ph++) {
+            bfp_complex_s32_t *H_hat = &main_state->H_hat[ych][ph];
+            xassert(H_hat->length <= AEC_FD_FRAME_LENGTH);
+            memcpy(retained->H_hat[ych][ph], H_hat->data, H_hat->length*sizeof(complex_s32_t));
+            retained->exp[ych][ph] = H_hat->exp;
+            retained->hr[ych][ph] = H_hat->hr;
+        }
+    }
+    retained->delay_samples = delay_samples;
+    retained->valid = 1;
+}
+
+/* Returns 1 if the retained filter was restored */
+static int aec_restore_filter(aec_retained_filter_t *retained, aec_state_t *main_state, int32_t delay_samples)
+{
+    int num_y_channels = main_state->shared_state->num_y_channels;
+    int num_phases = main_state->num_phases * main_state->shared_state->num_x_channels;
+
+    // The retained taps only model the echo path at the delay they were converged with
+    int restore = retained->valid && (retained->delay_samples == delay_samples);
+    retained->valid = 0;
+    if(!restore) {
+        return 0;
+    }
+
+    for(int ych=0; ych<num_y_channels; ych++) {
+        for(int ph=0; ph<num_phases; ph++) {
+            bfp_complex_s32_t *H_hat = &main_state->H_hat[ych][ph];
+            memcpy(H_hat->data, retained->H_hat[ych][ph], H_hat->length*sizeof(complex_s32_t));
+            H_hat->exp = retained->exp[ych][ph];
+            H_hat->hr = retained->hr[ych][ph];
+        }
+    }
+    return 1;
+}
+#endif
+
+void aec_switch_init(aec_switch_t *sw)
+{
+    memset(&sw->stats, 0, sizeof(sw->stats));
+    sw->erle_before_switch = 0;
+    sw->erle_margin = powf(10, -AEC_RECOVERY_ERLE_MARGIN_dB/10.0f);
+    sw->frames_since_switch = -1;
+    sw->start_ticks = 0;
+#if appconfAEC_DE_SWITCH_RETAIN_FILTER
+    sw->retained_filter.valid = 0;
+#endif
+}
+
+void aec_switch_begin(aec_switch_t *sw, aec_state_t *main_state, int to_de_mode, int32_t delay_samples)
+{
+    sw->start_ticks = get_reference_time();
+
+    if(to_de_mode) {
+        sw->erle_before_switch = aec_erle_ch0(main_state);
+#if appconfAEC_DE_SWITCH_RETAIN_FILTER
+        aec_retain_filter(&sw->retained_filter, main_state, delay_samples);
+#else
+        (void)delay_samples;
+#endif
+    }
+}
+
+void aec_switch_end(aec_switch_t *sw, aec_state_t *main_state, int to_de_mode, int32_t delay_samples)
+{
+    aec_switch_stats_t *stats = &sw->stats;
+    if(!to_de_mode) {
+#if appconfAEC_DE_SWITCH_RETAIN_FILTER
+        stats->filter_restored = aec_restore_filter(&sw->retained_filter, main_state, delay_samples);
+#else
+        (void)main_state;
+        (void)delay_samples;
+        stats->filter_restored = 0;
+#endif
+        stats->recovery_frames = -1;
+        sw->frames_since_switch = 0;
+    }
+
+    uint32_t ticks = get_reference_time() - sw->start_ticks;
+    stats->switch_count++;
+    stats->last_switch_ticks = ticks;
+    if(ticks > stats->max_switch_ticks) {
+        stats->max_switch_ticks = ticks;
+    }
+}
+
+void aec_switch_track_recovery(aec_switch_t *sw, aec_state_t *main_state, int de_mode, int32_t ref_active_flag)
+{
+    aec_switch_stats_t *stats = &sw->stats;
+    if(de_mode || (stats->recovery_frames >= 0) || (sw->frames_since_switch < 0)) {
+        return;
+    }
+
+    sw->frames_since_switch++;
+    // Echo reduction can only be measured while there is a reference signal
+    if(ref_active_flag && (aec_erle_ch0(main_state) >= sw->erle_before_switch * sw->erle_margin)) {
+        stats->recovery_frames = sw->frames_since_switch;
+#if appconfPROFILE_ENABLED
+        rtos_printf("aec_switch: recovery_frames=%d filter_restored=%d switch_ticks=%u max_switch_ticks=%u\n",
+                    stats->recovery_frames, stats->filter_restored, stats->last_switch_ticks, stats->max_switch_ticks);
+#endif
+    } else if(sw->frames_since_switch >= (16000*AEC_RECOVERY_MAX_SECONDS)/AEC_FRAME_ADVANCE) {
+        // Give up, leaving recovery_frames at -1
+        sw->frames_since_switch = -1;
+    }
+}
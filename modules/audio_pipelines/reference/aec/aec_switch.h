@@ -0,0 +1,105 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef AEC_SWITCH_H_
+#define AEC_SWITCH_H_
+
+#include <stdint.h>
+#include "aec_defines.h"
+#include "aec_api.h"
+
+/**
+ * \addtogroup aec_switch aec_switch
+ *
+ * Bookkeeping for the ADEC pipelines switching the AEC between its normal
+ * configuration and its delay estimation configuration.
+ *
+ * The caller re-initialises the AEC between aec_switch_begin() and
+ * aec_switch_end(). The time taken is recorded, and after a switch back to
+ * normal mode the number of frames until the echo reduction recovers to its
+ * level before the switch is counted by aec_switch_track_recovery().
+ * @{
+ */
+
+/* Keep a copy of the normal mode main filter while the AEC is in delay
+ * estimation mode, and restore it on returning to normal mode if the delay was
+ * not changed. Echo reduction then resumes as soon as the X FIFO refills,
+ * rather than after the filter has converged again. The copy needs
+ * AEC_MAX_Y_CHANNELS * AEC_MAX_X_CHANNELS * AEC_MAIN_FILTER_PHASES *
+ * AEC_FD_FRAME_LENGTH * 8 bytes, 82 kB for the default configuration. Set to
+ * 0 to save that memory and let the filter converge again after each switch. */
+#ifndef appconfAEC_DE_SWITCH_RETAIN_FILTER
+#define appconfAEC_DE_SWITCH_RETAIN_FILTER 1
+#endif
+
+#define AEC_RECOVERY_ERLE_MARGIN_dB (3) // Echo reduction has recovered from a configuration switch once it is within 3dB of its level before the switch
+#define AEC_RECOVERY_MAX_SECONDS (30) // Stop waiting for echo reduction to recover 30 seconds after a configuration switch
+
+typedef struct {
+    uint32_t switch_count; // Number of AEC configuration switches
+    uint32_t last_switch_ticks; // Time taken by the last switch, in 100MHz reference clock ticks
+    uint32_t max_switch_ticks; // Longest time taken by a switch, in 100MHz reference clock ticks
+    int32_t filter_restored; // 1 if the last switch to normal mode restored the retained main filter
+    int32_t recovery_frames; // Frames taken for echo reduction to recover after the last switch to normal mode. -1 until it has recovered
+} aec_switch_stats_t;
+
+#if appconfAEC_DE_SWITCH_RETAIN_FILTER
+typedef struct {
+    complex_s32_t DWORD_ALIGNED H_hat[AEC_MAX_Y_CHANNELS][AEC_MAX_X_CHANNELS*AEC_MAIN_FILTER_PHASES][AEC_FD_FRAME_LENGTH];
+    exponent_t exp[AEC_MAX_Y_CHANNELS][AEC_MAX_X_CHANNELS*AEC_MAIN_FILTER_PHASES];
+    headroom_t hr[AEC_MAX_Y_CHANNELS][AEC_MAX_X_CHANNELS*AEC_MAIN_FILTER_PHASES];
+    int32_t delay_samples; // Delay when the filter was retained
+    int32_t valid;
+} aec_retained_filter_t;
+#endif
+
+typedef struct {
+    aec_switch_stats_t stats;
+    float erle_before_switch; // Main filter echo reduction on ch 0 before switching to delay estimation mode
+    float erle_margin; // Fraction of erle_before_switch at which echo reduction has recovered
+    int32_t frames_since_switch; // Frames since the last switch to normal mode. -1 once recovery is no longer tracked
+    uint32_t start_ticks; // Reference time at the start of the switch in progress
+#if appconfAEC_DE_SWITCH_RETAIN_FILTER
+    aec_retained_filter_t retained_filter;
+#endif
+} aec_switch_t;
+
+/**
+ * Clear the statistics and any retained filter.
+ */
+void aec_switch_init(aec_switch_t *sw);
+
+/**
+ * Start a switch, before the AEC is re-initialised.
+ *
+ * \param sw             The switch state.
+ * \param main_state     The AEC main filter state, in the old configuration.
+ * \param to_de_mode     Non-zero if switching to the delay estimation configuration.
+ * \param delay_samples  Mic delay applied by the delay buffer.
+ */
+void aec_switch_begin(aec_switch_t *sw, aec_state_t *main_state, int to_de_mode, int32_t delay_samples);
+
+/**
+ * Finish a switch, after the AEC has been re-initialised.
+ *
+ * \param sw             The switch state.
+ * \param main_state     The AEC main filter state, in the new configuration.
+ * \param to_de_mode     As passed to aec_switch_begin().
+ * \param delay_samples  Mic delay applied by the delay buffer.
+ */
+void aec_switch_end(aec_switch_t *sw, aec_state_t *main_state, int to_de_mode, int32_t delay_samples);
+
+/**
+ * Count the frames until echo reduction is back to where it was before the
+ * AEC switched to delay estimation mode. Call once per frame processed.
+ *
+ * \param sw               The switch state.
+ * \param main_state       The AEC main filter state.
+ * \param de_mode          Non-zero while the AEC is in delay estimation mode.
+ * \param ref_active_flag  Non-zero if the reference is active in this frame.
+ */
+void aec_switch_track_recovery(aec_switch_t *sw, aec_state_t *main_state, int de_mode, int32_t ref_active_flag);
+
+/**@}*/
+
+#endif /* AEC_SWITCH_H_ */
@@ -0,0 +1,91 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "audio_pipeline_dsp.h"
+#include "profile.h"
+#include "delay_alignment.h"
+
+#if appconfDELAY_ESTIMATOR_TASK
+#include "FreeRTOS.h"
+#include "task.h"
+#endif
+
+PROFILE_PROBE_DEFINE(delay_estimator_probe, "delay_est");
+
+#if appconfDELAY_ESTIMATOR_TASK
+static TaskHandle_t delay_estimator_task_handle;
+
+static void delay_estimator_task(delay_estimator_t *de)
+{
+    for(;;) {
+        // Woken by the pipeline stage when an estimate is due
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        PROFILE_START(delay_estimator_probe);
+        delay_estimator_process(de);
+        PROFILE_END(delay_estimator_probe);
+    }
+}
+#endif
+
+void delay_alignment_init(delay_alignment_t *da, float_s32_t ref_active_threshold)
+{
+    // Delays that the delay buffer can apply
+    delay_estimator_config_t de_config = {
+        .min_lag = appconfDELAY_ESTIMATOR_TARGET_SAMPLES - (DELAY_BUF_MAX_DELAY_SAMPLES - 1),
+        .max_lag = appconfDELAY_ESTIMATOR_TARGET_SAMPLES + (DELAY_BUF_MAX_DELAY_SAMPLES - 1),
+        .interval_samples = 16*appconfDELAY_ESTIMATOR_INTERVAL_MS,
+        .peak_ratio_threshold = DELAY_ESTIMATOR_PEAK_RATIO_THRESHOLD,
+        .smoothing = DELAY_ESTIMATOR_SMOOTHING,
+    };
+    delay_estimator_init(&da->delay_estimator, &de_config);
+    da->ref_active_threshold = ref_active_threshold;
+    da->changes = 0;
+#if appconfDELAY_ESTIMATOR_TASK
+    xTaskCreate((TaskFunction_t) delay_estimator_task,
+                "delay_est",
+                RTOS_THREAD_STACK_SIZE(delay_estimator_task),
+                &da->delay_estimator,
+                appconfDELAY_ESTIMATOR_TASK_PRIORITY,
+                &delay_estimator_task_handle);
+    configASSERT(delay_estimator_task_handle != NULL);
+#endif
+}
+
+int delay_alignment_frame(delay_alignment_t *da,
+                          delay_buf_state_t *delay_state,
+                          int32_t (*input_y)[AP_FRAME_ADVANCE],
+                          int32_t (*input_x)[AP_FRAME_ADVANCE])
+{
+    delay_estimator_t *de = &da->delay_estimator;
+    int32_t ref_active = aec_detect_input_activity(input_x, da->ref_active_threshold, 1);
+
+    if(delay_estimator_push(de, input_y[0], input_x[0], AP_FRAME_ADVANCE, ref_active)) {
+#if appconfDELAY_ESTIMATOR_TASK
+        xTaskNotifyGive(delay_estimator_task_handle);
+#else
+        PROFILE_START(delay_estimator_probe);
+        delay_estimator_process(de);
+        PROFILE_END(delay_estimator_probe);
+#endif
+    }
+
+    delay_estimate_t estimate;
+    if(!delay_estimator_get(de, &estimate) || !estimate.valid) {
+        return 0;
+    }
+
+    // Delay the mic so that the echo follows the reference by the target delay. A negative mic delay delays the reference instead
+    int32_t mic_delay = appconfDELAY_ESTIMATOR_TARGET_SAMPLES - estimate.lag;
+    if(abs(mic_delay - delay_state->delay_samples) <= appconfDELAY_ESTIMATOR_TOLERANCE_SAMPLES) {
+        return 0;
+    }
+    update_delay_samples(delay_state, mic_delay);
+    for(int ch=0; ch<AP_MAX_Y_CHANNELS; ch++) {
+        reset_partial_delay_buffer(delay_state, ch);
+    }
+    da->changes++;
+    return 1;
+}
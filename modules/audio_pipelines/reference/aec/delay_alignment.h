@@ -0,0 +1,101 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef DELAY_ALIGNMENT_H_
+#define DELAY_ALIGNMENT_H_
+
+#include <stdint.h>
+#include "aec_api.h"
+#include "delay_buffer.h"
+#include "delay_estimator.h"
+
+/**
+ * \addtogroup delay_alignment delay_alignment
+ *
+ * Aligns the mic and reference inputs of the ADEC pipelines with the
+ * standalone delay estimator in delay_estimator.h, by setting the delay of
+ * their delay buffer.
+ *
+ * Each frame is passed to the estimator before it is delayed. The estimates
+ * are made in a task of their own or in the calling pipeline stage, see
+ * appconfDELAY_ESTIMATOR_TASK.
+ * @{
+ */
+
+/* Set to 1 to align the mic and reference with the standalone delay estimator
+ * in delay_estimator.h instead of switching the AEC to its 30 phase delay
+ * estimation mode at startup. The estimator runs throughout, so the delay is
+ * also tracked after startup. It needs about 33 kB. */
+#ifndef appconfDELAY_ESTIMATOR_ENABLED
+#define appconfDELAY_ESTIMATOR_ENABLED 0
+#endif
+
+/* Time between delay estimates */
+#ifndef appconfDELAY_ESTIMATOR_INTERVAL_MS
+#define appconfDELAY_ESTIMATOR_INTERVAL_MS 1000
+#endif
+
+/* Echo delay the mic and reference are aligned to. This leaves the first
+ * samples of the AEC filter for the error of the estimate. */
+#ifndef appconfDELAY_ESTIMATOR_TARGET_SAMPLES
+#define appconfDELAY_ESTIMATOR_TARGET_SAMPLES 160
+#endif
+
+/* Smallest change in the estimated delay that is applied. Each change resets
+ * the AEC. */
+#ifndef appconfDELAY_ESTIMATOR_TOLERANCE_SAMPLES
+#define appconfDELAY_ESTIMATOR_TOLERANCE_SAMPLES 32
+#endif
+
+/* Set to 1 to make the estimates in a task of their own, at
+ * appconfDELAY_ESTIMATOR_TASK_PRIORITY, so that they use spare processing
+ * time. When 0 they are made in the pipeline stage. */
+#ifndef appconfDELAY_ESTIMATOR_TASK
+#define appconfDELAY_ESTIMATOR_TASK 1
+#endif
+
+#ifndef appconfDELAY_ESTIMATOR_TASK_PRIORITY
+#define appconfDELAY_ESTIMATOR_TASK_PRIORITY (appconfAUDIO_PIPELINE_TASK_PRIORITY - 1)
+#endif
+
+#define DELAY_ESTIMATOR_PEAK_RATIO_THRESHOLD (8.0f) // Correlation peak to mean ratio above which a delay estimate is confident
+#define DELAY_ESTIMATOR_SMOOTHING (0.5f) // Weight of the previous delay estimates in the smoothed cross spectrum
+
+typedef struct {
+    delay_estimator_t delay_estimator;
+    float_s32_t ref_active_threshold; // Reference input level above which it is considered active
+    uint32_t changes; // Number of delay changes applied from the estimates
+} delay_alignment_t;
+
+/**
+ * Initialise the delay estimator for the delays the delay buffer can apply,
+ * and create its task if appconfDELAY_ESTIMATOR_TASK is 1.
+ *
+ * Must be called once, on the tile running the pipeline stage.
+ *
+ * \param da                    The delay alignment state.
+ * \param ref_active_threshold  Reference input level above which it is
+ *                              considered active.
+ */
+void delay_alignment_init(delay_alignment_t *da, float_s32_t ref_active_threshold);
+
+/**
+ * Pass a frame, before it is delayed, to the delay estimator, and apply any
+ * new estimate to the delay buffer.
+ *
+ * \param da           The delay alignment state.
+ * \param delay_state  The delay buffer.
+ * \param input_y      The mic input of the frame.
+ * \param input_x      The reference input of the frame.
+ * \returns            1 if the delay was changed, in which case the AEC
+ *                     filters model the echo path at the old alignment and
+ *                     should be reset.
+ */
+int delay_alignment_frame(delay_alignment_t *da,
+                          delay_buf_state_t *delay_state,
+                          int32_t (*input_y)[AP_FRAME_ADVANCE],
+                          int32_t (*input_x)[AP_FRAME_ADVANCE]);
+
+/**@}*/
+
+#endif /* DELAY_ALIGNMENT_H_ */
@@ -0,0 +1,153 @@
+// Copyright 2022-2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include "delay_buffer.h"
+
+void delay_buffer_init(delay_buf_state_t *state, int default_delay_samples) {
+    memset(state->delay_buffer, 0, sizeof(state->delay_buffer));
+    memset(&state->curr_idx[0], 0, sizeof(state->curr_idx));
+    state->delay_samples = default_delay_samples;
+    state->delay_frac = 0;
+}
+
+void get_delayed_sample(delay_buf_state_t *delay_state, int32_t *sample, int32_t ch) {
+    delay_state->delay_buffer[ch][delay_state->curr_idx[ch]] = *sample;
+    int32_t abs_delay_samples = (delay_state->delay_samples < 0) ? -delay_state->delay_samples : delay_state->delay_samples;
+    // Send back the samples with the correct delay
+    uint32_t delay_idx = (
+            (DELAY_BUF_MAX_DELAY_SAMPLES + delay_state->curr_idx[ch] - abs_delay_samples)
+            % DELAY_BUF_MAX_DELAY_SAMPLES
+            );
+    *sample = delay_state->delay_buffer[ch][delay_idx];
+    delay_state->curr_idx[ch] = (delay_state->curr_idx[ch] + 1) % DELAY_BUF_MAX_DELAY_SAMPLES;
+}
+
+void update_delay_samples(delay_buf_state_t *delay_state, int32_t num_samples) {
+    delay_state->delay_samples = num_samples;
+    delay_state->delay_frac = 0;
+}
+
+void update_fractional_delay(delay_buf_state_t *delay_state, int32_t frac) {
+    assert((frac >= 0) && (frac < (1 << DELAY_BUF_FRAC_BITS)));
+    delay_state->delay_frac = frac;
+}
+
+void reset_partial_delay_buffer(delay_buf_state_t *delay_state, int32_t ch) {
+    int32_t num_samples = delay_state->delay_samples;
+    if(!num_samples) {
+        return;
+    }
+    // Reset delay_state->delay_samples before the current index
+
+    num_samples = (num_samples < 0) ? -num_samples : num_samples;
+    // Reset num_samples samples before curr_idx
+    int32_t reset_start = (
+            (DELAY_BUF_MAX_DELAY_SAMPLES + delay_state->curr_idx[ch] - num_samples)
+            % DELAY_BUF_MAX_DELAY_SAMPLES
+            );
+    if(reset_start < delay_state->curr_idx[ch]) {
+        //reset_start hasn't wrapped around
+        memset(&delay_state->delay_buffer[ch][reset_start], 0, num_samples*sizeof(int32_t));
+    }
+    else {
+        //reset_start has wrapped around
+        memset(&delay_state->delay_buffer[ch][0], 0, delay_state->curr_idx[ch]*sizeof(int32_t));
+        int remaining = num_samples - delay_state->curr_idx[ch];
+        memset(&delay_state->delay_buffer[ch][DELAY_BUF_MAX_DELAY_SAMPLES - remaining], 0, remaining*sizeof(int32_t));
+    }
+}
+
+void delay_buffer_get_spans(delay_buf_state_t *delay_state, delay_buf_spans_t *spans, int32_t num_samples, int32_t delay, int32_t ch) {
+    assert((num_samples >= 0) && (delay >= 0));
+    assert(delay + num_samples <= DELAY_BUF_MAX_DELAY_SAMPLES);
+
+    int32_t start = delay_state->curr_idx[ch] - delay - num_samples;
+    if (start < 0) {
+        start += DELAY_BUF_MAX_DELAY_SAMPLES;
+    }
+    int32_t first_len = DELAY_BUF_MAX_DELAY_SAMPLES - start;
+
+    spans->data[0] = &delay_state->delay_buffer[ch][start];
+    if (num_samples <= first_len) {
+        spans->len[0] = num_samples;
+        spans->data[1] = NULL;
+        spans->len[1] = 0;
+    } else {
+        spans->len[0] = first_len;
+        spans->data[1] = &delay_state->delay_buffer[ch][0];
+        spans->len[1] = num_samples - first_len;
+    }
+}
+
+void delay_buffer_write_block(delay_buf_state_t *delay_state, const int32_t *samples, int32_t num_samples, int32_t ch) {
+    assert((num_samples >= 0) && (num_samples <= DELAY_BUF_MAX_DELAY_SAMPLES));
+
+    int32_t idx = delay_state->curr_idx[ch];
+    int32_t first_len = DELAY_BUF_MAX_DELAY_SAMPLES - idx;
+
+    if (num_samples < first_len) {
+        memcpy(&delay_state->delay_buffer[ch][idx], samples, num_samples * sizeof(int32_t));
+        delay_state->curr_idx[ch] = idx + num_samples;
+    } else {
+        memcpy(&delay_state->delay_buffer[ch][idx], samples, first_len * sizeof(int32_t));
+        memcpy(&delay_state->delay_buffer[ch][0], &samples[first_len], (num_samples - first_len) * sizeof(int32_t));
+        delay_state->curr_idx[ch] = num_samples - first_len;
+    }
+}
+
+static void read_block(delay_buf_state_t *delay_state, int32_t *samples, int32_t num_samples, int32_t delay, int32_t ch) {
+    delay_buf_spans_t spans;
+
+    delay_buffer_get_spans(delay_state, &spans, num_samples, delay, ch);
+    memcpy(samples, spans.data[0], spans.len[0] * sizeof(int32_t));
+    if (spans.len[1]) {
+        memcpy(&samples[spans.len[0]], spans.data[1], spans.len[1] * sizeof(int32_t));
+    }
+}
+
+void delay_buffer_read_block(delay_buf_state_t *delay_state, int32_t *samples, int32_t num_samples, int32_t ch) {
+    int32_t delay = (delay_state->delay_samples < 0) ? -delay_state->delay_samples : delay_state->delay_samples;
+
+    read_block(delay_state, samples, num_samples, delay, ch);
+}
+
+void get_delayed_block(delay_buf_state_t *delay_state, int32_t *samples, int32_t num_samples, int32_t ch) {
+    int32_t abs_delay_samples = (delay_state->delay_samples < 0) ? -delay_state->delay_samples : delay_state->delay_samples;
+    // A delay of the full buffer length wraps around to the sample just written, as in get_delayed_sample()
+    int32_t delay = abs_delay_samples % DELAY_BUF_MAX_DELAY_SAMPLES;
+    int32_t frac = delay_state->delay_frac;
+    // Oldest sample needed relative to the one being delayed
+    int32_t history = delay + (frac ? 1 : 0);
+
+    // Writing the whole block before reading is only the same as going sample
+    // by sample while the samples read are not overwritten by the block
+    // itself, so very long delays are handled a chunk at a time.
+    int32_t max_chunk = DELAY_BUF_MAX_DELAY_SAMPLES - history;
+    assert(max_chunk > 0);
+
+    while (num_samples > 0) {
+        int32_t chunk = (num_samples < max_chunk) ? num_samples : max_chunk;
+
+        delay_buffer_write_block(delay_state, samples, chunk, ch);
+        read_block(delay_state, samples, chunk, delay, ch);
+
+        if (frac) {
+            int32_t prev;
+            read_block(delay_state, &prev, 1, delay + chunk, ch);
+
+            // Interpolate towards the previous sample, working backwards so each
+            // sample's predecessor is still unmodified when it is needed
+            for (int32_t i = chunk - 1; i >= 0; i--) {
+                int32_t older = (i > 0) ? samples[i - 1] : prev;
+                int64_t diff = (int64_t)older - samples[i];
+                samples[i] += (int32_t)((diff * frac) >> DELAY_BUF_FRAC_BITS);
+            }
+        }
+
+        samples += chunk;
+        num_samples -= chunk;
+    }
+}
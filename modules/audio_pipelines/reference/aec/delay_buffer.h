@@ -0,0 +1,90 @@
+// Copyright 2022-2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef DELAY_BUFFER_H_
+#define DELAY_BUFFER_H_
+#include "audio_pipeline_dsp.h"
+
+/* Number of fractional delay bits, see update_fractional_delay() */
+#define DELAY_BUF_FRAC_BITS     (16)
+
+typedef struct {
+    // Circular buffer to store the samples
+    int32_t delay_buffer[MAX_DELAY_BUF_CHANNELS][DELAY_BUF_MAX_DELAY_SAMPLES];
+    // index of the value for the samples to be stored in the buffer
+    int32_t curr_idx[MAX_DELAY_BUF_CHANNELS];
+    int32_t delay_samples;
+    // Fraction of a sample added to the delay, in Q0.DELAY_BUF_FRAC_BITS. Only applied by get_delayed_block()
+    int32_t delay_frac;
+} delay_buf_state_t;
+
+/* Up to two contiguous regions of one channel of the circular buffer, in time order */
+typedef struct {
+    int32_t *data[2];
+    int32_t len[2];
+} delay_buf_spans_t;
+
+void delay_buffer_init(delay_buf_state_t *state, int default_delay_samples);
+void get_delayed_sample(delay_buf_state_t *delay_state, int32_t *sample, int32_t ch);
+void update_delay_samples(delay_buf_state_t *delay_state, int32_t num_samples);
+void reset_partial_delay_buffer(delay_buf_state_t *delay_state, int32_t ch);
+
+/**
+ * Set the fractional part of the delay. The delayed samples are linearly
+ * interpolated between delay_samples and delay_samples + 1 samples ago.
+ * update_delay_samples() clears the fractional delay.
+ *
+ * \param delay_state  Delay buffer state.
+ * \param frac         Fraction of a sample in Q0.DELAY_BUF_FRAC_BITS, 0 to disable.
+ */
+void update_fractional_delay(delay_buf_state_t *delay_state, int32_t frac);
+
+/**
+ * Block equivalent of calling get_delayed_sample() on each sample in turn.
+ * Each sample is replaced in place by the sample delay_samples before it.
+ *
+ * \param delay_state  Delay buffer state.
+ * \param samples      num_samples samples to delay, replaced by the delayed samples.
+ * \param num_samples  Number of samples, at most DELAY_BUF_MAX_DELAY_SAMPLES.
+ * \param ch           Delay buffer channel.
+ */
+void get_delayed_block(delay_buf_state_t *delay_state, int32_t *samples, int32_t num_samples, int32_t ch);
+
+/**
+ * Append samples to a channel of the circular buffer.
+ *
+ * \param delay_state  Delay buffer state.
+ * \param samples      Samples to write.
+ * \param num_samples  Number of samples, at most DELAY_BUF_MAX_DELAY_SAMPLES.
+ * \param ch           Delay buffer channel.
+ */
+void delay_buffer_write_block(delay_buf_state_t *delay_state, const int32_t *samples, int32_t num_samples, int32_t ch);
+
+/**
+ * Get the location in the circular buffer of num_samples consecutive samples,
+ * the newest of which was written delay samples before the most recent one.
+ * This gives read only access to the buffer history without copying it.
+ *
+ * \param delay_state  Delay buffer state.
+ * \param spans        Filled with the location of the samples. len[1] is 0
+ *                     when the samples do not wrap around the end of the buffer.
+ * \param num_samples  Number of samples.
+ * \param delay        Age of the newest sample, in samples.
+ *                     delay + num_samples must not exceed DELAY_BUF_MAX_DELAY_SAMPLES.
+ * \param ch           Delay buffer channel.
+ */
+void delay_buffer_get_spans(delay_buf_state_t *delay_state, delay_buf_spans_t *spans, int32_t num_samples, int32_t delay, int32_t ch);
+
+/**
+ * Copy the num_samples samples written by the last delay_buffer_write_block()
+ * of that length, delayed by delay_samples, out of the circular buffer.
+ *
+ * \param delay_state  Delay buffer state.
+ * \param samples      Output buffer of num_samples samples.
+ * \param num_samples  Number of samples. delay_samples + num_samples must not
+ *                     exceed DELAY_BUF_MAX_DELAY_SAMPLES.
+ * \param ch           Delay buffer channel.
+ */
+void delay_buffer_read_block(delay_buf_state_t *delay_state, int32_t *samples, int32_t num_samples, int32_t ch);
+
+#endif /* DELAY_BUFFER_H_ */
@@ -0,0 +1,249 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <string.h>
+#include <math.h>
+
+#include "delay_estimator.h"
+
+#ifndef M_PI
+#define M_PI                (3.14159265358979323846)
+#endif
+
+#define FFT_LENGTH          DELAY_ESTIMATOR_FFT_LENGTH
+#define NUM_BINS            (FFT_LENGTH / 2 + 1)
+
+/* Input samples are Q1.31, scaled to +/-1 after decimation */
+#define INPUT_SCALE         (1.0f / (2147483648.0f * DELAY_ESTIMATOR_DECIMATION))
+
+/* Consecutive estimates closer than this, in decimated samples, agree */
+#define CONSISTENT_LAG      (2)
+
+/* Whitening floor, relative to the largest cross spectrum magnitude */
+#define PHAT_FLOOR          (1e-6f)
+
+static void fft_bit_reverse(delay_estimator_complex_t *x)
+{
+    for (int i = 1, j = 0; i < FFT_LENGTH; i++) {
+        int bit = FFT_LENGTH >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            delay_estimator_complex_t t = x[i];
+            x[i] = x[j];
+            x[j] = t;
+        }
+    }
+}
+
+/* In place radix 2 FFT. The inverse is unscaled. */
+static void fft(delay_estimator_complex_t *x, int inverse)
+{
+    fft_bit_reverse(x);
+
+    for (int len = 2; len <= FFT_LENGTH; len <<= 1) {
+        float angle = (inverse ? 2.0f : -2.0f) * (float)M_PI / len;
+        delay_estimator_complex_t w_step = { cosf(angle), sinf(angle) };
+
+        for (int start = 0; start < FFT_LENGTH; start += len) {
+            delay_estimator_complex_t w = { 1.0f, 0.0f };
+
+            for (int k = 0; k < len / 2; k++) {
+                delay_estimator_complex_t *a = &x[start + k];
+                delay_estimator_complex_t *b = &x[start + k + len / 2];
+                delay_estimator_complex_t t = {
+                    b->re * w.re - b->im * w.im,
+                    b->re * w.im + b->im * w.re,
+                };
+                b->re = a->re - t.re;
+                b->im = a->im - t.im;
+                a->re += t.re;
+                a->im += t.im;
+
+                float w_re = w.re * w_step.re - w.im * w_step.im;
+                w.im = w.re * w_step.im + w.im * w_step.re;
+                w.re = w_re;
+            }
+        }
+    }
+}
+
+void delay_estimator_init(delay_estimator_t *de, const delay_estimator_config_t *config)
+{
+    memset(de, 0, sizeof(*de));
+    de->config = *config;
+}
+
+int delay_estimator_push(delay_estimator_t *de, const int32_t *mic, const int32_t *ref, int n, int ref_active)
+{
+    for (int i = 0; i < n; i++) {
+        de->mic_acc += mic[i];
+        de->ref_acc += ref[i];
+
+        if (++de->acc_count == DELAY_ESTIMATOR_DECIMATION) {
+            de->mic_history[de->history_idx] = (float)de->mic_acc * INPUT_SCALE;
+            de->ref_history[de->history_idx] = (float)de->ref_acc * INPUT_SCALE;
+            de->history_idx = (de->history_idx + 1) % DELAY_ESTIMATOR_WINDOW;
+            de->mic_acc = 0;
+            de->ref_acc = 0;
+            de->acc_count = 0;
+        }
+    }
+
+    de->samples_since_estimate += n;
+    if (ref_active) {
+        de->active_samples += n;
+    }
+    if (de->samples_since_estimate < (uint32_t)de->config.interval_samples ||
+        __atomic_load_n(&de->busy, __ATOMIC_ACQUIRE)) {
+        return 0;
+    }
+
+    int enough_reference = (2 * de->active_samples >= de->samples_since_estimate);
+    de->samples_since_estimate = 0;
+    de->active_samples = 0;
+    if (!enough_reference) {
+        return 0;
+    }
+
+    /* Oldest first, zero padded */
+    for (int i = 0; i < DELAY_ESTIMATOR_WINDOW; i++) {
+        int idx = (de->history_idx + i) % DELAY_ESTIMATOR_WINDOW;
+        de->work[i].re = de->mic_history[idx];
+        de->work[i].im = de->ref_history[idx];
+    }
+    memset(&de->work[DELAY_ESTIMATOR_WINDOW], 0, (FFT_LENGTH - DELAY_ESTIMATOR_WINDOW) * sizeof(de->work[0]));
+    __atomic_store_n(&de->busy, 1, __ATOMIC_RELAXED);
+    return 1;
+}
+
+/* Smooth the cross spectrum of the window into de->cross_spectrum, then
+ * replace the window with its whitened cross correlation. Returns 0 if the
+ * reference is silent, leaving the cross spectrum as it was. */
+static int gcc_phat(delay_estimator_t *de)
+{
+    delay_estimator_complex_t *z = de->work;
+    delay_estimator_complex_t *s = de->cross_spectrum;
+    float alpha = de->config.smoothing;
+    float max_mag = 0;
+    float ref_energy = 0;
+
+    for (int i = 0; i < DELAY_ESTIMATOR_WINDOW; i++) {
+        ref_energy += z[i].im * z[i].im;
+    }
+    if (ref_energy == 0) {
+        return 0;
+    }
+
+    /* One FFT of mic + j * ref gives both spectra */
+    fft(z, 0);
+
+    for (int k = 0; k < NUM_BINS; k++) {
+        delay_estimator_complex_t zk = z[k];
+        delay_estimator_complex_t zn = z[(FFT_LENGTH - k) % FFT_LENGTH];
+        delay_estimator_complex_t m = { 0.5f * (zk.re + zn.re), 0.5f * (zk.im - zn.im) };
+        delay_estimator_complex_t r = { 0.5f * (zk.im + zn.im), -0.5f * (zk.re - zn.re) };
+
+        /* mic * conj(ref) correlates to a peak at the echo delay */
+        s[k].re = alpha * s[k].re + (1.0f - alpha) * (m.re * r.re + m.im * r.im);
+        s[k].im = alpha * s[k].im + (1.0f - alpha) * (m.im * r.re - m.re * r.im);
+
+        float mag = sqrtf(s[k].re * s[k].re + s[k].im * s[k].im);
+        max_mag = (mag > max_mag) ? mag : max_mag;
+    }
+
+    /* DC and Nyquist carry no delay information */
+    float phat_floor = max_mag * PHAT_FLOOR;
+    z[0].re = z[0].im = 0;
+    z[FFT_LENGTH / 2].re = z[FFT_LENGTH / 2].im = 0;
+    for (int k = 1; k < NUM_BINS - 1; k++) {
+        float scale = 1.0f / (sqrtf(s[k].re * s[k].re + s[k].im * s[k].im) + phat_floor);
+        z[k].re = s[k].re * scale;
+        z[k].im = s[k].im * scale;
+        z[FFT_LENGTH - k].re = z[k].re;
+        z[FFT_LENGTH - k].im = -z[k].im;
+    }
+
+    /* The correlation is real, in z[].re */
+    fft(z, 1);
+    return 1;
+}
+
+static void delay_estimator_publish(delay_estimator_t *de, const delay_estimate_t *estimate)
+{
+    de->prev_estimate = *estimate;
+    de->estimate = *estimate;
+    /* Release so a reader that sees the new count also sees the estimate, and
+     * the pushing thread sees the work buffer is free once busy is clear */
+    __atomic_store_n(&de->estimate_count, de->estimate_count + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&de->busy, 0, __ATOMIC_RELEASE);
+}
+
+void delay_estimator_process(delay_estimator_t *de)
+{
+    const delay_estimator_complex_t *c = de->work;
+    delay_estimate_t estimate = {0};
+
+    if (!gcc_phat(de)) {
+        delay_estimator_publish(de, &estimate);
+        return;
+    }
+
+    /* Lags in decimated samples, rounded inwards */
+    int min_lag = de->config.min_lag / DELAY_ESTIMATOR_DECIMATION;
+    int max_lag = de->config.max_lag / DELAY_ESTIMATOR_DECIMATION;
+    int peak_lag = min_lag;
+    float peak = -INFINITY;
+    float sum = 0;
+
+    for (int lag = min_lag; lag <= max_lag; lag++) {
+        float v = c[(lag + FFT_LENGTH) % FFT_LENGTH].re;
+        sum += fabsf(v);
+        if (v > peak) {
+            peak = v;
+            peak_lag = lag;
+        }
+    }
+    float mean = sum / (max_lag - min_lag + 1);
+
+    /* Parabolic interpolation between the neighbours of the peak */
+    float offset = 0;
+    if (peak_lag > min_lag && peak_lag < max_lag) {
+        float before = c[(peak_lag - 1 + FFT_LENGTH) % FFT_LENGTH].re;
+        float after = c[(peak_lag + 1 + FFT_LENGTH) % FFT_LENGTH].re;
+        float denom = before - 2 * peak + after;
+        if (denom < 0) {
+            offset = 0.5f * (before - after) / denom;
+        }
+    }
+
+    estimate.lag = (int32_t)lroundf((peak_lag + offset) * DELAY_ESTIMATOR_DECIMATION);
+    estimate.peak_ratio = (mean > 0) ? peak / mean : 0;
+
+    /* A single confident estimate can be a chance alignment of the reference
+     * with itself, so it must be repeated */
+    int confident = (estimate.peak_ratio >= de->config.peak_ratio_threshold);
+    int32_t lag_change = estimate.lag - de->prev_estimate.lag;
+    if (lag_change < 0) {
+        lag_change = -lag_change;
+    }
+    estimate.valid = confident &&
+                     (de->prev_estimate.peak_ratio >= de->config.peak_ratio_threshold) &&
+                     (lag_change <= CONSISTENT_LAG * DELAY_ESTIMATOR_DECIMATION);
+
+    delay_estimator_publish(de, &estimate);
+}
+
+int delay_estimator_get(delay_estimator_t *de, delay_estimate_t *estimate)
+{
+    uint32_t count = __atomic_load_n(&de->estimate_count, __ATOMIC_ACQUIRE);
+
+    if (count == de->estimate_count_read) {
+        return 0;
+    }
+    *estimate = de->estimate;
+    de->estimate_count_read = count;
+    return 1;
+}
@@ -0,0 +1,132 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef DELAY_ESTIMATOR_H_
+#define DELAY_ESTIMATOR_H_
+
+#include <stdint.h>
+
+/**
+ * \addtogroup delay_estimator delay_estimator
+ *
+ * Estimates the delay of the echo in the mic input relative to the reference
+ * input, for aligning them before the AEC.
+ *
+ * The mic and reference are decimated by DELAY_ESTIMATOR_DECIMATION and the
+ * most recent DELAY_ESTIMATOR_WINDOW decimated samples of each are kept. At
+ * each estimate their cross spectrum is smoothed with those of the previous
+ * estimates and whitened (GCC-PHAT), so that the cross correlation has a
+ * sharp peak at the echo delay whatever the spectrum of the reference. The
+ * peak is interpolated to a fraction of a decimated sample.
+ *
+ * Adding samples is cheap and done on every frame. The estimate itself is an
+ * FFT and inverse FFT of DELAY_ESTIMATOR_FFT_LENGTH points, done once every
+ * interval. The two can run in different threads: delay_estimator_push()
+ * copies the window to be processed into a separate buffer, and does not
+ * touch it again until delay_estimator_process() has finished with it.
+ *
+ * The module is independent of the AEC library and of the OS.
+ * @{
+ */
+
+/* Decimation factor of the mic and reference */
+#define DELAY_ESTIMATOR_DECIMATION  (8)
+
+/* Number of decimated samples correlated, 512 ms at 16 kHz */
+#define DELAY_ESTIMATOR_WINDOW      (1024)
+
+/* Zero padded to twice the window so that the correlation does not wrap */
+#define DELAY_ESTIMATOR_FFT_LENGTH  (2 * DELAY_ESTIMATOR_WINDOW)
+
+typedef struct {
+    float re;
+    float im;
+} delay_estimator_complex_t;
+
+typedef struct {
+    int32_t min_lag;                // Shortest echo delay searched, in input samples. May be negative
+    int32_t max_lag;                // Longest echo delay searched, in input samples
+    int32_t interval_samples;       // Input samples between estimates
+    float peak_ratio_threshold;     // Ratio of the correlation peak to its mean magnitude above which an estimate is confident
+    float smoothing;                // Weight of the previous estimates in the smoothed cross spectrum, 0 to 1
+} delay_estimator_config_t;
+
+typedef struct {
+    int32_t lag;            // Echo delay, in input samples. Positive when the echo follows the reference
+    float peak_ratio;       // Ratio of the correlation peak to its mean magnitude
+    int32_t valid;          // 1 if confident and consistent with the previous estimate
+} delay_estimate_t;
+
+typedef struct {
+    delay_estimator_config_t config;
+
+    // Decimated input, circular
+    float mic_history[DELAY_ESTIMATOR_WINDOW];
+    float ref_history[DELAY_ESTIMATOR_WINDOW];
+    uint32_t history_idx;
+
+    // Decimator
+    int64_t mic_acc;
+    int64_t ref_acc;
+    uint32_t acc_count;
+
+    uint32_t samples_since_estimate;
+    uint32_t active_samples;
+
+    // Window being processed, mic in the real part and reference in the imaginary part
+    delay_estimator_complex_t work[DELAY_ESTIMATOR_FFT_LENGTH];
+    delay_estimator_complex_t cross_spectrum[DELAY_ESTIMATOR_FFT_LENGTH / 2 + 1];
+
+    delay_estimate_t estimate;
+    delay_estimate_t prev_estimate;
+    // Shared with the processing thread, accessed with __atomic builtins
+    uint32_t estimate_count;
+    uint32_t estimate_count_read;
+    int32_t busy;
+} delay_estimator_t;
+
+/**
+ * Initialise a delay estimator.
+ *
+ * \param de      The delay estimator.
+ * \param config  Its configuration. The lag range must be within half the
+ *                window, DELAY_ESTIMATOR_WINDOW * DELAY_ESTIMATOR_DECIMATION / 2
+ *                input samples, either side of 0.
+ */
+void delay_estimator_init(delay_estimator_t *de, const delay_estimator_config_t *config);
+
+/**
+ * Add one channel of mic input and one of reference input.
+ *
+ * \param de          The delay estimator.
+ * \param mic         Mic samples.
+ * \param ref         Reference samples.
+ * \param n           Number of samples of each.
+ * \param ref_active  Non-zero if the reference is active in these samples.
+ *                    Estimates are only made when the reference was active
+ *                    for at least half of the interval.
+ * \returns           1 if an estimate is due, in which case
+ *                    delay_estimator_process() must be called before the next
+ *                    estimate can be started.
+ */
+int delay_estimator_push(delay_estimator_t *de, const int32_t *mic, const int32_t *ref, int n, int ref_active);
+
+/**
+ * Make the estimate started by delay_estimator_push().
+ *
+ * May be called from another thread than delay_estimator_push().
+ */
+void delay_estimator_process(delay_estimator_t *de);
+
+/**
+ * Get the most recent estimate.
+ *
+ * \param de        The delay estimator.
+ * \param estimate  Set to the estimate.
+ * \returns         1 if the estimate was made since the last call, else 0.
+ */
+int delay_estimator_get(delay_estimator_t *de, delay_estimate_t *estimate);
+
+/**@}*/
+
+#endif /* DELAY_ESTIMATOR_H_ */
@@ -6,10 +6,108 @@
 
 #include <stdint.h>
 #include "app_conf.h"
+#include "frame_pool.h"
+#include "pipeline_graph.h"
+#include "frame_trace.h"
 
 #define AUDIO_PIPELINE_DONT_FREE_FRAME 0
 #define AUDIO_PIPELINE_FREE_FRAME      1
 
+/* Number of frames preallocated by the pipeline on each tile. Frames are
+ * taken from this pool by the pipeline input and returned to it after
+ * audio_pipeline_output(), so no heap allocation is made per frame. */
+#ifndef appconfAUDIO_PIPELINE_FRAME_POOL_DEPTH
+#define appconfAUDIO_PIPELINE_FRAME_POOL_DEPTH  8
+#endif
+
+/* Set to 0 when the application does not use the reference or raw microphone
+ * channels passed to audio_pipeline_output(). They are then not sent from
+ * tile 1 to tile 0 and are zero in the output. */
+#ifndef appconfAUDIO_PIPELINE_OUTPUT_REF_ENABLED
+#define appconfAUDIO_PIPELINE_OUTPUT_REF_ENABLED    1
+#endif
+
+#ifndef appconfAUDIO_PIPELINE_OUTPUT_MIC_ENABLED
+#define appconfAUDIO_PIPELINE_OUTPUT_MIC_ENABLED    1
+#endif
+
+/* Set to 1 to send the reference and raw microphone channels from tile 1 to
+ * tile 0 as 16 bit samples. The processed channels are always sent at full
+ * resolution. */
+#ifndef appconfAUDIO_PIPELINE_PASSTHROUGH_INT16
+#define appconfAUDIO_PIPELINE_PASSTHROUGH_INT16     0
+#endif
+
+/* Set to 1 to trace the latency of each frame from its capture by the
+ * pipeline input to the pipeline output, see frame_trace.h. The end to end
+ * latency is recorded in the "latency" profiling probe, the latency on
+ * reaching the output tile in the "lat_hop" probe, and the time tile 1 takes
+ * to send each frame, including any wait for tile 0, in the "lat_tx_wait"
+ * probe. The probes need appconfPROFILE_ENABLED. */
+#ifndef appconfAUDIO_PIPELINE_LATENCY_TRACE
+#define appconfAUDIO_PIPELINE_LATENCY_TRACE         0
+#endif
+
+/* Latency budget in microseconds. With latency tracing, frames over the
+ * budget are counted and logged with the latency at each stage, to find
+ * scheduling stalls. 0 for no budget. */
+#ifndef appconfAUDIO_PIPELINE_LATENCY_BUDGET_US
+#define appconfAUDIO_PIPELINE_LATENCY_BUDGET_US     0
+#endif
+
+#if appconfAUDIO_PIPELINE_LATENCY_TRACE
+#define AUDIO_PIPELINE_TRACE_CAPTURE(frame_data)        frame_trace_capture(&(frame_data)->trace, get_reference_time())
+#define AUDIO_PIPELINE_TRACE_STAGE(frame_data, stage)   frame_trace_stage(&(frame_data)->trace, (stage), get_reference_time())
+#define AUDIO_PIPELINE_TRACE_TX(frame_data)             frame_trace_tx(&(frame_data)->trace, get_reference_time())
+#define AUDIO_PIPELINE_TRACE_TX_DONE(frame_data)        frame_trace_tx_done(&(frame_data)->trace, get_reference_time())
+#define AUDIO_PIPELINE_TRACE_RX(frame_data, rx_start)   frame_trace_rx(&(frame_data)->trace, (rx_start), get_reference_time())
+#define AUDIO_PIPELINE_TRACE_OUTPUT(frame_data)         frame_trace_output(&(frame_data)->trace, get_reference_time(), \
+                                                                           appconfAUDIO_PIPELINE_LATENCY_BUDGET_US * 100)
+#else
+#define AUDIO_PIPELINE_TRACE_CAPTURE(frame_data)
+#define AUDIO_PIPELINE_TRACE_STAGE(frame_data, stage)
+#define AUDIO_PIPELINE_TRACE_TX(frame_data)
+#define AUDIO_PIPELINE_TRACE_TX_DONE(frame_data)
+#define AUDIO_PIPELINE_TRACE_RX(frame_data, rx_start)
+#define AUDIO_PIPELINE_TRACE_OUTPUT(frame_data)
+#endif
+
+/* Set a stage to 1 to bypass it in the default pipeline graph. Its code is
+ * also compiled out, so it cannot be enabled by a graph loaded at runtime. */
+#ifndef appconfAUDIO_PIPELINE_SKIP_STATIC_DELAY
+#define appconfAUDIO_PIPELINE_SKIP_STATIC_DELAY 0
+#endif
+
+#ifndef appconfAUDIO_PIPELINE_SKIP_AEC
+#define appconfAUDIO_PIPELINE_SKIP_AEC          0
+#endif
+
+#ifndef appconfAUDIO_PIPELINE_SKIP_IC_AND_VNR
+#define appconfAUDIO_PIPELINE_SKIP_IC_AND_VNR   0
+#endif
+
+#ifndef appconfAUDIO_PIPELINE_SKIP_NS
+#define appconfAUDIO_PIPELINE_SKIP_NS           0
+#endif
+
+#ifndef appconfAUDIO_PIPELINE_SKIP_AGC
+#define appconfAUDIO_PIPELINE_SKIP_AGC          0
+#endif
+
+/* Set to 1 to load the pipeline graph from appconfAUDIO_PIPELINE_GRAPH_FILE
+ * in the filesystem at startup, if it exists, in place of the default graph
+ * of the pipeline. The file is read on FS_TILE_NO, which must have mounted
+ * the filesystem before audio_pipeline_init(), and is passed to the other
+ * tile on appconfAUDIO_PIPELINE_GRAPH_PORT. See pipeline_graph.h for the
+ * format. */
+#ifndef appconfAUDIO_PIPELINE_GRAPH_FILE_ENABLED
+#define appconfAUDIO_PIPELINE_GRAPH_FILE_ENABLED    0
+#endif
+
+#ifndef appconfAUDIO_PIPELINE_GRAPH_FILE
+#define appconfAUDIO_PIPELINE_GRAPH_FILE            "pipeline_graph.txt"
+#endif
+
 void audio_pipeline_init(
         void *input_app_data,
         void *output_app_data);
@@ -26,4 +124,51 @@ int audio_pipeline_output(
         size_t ch_count,
         size_t frame_count);
 
+/**
+ * Return a frame to the pipeline frame pool.
+ *
+ * This must only be called by an audio_pipeline_output() implementation that
+ * returned AUDIO_PIPELINE_DONT_FREE_FRAME, from the pipeline output task,
+ * once it has finished with the frame.
+ *
+ * \param frame  The output_audio_frames pointer passed to audio_pipeline_output().
+ */
+void audio_pipeline_frame_release(void *frame);
+
+/**
+ * Read the frame pool statistics of the pipeline running on this tile.
+ *
+ * \param stats  Filled with the current statistics.
+ */
+void audio_pipeline_frame_pool_stats_get(frame_pool_stats_t *stats);
+
+/**
+ * Replace the pipeline graph, which is otherwise the default graph of the
+ * pipeline or the graph loaded from appconfAUDIO_PIPELINE_GRAPH_FILE. Must be
+ * called before audio_pipeline_init(), on each tile, and the graph must
+ * remain valid.
+ *
+ * \param graph  The graph, or NULL for the default graph.
+ */
+void audio_pipeline_graph_set(const pipeline_graph_t *graph);
+
+/**
+ * Get the pipeline graph. The first call on each tile loads the graph file
+ * when appconfAUDIO_PIPELINE_GRAPH_FILE_ENABLED is set.
+ */
+const pipeline_graph_t *audio_pipeline_graph_get(void);
+
+/**
+ * Plan the pipeline threads of a tile from the pipeline graph. If the graph
+ * is invalid for either tile, both tiles plan the default graph of the
+ * pipeline.
+ *
+ * \param plan       Filled with the plan.
+ * \param tile       The tile.
+ * \param stage_fns  The stage functions of the tile, see pipeline_graph_plan().
+ */
+void audio_pipeline_graph_plan(pipeline_graph_plan_t *plan,
+                               unsigned tile,
+                               const pipeline_graph_stage_t stage_fns[PIPELINE_STAGE_COUNT]);
+
 #endif /* AUDIO_PIPELINE_H_ */
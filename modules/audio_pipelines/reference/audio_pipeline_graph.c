@@ -0,0 +1,121 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+/* STD headers */
+#include <string.h>
+#include <stdint.h>
+
+/* FreeRTOS headers */
+#include "FreeRTOS.h"
+
+/* App headers */
+#include "app_conf.h"
+#include "audio_pipeline.h"
+#include "audio_pipeline_dsp.h"
+#include "pipeline_graph.h"
+#if appconfAUDIO_PIPELINE_GRAPH_FILE_ENABLED
+#include "platform/driver_instances.h"
+#include "ff.h"
+#endif
+
+#define AUDIO_PIPELINE_GRAPH_TILES  (2)
+
+static const pipeline_graph_t default_graph = AUDIO_PIPELINE_GRAPH_DEFAULT;
+static const pipeline_graph_t *active_graph = NULL;
+
+void audio_pipeline_graph_set(const pipeline_graph_t *graph)
+{
+    active_graph = graph;
+}
+
+#if appconfAUDIO_PIPELINE_GRAPH_FILE_ENABLED
+#ifndef FS_TILE_NO
+#error FS_TILE_NO must be defined to load the pipeline graph from the filesystem
+#endif
+
+/* Load the graph from appconfAUDIO_PIPELINE_GRAPH_FILE on the filesystem tile
+ * and pass it to the other tile. A graph with no entries is passed when the
+ * file is missing or invalid, so that the other tile does not wait for it. */
+static const pipeline_graph_t *audio_pipeline_graph_load(void)
+{
+    static pipeline_graph_t file_graph;
+
+#if ON_TILE(FS_TILE_NO)
+    FIL file;
+    UINT bytes_read = 0;
+    int count = 0;
+    FRESULT result = f_open(&file, appconfAUDIO_PIPELINE_GRAPH_FILE, FA_READ);
+
+    if (result == FR_OK) {
+        size_t size = f_size(&file);
+        char *text = pvPortMalloc(size + 1);
+
+        if (text != NULL && f_read(&file, text, size, &bytes_read) == FR_OK && bytes_read == size) {
+            text[size] = '\0';
+            count = pipeline_graph_parse(text, &file_graph);
+        }
+        vPortFree(text);
+        f_close(&file);
+
+        if (count < 0) {
+            rtos_printf("%s: error on line %d, using the default pipeline graph\n", appconfAUDIO_PIPELINE_GRAPH_FILE, -count);
+        } else {
+            rtos_printf("Loaded %d pipeline stages from %s\n", count, appconfAUDIO_PIPELINE_GRAPH_FILE);
+        }
+    } else {
+        /* FR_NOT_ENABLED if the filesystem was not mounted before
+         * audio_pipeline_init(), FR_NO_FILE if there is no graph file */
+        rtos_printf("%s: not opened (FatFS error %d), using the default pipeline graph\n", appconfAUDIO_PIPELINE_GRAPH_FILE, result);
+    }
+    if (count <= 0) {
+        memset(&file_graph, 0, sizeof(file_graph));
+    }
+    rtos_intertile_tx(intertile_ctx, appconfAUDIO_PIPELINE_GRAPH_PORT, &file_graph, sizeof(file_graph));
+#else
+    size_t len = rtos_intertile_rx_len(intertile_ctx, appconfAUDIO_PIPELINE_GRAPH_PORT, RTOS_OSAL_WAIT_FOREVER);
+    xassert(len == sizeof(file_graph));
+    rtos_intertile_rx_data(intertile_ctx, &file_graph, sizeof(file_graph));
+#endif
+
+    return file_graph.count > 0 ? &file_graph : NULL;
+}
+#endif
+
+const pipeline_graph_t *audio_pipeline_graph_get(void)
+{
+#if appconfAUDIO_PIPELINE_GRAPH_FILE_ENABLED
+    static int file_loaded = 0;
+
+    if (!file_loaded) {
+        const pipeline_graph_t *file_graph = audio_pipeline_graph_load();
+
+        file_loaded = 1;
+        if (file_graph != NULL) {
+            active_graph = file_graph;
+        }
+    }
+#endif
+    return active_graph != NULL ? active_graph : &default_graph;
+}
+
+void audio_pipeline_graph_plan(pipeline_graph_plan_t *plan,
+                               unsigned tile,
+                               const pipeline_graph_stage_t stage_fns[PIPELINE_STAGE_COUNT])
+{
+    /* Each tile implements the stages the default graph places on it */
+    const uint32_t tile_stages[AUDIO_PIPELINE_GRAPH_TILES] = {
+        pipeline_graph_tile_stages(&default_graph, 0),
+        pipeline_graph_tile_stages(&default_graph, 1),
+    };
+    const pipeline_graph_t *graph = audio_pipeline_graph_get();
+
+    /* The graph is checked for both tiles, so that both fall back to the
+     * default graph if it is invalid for either */
+    if (pipeline_graph_check(graph, tile_stages, AUDIO_PIPELINE_GRAPH_TILES) != 0) {
+        rtos_printf("Pipeline graph is invalid, using the default\n");
+        graph = &default_graph;
+    }
+    int ret = pipeline_graph_plan(plan, graph, tile, stage_fns);
+    configASSERT(ret == 0);
+    (void) ret;
+}
@@ -0,0 +1,48 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef AUDIO_PIPELINE_TRANSPORT_H_
+#define AUDIO_PIPELINE_TRANSPORT_H_
+
+#include "app_conf.h"
+#include "audio_pipeline.h"
+#include "audio_pipeline_dsp.h"
+#include "frame_transport.h"
+
+#if appconfAUDIO_PIPELINE_PASSTHROUGH_INT16
+#define FRAME_DATA_PASSTHROUGH_ENCODING     FRAME_TRANSPORT_INT16
+#else
+#define FRAME_DATA_PASSTHROUGH_ENCODING     FRAME_TRANSPORT_RAW
+#endif
+
+/*
+ * The parts of frame_data_t sent from tile 1 to tile 0. These are the
+ * channels read by the tile 0 stages and audio_pipeline_output(), and the
+ * per frame context computed by the tile 1 stages. vnr_pred_flag and the
+ * stage buffers are only used on tile 0 so are never sent.
+ */
+static const frame_transport_field_t frame_data_transport_fields[] = {
+    FRAME_TRANSPORT_FIELD(frame_data_t, samples, FRAME_TRANSPORT_RAW),
+#if appconfAUDIO_PIPELINE_OUTPUT_REF_ENABLED
+    FRAME_TRANSPORT_FIELD(frame_data_t, aec_reference_audio_samples, FRAME_DATA_PASSTHROUGH_ENCODING),
+#endif
+#if appconfAUDIO_PIPELINE_OUTPUT_MIC_ENABLED
+    FRAME_TRANSPORT_FIELD(frame_data_t, mic_samples_passthrough, FRAME_DATA_PASSTHROUGH_ENCODING),
+#endif
+    FRAME_TRANSPORT_FIELD(frame_data_t, max_ref_energy, FRAME_TRANSPORT_RAW),
+    FRAME_TRANSPORT_FIELD(frame_data_t, aec_corr_factor, FRAME_TRANSPORT_RAW),
+    FRAME_TRANSPORT_FIELD(frame_data_t, ref_active_flag, FRAME_TRANSPORT_RAW),
+#if appconfAUDIO_PIPELINE_LATENCY_TRACE
+    FRAME_TRANSPORT_FIELD(frame_data_t, trace, FRAME_TRANSPORT_RAW),
+#endif
+};
+
+static const frame_transport_desc_t frame_data_transport = {
+    frame_data_transport_fields,
+    sizeof(frame_data_transport_fields) / sizeof(frame_data_transport_fields[0]),
+};
+
+/* Upper bound on the size of the message carrying one frame between tiles */
+#define FRAME_DATA_TRANSPORT_MAX_BYTES  ( sizeof(frame_data_t) )
+
+#endif /* AUDIO_PIPELINE_TRANSPORT_H_ */
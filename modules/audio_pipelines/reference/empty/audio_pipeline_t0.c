@@ -21,17 +21,33 @@
 #include "audio_pipeline.h"
 #include "audio_pipeline_dsp.h"
 
-#if appconfAUDIO_PIPELINE_FRAME_ADVANCE != 240
-#error This pipeline is only configured for 240 frame advance
-#endif
-
 #if ON_TILE(0)
+static frame_pool_t frame_pool;
+static uint8_t DWORD_ALIGNED frame_pool_storage[FRAME_POOL_STORAGE_SIZE(sizeof(frame_data_t), appconfAUDIO_PIPELINE_FRAME_POOL_DEPTH)];
+
+void audio_pipeline_frame_release(void *frame)
+{
+    if (frame_pool_owns(&frame_pool, frame)) {
+        frame_pool_release(&frame_pool, frame);
+    } else {
+        vPortFree(frame);
+    }
+}
+
+void audio_pipeline_frame_pool_stats_get(frame_pool_stats_t *stats)
+{
+    frame_pool_stats_get(&frame_pool, stats);
+}
 
 static void *audio_pipeline_input_i(void *input_app_data)
 {
     frame_data_t *frame_data;
 
-    frame_data = pvPortMalloc(sizeof(frame_data_t));
+    frame_data = frame_pool_alloc(&frame_pool);
+    if (frame_data == NULL) {
+        /* Pool exhausted by a downstream stall, fall back to the heap rather than drop input */
+        frame_data = pvPortMalloc(sizeof(frame_data_t));
+    }
     memset(frame_data, 0x00, sizeof(frame_data_t));
 
     size_t bytes_received = 0;
@@ -53,10 +69,14 @@ static void *audio_pipeline_input_i(void *input_app_data)
 static int audio_pipeline_output_i(frame_data_t *frame_data,
                                    void *output_app_data)
 {
-    return audio_pipeline_output(output_app_data,
+    int ret = audio_pipeline_output(output_app_data,
                                (int32_t **)frame_data->samples,
                                6,
                                appconfAUDIO_PIPELINE_FRAME_ADVANCE);
+    if (ret == AUDIO_PIPELINE_FREE_FRAME) {
+        audio_pipeline_frame_release(frame_data);
+    }
+    return AUDIO_PIPELINE_DONT_FREE_FRAME;
 }
 
 void empty_stage(void)
@@ -85,6 +105,11 @@ void audio_pipeline_init(
         configMINIMAL_STACK_SIZE + RTOS_THREAD_STACK_SIZE(empty_stage) + RTOS_THREAD_STACK_SIZE(audio_pipeline_output_i),
     };
 
+    frame_pool_init(&frame_pool,
+                    frame_pool_storage,
+                    sizeof(frame_data_t),
+                    appconfAUDIO_PIPELINE_FRAME_POOL_DEPTH);
+
     initialize_pipeline_stages();
 
     generic_pipeline_init((pipeline_input_t)audio_pipeline_input_i,
@@ -13,8 +13,23 @@
 /* Pipeline config */
 #define AP_MAX_Y_CHANNELS (2)
 #define AP_MAX_X_CHANNELS (2)
+/* Block size of stage 1, STAGE_BLOCK_ADVANCE. The pipeline frame advance,
+ * appconfAUDIO_PIPELINE_FRAME_ADVANCE, is adapted to it by stage_blocks.h. */
 #define AP_FRAME_ADVANCE (240)
 
+/* Default pipeline graph, see pipeline_graph.h. The fixed delay and AEC on
+ * tile 1, then IC/VNR, NS and AGC on tile 0, each stage in its own thread. */
+#define AUDIO_PIPELINE_GRAPH_DEFAULT {                                  \
+    .entries = {                                                        \
+        {PIPELINE_STAGE_DELAY,  1, 0, appconfAUDIO_PIPELINE_SKIP_STATIC_DELAY}, \
+        {PIPELINE_STAGE_AEC,    1, 1, appconfAUDIO_PIPELINE_SKIP_AEC},         \
+        {PIPELINE_STAGE_IC_VNR, 0, 0, appconfAUDIO_PIPELINE_SKIP_IC_AND_VNR},  \
+        {PIPELINE_STAGE_NS,     0, 1, appconfAUDIO_PIPELINE_SKIP_NS},          \
+        {PIPELINE_STAGE_AGC,    0, 2, appconfAUDIO_PIPELINE_SKIP_AGC},         \
+    },                                                                  \
+    .count = 5,                                                         \
+}
+
 /* AEC config */
 #define AEC_MAX_Y_CHANNELS   (AP_MAX_Y_CHANNELS)
 #define AEC_MAX_X_CHANNELS   (AP_MAX_X_CHANNELS)
@@ -33,6 +48,9 @@
 #include "ns_api.h"
 #include "vnr_features_api.h"
 #include "vnr_inference_api.h"
+#if appconfAUDIO_PIPELINE_LATENCY_TRACE
+#include "frame_trace.h"
+#endif
 
 
 /* Note: Changing the order here will effect the channel order for
@@ -48,6 +66,17 @@ typedef struct {
     float_s32_t max_ref_energy;
     float_s32_t aec_corr_factor;
     int32_t ref_active_flag;
+
+    /* Set while the processed channel is held in proc_buf rather than samples[0].
+     * See stage_buffers.h */
+    int32_t proc_buf_active;
+
+    /* Ping-pong buffer for the tile 0 stages */
+    int32_t DWORD_ALIGNED proc_buf[appconfAUDIO_PIPELINE_FRAME_ADVANCE];
+
+#if appconfAUDIO_PIPELINE_LATENCY_TRACE
+    frame_trace_t trace;
+#endif
 } frame_data_t;
 
 typedef struct stage_delay_ctx {
@@ -4,6 +4,7 @@
 /* STD headers */
 #include <string.h>
 #include <stdint.h>
+#include <math.h>
 #include <xcore/hwtimer.h>
 
 /* FreeRTOS headers */
@@ -20,28 +21,71 @@
 #include "app_conf.h"
 #include "audio_pipeline.h"
 #include "audio_pipeline_dsp.h"
-
-#if appconfAUDIO_PIPELINE_FRAME_ADVANCE != 240
-#error This pipeline is only configured for 240 frame advance
-#endif
+#include "audio_pipeline_transport.h"
+#include "aec_process_frame_threads.h"
+#include "aec_idle_gate.h"
+#include "stage_blocks.h"
+#include "profile.h"
 
 #if ON_TILE(1)
+static frame_pool_t frame_pool;
+static uint8_t DWORD_ALIGNED frame_pool_storage[FRAME_POOL_STORAGE_SIZE(sizeof(frame_data_t), appconfAUDIO_PIPELINE_FRAME_POOL_DEPTH)];
+static uint8_t DWORD_ALIGNED frame_transport_buf[FRAME_DATA_TRANSPORT_MAX_BYTES];
+PROFILE_PROBE_DEFINE(delay_probe, "delay");
+PROFILE_PROBE_DEFINE(aec_probe, "aec");
+PROFILE_PROBE_DEFINE(aec_idle_probe, "aec_idle");
+
 #if appconfINPUT_SAMPLES_MIC_DELAY_MS != 0
 static stage_delay_ctx_t DWORD_ALIGNED delay_buf_state = {};
 #endif
 static aec_ctx_t DWORD_ALIGNED aec_state = {};
+#if appconfAEC_IDLE_GATE_ENABLED
+static aec_idle_gate_t aec_idle_gate;
+static float_s32_t aec_idle_hold_threshold;
+static float_s32_t aec_idle_resume_threshold;
+#endif
+#if STAGE_BLOCKS_ADAPTED
+/* The AEC processes blocks of AEC_FRAME_ADVANCE samples, with the mic
+ * channels followed by the reference channels */
+static stage_blocks_t aec_blocks;
+static int32_t DWORD_ALIGNED aec_blocks_input[STAGE_BLOCKS_STORAGE_SIZE(appconfAUDIO_PIPELINE_FRAME_ADVANCE, AEC_MAX_Y_CHANNELS + AEC_MAX_X_CHANNELS)];
+static int32_t DWORD_ALIGNED aec_blocks_output[STAGE_BLOCKS_STORAGE_SIZE(appconfAUDIO_PIPELINE_FRAME_ADVANCE, AEC_MAX_Y_CHANNELS)];
+
+/* Context of the last block, for the frames that complete no block */
+static float_s32_t aec_max_ref_energy;
+static float_s32_t aec_corr_factor;
+#endif
+
 
+void audio_pipeline_frame_release(void *frame)
+{
+    if (frame_pool_owns(&frame_pool, frame)) {
+        frame_pool_release(&frame_pool, frame);
+    } else {
+        vPortFree(frame);
+    }
+}
+
+void audio_pipeline_frame_pool_stats_get(frame_pool_stats_t *stats)
+{
+    frame_pool_stats_get(&frame_pool, stats);
+}
 
 static void *audio_pipeline_input_i(void *input_app_data)
 {
     frame_data_t *frame_data;
-    frame_data = pvPortMalloc(sizeof(frame_data_t));
+    frame_data = frame_pool_alloc(&frame_pool);
+    if (frame_data == NULL) {
+        /* Pool exhausted by a downstream stall, fall back to the heap rather than drop input */
+        frame_data = pvPortMalloc(sizeof(frame_data_t));
+    }
     memset(frame_data, 0x00, sizeof(frame_data_t));
 
     audio_pipeline_input(input_app_data,
                        (int32_t **)frame_data->aec_reference_audio_samples,
                        4,
                        appconfAUDIO_PIPELINE_FRAME_ADVANCE);
+    AUDIO_PIPELINE_TRACE_CAPTURE(frame_data);
 
     frame_data->vnr_pred_flag = 0;
 
@@ -54,18 +98,25 @@ static int audio_pipeline_output_i(frame_data_t *frame_data,
                                    void *output_app_data)
 {
 
+    AUDIO_PIPELINE_TRACE_TX(frame_data);
+    size_t len = frame_transport_pack(&frame_data_transport, frame_transport_buf, frame_data);
+
     rtos_intertile_tx(intertile_ctx,
                       appconfAUDIOPIPELINE_PORT,
-                      frame_data,
-                      sizeof(frame_data_t));
+                      frame_transport_buf,
+                      len);
+    AUDIO_PIPELINE_TRACE_TX_DONE(frame_data);
 
-    return AUDIO_PIPELINE_FREE_FRAME;
+    audio_pipeline_frame_release(frame_data);
+    return AUDIO_PIPELINE_DONT_FREE_FRAME;
 }
 
+PIPELINE_GRAPH_STAGE_FPTRGROUP
 static void stage_delay(frame_data_t *frame_data)
 {
 #if appconfAUDIO_PIPELINE_SKIP_STATIC_DELAY
 #else
+    PROFILE_START(delay_probe);
 #if (appconfINPUT_SAMPLES_MIC_DELAY_MS > 0) /* Delay mics */
     size_t bytes_sent = xStreamBufferSend(
                                 delay_buf_state.delay_buf,
@@ -104,29 +155,101 @@ static void stage_delay(frame_data_t *frame_data)
     }
 #else /* Delay None */
 #endif
+    PROFILE_END(delay_probe);
 #endif /* appconfAUDIO_PIPELINE_SKIP_DELAY */
+    AUDIO_PIPELINE_TRACE_STAGE(frame_data, PIPELINE_STAGE_DELAY);
 }
 
+#if !appconfAUDIO_PIPELINE_SKIP_AEC
+/* Process one block of AEC_FRAME_ADVANCE samples and compute the context used
+ * by the tile 0 stages */
+static void aec_process_block(int32_t (*output)[AEC_FRAME_ADVANCE],
+                              float_s32_t *max_ref_energy,
+                              float_s32_t *corr_factor,
+                              int32_t (*y_data)[AEC_FRAME_ADVANCE],
+                              int32_t (*x_data)[AEC_FRAME_ADVANCE])
+{
+    int aec_run = 1;
+
+#if appconfAEC_IDLE_GATE_ENABLED
+    aec_run = aec_idle_gate_frame(&aec_idle_gate,
+                                  aec_idle_hold_threshold,
+                                  aec_idle_resume_threshold,
+                                  &aec_state.aec_main_state,
+                                  x_data,
+                                  0);
+#endif
+
+    if (aec_run) {
+        PROFILE_START(aec_probe);
+#if (appconfAUDIO_PIPELINE_AEC_THREADS > 1)
+        aec_process_frame_threads(
+#else
+        aec_process_frame_1thread(
+#endif
+                &aec_state.aec_main_state,
+                &aec_state.aec_shadow_state,
+                output,
+                NULL,
+                y_data,
+                x_data);
+        PROFILE_END(aec_probe);
+    } else {
+        /* The reference is quiet, pass the mic input through and leave the
+         * filters as they are */
+        PROFILE_START(aec_idle_probe);
+        aec_process_frame_idle(&aec_state.aec_main_state,
+                               &aec_state.aec_shadow_state,
+                               output,
+                               y_data,
+                               x_data);
+        PROFILE_END(aec_idle_probe);
+    }
+
+    *max_ref_energy = aec_calc_max_input_energy(
+                            x_data,
+                            aec_state.aec_main_state.shared_state->num_x_channels);
+    /* The filters were not run, so there is no echo estimate to correlate
+     * with */
+    *corr_factor = aec_run ? aec_calc_corr_factor(&aec_state.aec_main_state, 0) : (float_s32_t){0, 0};
+}
+#endif
+
+PIPELINE_GRAPH_STAGE_FPTRGROUP
 static void stage_aec(frame_data_t *frame_data)
 {
 #if appconfAUDIO_PIPELINE_SKIP_AEC
+#elif STAGE_BLOCKS_ADAPTED
+    for (int ch = 0; ch < AEC_MAX_Y_CHANNELS; ch++) {
+        stage_blocks_write(&aec_blocks, ch, frame_data->samples[ch]);
+    }
+    for (int ch = 0; ch < AEC_MAX_X_CHANNELS; ch++) {
+        stage_blocks_write(&aec_blocks, AEC_MAX_Y_CHANNELS + ch, frame_data->aec_reference_audio_samples[ch]);
+    }
+    uint32_t blocks = stage_blocks_advance(&aec_blocks);
+    for (uint32_t b = 0; b < blocks; b++) {
+        aec_process_block((int32_t (*)[AEC_FRAME_ADVANCE])stage_blocks_output(&aec_blocks, b, 0),
+                          &aec_max_ref_energy,
+                          &aec_corr_factor,
+                          (int32_t (*)[AEC_FRAME_ADVANCE])stage_blocks_input(&aec_blocks, b, 0),
+                          (int32_t (*)[AEC_FRAME_ADVANCE])stage_blocks_input(&aec_blocks, b, AEC_MAX_Y_CHANNELS));
+    }
+    for (int ch = 0; ch < AEC_MAX_Y_CHANNELS; ch++) {
+        stage_blocks_read(&aec_blocks, ch, frame_data->samples[ch]);
+    }
+    frame_data->max_ref_energy = aec_max_ref_energy;
+    frame_data->aec_corr_factor = aec_corr_factor;
 #else
     int32_t DWORD_ALIGNED stage1_output[AEC_MAX_Y_CHANNELS][appconfAUDIO_PIPELINE_FRAME_ADVANCE];
 
-    aec_process_frame_1thread(
-            &aec_state.aec_main_state,
-            &aec_state.aec_shadow_state,
-            stage1_output,
-            NULL,
-            frame_data->samples,
-            frame_data->aec_reference_audio_samples);
-
-    frame_data->max_ref_energy = aec_calc_max_input_energy(
-                                    frame_data->aec_reference_audio_samples,
-                                    aec_state.aec_main_state.shared_state->num_x_channels);
-    frame_data->aec_corr_factor = aec_calc_corr_factor(&aec_state.aec_main_state, 0);
+    aec_process_block(stage1_output,
+                      &frame_data->max_ref_energy,
+                      &frame_data->aec_corr_factor,
+                      frame_data->samples,
+                      frame_data->aec_reference_audio_samples);
     memcpy(frame_data->samples, stage1_output, AEC_MAX_Y_CHANNELS * appconfAUDIO_PIPELINE_FRAME_ADVANCE * sizeof(int32_t));
 #endif
+    AUDIO_PIPELINE_TRACE_STAGE(frame_data, PIPELINE_STAGE_AEC);
 }
 
 static void initialize_pipeline_stages(void)
@@ -146,25 +269,75 @@ static void initialize_pipeline_stages(void)
              AEC_MAX_X_CHANNELS,
              AEC_MAIN_FILTER_PHASES,
              AEC_SHADOW_FILTER_PHASES);
+
+    aec_process_frame_threads_init(appconfAUDIO_PIPELINE_AEC_THREADS, appconfAUDIO_PIPELINE_TASK_PRIORITY);
+
+#if STAGE_BLOCKS_ADAPTED
+    stage_blocks_init(&aec_blocks,
+                      appconfAUDIO_PIPELINE_FRAME_ADVANCE,
+                      aec_blocks_input,
+                      AEC_MAX_Y_CHANNELS + AEC_MAX_X_CHANNELS,
+                      aec_blocks_output,
+                      AEC_MAX_Y_CHANNELS);
+#endif
+
+#if appconfAEC_IDLE_GATE_ENABLED
+    /* Keep the AEC running for at least the echo tail modelled by the main
+     * filter after the reference stops */
+    uint32_t idle_hold_frames = (16 * appconfAEC_IDLE_GATE_HOLD_MS) / AEC_FRAME_ADVANCE;
+    if (idle_hold_frames < AEC_MAIN_FILTER_PHASES) {
+        idle_hold_frames = AEC_MAIN_FILTER_PHASES;
+    }
+    aec_idle_gate_init(&aec_idle_gate, idle_hold_frames);
+    aec_idle_hold_threshold = f64_to_float_s32(pow(10, appconfAEC_IDLE_GATE_HOLD_dB / 20.0));
+    aec_idle_resume_threshold = f64_to_float_s32(pow(10, appconfAEC_IDLE_GATE_RESUME_dB / 20.0));
+#endif
 }
 
+PIPELINE_GRAPH_PLAN_DEFINE(graph_plan)
+
 void audio_pipeline_init(
     void *input_app_data,
     void *output_app_data)
 {
-    const int stage_count = 2;
-    const pipeline_stage_t stages[] = {
-        (pipeline_stage_t)stage_delay,
-        (pipeline_stage_t)stage_aec,
+    const pipeline_graph_stage_t stage_fns[PIPELINE_STAGE_COUNT] = {
+        [PIPELINE_STAGE_DELAY] = (pipeline_graph_stage_t)stage_delay,
+        [PIPELINE_STAGE_AEC] = (pipeline_graph_stage_t)stage_aec,
     };
 
-    const configSTACK_DEPTH_TYPE stage_stack_sizes[] = {
-        configMINIMAL_STACK_SIZE + RTOS_THREAD_STACK_SIZE(stage_delay) + RTOS_THREAD_STACK_SIZE(audio_pipeline_input_i),
-        configMINIMAL_STACK_SIZE + RTOS_THREAD_STACK_SIZE(stage_aec) + RTOS_THREAD_STACK_SIZE(audio_pipeline_output_i),
+    /* The threads run the stages the pipeline graph places in them */
+    const pipeline_stage_t stages[PIPELINE_GRAPH_MAX_THREADS] = {
+        (pipeline_stage_t)graph_plan_thread_0,
+        (pipeline_stage_t)graph_plan_thread_1,
+        (pipeline_stage_t)graph_plan_thread_2,
+        (pipeline_stage_t)graph_plan_thread_3,
     };
 
+    configSTACK_DEPTH_TYPE stage_stack_sizes[PIPELINE_GRAPH_MAX_THREADS] = {
+        configMINIMAL_STACK_SIZE + RTOS_THREAD_STACK_SIZE(graph_plan_thread_0),
+        configMINIMAL_STACK_SIZE + RTOS_THREAD_STACK_SIZE(graph_plan_thread_1),
+        configMINIMAL_STACK_SIZE + RTOS_THREAD_STACK_SIZE(graph_plan_thread_2),
+        configMINIMAL_STACK_SIZE + RTOS_THREAD_STACK_SIZE(graph_plan_thread_3),
+    };
+
+    frame_pool_init(&frame_pool,
+                    frame_pool_storage,
+                    sizeof(frame_data_t),
+                    appconfAUDIO_PIPELINE_FRAME_POOL_DEPTH);
+
     initialize_pipeline_stages();
 
+    audio_pipeline_graph_plan(&graph_plan, THIS_XCORE_TILE, stage_fns);
+
+    /* The input runs in the first thread and the output in the last. A tile
+     * that runs no stage has one thread, that only runs the input and output. */
+    const int thread_count = graph_plan.thread_count > 0 ? graph_plan.thread_count : 1;
+    if (graph_plan.thread_count == 0) {
+        stage_stack_sizes[0] = configMINIMAL_STACK_SIZE;
+    }
+    stage_stack_sizes[0] += RTOS_THREAD_STACK_SIZE(audio_pipeline_input_i);
+    stage_stack_sizes[thread_count - 1] += RTOS_THREAD_STACK_SIZE(audio_pipeline_output_i);
+
     generic_pipeline_init((pipeline_input_t)audio_pipeline_input_i,
                         (pipeline_output_t)audio_pipeline_output_i,
                         input_app_data,
@@ -172,7 +345,7 @@ void audio_pipeline_init(
                         stages,
                         (const size_t*) stage_stack_sizes,
                         appconfAUDIO_PIPELINE_TASK_PRIORITY,
-                        stage_count);
-
+                        thread_count);
 }
+
 #endif /* ON_TILE(1) */
@@ -23,6 +23,9 @@
 /* App headers */
 #include "app_conf.h"
 #include "audio_pipeline.h"
+#include "stage_buffers.h"
+#include "stage_blocks.h"
+#include "profile.h"
 
 #define VNR_AGC_THRESHOLD              (0.5)
 #define EMA_ENERGY_ALPHA               (0.25)
@@ -37,11 +40,12 @@ typedef struct {
     float_s32_t input_vnr_pred;
     float_s32_t output_vnr_pred;
     control_flag_e control_flag;
-} frame_data_t;
 
-#if appconfAUDIO_PIPELINE_FRAME_ADVANCE != 240
-#error This pipeline is only configured for 240 frame advance
-#endif
+    /* Set while the processed channel is held in proc_buf rather than samples[0].
+     * See stage_buffers.h */
+    int32_t proc_buf_active;
+    int32_t DWORD_ALIGNED proc_buf[appconfAUDIO_PIPELINE_FRAME_ADVANCE];
+} frame_data_t;
 
 typedef struct ic_stage_ctx {
     ic_state_t state;
@@ -71,13 +75,57 @@ static ns_stage_ctx_t DWORD_ALIGNED ns_stage_state = {};
 static agc_stage_ctx_t DWORD_ALIGNED agc_stage_state = {};
 #endif
 
+PROFILE_PROBE_DEFINE(ic_probe, "ic_vnr");
+PROFILE_PROBE_DEFINE(ns_probe, "ns");
+PROFILE_PROBE_DEFINE(agc_probe, "agc");
+
+#if STAGE_BLOCKS_ADAPTED
+/* The stages process blocks of STAGE_BLOCK_ADVANCE samples */
+#if !appconfAUDIO_PIPELINE_SKIP_IC_AND_VNR
+static stage_blocks_t ic_blocks;
+static int32_t DWORD_ALIGNED ic_blocks_input[STAGE_BLOCKS_STORAGE_SIZE(appconfAUDIO_PIPELINE_FRAME_ADVANCE, 2)];
+static int32_t DWORD_ALIGNED ic_blocks_output[STAGE_BLOCKS_STORAGE_SIZE(appconfAUDIO_PIPELINE_FRAME_ADVANCE, 1)];
+#endif
+#if !appconfAUDIO_PIPELINE_SKIP_NS
+static stage_blocks_t ns_blocks;
+static int32_t DWORD_ALIGNED ns_blocks_input[STAGE_BLOCKS_STORAGE_SIZE(appconfAUDIO_PIPELINE_FRAME_ADVANCE, 1)];
+static int32_t DWORD_ALIGNED ns_blocks_output[STAGE_BLOCKS_STORAGE_SIZE(appconfAUDIO_PIPELINE_FRAME_ADVANCE, 1)];
+#endif
+#if !appconfAUDIO_PIPELINE_SKIP_AGC
+static stage_blocks_t agc_blocks;
+static int32_t DWORD_ALIGNED agc_blocks_input[STAGE_BLOCKS_STORAGE_SIZE(appconfAUDIO_PIPELINE_FRAME_ADVANCE, 1)];
+static int32_t DWORD_ALIGNED agc_blocks_output[STAGE_BLOCKS_STORAGE_SIZE(appconfAUDIO_PIPELINE_FRAME_ADVANCE, 1)];
+#endif
+#endif
+
 static trace_data_t* trace_data = 0;
 
+static frame_pool_t frame_pool;
+static uint8_t DWORD_ALIGNED frame_pool_storage[FRAME_POOL_STORAGE_SIZE(sizeof(frame_data_t), appconfAUDIO_PIPELINE_FRAME_POOL_DEPTH)];
+
+void audio_pipeline_frame_release(void *frame)
+{
+    if (frame_pool_owns(&frame_pool, frame)) {
+        frame_pool_release(&frame_pool, frame);
+    } else {
+        vPortFree(frame);
+    }
+}
+
+void audio_pipeline_frame_pool_stats_get(frame_pool_stats_t *stats)
+{
+    frame_pool_stats_get(&frame_pool, stats);
+}
+
 static void *audio_pipeline_input_i(void *input_app_data)
 {
     frame_data_t *frame_data;
 
-    frame_data = pvPortMalloc(sizeof(frame_data_t));
+    frame_data = frame_pool_alloc(&frame_pool);
+    if (frame_data == NULL) {
+        /* Pool exhausted by a downstream stall, fall back to the heap rather than drop input */
+        frame_data = pvPortMalloc(sizeof(frame_data_t));
+    }
     memset(frame_data, 0x00, sizeof(frame_data_t));
 
     audio_pipeline_input(input_app_data,
@@ -100,10 +148,16 @@ static int audio_pipeline_output_i(frame_data_t *frame_data,
         trace_data->control_flag = (int)frame_data->control_flag;
     }
 
-    return audio_pipeline_output(output_app_data,
+    FRAME_STAGE_SETTLE(frame_data);
+
+    int ret = audio_pipeline_output(output_app_data,
                                (int32_t **)frame_data->samples,
                                4,
                                appconfAUDIO_PIPELINE_FRAME_ADVANCE);
+    if (ret == AUDIO_PIPELINE_FREE_FRAME) {
+        audio_pipeline_frame_release(frame_data);
+    }
+    return AUDIO_PIPELINE_DONT_FREE_FRAME;
 }
 
 static void stage_vnr_and_ic(frame_data_t *frame_data)
@@ -112,12 +166,32 @@ static void stage_vnr_and_ic(frame_data_t *frame_data)
     (void) frame_data;
 #else
 
-    int32_t DWORD_ALIGNED ic_output[appconfAUDIO_PIPELINE_FRAME_ADVANCE];
+    PROFILE_START(ic_probe);
+#if STAGE_BLOCKS_ADAPTED
+    vnr_pred_state_t *vnr_pred_state = &vnr_pred_stage_state.vnr_pred_state;
+
+    stage_blocks_write(&ic_blocks, 0, FRAME_STAGE_INPUT(frame_data));
+    stage_blocks_write(&ic_blocks, 1, frame_data->samples[1]);
+    uint32_t blocks = stage_blocks_advance(&ic_blocks);
+    for (uint32_t b = 0; b < blocks; b++) {
+        ic_filter(&ic_stage_state.state,
+                  stage_blocks_input(&ic_blocks, b, 0),
+                  stage_blocks_input(&ic_blocks, b, 1),
+                  stage_blocks_output(&ic_blocks, b, 0));
+        ic_calc_vnr_pred(&ic_stage_state.state, &vnr_pred_state->input_vnr_pred, &vnr_pred_state->output_vnr_pred);
+        ic_adapt(&ic_stage_state.state, vnr_pred_state->input_vnr_pred);
+    }
+    stage_blocks_read(&ic_blocks, 0, FRAME_STAGE_INPUT(frame_data));
 
+    /* Frames that complete no block keep the predictions of the last block */
+    frame_data->input_vnr_pred = vnr_pred_state->input_vnr_pred;
+    frame_data->output_vnr_pred = vnr_pred_state->output_vnr_pred;
+    frame_data->control_flag = ic_stage_state.state.ic_adaption_controller_state.control_flag;
+#else
     ic_filter(&ic_stage_state.state,
-              frame_data->samples[0],
+              FRAME_STAGE_INPUT(frame_data),
               frame_data->samples[1],
-              ic_output);
+              FRAME_STAGE_OUTPUT(frame_data));
 
     // VNR
     vnr_pred_state_t *vnr_pred_state = &vnr_pred_stage_state.vnr_pred_state;
@@ -129,7 +203,9 @@ static void stage_vnr_and_ic(frame_data_t *frame_data)
     frame_data->output_vnr_pred = vnr_pred_stage_state.vnr_pred_state.output_vnr_pred;
     frame_data->control_flag = ic_stage_state.state.ic_adaption_controller_state.control_flag;
 
-    memcpy(frame_data->samples, ic_output, appconfAUDIO_PIPELINE_FRAME_ADVANCE * sizeof(int32_t));
+    FRAME_STAGE_SWAP(frame_data);
+#endif /* STAGE_BLOCKS_ADAPTED */
+    PROFILE_END(ic_probe);
 #endif
 }
 
@@ -138,13 +214,26 @@ static void stage_ns(frame_data_t *frame_data)
 #if appconfAUDIO_PIPELINE_SKIP_NS
     (void) frame_data;
 #else
-    int32_t DWORD_ALIGNED ns_output[appconfAUDIO_PIPELINE_FRAME_ADVANCE];
-    configASSERT(NS_FRAME_ADVANCE == appconfAUDIO_PIPELINE_FRAME_ADVANCE);
+    PROFILE_START(ns_probe);
+    configASSERT(NS_FRAME_ADVANCE == STAGE_BLOCK_ADVANCE);
+#if STAGE_BLOCKS_ADAPTED
+    stage_blocks_write(&ns_blocks, 0, FRAME_STAGE_INPUT(frame_data));
+    uint32_t blocks = stage_blocks_advance(&ns_blocks);
+    for (uint32_t b = 0; b < blocks; b++) {
+        ns_process_frame(
+                    &ns_stage_state.state,
+                    stage_blocks_output(&ns_blocks, b, 0),
+                    stage_blocks_input(&ns_blocks, b, 0));
+    }
+    stage_blocks_read(&ns_blocks, 0, FRAME_STAGE_INPUT(frame_data));
+#else
     ns_process_frame(
                 &ns_stage_state.state,
-                ns_output,
-                frame_data->samples[0]);
-    memcpy(frame_data->samples, ns_output, appconfAUDIO_PIPELINE_FRAME_ADVANCE * sizeof(int32_t));
+                FRAME_STAGE_OUTPUT(frame_data),
+                FRAME_STAGE_INPUT(frame_data));
+    FRAME_STAGE_SWAP(frame_data);
+#endif
+    PROFILE_END(ns_probe);
 #endif
 }
 
@@ -153,23 +242,40 @@ static void stage_agc(frame_data_t *frame_data)
 #if appconfAUDIO_PIPELINE_SKIP_AGC
     (void) frame_data;
 #else
-    int32_t DWORD_ALIGNED agc_output[appconfAUDIO_PIPELINE_FRAME_ADVANCE];
-    configASSERT(AGC_FRAME_ADVANCE == appconfAUDIO_PIPELINE_FRAME_ADVANCE);
+    PROFILE_START(agc_probe);
+    configASSERT(AGC_FRAME_ADVANCE == STAGE_BLOCK_ADVANCE);
 
     agc_stage_state.md.vnr_flag = float_s32_gt(frame_data->output_vnr_pred, f32_to_float_s32(VNR_AGC_THRESHOLD));
 
+#if STAGE_BLOCKS_ADAPTED
+    stage_blocks_write(&agc_blocks, 0, FRAME_STAGE_INPUT(frame_data));
+    uint32_t blocks = stage_blocks_advance(&agc_blocks);
+    for (uint32_t b = 0; b < blocks; b++) {
+        agc_process_frame(
+                &agc_stage_state.state,
+                stage_blocks_output(&agc_blocks, b, 0),
+                stage_blocks_input(&agc_blocks, b, 0),
+                &agc_stage_state.md);
+    }
+    stage_blocks_read(&agc_blocks, 0, FRAME_STAGE_INPUT(frame_data));
+#else
+    /* AGC supports in-place processing, so the processed channel stays where it is */
     agc_process_frame(
             &agc_stage_state.state,
-            agc_output,
-            frame_data->samples[0],
+            FRAME_STAGE_INPUT(frame_data),
+            FRAME_STAGE_INPUT(frame_data),
             &agc_stage_state.md);
-    memcpy(frame_data->samples, agc_output, appconfAUDIO_PIPELINE_FRAME_ADVANCE * sizeof(int32_t));
+#endif
+    PROFILE_END(agc_probe);
 #endif
 }
 
 static void initialize_pipeline_stages(void) {
 #if !appconfAUDIO_PIPELINE_SKIP_IC_AND_VNR
     ic_init(&ic_stage_state.state);
+#if STAGE_BLOCKS_ADAPTED
+    stage_blocks_init(&ic_blocks, appconfAUDIO_PIPELINE_FRAME_ADVANCE, ic_blocks_input, 2, ic_blocks_output, 1);
+#endif
 
     // Set some VNR parameters
     ic_stage_state.state.ic_adaption_controller_state.adaption_controller_config.input_vnr_threshold =
@@ -179,11 +285,17 @@ static void initialize_pipeline_stages(void) {
 #endif
 #if !appconfAUDIO_PIPELINE_SKIP_NS
     ns_init(&ns_stage_state.state);
+#if STAGE_BLOCKS_ADAPTED
+    stage_blocks_init(&ns_blocks, appconfAUDIO_PIPELINE_FRAME_ADVANCE, ns_blocks_input, 1, ns_blocks_output, 1);
+#endif
 #endif
 #if !appconfAUDIO_PIPELINE_SKIP_AGC
     agc_init(&agc_stage_state.state, &AGC_PROFILE_ASR);
     agc_stage_state.md.aec_ref_power = AGC_META_DATA_NO_AEC;
     agc_stage_state.md.aec_corr_factor = AGC_META_DATA_NO_AEC;
+#if STAGE_BLOCKS_ADAPTED
+    stage_blocks_init(&agc_blocks, appconfAUDIO_PIPELINE_FRAME_ADVANCE, agc_blocks_input, 1, agc_blocks_output, 1);
+#endif
 #endif
 }
 
@@ -205,6 +317,11 @@ void audio_pipeline_init(
         configMINIMAL_STACK_SIZE + RTOS_THREAD_STACK_SIZE(stage_agc) + RTOS_THREAD_STACK_SIZE(audio_pipeline_output_i),
     };
 
+    frame_pool_init(&frame_pool,
+                    frame_pool_storage,
+                    sizeof(frame_data_t),
+                    appconfAUDIO_PIPELINE_FRAME_POOL_DEPTH);
+
     initialize_pipeline_stages();
 
     trace_data = (trace_data_t *) output_app_data;
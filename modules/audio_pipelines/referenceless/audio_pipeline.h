@@ -6,10 +6,18 @@
 
 #include <stdint.h>
 #include "app_conf.h"
+#include "frame_pool.h"
 
 #define AUDIO_PIPELINE_DONT_FREE_FRAME 0
 #define AUDIO_PIPELINE_FREE_FRAME      1
 
+/* Number of frames preallocated by the pipeline on each tile. Frames are
+ * taken from this pool by the pipeline input and returned to it after
+ * audio_pipeline_output(), so no heap allocation is made per frame. */
+#ifndef appconfAUDIO_PIPELINE_FRAME_POOL_DEPTH
+#define appconfAUDIO_PIPELINE_FRAME_POOL_DEPTH  8
+#endif
+
 typedef struct {
     float input_vnr_pred;
     int control_flag;
@@ -31,4 +39,22 @@ int audio_pipeline_output(
         size_t ch_count,
         size_t frame_count);
 
+/**
+ * Return a frame to the pipeline frame pool.
+ *
+ * This must only be called by an audio_pipeline_output() implementation that
+ * returned AUDIO_PIPELINE_DONT_FREE_FRAME, from the pipeline output task,
+ * once it has finished with the frame.
+ *
+ * \param frame  The output_audio_frames pointer passed to audio_pipeline_output().
+ */
+void audio_pipeline_frame_release(void *frame);
+
+/**
+ * Read the frame pool statistics of the pipeline running on this tile.
+ *
+ * \param stats  Filled with the current statistics.
+ */
+void audio_pipeline_frame_pool_stats_get(frame_pool_stats_t *stats);
+
 #endif /* AUDIO_PIPELINE_H_ */
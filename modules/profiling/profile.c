@@ -0,0 +1,188 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <stdint.h>
+#include <string.h>
+
+#include "profile.h"
+
+/* Bare metal applications and host builds print with printf */
+#if __has_include("rtos_printf.h")
+#include "rtos_printf.h"
+#define profile_printf  rtos_printf
+#else
+#include <stdio.h>
+#define profile_printf  printf
+#endif
+
+#define RING_MASK       (appconfPROFILE_RING_SIZE - 1)
+
+/* Number of ring entries above the 99th percentile, plus one */
+#define P99_RANK_MAX    (appconfPROFILE_RING_SIZE / 100 + 1)
+
+#if (appconfPROFILE_RING_SIZE & RING_MASK) != 0
+#error appconfPROFILE_RING_SIZE must be a power of 2
+#endif
+
+static profile_probe_t *probes[appconfPROFILE_MAX_PROBES];
+static uint32_t probe_count;
+
+static void probe_clear(profile_probe_t *probe)
+{
+    probe->count = 0;
+    probe->min_ticks = UINT32_MAX;
+    probe->max_ticks = 0;
+    probe->total_ticks = 0;
+}
+
+static void probe_register(profile_probe_t *probe)
+{
+    /* A probe may be recorded from more than one task over its lifetime, so
+     * only the first to claim it registers it */
+    if (__atomic_exchange_n(&probe->registered, 1, __ATOMIC_ACQ_REL)) {
+        return;
+    }
+    probe_clear(probe);
+    probe->ring_pos = 0;
+    memset(probe->ring, 0, sizeof(probe->ring));
+
+    uint32_t index = __atomic_fetch_add(&probe_count, 1, __ATOMIC_ACQ_REL);
+    if (index < appconfPROFILE_MAX_PROBES) {
+        __atomic_store_n(&probes[index], probe, __ATOMIC_RELEASE);
+    } else {
+        __atomic_store_n(&probe_count, appconfPROFILE_MAX_PROBES, __ATOMIC_RELEASE);
+        profile_printf("profile: no room for probe %s\n", probe->name);
+    }
+}
+
+/* The time below which 99% of the recent records fall */
+static uint32_t probe_p99(const profile_probe_t *probe)
+{
+    uint32_t window = probe->ring_pos < appconfPROFILE_RING_SIZE ? probe->ring_pos : appconfPROFILE_RING_SIZE;
+    uint32_t rank = window / 100 + 1;
+    uint32_t top[P99_RANK_MAX];
+    uint32_t top_count = 0;
+
+    if (window == 0) {
+        return 0;
+    }
+
+    /* Keep the largest rank times in descending order, the last of which is the percentile */
+    for (uint32_t i = 0; i < window; i++) {
+        uint32_t t = probe->ring[i];
+        uint32_t j;
+
+        if (top_count < rank) {
+            j = top_count++;
+        } else if (t > top[rank - 1]) {
+            j = rank - 1;
+        } else {
+            continue;
+        }
+        while (j > 0 && top[j - 1] < t) {
+            top[j] = top[j - 1];
+            j--;
+        }
+        top[j] = t;
+    }
+    return top[top_count - 1];
+}
+
+static void probe_stats(const profile_probe_t *probe, profile_stats_t *stats)
+{
+    stats->name = probe->name;
+    stats->count = probe->count;
+    stats->min_ticks = probe->count ? probe->min_ticks : 0;
+    stats->avg_ticks = probe->count ? (uint32_t)(probe->total_ticks / probe->count) : 0;
+    stats->max_ticks = probe->max_ticks;
+    stats->p99_ticks = probe_p99(probe);
+}
+
+static void stats_print(const profile_stats_t *stats)
+{
+    profile_printf("profile: %s count=%u min=%u avg=%u max=%u p99=%u ticks\n",
+                   stats->name,
+                   (unsigned)stats->count,
+                   (unsigned)stats->min_ticks,
+                   (unsigned)stats->avg_ticks,
+                   (unsigned)stats->max_ticks,
+                   (unsigned)stats->p99_ticks);
+}
+
+void profile_probe_record(profile_probe_t *probe, uint32_t ticks)
+{
+    if (!probe->registered) {
+        probe_register(probe);
+    }
+
+    probe->ring[probe->ring_pos & RING_MASK] = ticks;
+    probe->ring_pos++;
+    /* Keep the position from wrapping back into the partly filled range */
+    if (probe->ring_pos == 2 * appconfPROFILE_RING_SIZE) {
+        probe->ring_pos = appconfPROFILE_RING_SIZE;
+    }
+
+    probe->total_ticks += ticks;
+    if (ticks < probe->min_ticks) {
+        probe->min_ticks = ticks;
+    }
+    if (ticks > probe->max_ticks) {
+        probe->max_ticks = ticks;
+    }
+    probe->count++;
+
+#if appconfPROFILE_REPORT_INTERVAL > 0
+    if (probe->count == appconfPROFILE_REPORT_INTERVAL) {
+        profile_stats_t stats;
+
+        probe_stats(probe, &stats);
+        stats_print(&stats);
+        probe_clear(probe);
+    }
+#endif
+}
+
+unsigned profile_probe_count(void)
+{
+    return __atomic_load_n(&probe_count, __ATOMIC_ACQUIRE);
+}
+
+int profile_stats_get(unsigned index, profile_stats_t *stats)
+{
+    profile_probe_t *probe = NULL;
+
+    if (index < profile_probe_count()) {
+        probe = __atomic_load_n(&probes[index], __ATOMIC_ACQUIRE);
+    }
+    if (probe == NULL) {
+        // Out of range, or still being registered
+        memset(stats, 0, sizeof(*stats));
+        return -1;
+    }
+    probe_stats(probe, stats);
+    return 0;
+}
+
+void profile_reset(void)
+{
+    unsigned count = profile_probe_count();
+
+    for (unsigned i = 0; i < count; i++) {
+        profile_probe_t *probe = __atomic_load_n(&probes[i], __ATOMIC_ACQUIRE);
+        if (probe != NULL) {
+            probe_clear(probe);
+        }
+    }
+}
+
+void profile_dump(void)
+{
+    unsigned count = profile_probe_count();
+    profile_stats_t stats;
+
+    for (unsigned i = 0; i < count; i++) {
+        if (profile_stats_get(i, &stats) == 0) {
+            stats_print(&stats);
+        }
+    }
+}
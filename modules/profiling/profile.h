@@ -0,0 +1,130 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * \addtogroup profile profile
+ *
+ * Named timing probes for the audio pipelines, ASR and sample rate conversion.
+ *
+ * A probe is defined once with PROFILE_PROBE_DEFINE() and timed with
+ * PROFILE_START() and PROFILE_END() around the code of interest, or given a
+ * time measured by the caller with PROFILE_RECORD(). Each probe
+ * keeps its count, min, max and total time, and the most recent
+ * appconfPROFILE_RING_SIZE times in a ring buffer from which the 99th
+ * percentile is taken. A probe registers itself the first time it is
+ * recorded, so probes in code that never runs cost nothing.
+ *
+ * Times are in 100 MHz reference clock ticks. At a 600 MHz core clock one
+ * tick is 6 core cycles, and the load of a probe in MIPS is
+ * avg_ticks * 100 / period_us, where period_us is the interval between records.
+ *
+ * Profiling is compiled in when appconfPROFILE_ENABLED is 1. Otherwise the
+ * macros expand to nothing, no probe is registered and the functions report
+ * no probes.
+ *
+ * Each probe must be recorded by one task at a time. The statistics can be
+ * read from any task and may be one record out of date.
+ * @{
+ */
+
+/* Set to 1 to compile in the profiling probes */
+#ifndef appconfPROFILE_ENABLED
+#define appconfPROFILE_ENABLED          0
+#endif
+
+/* Maximum number of probes registered per tile */
+#ifndef appconfPROFILE_MAX_PROBES
+#define appconfPROFILE_MAX_PROBES       32
+#endif
+
+/* Number of recent times kept per probe for the percentile, a power of 2 */
+#ifndef appconfPROFILE_RING_SIZE
+#define appconfPROFILE_RING_SIZE        256
+#endif
+
+/* Number of records between automatic reports of each probe, 0 to disable.
+ * A report prints the probe statistics and starts a new count. */
+#ifndef appconfPROFILE_REPORT_INTERVAL
+#define appconfPROFILE_REPORT_INTERVAL  0
+#endif
+
+typedef struct {
+    const char *name;
+    int registered;
+    uint32_t count;
+    uint32_t min_ticks;
+    uint32_t max_ticks;
+    uint64_t total_ticks;
+    uint32_t ring_pos;
+    uint32_t ring[appconfPROFILE_RING_SIZE];
+} profile_probe_t;
+
+typedef struct {
+    const char *name;
+    uint32_t count;         // Records since the last reset or report
+    uint32_t min_ticks;
+    uint32_t avg_ticks;
+    uint32_t max_ticks;
+    uint32_t p99_ticks;     // Over the most recent appconfPROFILE_RING_SIZE records
+} profile_stats_t;
+
+#if appconfPROFILE_ENABLED
+
+#include <xcore/hwtimer.h>
+
+#define PROFILE_PROBE_DEFINE(var, probe_name)   static profile_probe_t var = { .name = probe_name }
+#define PROFILE_START(var)                      uint32_t var##_profile_start = get_reference_time()
+#define PROFILE_END(var)                        profile_probe_record(&var, get_reference_time() - var##_profile_start)
+#define PROFILE_RECORD(var, ticks)              profile_probe_record(&var, (ticks))
+
+#else
+
+#define PROFILE_PROBE_DEFINE(var, probe_name)   extern profile_probe_t var
+#define PROFILE_START(var)
+#define PROFILE_END(var)
+#define PROFILE_RECORD(var, ticks)
+
+#endif /* appconfPROFILE_ENABLED */
+
+/**
+ * Record one time for a probe, registering the probe if this is its first record.
+ *
+ * \param probe  The probe.
+ * \param ticks  The time in reference clock ticks.
+ */
+void profile_probe_record(profile_probe_t *probe, uint32_t ticks);
+
+/**
+ * Get the number of registered probes.
+ */
+unsigned profile_probe_count(void);
+
+/**
+ * Get the statistics of a registered probe.
+ *
+ * \param index  Registration index of the probe, less than profile_probe_count().
+ * \param stats  Filled with the statistics.
+ * \returns      0 on success, -1 if there is no probe at index.
+ */
+int profile_stats_get(unsigned index, profile_stats_t *stats);
+
+/**
+ * Clear the statistics of every probe.
+ */
+void profile_reset(void);
+
+/**
+ * Print the statistics of every probe, one line each, in the form
+ * "profile: <name> count=<n> min=<t> avg=<t> max=<t> p99=<t> ticks".
+ */
+void profile_dump(void);
+
+/**@}*/
+
+#endif /* PROFILE_H_ */
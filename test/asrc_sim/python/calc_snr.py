@@ -6,13 +6,17 @@ import scipy.io.wavfile
 import argparse
 import os
 
-def rawFFT(data, sampling_rate, plot_fname, show_plot):
-    data_len = len(data)
-    print(f"data_len = {data_len}")
+fftLength = 128
 
-    fftLength = 128
+def load_bin(fname):
+    """Load an asrc_input.bin or asrc_output.bin file as doubles in [-1, 1)"""
+    dt = np.fromfile(fname, dtype=np.int32)
+    return np.array(dt/(np.iinfo(np.int32).max), dtype=np.double)
 
-    skip = int(15*60*sampling_rate) # Skip 15mins from the beginning
+def fft_snr(data, sampling_rate, skip_secs=15*60):
+    """Return the SNR and the FFT magnitude of a fftLength block of data, skip_secs from the beginning.
+    The block is taken from the end of the data when it is shorter than that."""
+    skip = min(int(skip_secs*sampling_rate), len(data) - 2*fftLength)
     Data = np.fft.rfft(data[skip + fftLength:skip + 2*fftLength])
     Data1 = np.abs(Data)
     m = np.argmax(Data1)
@@ -21,6 +25,13 @@ def rawFFT(data, sampling_rate, plot_fname, show_plot):
     noise_power = np.sum(tmpNoise)
     signal_power = Data1[m]
     snr = 20*(np.log10(signal_power/noise_power))
+    return snr, Data1
+
+def rawFFT(data, sampling_rate, plot_fname, show_plot):
+    data_len = len(data)
+    print(f"data_len = {data_len}")
+
+    snr, Data1 = fft_snr(data, sampling_rate) # Skip 15mins from the beginning
     print(f"SNR = {snr}")
 
     Data_abs = 20 * np.log10(Data1/np.max(Data1))
@@ -68,7 +79,7 @@ if __name__ == "__main__":
     if os.path.isfile(args.input_file):
         dt = np.fromfile(args.input_file, dtype=np.int32)
         scipy.io.wavfile.write("test.wav", args.sampling_rate, dt.T)
-        data = np.array(dt/(np.iinfo(np.int32).max), dtype=np.double)
+        data = load_bin(args.input_file)
         snr = rawFFT(data, args.sampling_rate, args.plotfile, args.show)
     else:
         assert False, f"Invalid input file {args.input_file}"
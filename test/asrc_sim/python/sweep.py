@@ -0,0 +1,159 @@
+# Copyright 2024 XMOS LIMITED.
+# This Software is subject to the terms of the XMOS Public Licence: Version 1.
+import numpy as np
+import argparse
+import csv
+import itertools
+import os
+import re
+import subprocess
+import sys
+import time
+from concurrent.futures import ThreadPoolExecutor, as_completed
+
+from calc_snr import load_bin, fft_snr
+
+# Script that runs the ASRC simulator applications over a grid of parameters, in parallel, and writes the SNR, the rate
+# control metrics and the runtime of every point of the grid to a CSV file.
+#
+# The grid is the product of the applications, I2S rates, USB clock drifts in ppm, USB jitter profiles, rate
+# controllers and gain scale factors. The USB rate is always 48000 in the simulator, so the USB rate is swept with
+# the ppm drift. A jitter profile is one of:
+#   none            The USB task runs from a fixed clock, drifting by the ppm
+#   gauss:<ns>      SOF timestamps drifting by the ppm, with gaussian jitter of <ns> ns rms, generated by this script
+#   <file>          A file of recorded SOF timestamps, such as log_sofs_1hr. The ppm is not used.
+# Parameters an application does not use are not swept for it: i2s_in_usb_out only has the P controller and Kp.
+#
+# Each point runs in its own directory under the output directory, which keeps its log. The ASRC output is deleted
+# once its SNR is calculated, unless --keep-bin is given.
+#
+# From the test/asrc_sim directory, after building, run for example:
+# python python/sweep.py --app usb_in_i2s_out --i2s-rates 48000 192000 --ppm -100 0 100 --jitter none gauss:500 \
+#     --controller p pi pid pi_est --kp-scale 0.5 1 2 -j 8
+
+SOF_TICKS = 100000                      # SOF period in 100MHz reference timer ticks
+USB_RATE = 48000
+
+CSV_FIELDS = ["point", "app", "i2s_rate", "ppm", "jitter", "controller", "kp_scale", "ki_scale", "kd_scale",
+              "snr_db", "stable_time_s", "lock_time_s", "max_avg_level_excursion", "max_level_excursion",
+              "runtime_s", "status"]
+
+metrics_re = re.compile(r"Rate control metrics: stable level at ([-\d.]+) s, lock time ([-\d.]+) s, "
+                        r"max average level excursion (\d+), max level excursion (\d+)")
+
+def get_args():
+    parser = argparse.ArgumentParser("Script to run the ASRC simulator over a grid of parameters")
+    parser.add_argument("--app", nargs="+", default=["usb_in_i2s_out", "i2s_in_usb_out"], choices=["usb_in_i2s_out", "i2s_in_usb_out"], help="Simulator applications")
+    parser.add_argument("--i2s-rates", nargs="+", type=int, default=[48000], help="I2S rates")
+    parser.add_argument("--ppm", nargs="+", type=float, default=[10], help="USB clock drifts in ppm")
+    parser.add_argument("--jitter", nargs="+", default=["none"], help="USB jitter profiles: none, gauss:<ns rms> or a SOF timestamps file")
+    parser.add_argument("--controller", nargs="+", default=["p"], choices=["p", "pi", "pid", "pi_est"], help="Rate controller engines of usb_in_i2s_out")
+    parser.add_argument("--kp-scale", nargs="+", type=float, default=[1.0], help="Kp scale factors")
+    parser.add_argument("--ki-scale", nargs="+", type=float, default=[1.0], help="Ki scale factors, usb_in_i2s_out only")
+    parser.add_argument("--kd-scale", nargs="+", type=float, default=[1.0], help="Kd scale factors, usb_in_i2s_out only")
+    parser.add_argument("--mins", type=float, default=20, help="Simulated time in minutes")
+    parser.add_argument("--snr-skip-mins", type=float, default=15, help="Time from the start of the ASRC output to calculate the SNR at")
+    parser.add_argument("--jobs", "-j", type=int, default=os.cpu_count(), help="Number of simulations to run in parallel")
+    parser.add_argument("--build-dir", type=str, default="build", help="Directory containing the simulator executables")
+    parser.add_argument("--out-dir", "-o", type=str, default="_sweep", help="Directory to run the points in")
+    parser.add_argument("--csv", type=str, default="sweep.csv", help="CSV file to write, in the output directory")
+    parser.add_argument("--keep-bin", action="store_true", help="Keep the ASRC input and output files of each point")
+    parser.add_argument("--dry-run", action="store_true", help="Only print the points of the grid")
+    return parser.parse_args()
+
+def get_points(args):
+    points = []
+    for app, i2s_rate, ppm, jitter, controller, kp, ki, kd in itertools.product(args.app, args.i2s_rates, args.ppm, args.jitter,
+                                                                             args.controller, args.kp_scale, args.ki_scale, args.kd_scale):
+        if app == "i2s_in_usb_out":
+            controller, ki, kd = "p", 1.0, 1.0
+        if jitter != "none" and not jitter.startswith("gauss:"):
+            ppm = None
+        point = (app, i2s_rate, ppm, jitter, controller, kp, ki, kd)
+        if point not in points:
+            points.append(point)
+    return points
+
+def gen_sof_timestamps(fname, ppm, jitter_ns, mins, seed):
+    """Write a file of SOF timestamps, in 100MHz ticks, drifting by ppm with gaussian jitter, covering mins minutes"""
+    num_sofs = int(mins * 60 * 1000 * 1.01) + 1
+    rng = np.random.default_rng(seed)
+    ticks = np.arange(num_sofs) * (SOF_TICKS / (1 + ppm / 1e6)) + rng.normal(0, jitter_ns / 10, num_sofs)
+    np.savetxt(fname, np.mod(np.round(ticks), 2**32).astype(np.uint32), fmt="%u")
+
+def run_point(idx, point, args):
+    app, i2s_rate, ppm, jitter, controller, kp, ki, kd = point
+    point_dir = os.path.join(args.out_dir, f"point_{idx}")
+    os.makedirs(point_dir, exist_ok=True)
+
+    cmd = [os.path.abspath(os.path.join(args.build_dir, app)), "--mins", str(args.mins), "--kp-scale", str(kp)]
+    if app == "usb_in_i2s_out":
+        cmd += ["--ki-scale", str(ki), "--kd-scale", str(kd)]
+    if ppm is not None:
+        cmd += ["--ppm", str(ppm)]
+    cmd += [str(i2s_rate)]
+    if jitter.startswith("gauss:"):
+        sofs = os.path.abspath(os.path.join(point_dir, "sofs"))
+        gen_sof_timestamps(sofs, ppm, float(jitter.split(":")[1]), args.mins, idx)
+        cmd += [sofs]
+    elif jitter != "none":
+        cmd += [os.path.abspath(jitter)]
+    if app == "usb_in_i2s_out":
+        cmd += [controller]
+
+    row = {"point": idx, "app": app, "i2s_rate": i2s_rate, "ppm": "" if ppm is None else ppm, "jitter": jitter,
+           "controller": controller, "kp_scale": kp, "ki_scale": ki, "kd_scale": kd}
+
+    start = time.time()
+    with open(os.path.join(point_dir, "log"), "w") as log:
+        result = subprocess.run(cmd, cwd=point_dir, stdout=log, stderr=subprocess.STDOUT)
+    row["runtime_s"] = round(time.time() - start, 1)
+    row["status"] = "PASS" if result.returncode == 0 else f"FAIL {result.returncode}"
+
+    with open(os.path.join(point_dir, "log")) as log:
+        for line in log:
+            m = metrics_re.search(line)
+            if m:
+                row["stable_time_s"], row["lock_time_s"] = m.group(1), m.group(2)
+                row["max_avg_level_excursion"], row["max_level_excursion"] = m.group(3), m.group(4)
+
+    # The ASRC output is at the I2S rate for usb_in_i2s_out and at the USB rate for i2s_in_usb_out
+    output_rate = i2s_rate if app == "usb_in_i2s_out" else USB_RATE
+    output_file = os.path.join(point_dir, "asrc_output.bin")
+    if os.path.isfile(output_file):
+        data = load_bin(output_file)
+        if len(data) >= 2 * 128:
+            snr, _ = fft_snr(data, output_rate, args.snr_skip_mins * 60)
+            row["snr_db"] = round(float(snr), 2)
+    if not args.keep_bin:
+        for f in ["asrc_input.bin", "asrc_output.bin", "sofs"]:
+            if os.path.isfile(os.path.join(point_dir, f)):
+                os.remove(os.path.join(point_dir, f))
+    return row
+
+# Usage python python/sweep.py [grid options] -j <jobs>
+if __name__ == "__main__":
+    args = get_args()
+    points = get_points(args)
+    print(f"{len(points)} points, {args.jobs} in parallel")
+    if args.dry_run:
+        for idx, point in enumerate(points):
+            print(idx, point)
+        sys.exit(0)
+
+    for app in args.app:
+        assert os.path.isfile(os.path.join(args.build_dir, app)), f"ERROR: {app} not found in {args.build_dir}. Build it first."
+    os.makedirs(args.out_dir, exist_ok=True)
+
+    # Rows are written as the points finish, so that a sweep stopped part way keeps the points run so far
+    with open(os.path.join(args.out_dir, args.csv), "w", newline="") as f:
+        writer = csv.DictWriter(f, fieldnames=CSV_FIELDS)
+        writer.writeheader()
+        with ThreadPoolExecutor(max_workers=args.jobs) as pool:
+            futures = [pool.submit(run_point, idx, point, args) for idx, point in enumerate(points)]
+            for num_done, future in enumerate(as_completed(futures), 1):
+                row = future.result()
+                writer.writerow(row)
+                f.flush()
+                print(f"[{num_done}/{len(points)}] {row}")
+    print(f"Results in {os.path.join(args.out_dir, args.csv)}")
@@ -61,4 +61,18 @@ else
     exit -1
 fi
 
+# Rate controller engines with SOF timestamps. The PI engine must not leave the buffer level further from the stable level than P.
+i2srate=48000
+build/usb_in_i2s_out $i2srate log_sofs_1hr p 2>&1 > log_p
+build/usb_in_i2s_out $i2srate log_sofs_1hr pi 2>&1 > log_pi
+grep "Rate control metrics" log_p log_pi
+excursion_p=$(grep "Rate control metrics" log_p | sed -E 's/.*max average level excursion ([0-9]+).*/\1/g')
+excursion_pi=$(grep "Rate control metrics" log_pi | sed -E 's/.*max average level excursion ([0-9]+).*/\1/g')
+if [ $((excursion_pi)) -le $((excursion_p)) ]; then
+    echo "Rate control excursion P $excursion_p PI $excursion_pi PASS"
+else
+    echo "Rate control excursion P $excursion_p PI $excursion_pi FAIL"
+    exit -1
+fi
+
 #python plot_csv.py log $dir_name/test_correct_$i.png 2
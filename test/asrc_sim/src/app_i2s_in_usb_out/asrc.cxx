@@ -18,6 +18,7 @@ ASRC::ASRC(sc_module_name name, uint32_t fs_in, uint32_t fs_out, uint32_t block_
     , m_buffer(buffer)
     , m_config(config)
     , m_trigger(trigger)
+    , m_metrics(config)
 {
     uint32_t rand_seed[MAX_ASRC_N_IO_CHANNELS] = {0};
     m_nominal_rate_ratio = wrapper_asrc_init(&m_profile_info_ptr, fs_in, fs_out, block_size, 1, 1, ASRC_DITHER_OFF, rand_seed);
@@ -105,6 +106,7 @@ void ASRC::process()
         if(long_term_buf_state.flag_stable_avg)
         {
             printf("%d,%d\n", long_term_buf_state.avg_buffer_level, short_term_buf_state.avg_buffer_level);
+            m_metrics.update(m_buffer->fill_level() - long_term_buf_state.stable_avg_level, long_term_buf_state.avg_buffer_level - long_term_buf_state.stable_avg_level);
         }
 
         // After 16 writes
@@ -125,13 +127,13 @@ void ASRC::process()
                 //printf("rate_ratio = %llu, test = %llu\n", rate_ratio, test_rate_ratio);
                 //rate_ratio = test_rate_ratio;
 
-                error = calc_usb_buffer_based_correction(m_config->nominal_i2s_rate, &long_term_buf_state, &short_term_buf_state);
+                error = calc_usb_buffer_based_correction(m_config->nominal_i2s_rate, m_config->kp_scale, &long_term_buf_state, &short_term_buf_state);
 
                 rate_ratio = rate_ratio + error;
             }
             else
             {
-                error = calc_usb_buffer_based_correction(m_config->nominal_i2s_rate, &long_term_buf_state, &short_term_buf_state);
+                error = calc_usb_buffer_based_correction(m_config->nominal_i2s_rate, m_config->kp_scale, &long_term_buf_state, &short_term_buf_state);
                 rate_ratio = m_actual_rate_ratio + error;
             }
 
@@ -146,3 +148,8 @@ void ASRC::process()
         }
     }
 }
+
+void ASRC::print_metrics()
+{
+    m_metrics.print();
+}
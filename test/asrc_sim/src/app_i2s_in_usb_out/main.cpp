@@ -13,7 +13,7 @@
 
 #define DEFAULT_NOMINAL_USB_RATE (48000) // Do not change!! Only 48000KHz USB supported
 #define DEFAULT_USB_DRIFT_PPM    (10)
-#define DEFAULT_SIM_TIME_MINS    (20)    // Simulation time in mins
+#define DEFAULT_SIM_TIME_MINS    (20)    // Simulation time in mins, unless set with --mins
 #define ASRC_BLOCK_SIZE          (244)   // Number of samples that make the ASRC input block
 
 // Usage. From the build directory, run: ./i2s_in_usb_out <i2s_rate> ../log_sofs_1hr 2>&1 | tee log
@@ -23,12 +23,17 @@ int sc_main(int argc, char* argv[])
     app_config->nominal_usb_rate = DEFAULT_NOMINAL_USB_RATE;
     app_config->usb_drift_ppm = DEFAULT_USB_DRIFT_PPM;
     app_config->asrc_block_size = ASRC_BLOCK_SIZE;
+    app_config->sim_time_mins = DEFAULT_SIM_TIME_MINS;
+    app_config->kp_scale = 1.0;
+    app_config->ki_scale = 1.0;
+    app_config->kd_scale = 1.0;
     // Choose the frequency of the sine tone used as ASRC input such that there are an integer no. of periods in a 128 point FFT on the asrc output, which is at the USB rate
     app_config->asrc_input_sine_freq = 6000;
 
+    argc = parse_sim_options(argc, argv, app_config);
     if(argc < 2)
     {
-        printf("Usage:\ni2s_in_usb_out <i2s_rate> \nor\ni2s_in_usb_out <i2s_rate> <USB timestamps file>\nExiting\n");
+        printf("Usage:\ni2s_in_usb_out [--ppm <usb drift>] [--mins <sim time>] [--kp-scale <scale>] <i2s_rate> \nor\ni2s_in_usb_out [options] <i2s_rate> <USB timestamps file>\nExiting\n");
         return -1;
     }
     app_config->nominal_i2s_rate = (double)(atoi(argv[1]));
@@ -70,7 +75,9 @@ int sc_main(int argc, char* argv[])
 
 
     // Simulate for N seconds.
-    sc_start(DEFAULT_SIM_TIME_MINS*60*app_config->nominal_i2s_rate, SC_US);
+    sc_start(app_config->sim_time_mins*60*app_config->nominal_i2s_rate, SC_US);
+
+    asrc.print_metrics();
 
     delete app_config->asrc_input_samples;
     delete app_config;
@@ -30,9 +30,9 @@ static inline sw_pll_q24_t get_Kp_for_usb_buffer_control(int32_t nominal_i2s_rat
     return Kp;
 }
 
-uint64_t calc_usb_buffer_based_correction(int32_t nominal_i2s_rate, buffer_calc_state_t *long_term_buf_state, buffer_calc_state_t *short_term_buf_state)
+uint64_t calc_usb_buffer_based_correction(int32_t nominal_i2s_rate, double kp_scale, buffer_calc_state_t *long_term_buf_state, buffer_calc_state_t *short_term_buf_state)
 {
-    sw_pll_q24_t Kp = get_Kp_for_usb_buffer_control(nominal_i2s_rate);
+    sw_pll_q24_t Kp = (sw_pll_q24_t)(get_Kp_for_usb_buffer_control(nominal_i2s_rate) * kp_scale);
     int64_t max_allowed_correction = (int64_t)1500 << 32;
     int64_t total_error = 0;
 
@@ -15,6 +15,7 @@ ASRC::ASRC(sc_module_name name, uint32_t fs_in, uint32_t fs_out, uint32_t block_
     , m_buffer(buffer)
     , m_config(config)
     , m_trigger(trigger)
+    , m_metrics(config)
 {
     uint32_t rand_seed[MAX_ASRC_N_IO_CHANNELS] = {0};
 
@@ -52,6 +53,8 @@ void ASRC::process()
     }
 
     init_calc_buffer_level_state(&buf_state, 10, 8);
+    pi_control_init(m_config->nominal_i2s_rate, (rate_control_mode_t)m_config->rate_control_mode,
+                    m_config->kp_scale, m_config->ki_scale, m_config->kd_scale);
 
     FILE *fp;
     fp = fopen("asrc_output.bin", "wb");
@@ -73,22 +76,20 @@ void ASRC::process()
 
         if(buffer_writes_count == 16)
         {
-            int64_t error;
+            uint64_t measured_ratio;
             if(m_config->usb_timestamps[0].size() != 0)
             {
-                rate_ratio = float_div_u64_fixed_output_q_format(g_avg_usb_rate, g_avg_i2s_rate, 28+32);
-                error = pi_control(m_config->nominal_i2s_rate, &buf_state);
-                // Uncomment to apply a fixed correction instead of the pi_control() code.
-                //double correction = 0.000000043;
-                //uint64_t correction_i = (uint64_t)(correction * ((uint64_t)1 << (28+32)));
-                //rate_ratio = rate_ratio - correction_i;
-                rate_ratio = rate_ratio + error;
+                measured_ratio = float_div_u64_fixed_output_q_format(g_avg_usb_rate, g_avg_i2s_rate, 28+32);
             }
             else
             {
-                error = pi_control(m_config->nominal_i2s_rate, &buf_state);
-                rate_ratio = m_actual_rate_ratio + error;
+                measured_ratio = m_actual_rate_ratio;
             }
+            // Uncomment to apply a fixed correction instead of the pi_control() code.
+            //double correction = 0.000000043;
+            //uint64_t correction_i = (uint64_t)(correction * ((uint64_t)1 << (28+32)));
+            //rate_ratio = measured_ratio - correction_i;
+            rate_ratio = pi_control(measured_ratio, &buf_state);
 
             buffer_writes_count = 0;
 
@@ -98,5 +99,15 @@ void ASRC::process()
             }
         }
 
+        if(buf_state.flag_stable_avg)
+        {
+            m_metrics.update(m_buffer->fill_level() - buf_state.stable_avg_level, buf_state.avg_buffer_level - buf_state.stable_avg_level);
+        }
+
     }
 }
+
+void ASRC::print_metrics()
+{
+    m_metrics.print();
+}
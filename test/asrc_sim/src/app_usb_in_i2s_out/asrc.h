@@ -6,6 +6,7 @@
 #include "buffer.h"
 #include "ASRC_wrapper.h"
 #include "config.h"
+#include "rate_metrics.h"
 
 SC_MODULE(ASRC)
 {
@@ -29,6 +30,9 @@ SC_MODULE(ASRC)
 
         ASRCCtrl_profile_only_t *m_profile_info_ptr[MAX_ASRC_N_IO_CHANNELS];
 
+        RateMetrics m_metrics;
+
     public:
         void process();
+        void print_metrics();
 };
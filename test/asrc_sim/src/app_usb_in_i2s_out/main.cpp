@@ -1,6 +1,7 @@
 // Copyright 2023 XMOS LIMITED.
 // This Software is subject to the terms of the XMOS Public Licence: Version 1.
 #include <string>
+#include <cstring>
 #include <sstream>
 #include <fstream>
 #include "systemc.h"
@@ -10,25 +11,47 @@
 #include "asrc.h"
 #include "config.h"
 #include "helpers.h"
+#include "rate_control.h"
 
 #define DEFAULT_NOMINAL_USB_RATE (48000) // Do not change!! Only 48000KHz USB supported
 #define DEFAULT_USB_DRIFT_PPM    (10)
-#define DEFAULT_SIM_TIME_MINS    (20)    // Simulation time in mins
+#define DEFAULT_SIM_TIME_MINS    (20)    // Simulation time in mins, unless set with --mins
 #define ASRC_BLOCK_SIZE          (96)    // Number of samples that make the ASRC input block
 
 
-// Usage. From the build directory, run: ./usb_in_i2s_out <i2s_rate> ../log_sofs_1hr 2>&1 | tee log
+static const char *rate_control_names[] = {"p", "pi", "pid", "pi_est"};
+
+// Returns the rate_control_mode_t engine with the given name, or -1
+static int parse_rate_control_mode(const char *name)
+{
+    for(unsigned i=0; i<sizeof(rate_control_names)/sizeof(rate_control_names[0]); i++)
+    {
+        if(strcmp(name, rate_control_names[i]) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Usage. From the build directory, run: ./usb_in_i2s_out <i2s_rate> ../log_sofs_1hr [p|pi|pid|pi_est] 2>&1 | tee log
 int sc_main(int argc, char* argv[])
 {
     config_t *app_config = new config_t;
     app_config->nominal_usb_rate = DEFAULT_NOMINAL_USB_RATE;
     app_config->usb_drift_ppm = DEFAULT_USB_DRIFT_PPM;
     app_config->asrc_block_size = ASRC_BLOCK_SIZE;
+    app_config->sim_time_mins = DEFAULT_SIM_TIME_MINS;
+    app_config->kp_scale = 1.0;
+    app_config->ki_scale = 1.0;
+    app_config->kd_scale = 1.0;
+    app_config->rate_control_mode = RATE_CONTROL_P;
 
 
+    argc = parse_sim_options(argc, argv, app_config);
     if(argc < 2)
     {
-        printf("Usage:\nusb_in_i2s_out <i2s_rate> \nor\nusb_in_i2s_out <i2s_rate> <USB timestamps file>\nExiting\n");
+        printf("Usage:\nusb_in_i2s_out [--ppm <usb drift>] [--mins <sim time>] [--kp-scale|--ki-scale|--kd-scale <scale>] <i2s_rate> [USB timestamps file] [rate controller: p, pi, pid or pi_est]\nExiting\n");
         return -1;
     }
     app_config->nominal_i2s_rate = (double)(atoi(argv[1]));
@@ -53,11 +76,24 @@ int sc_main(int argc, char* argv[])
         return -1;
     }
 
-    if(argc == 3) // If SOF timestamps file is provided, parse the timestamps into a std::vector
+    // The optional arguments are the SOF timestamps file and then the rate controller, or the rate controller alone
+    int arg = 2;
+    if((argc > arg) && (parse_rate_control_mode(argv[arg]) < 0)) // If SOF timestamps file is provided, parse the timestamps into a std::vector
+    {
+        printf("argv[2] = %s\n", argv[arg]);
+        parse_sof_timestamps(argv[arg], app_config);
+        arg++;
+    }
+    if(argc > arg)
     {
-        printf("argv[2] = %s\n", argv[2]);
-        parse_sof_timestamps(argv[2], app_config);
+        app_config->rate_control_mode = parse_rate_control_mode(argv[arg]);
+        if(app_config->rate_control_mode < 0)
+        {
+            printf("ERROR: unknown rate controller %s\n", argv[arg]);
+            return -1;
+        }
     }
+    printf("Rate controller = %s\n", rate_control_names[app_config->rate_control_mode]);
 
     app_config->actual_usb_rate = (double)app_config->nominal_usb_rate * (1 + app_config->usb_drift_ppm/1000000);
     double sof_period = (1e-3/(1/app_config->nominal_i2s_rate)) / (1 + app_config->usb_drift_ppm/1000000);
@@ -82,7 +118,9 @@ int sc_main(int argc, char* argv[])
     sc_start(0, SC_SEC);
 
     // Simulate for N seconds
-    sc_start(DEFAULT_SIM_TIME_MINS*60*app_config->nominal_i2s_rate, SC_US);
+    sc_start(app_config->sim_time_mins*60*app_config->nominal_i2s_rate, SC_US);
+
+    asrc.print_metrics();
 
     return 0;
 }
@@ -4,10 +4,10 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include "avg_buffer_level.h"
+#include "rate_control.h"
+#include "pi_control.h"
 
-typedef int32_t sw_pll_q24_t; // Type for 8.24 signed fixed point
-#define SW_PLL_NUM_FRAC_BITS 24
-#define SW_PLL_Q24(val) ((sw_pll_q24_t)((double)val * (1 << SW_PLL_NUM_FRAC_BITS)))
+static rate_control_t g_rate_control;
 
 int32_t calc_accum_error(int32_t error)
 {
@@ -66,27 +66,22 @@ static inline sw_pll_q24_t get_Kp_for_usb_buffer_control(int32_t nominal_i2s_rat
     return Kp;
 }
 
-uint64_t pi_control(int32_t nominal_i2s_rate, buffer_calc_state_t *buf_state)
+void pi_control_init(int32_t nominal_i2s_rate, rate_control_mode_t mode, double kp_scale, double ki_scale, double kd_scale)
 {
-    sw_pll_q24_t Kp = get_Kp_for_usb_buffer_control(nominal_i2s_rate);
-    int64_t max_allowed_correction = (int64_t)1500 << 32;
-    int64_t total_error = 0;
-
-    if(buf_state->flag_stable_avg == true)
-    {
-        int64_t error_p = ((int64_t)Kp * (int64_t)(buf_state->avg_buffer_level - buf_state->stable_avg_level));
-
-        total_error = (int64_t)(error_p << 8);
-        if(total_error > max_allowed_correction)
-        {
-            total_error = max_allowed_correction;
-        }
-        else if(total_error < -(max_allowed_correction))
-        {
-            total_error = -(max_allowed_correction);
-        }
-    }
-
-    return total_error;
+    rate_control_gains_t gains;
+    rate_control_gains_from_kp(get_Kp_for_usb_buffer_control(nominal_i2s_rate), mode, &gains);
+    // Scale the gains of the engine, for sweeping them in the simulator
+    gains.Kp = (sw_pll_q24_t)(gains.Kp * kp_scale);
+    gains.Ki = (sw_pll_q24_t)(gains.Ki * ki_scale);
+    gains.Kd = (sw_pll_q24_t)(gains.Kd * kd_scale);
+    rate_control_init(&g_rate_control, mode, nominal_i2s_rate, &gains);
+}
 
+uint64_t pi_control(uint64_t measured_ratio, buffer_calc_state_t *buf_state)
+{
+    return rate_control_update(&g_rate_control,
+                               measured_ratio,
+                               buf_state->flag_stable_avg,
+                               buf_state->avg_buffer_level - buf_state->stable_avg_level,
+                               buf_state->avg_count);
 }
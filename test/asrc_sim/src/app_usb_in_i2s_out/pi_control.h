@@ -5,13 +5,15 @@
 
 #include <stdint.h>
 #include "avg_buffer_level.h"
+#include "rate_control.h"
 
 #ifdef __cplusplus
  extern "C" {
 #endif
 
 void calc_avg_i2s_send_buffer_level(int current_level, bool reset);
-uint64_t pi_control(int32_t nominal_i2s_rate, buffer_calc_state_t *buf_state);
+void pi_control_init(int32_t nominal_i2s_rate, rate_control_mode_t mode, double kp_scale, double ki_scale, double kd_scale);
+uint64_t pi_control(uint64_t measured_ratio, buffer_calc_state_t *buf_state);
 
 #ifdef __cplusplus
  }
@@ -20,6 +20,7 @@ typedef struct
     int32_t buffer_level_stable_threshold; // No. of frames to wait before declaring the buffer level stable
     int32_t count;  /// Running counter for tracking the averaging window
     int32_t buffer_level_stable_count;  /// Frame counter for counting number of averaging windows before declaring that the average is stable
+    uint32_t avg_count; /// Number of windowed averages calculated. Changes whenever avg_buffer_level is updated
 
     bool flag_first_done;   /// Flag indicating if the very first windowed average has been computed
     bool flag_stable_avg;   /// Flag indicating whether a stable average has been computed
@@ -14,4 +14,9 @@ typedef struct
     int asrc_block_size;
     std::vector<uint32_t> usb_timestamps[2]; // 2 in case OUT and IN timestamps are present.
     int *asrc_input_samples;
+    double sim_time_mins;
+    int rate_control_mode;  // rate_control_mode_t engine of the usb_in_i2s_out rate controller
+    double kp_scale;        // Scale factors applied to the rate controller gains
+    double ki_scale;
+    double kd_scale;
 }config_t;
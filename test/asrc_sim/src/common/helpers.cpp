@@ -8,6 +8,7 @@
 #include "config.h"
 
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <numeric>
 
@@ -63,3 +64,56 @@ int verify_i2s_rate(int i2s_rate)
     printf("nominal_i2s_rate = %d\n", (int)i2s_rate);
     return 0;
 }
+
+// Parse the options common to both applications and remove them from argv, leaving the positional arguments.
+// Returns the number of arguments left, or -1 on an invalid option.
+//  --ppm <drift>           USB clock drift in ppm, when there's no SOF timestamps file
+//  --mins <minutes>        Simulated time in minutes
+//  --kp-scale <scale>      Scale factor of the rate controller Kp
+//  --ki-scale <scale>      Scale factor of the rate controller Ki (usb_in_i2s_out only)
+//  --kd-scale <scale>      Scale factor of the rate controller Kd (usb_in_i2s_out only)
+int parse_sim_options(int argc, char* argv[], config_t *app_config)
+{
+    int num_args = 0;
+    for(int i=0; i<argc; i++)
+    {
+        if(strncmp(argv[i], "--", 2) != 0)
+        {
+            argv[num_args++] = argv[i];
+            continue;
+        }
+        if(i + 1 >= argc)
+        {
+            printf("ERROR: option %s has no value\n", argv[i]);
+            return -1;
+        }
+        double val = atof(argv[i + 1]);
+        if(strcmp(argv[i], "--ppm") == 0)
+        {
+            app_config->usb_drift_ppm = val;
+        }
+        else if(strcmp(argv[i], "--mins") == 0)
+        {
+            app_config->sim_time_mins = val;
+        }
+        else if(strcmp(argv[i], "--kp-scale") == 0)
+        {
+            app_config->kp_scale = val;
+        }
+        else if(strcmp(argv[i], "--ki-scale") == 0)
+        {
+            app_config->ki_scale = val;
+        }
+        else if(strcmp(argv[i], "--kd-scale") == 0)
+        {
+            app_config->kd_scale = val;
+        }
+        else
+        {
+            printf("ERROR: unknown option %s\n", argv[i]);
+            return -1;
+        }
+        i++;
+    }
+    return num_args;
+}
@@ -0,0 +1,38 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#include <cstdlib>
+#include "systemc.h"
+#include "rate_metrics.h"
+
+void RateMetrics::update(int level_error, int avg_level_error)
+{
+    double now = sc_time_stamp().to_seconds() * 1e6 / m_config->nominal_i2s_rate; // 1us of simulated time is an I2S sample period
+    if(m_stable_time < 0)
+    {
+        m_stable_time = now;
+        m_lock_time = 0;
+    }
+    if(abs(level_error) > m_max_level_excursion)
+    {
+        m_max_level_excursion = abs(level_error);
+    }
+    if(abs(avg_level_error) > m_max_avg_level_excursion)
+    {
+        m_max_avg_level_excursion = abs(avg_level_error);
+    }
+    if(abs(avg_level_error) > LOCK_BAND)
+    {
+        m_lock_time = now - m_stable_time;
+    }
+}
+
+void RateMetrics::print()
+{
+    if(m_stable_time < 0)
+    {
+        printf("Rate control metrics: no stable buffer level\n");
+        return;
+    }
+    printf("Rate control metrics: stable level at %.1f s, lock time %.1f s, max average level excursion %d, max level excursion %d\n",
+           m_stable_time, m_lock_time, m_max_avg_level_excursion, m_max_level_excursion);
+}
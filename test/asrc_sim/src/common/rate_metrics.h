@@ -0,0 +1,26 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#pragma once
+
+#include "config.h"
+
+// Rate control metrics, measured from when the stable buffer level is known. They are printed at the end of the
+// simulation as a line parsed by python/sweep.py.
+class RateMetrics
+{
+    public:
+        static const int LOCK_BAND = 4;         // The loop is locked once the average level stays within this of the stable level
+
+        RateMetrics(config_t *config) : m_config(config) {}
+
+        // Call after every buffer write once the stable level is known
+        void update(int level_error, int avg_level_error);
+        void print();
+
+    private:
+        config_t *m_config;
+        double m_stable_time = -1;              // Time at which the stable level was calculated
+        double m_lock_time = -1;                // Time from m_stable_time to the last time the average was outside LOCK_BAND
+        int m_max_avg_level_excursion = 0;      // Largest |average level - stable level|
+        int m_max_level_excursion = 0;          // Largest |buffer level - stable level|
+};
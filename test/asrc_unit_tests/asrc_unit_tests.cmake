@@ -32,3 +32,51 @@ else()
         PRIVATE m)
     target_compile_definitions(test_asrc_div PRIVATE X86_BUILD=1)
 endif()
+
+## The rate controller is tested on the host, against a model of the buffer using the simulator's buffer level averaging
+if(NOT ${CMAKE_SYSTEM_NAME} STREQUAL XCORE_XS3A)
+    set(ASRC_SIM_PATH ${CMAKE_CURRENT_LIST_DIR}/../asrc_sim)
+
+    add_executable(test_rate_control
+        ${CMAKE_CURRENT_LIST_DIR}/src/test_rate_control.c
+        ${CMAKE_CURRENT_LIST_DIR}/src/pseudo_rand.c
+        ${ASRC_EXAMPLE_PATH}/src/shared/rate_control.c
+        ${ASRC_SIM_PATH}/src/common/buffer/avg_buffer_level.c
+    )
+
+    target_include_directories(test_rate_control
+        PRIVATE
+            ${CMAKE_CURRENT_LIST_DIR}/src
+            ${ASRC_EXAMPLE_PATH}/src/shared
+            ${ASRC_SIM_PATH}/src/common/buffer
+    )
+
+    target_compile_definitions(test_rate_control PRIVATE X86_BUILD=1)
+
+    target_link_libraries(test_rate_control PRIVATE m)
+endif()
+
+## The multi-channel ASRC benchmark needs lib_src, which is only built for xcore
+if(${CMAKE_SYSTEM_NAME} STREQUAL XCORE_XS3A)
+    add_executable(test_asrc_mc_bench
+        ${CMAKE_CURRENT_LIST_DIR}/src/asrc_mc_bench.c
+        ${ASRC_EXAMPLE_PATH}/src/asrc_mc.c
+    )
+
+    target_include_directories(test_asrc_mc_bench
+        PRIVATE
+            ${ASRC_EXAMPLE_PATH}/src
+    )
+
+    target_link_libraries(test_asrc_mc_bench PRIVATE lib_src)
+
+    target_compile_options(test_asrc_mc_bench
+        PRIVATE
+            "-O3"
+            "-target=XCORE-AI-EXPLORER")
+
+    target_link_options(test_asrc_mc_bench
+        PRIVATE
+            "-target=XCORE-AI-EXPLORER"
+            "-report")
+endif()
@@ -0,0 +1,146 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include <platform.h>
+#include <xs1.h>
+#include <xcore/assert.h>
+#include <xcore/hwtimer.h>
+
+#include "src.h"
+#include "asrc_mc.h"
+
+// Benchmark of the multi-channel ASRC engine on one core.
+//
+// For 2, 4 and 8 channels, each split into 1, 2 and 4 groups, a sine is converted for a number of blocks and the
+// groups are timed one after the other. The time per core is that of the slowest group, as the groups of a block
+// run in parallel. The output of every split must hash the same as the output with one group.
+
+#define BLOCK_LENGTH        (96)
+#define MAX_OUT_SAMPLES     (BLOCK_LENGTH * 5)
+#define NUM_BLOCKS          (100)
+#define CYCLES_PER_TICK     (6)     // 600 MHz core clock, 100 MHz reference clock
+
+typedef struct
+{
+    unsigned fs_in;
+    unsigned fs_out;
+    fs_code_t in_code;
+    fs_code_t out_code;
+}rates_t;
+
+static const rates_t rates[] = {
+    {48000, 48000, FS_CODE_48, FS_CODE_48},
+    {44100, 48000, FS_CODE_44, FS_CODE_48},
+    {48000, 192000, FS_CODE_48, FS_CODE_192},
+};
+
+static asrc_mc_t mc;
+static int32_t __attribute__((aligned(8))) storage[ASRC_MC_STORAGE_WORDS(ASRC_MC_MAX_CHANS, ASRC_MC_MAX_GROUPS, BLOCK_LENGTH, MAX_OUT_SAMPLES)];
+static int32_t in[BLOCK_LENGTH * ASRC_MC_MAX_CHANS];
+static int32_t out[MAX_OUT_SAMPLES * ASRC_MC_MAX_CHANS];
+static uint32_t ref_hash[NUM_BLOCKS];   // Hash of each output block with one group
+static unsigned ref_n_out[NUM_BLOCKS];
+
+static uint32_t hash_block(const int32_t *block, unsigned n)
+{
+    uint32_t hash = 2166136261u;
+    for(int i=0; i<n; i++)
+    {
+        hash = (hash ^ (uint32_t)block[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static void fill_block(int32_t *block, unsigned num_chans, unsigned block_idx)
+{
+    for(int i=0; i<BLOCK_LENGTH; i++)
+    {
+        unsigned n = block_idx * BLOCK_LENGTH + i;
+        for(int ch=0; ch<num_chans; ch++)
+        {
+            // A different frequency per channel so that a channel mix up shows in the output
+            block[i * num_chans + ch] = (int32_t)(sin(2 * M_PI * n * (ch + 1) * 0.01) * (1 << 30));
+        }
+    }
+}
+
+static void run(const rates_t *r, unsigned num_chans, unsigned num_groups)
+{
+    uint32_t core_ticks = 0;
+    uint32_t total_ticks = 0;
+    unsigned total_out = 0;
+
+    asrc_mc_init(&mc, storage, num_chans, num_groups, BLOCK_LENGTH, MAX_OUT_SAMPLES);
+    uint64_t fs_ratio = asrc_mc_set_rates(&mc, r->in_code, r->out_code, OFF);
+
+    for(int b=0; b<NUM_BLOCKS; b++)
+    {
+        unsigned n_out = 0;
+        uint32_t slowest = 0;
+
+        fill_block(in, num_chans, b);
+        for(int g=0; g<num_groups; g++)
+        {
+            uint32_t start = get_reference_time();
+            unsigned n_out_group = asrc_mc_process_group(&mc, g, in, out, fs_ratio);
+            uint32_t ticks = get_reference_time() - start;
+
+            xassert((g == 0) || (n_out_group == n_out));
+            n_out = n_out_group;
+            total_ticks += ticks;
+            if(ticks > slowest)
+            {
+                slowest = ticks;
+            }
+        }
+        core_ticks += slowest;
+        total_out += n_out;
+
+        if(num_groups == 1)
+        {
+            ref_n_out[b] = n_out;
+            ref_hash[b] = hash_block(out, n_out * num_chans);
+        }
+        else
+        {
+            xassert(n_out == ref_n_out[b]);
+            xassert(hash_block(out, n_out * num_chans) == ref_hash[b]);
+        }
+    }
+
+    // Cycles per input sample of each channel, over all cores, and per core for the slowest group
+    unsigned total_cycles_per_samp_x100 = (uint64_t)total_ticks * CYCLES_PER_TICK * 100 / (NUM_BLOCKS * BLOCK_LENGTH * num_chans);
+    unsigned core_cycles_per_samp_x100 = (uint64_t)core_ticks * CYCLES_PER_TICK * 100 / (NUM_BLOCKS * BLOCK_LENGTH);
+    printf("%6u -> %6u Hz, %u chans, %u groups: %u.%02u cycles per channel sample, %u.%02u cycles per frame on the slowest core, %u output samples\n",
+           r->fs_in, r->fs_out, num_chans, num_groups,
+           total_cycles_per_samp_x100 / 100, total_cycles_per_samp_x100 % 100,
+           core_cycles_per_samp_x100 / 100, core_cycles_per_samp_x100 % 100,
+           total_out);
+}
+
+int main(int argc, char** argv)
+{
+    static const unsigned num_chans[] = {2, 4, 8};
+    static const unsigned num_groups[] = {1, 2, 4};
+
+    for(int r=0; r<sizeof(rates) / sizeof(rates[0]); r++)
+    {
+        for(int c=0; c<sizeof(num_chans) / sizeof(num_chans[0]); c++)
+        {
+            for(int g=0; g<sizeof(num_groups) / sizeof(num_groups[0]); g++)
+            {
+                if(num_groups[g] <= num_chans[c])
+                {
+                    run(&rates[r], num_chans[c], num_groups[g]);
+                }
+            }
+        }
+    }
+
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,332 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <math.h>
+
+#include "rate_control.h"
+#include "avg_buffer_level.h"
+#include "pseudo_rand.h"
+
+#define xassert assert
+
+// Tests of the rate controller, against a model of the USB -> ASRC -> (buffer) -> I2S direction.
+//
+// As in the simulator, a block of USB_BLOCK samples is converted every 2ms, the buffer level average is updated
+// after every block and the controller runs after every UPDATE_BLOCKS blocks. The ratio measurement has an offset
+// and jitter. The metrics are those printed by the simulator: the lock time, after which the average level stays
+// within LOCK_BAND of the stable level, and the largest excursion of the average from the stable level.
+
+#define USB_RATE        (48000)
+#define USB_DRIFT_PPM   (10)
+#define USB_BLOCK       (96)
+#define UPDATE_BLOCKS   (16)
+#define START_LEVEL     (300)
+#define LOCK_BAND       (4)
+#define Q60             ((double)((uint64_t)1 << 60))
+
+typedef struct
+{
+    double lock_time;       // Seconds from the stable level to the last time the average was out of the band
+    int max_excursion;      // Largest |average - stable level| once stable
+    int final_error;        // Average - stable level at the end
+    double ratio_jitter;    // RMS error of the applied ratio from the true ratio, in ppm, over the last half
+}metrics_t;
+
+typedef struct
+{
+    double t;
+    double written;
+    double read;
+    double ratio;
+    unsigned seed;
+    uint32_t block;
+    buffer_calc_state_t buf_state;
+}plant_t;
+
+// The Kp of the P engine, from rate_server.h
+#define KP_I2S_BUF_CONTROL_FS48     (SW_PLL_Q24(11.542724608))      // 0.000000043 * (2**28)
+#define KP_I2S_BUF_CONTROL_FS96     (SW_PLL_Q24(5.905580032))       // 0.000000022 * (2**28)
+#define KP_I2S_BUF_CONTROL_FS192    (SW_PLL_Q24(3.2749125632))      // 0.0000000122 * (2**28)
+
+static void get_gains(uint32_t fs_out, rate_control_mode_t mode, rate_control_gains_t *gains)
+{
+    sw_pll_q24_t Kp = (fs_out <= 48000) ? KP_I2S_BUF_CONTROL_FS48 : (fs_out <= 96000) ? KP_I2S_BUF_CONTROL_FS96 : KP_I2S_BUF_CONTROL_FS192;
+    rate_control_gains_from_kp(Kp, mode, gains);
+}
+
+static void plant_init(plant_t *p, uint32_t fs_out)
+{
+    memset(p, 0, sizeof(plant_t));
+    p->ratio = (double)USB_RATE / fs_out;
+    p->seed = 1;
+    init_calc_buffer_level_state(&p->buf_state, 10, 8);
+}
+
+static inline int plant_level_error(const plant_t *p)
+{
+    return p->buf_state.avg_buffer_level - p->buf_state.stable_avg_level;
+}
+
+// Run the plant and the controller for a number of seconds
+static void plant_run(plant_t *p, rate_control_t *rc, uint32_t fs_out, double bias_ppm, double jitter_ppm, double seconds, metrics_t *m)
+{
+    const double usb_rate = USB_RATE * (1 + USB_DRIFT_PPM * 1e-6);
+    const double true_ratio = usb_rate / fs_out;
+    const double dt = USB_BLOCK / usb_rate;
+    const double t_end = p->t + seconds;
+    const double t_jitter = p->t + seconds / 2;
+    double stable_t = -1;
+    double sq_sum = 0;
+    unsigned sq_count = 0;
+
+    memset(m, 0, sizeof(metrics_t));
+    while(p->t < t_end)
+    {
+        p->t += dt;
+        p->written += USB_BLOCK / p->ratio;
+        p->read += fs_out * dt;
+        int level = START_LEVEL + (int)floor(p->written) - (int)floor(p->read);
+        calc_avg_buffer_level(&p->buf_state, level, false);
+
+        if(p->buf_state.flag_stable_avg)
+        {
+            if(stable_t < 0)
+            {
+                stable_t = p->t;
+            }
+            int err = abs(plant_level_error(p));
+            if(err > m->max_excursion)
+            {
+                m->max_excursion = err;
+            }
+            if(err > LOCK_BAND)
+            {
+                m->lock_time = p->t - stable_t;
+            }
+        }
+
+        if(++p->block % UPDATE_BLOCKS == 0)
+        {
+            double jitter = jitter_ppm * (2 * (double)pseudo_rand_uint32(&p->seed) / UINT32_MAX - 1);
+            double measured = true_ratio * (1 + (bias_ppm + jitter) * 1e-6);
+            uint64_t ratio = rate_control_update(rc, (uint64_t)(measured * Q60), p->buf_state.flag_stable_avg,
+                                                 plant_level_error(p), p->buf_state.avg_count);
+            p->ratio = ratio / Q60;
+
+            if(p->t > t_jitter)
+            {
+                double err_ppm = (p->ratio / true_ratio - 1) * 1e6;
+                sq_sum += err_ppm * err_ppm;
+                sq_count++;
+            }
+        }
+    }
+    m->final_error = plant_level_error(p);
+    m->ratio_jitter = sqrt(sq_sum / sq_count);
+}
+
+static void run_scenario(rate_control_mode_t mode, uint32_t fs_out, double bias_ppm, double jitter_ppm, double seconds, metrics_t *m)
+{
+    plant_t p;
+    rate_control_t rc;
+    rate_control_gains_t gains;
+
+    get_gains(fs_out, mode, &gains);
+    plant_init(&p, fs_out);
+    rate_control_init(&rc, mode, fs_out, &gains);
+    plant_run(&p, &rc, fs_out, bias_ppm, jitter_ppm, seconds, m);
+}
+
+// The P engine must compute the correction of the original rate_server.c code
+void test_p_matches_original(unsigned seed, bool verbose)
+{
+    rate_control_t rc;
+    rate_control_gains_t gains;
+
+    get_gains(48000, RATE_CONTROL_P, &gains);
+    rate_control_init(&rc, RATE_CONTROL_P, 48000, &gains);
+    for(int itt=0; itt<(1<<12); itt++)
+    {
+        uint64_t measured = ((uint64_t)1 << 60) + pseudo_rand_int(&seed, -(1 << 30), 1 << 30);
+        int32_t level_error = pseudo_rand_int(&seed, -1000, 1000);
+        bool stable = pseudo_rand_int(&seed, 0, 4) != 0;
+
+        int64_t total_error = 0;
+        if(stable)
+        {
+            int64_t max_allowed_correction = (int64_t)1500 << 32;
+            int64_t error_p = ((int64_t)gains.Kp * (int64_t)level_error);
+            total_error = (int64_t)(error_p << 8);
+            if(total_error > max_allowed_correction)
+            {
+                total_error = max_allowed_correction;
+            }
+            else if(total_error < -(max_allowed_correction))
+            {
+                total_error = -(max_allowed_correction);
+            }
+        }
+        uint64_t ratio = rate_control_update(&rc, measured, stable, level_error, itt);
+        xassert(ratio == measured + total_error);
+    }
+    if(verbose)
+    {
+        printf("P engine matches the original controller\n");
+    }
+}
+
+// Lock time and excursion with an offset in the measured ratio, that P alone leaves as a level offset
+void test_lock(bool verbose)
+{
+    static const uint32_t rates[] = {44100, 48000, 96000, 192000};
+    static const rate_control_mode_t modes[] = {RATE_CONTROL_P, RATE_CONTROL_PI, RATE_CONTROL_PID, RATE_CONTROL_PI_EST};
+    static const char *names[] = {"P", "PI", "PID", "PI_EST"};
+    const double bias_ppm = 3;
+    const double seconds = 1200;
+
+    for(unsigned r=0; r<sizeof(rates) / sizeof(rates[0]); r++)
+    {
+        for(unsigned i=0; i<sizeof(modes) / sizeof(modes[0]); i++)
+        {
+            metrics_t m;
+            run_scenario(modes[i], rates[r], bias_ppm, 10, seconds, &m);
+            if(verbose)
+            {
+                printf("%6u Hz %-6s: lock time %6.1f s, max excursion %3d, final error %3d, ratio jitter %.2f ppm\n",
+                       (unsigned)rates[r], names[i], m.lock_time, m.max_excursion, m.final_error, m.ratio_jitter);
+            }
+            if(modes[i] == RATE_CONTROL_P)
+            {
+                // Never locks. The offset is bias / Kp.
+                xassert(m.lock_time > seconds - 60);
+                xassert(abs(m.final_error) > 40);
+            }
+            else
+            {
+                xassert(m.lock_time < 300);
+                xassert(m.max_excursion <= 8);
+                xassert(abs(m.final_error) <= 2);
+            }
+        }
+    }
+}
+
+// The estimator filters the jitter of the measured ratio out of the applied ratio
+void test_estimator(bool verbose)
+{
+    metrics_t pi, pi_est;
+    run_scenario(RATE_CONTROL_PI, 48000, 0, 50, 600, &pi);
+    run_scenario(RATE_CONTROL_PI_EST, 48000, 0, 50, 600, &pi_est);
+    if(verbose)
+    {
+        printf("50 ppm measurement jitter: ratio jitter PI %.2f ppm, PI_EST %.2f ppm, max excursion PI %d, PI_EST %d\n",
+               pi.ratio_jitter, pi_est.ratio_jitter, pi.max_excursion, pi_est.max_excursion);
+    }
+    xassert(pi_est.ratio_jitter < pi.ratio_jitter / 4);
+    xassert(pi_est.max_excursion <= pi.max_excursion);
+}
+
+// The integral stops at the correction limit and the correction leaves saturation as soon as the error reverses
+void test_anti_windup(bool verbose)
+{
+    const uint64_t measured = (uint64_t)1 << 60;
+    rate_control_t rc;
+    rate_control_gains_t gains;
+    uint32_t avg_count = 0;
+
+    get_gains(48000, RATE_CONTROL_PI, &gains);
+    rate_control_init(&rc, RATE_CONTROL_PI, 48000, &gains);
+
+    // An error large enough to saturate the correction with P alone
+    for(int i=0; i<1000; i++)
+    {
+        uint64_t ratio = rate_control_update(&rc, measured, true, 1000, ++avg_count);
+        xassert(ratio <= measured + RATE_CONTROL_MAX_CORRECTION);
+    }
+    xassert(rc.correction == RATE_CONTROL_MAX_CORRECTION);
+    // The integral didn't wind up past the first window
+    xassert(rc.integral == ((int64_t)gains.Ki * 1000) << 8);
+
+    uint64_t ratio = rate_control_update(&rc, measured, true, -1, ++avg_count);
+    xassert(ratio < measured + ((int64_t)gains.Ki * 1000 << 8));
+
+    // Without the P term holding the correction at the limit, the integral stops within a step of the limit
+    rate_control_init(&rc, RATE_CONTROL_PI, 48000, &gains);
+    rc.gains.Kp = 0;
+    const int64_t step = ((int64_t)gains.Ki * 1000) << 8;
+    for(int i=0; i<100000; i++)
+    {
+        rate_control_update(&rc, measured, true, 1000, ++avg_count);
+        xassert(rc.integral < RATE_CONTROL_MAX_CORRECTION + step);
+    }
+    xassert(rc.correction == RATE_CONTROL_MAX_CORRECTION);
+    if(verbose)
+    {
+        printf("Anti-windup ok\n");
+    }
+}
+
+// Switching engine on a locked loop doesn't step the ratio, and a rate change keeps the relative correction
+void test_bumpless(bool verbose)
+{
+    static const rate_control_mode_t modes[] = {RATE_CONTROL_PI, RATE_CONTROL_PID, RATE_CONTROL_PI_EST, RATE_CONTROL_PI};
+    plant_t p;
+    rate_control_t rc;
+    rate_control_gains_t gains;
+    metrics_t m;
+
+    get_gains(48000, RATE_CONTROL_P, &gains);
+    plant_init(&p, 48000);
+    rate_control_init(&rc, RATE_CONTROL_P, 48000, &gains);
+    plant_run(&p, &rc, 48000, 3, 10, 600, &m);
+
+    for(unsigned i=0; i<sizeof(modes) / sizeof(modes[0]); i++)
+    {
+        int64_t before = rc.correction;
+        get_gains(48000, modes[i], &gains);
+        rate_control_set_rate(&rc, 48000, &gains);
+        rate_control_set_mode(&rc, modes[i]);
+        // Same level error as the last update
+        uint64_t ratio = rate_control_update(&rc, (uint64_t)(p.ratio * Q60), true, plant_level_error(&p), p.buf_state.avg_count);
+        double step_ppm = fabs((double)(rc.correction - before) / Q60 / p.ratio) * 1e6;
+        if(verbose)
+        {
+            printf("Switch to engine %d: correction step %.4f ppm\n", modes[i], step_ppm);
+        }
+        xassert(step_ppm < 0.001);
+        p.ratio = ratio / Q60;
+        plant_run(&p, &rc, 48000, 3, 10, 300, &m);
+    }
+    xassert(abs(m.final_error) <= 2);
+
+    // On a rate change the integral keeps the same correction relative to the nominal ratio
+    int64_t integral = rc.integral;
+    get_gains(96000, RATE_CONTROL_PI, &gains);
+    rate_control_set_rate(&rc, 96000, &gains);
+    xassert(llabs(rc.integral - integral / 2) <= 1);
+    xassert(rc.flag_est_valid == false);
+    xassert(rc.flag_prev_error_valid == false);
+    if(verbose)
+    {
+        printf("Bumpless transfer ok\n");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bool verbose = argc > 1 && (strcmp(argv[1], "-v") == 0);
+
+    test_p_matches_original(1, verbose);
+    test_anti_windup(verbose);
+    test_lock(verbose);
+    test_estimator(verbose);
+    test_bumpless(verbose);
+
+    printf("PASS\n");
+    return 0;
+}
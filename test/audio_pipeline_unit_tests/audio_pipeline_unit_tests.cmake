@@ -0,0 +1,100 @@
+set(AUDIO_PIPELINES_PATH ${CMAKE_CURRENT_LIST_DIR}/../../modules/audio_pipelines)
+set(PROFILING_PATH ${CMAKE_CURRENT_LIST_DIR}/../../modules/profiling)
+set(AUDIO_PIPELINE_UNIT_TESTS_PATH ${CMAKE_CURRENT_LIST_DIR})
+
+## Add test_<NAME>, built from src/test_<NAME>.c and SOURCES, for the xcore
+## or the host
+##   SOURCES            Sources under test
+##   INCLUDES           Include directories, after src
+##   X86_LIBRARIES      Libraries linked for the host only
+function(audio_pipeline_unit_test NAME)
+    cmake_parse_arguments(ARG "" "" "SOURCES;INCLUDES;X86_LIBRARIES" ${ARGN})
+    set(TARGET_NAME test_${NAME})
+
+    add_executable(${TARGET_NAME}
+        ${AUDIO_PIPELINE_UNIT_TESTS_PATH}/src/${TARGET_NAME}.c
+        ${ARG_SOURCES}
+    )
+
+    target_include_directories(${TARGET_NAME}
+        PRIVATE
+            ${AUDIO_PIPELINE_UNIT_TESTS_PATH}/src
+            ${ARG_INCLUDES}
+    )
+
+    if(${CMAKE_SYSTEM_NAME} STREQUAL XCORE_XS3A)
+        target_compile_options(${TARGET_NAME}
+            PRIVATE "-target=XCORE-AI-EXPLORER")
+
+        target_link_options(${TARGET_NAME}
+            PRIVATE
+                "-target=XCORE-AI-EXPLORER"
+                "-report")
+    else()
+        target_compile_definitions(${TARGET_NAME} PRIVATE X86_BUILD=1)
+        if(ARG_X86_LIBRARIES)
+            target_link_libraries(${TARGET_NAME} PRIVATE ${ARG_X86_LIBRARIES})
+        endif()
+    endif()
+endfunction()
+
+foreach(TEST_NAME frame_pool frame_transport pipeline_graph)
+    audio_pipeline_unit_test(${TEST_NAME}
+        SOURCES ${AUDIO_PIPELINES_PATH}/common/${TEST_NAME}.c
+        INCLUDES ${AUDIO_PIPELINES_PATH}/common
+    )
+endforeach()
+
+## The delay buffer is built against a stub of the pipeline config so that it
+## does not need the voice libraries
+audio_pipeline_unit_test(delay_buffer
+    SOURCES
+        ${AUDIO_PIPELINES_PATH}/reference/aec/delay_buffer.c
+    INCLUDES
+        ${AUDIO_PIPELINE_UNIT_TESTS_PATH}/src/stubs
+        ${AUDIO_PIPELINES_PATH}/reference/aec
+)
+
+## The frame trace records its statistics in profiling probes, which are
+## compiled in with appconfPROFILE_ENABLED. The host has no reference timer
+## header for the profiling macros, so it gets one from src/x86.
+audio_pipeline_unit_test(frame_trace
+    SOURCES
+        ${AUDIO_PIPELINES_PATH}/common/frame_trace.c
+        ${AUDIO_PIPELINES_PATH}/common/pipeline_graph.c
+        ${PROFILING_PATH}/profile.c
+    INCLUDES
+        ${AUDIO_PIPELINES_PATH}/common
+        ${PROFILING_PATH}
+)
+
+target_compile_definitions(test_frame_trace PRIVATE appconfPROFILE_ENABLED=1)
+if(NOT ${CMAKE_SYSTEM_NAME} STREQUAL XCORE_XS3A)
+    target_include_directories(test_frame_trace PRIVATE ${AUDIO_PIPELINE_UNIT_TESTS_PATH}/src/x86)
+endif()
+
+## The AEC idle gate does not depend on the AEC library
+audio_pipeline_unit_test(aec_idle_gate
+    SOURCES
+        ${AUDIO_PIPELINES_PATH}/reference/aec/aec_idle_gate.c
+    INCLUDES
+        ${AUDIO_PIPELINES_PATH}/reference/aec
+)
+
+## The delay estimator is independent of the AEC library and of the OS
+audio_pipeline_unit_test(delay_estimator
+    SOURCES
+        ${AUDIO_PIPELINES_PATH}/reference/aec/delay_estimator.c
+    INCLUDES
+        ${AUDIO_PIPELINES_PATH}/reference/aec
+    X86_LIBRARIES
+        m
+)
+
+## The stage block adapter is independent of the DSP libraries and of the OS
+audio_pipeline_unit_test(stage_blocks
+    SOURCES
+        ${AUDIO_PIPELINES_PATH}/common/stage_blocks.c
+    INCLUDES
+        ${AUDIO_PIPELINES_PATH}/common
+)
@@ -0,0 +1,18 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef AUDIO_PIPELINE_DSP_H_
+#define AUDIO_PIPELINE_DSP_H_
+
+/* The subset of the ADEC pipeline config used by delay_buffer.c */
+
+#include <stdint.h>
+
+#define AP_FRAME_ADVANCE (240)
+
+/* Delay buffer config */
+#define MAX_DELAY_BUF_CHANNELS (2)
+#define DELAY_BUF_MAX_DELAY_MS                ( 150 )
+#define DELAY_BUF_MAX_DELAY_SAMPLES           ( 16000*DELAY_BUF_MAX_DELAY_MS/1000 )
+
+#endif /* AUDIO_PIPELINE_DSP_H_ */
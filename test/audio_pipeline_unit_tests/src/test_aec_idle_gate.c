@@ -0,0 +1,150 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#if !X86_BUILD
+    #include <platform.h>
+    #include <xs1.h>
+    #include <xcore/assert.h>
+#else
+    #include <assert.h>
+    #define xassert assert
+#endif
+#include "aec_idle_gate.h"
+
+#define TEST_HOLD_FRAMES    (10)
+#define TEST_ITERATIONS     (1000)
+
+/* Reference levels relative to the gate thresholds */
+typedef enum {
+    LEVEL_QUIET,    // Below the hold threshold
+    LEVEL_BAND,     // Between the hold and resume thresholds
+    LEVEL_ACTIVE,   // Above the resume threshold
+} test_level_t;
+
+/* Compare the level against the threshold the gate asks for, as the pipelines
+ * do, and update the gate */
+static int gate_frame(aec_idle_gate_t *gate, test_level_t level)
+{
+    int ref_present = aec_idle_gate_is_idle(gate) ? (level == LEVEL_ACTIVE) : (level != LEVEL_QUIET);
+    return aec_idle_gate_update(gate, ref_present);
+}
+
+void test_hold_and_resume(bool verbose)
+{
+    aec_idle_gate_t gate;
+
+    aec_idle_gate_init(&gate, TEST_HOLD_FRAMES);
+    xassert(!aec_idle_gate_is_idle(&gate));
+
+    /* The AEC runs through the hold time */
+    for (int i = 0; i < TEST_HOLD_FRAMES - 1; i++) {
+        xassert(gate_frame(&gate, LEVEL_QUIET) == 1);
+    }
+    /* Activity restarts the hold time */
+    xassert(gate_frame(&gate, LEVEL_ACTIVE) == 1);
+    for (int i = 0; i < TEST_HOLD_FRAMES - 1; i++) {
+        xassert(gate_frame(&gate, LEVEL_QUIET) == 1);
+    }
+    xassert(gate_frame(&gate, LEVEL_QUIET) == 0);
+    xassert(aec_idle_gate_is_idle(&gate));
+
+    for (int i = 0; i < 100; i++) {
+        xassert(gate_frame(&gate, LEVEL_QUIET) == 0);
+    }
+
+    /* Resumes on the first active frame */
+    xassert(gate_frame(&gate, LEVEL_ACTIVE) == 1);
+    xassert(gate.stats.resume_count == 1);
+    xassert(gate.stats.idle_frames == 101);
+    xassert(gate.stats.active_frames == 2 * TEST_HOLD_FRAMES);
+
+    if (verbose) {
+        printf("active=%u idle=%u resumes=%u\n", (unsigned)gate.stats.active_frames,
+               (unsigned)gate.stats.idle_frames, (unsigned)gate.stats.resume_count);
+    }
+}
+
+void test_hysteresis(bool verbose)
+{
+    aec_idle_gate_t gate;
+
+    /* A reference between the thresholds keeps the gate in its state */
+    aec_idle_gate_init(&gate, TEST_HOLD_FRAMES);
+    for (int i = 0; i < TEST_ITERATIONS; i++) {
+        xassert(gate_frame(&gate, LEVEL_BAND) == 1);
+    }
+    for (int i = 0; i < TEST_HOLD_FRAMES; i++) {
+        gate_frame(&gate, LEVEL_QUIET);
+    }
+    xassert(aec_idle_gate_is_idle(&gate));
+    for (int i = 0; i < TEST_ITERATIONS; i++) {
+        xassert(gate_frame(&gate, LEVEL_BAND) == 0);
+    }
+
+    /* A reference around the resume threshold does not toggle the gate,
+     * since going idle again needs the hold time below the hold threshold */
+    aec_idle_gate_init(&gate, TEST_HOLD_FRAMES);
+    srand(1);
+    for (int i = 0; i < TEST_ITERATIONS; i++) {
+        gate_frame(&gate, (rand() & 1) ? LEVEL_ACTIVE : LEVEL_BAND);
+    }
+    xassert(gate.stats.idle_frames == 0);
+
+    /* Noise around the hold threshold does not resume an idle gate */
+    aec_idle_gate_init(&gate, TEST_HOLD_FRAMES);
+    for (int i = 0; i < TEST_ITERATIONS; i++) {
+        gate_frame(&gate, (rand() & 1) ? LEVEL_QUIET : LEVEL_BAND);
+    }
+    xassert(gate.stats.resume_count == 0);
+
+    if (verbose) {
+        printf("hysteresis OK\n");
+    }
+}
+
+void test_reset(bool verbose)
+{
+    aec_idle_gate_t gate;
+
+    aec_idle_gate_init(&gate, 0);
+    xassert(gate_frame(&gate, LEVEL_QUIET) == 0);
+
+    /* A reset gate runs the AEC without counting a resume, and the hold time
+     * starts again */
+    aec_idle_gate_init(&gate, TEST_HOLD_FRAMES);
+    for (int i = 0; i < TEST_HOLD_FRAMES; i++) {
+        gate_frame(&gate, LEVEL_QUIET);
+    }
+    xassert(aec_idle_gate_is_idle(&gate));
+    aec_idle_gate_reset(&gate);
+    xassert(!aec_idle_gate_is_idle(&gate));
+    for (int i = 0; i < TEST_HOLD_FRAMES - 1; i++) {
+        xassert(gate_frame(&gate, LEVEL_QUIET) == 1);
+    }
+    xassert(gate_frame(&gate, LEVEL_QUIET) == 0);
+    xassert(gate.stats.resume_count == 0);
+    xassert(gate.stats.idle_frames == 2);
+
+    if (verbose) {
+        printf("reset OK\n");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    bool verbose = false;
+
+    test_hold_and_resume(verbose);
+
+    test_hysteresis(verbose);
+
+    test_reset(verbose);
+
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,214 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#if !X86_BUILD
+    #include <platform.h>
+    #include <xs1.h>
+    #include <xcore/assert.h>
+    #include <xcore/hwtimer.h>
+    #define TICKS_PER_US    (100)
+    static uint32_t now_ticks(void) { return get_reference_time(); }
+#else
+    #include <assert.h>
+    #include <time.h>
+    #define xassert assert
+    #define TICKS_PER_US    (1000)
+    static uint32_t now_ticks(void)
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint32_t)((ts.tv_sec * 1000000000ull) + ts.tv_nsec);
+    }
+#endif
+#include "delay_buffer.h"
+
+#define TEST_FRAMES     (2000)
+
+static delay_buf_state_t ref_state;
+static delay_buf_state_t dut_state;
+
+static int32_t ref_frame[MAX_DELAY_BUF_CHANNELS][AP_FRAME_ADVANCE];
+static int32_t dut_frame[MAX_DELAY_BUF_CHANNELS][AP_FRAME_ADVANCE];
+
+static int32_t random_delay(void)
+{
+    /* Mostly realistic delays, with the extremes and negative delays exercised too */
+    switch (rand() % 8) {
+    case 0:  return 0;
+    case 1:  return DELAY_BUF_MAX_DELAY_SAMPLES;
+    case 2:  return DELAY_BUF_MAX_DELAY_SAMPLES - 1 - (rand() % AP_FRAME_ADVANCE);
+    case 3:  return -(rand() % DELAY_BUF_MAX_DELAY_SAMPLES);
+    default: return rand() % DELAY_BUF_MAX_DELAY_SAMPLES;
+    }
+}
+
+static void fill_frame(void)
+{
+    for (int ch = 0; ch < MAX_DELAY_BUF_CHANNELS; ch++) {
+        for (int i = 0; i < AP_FRAME_ADVANCE; i++) {
+            ref_frame[ch][i] = (int32_t)(((uint32_t)rand() << 16) ^ (uint32_t)rand());
+        }
+    }
+    memcpy(dut_frame, ref_frame, sizeof(ref_frame));
+}
+
+void test_block_matches_per_sample(bool verbose)
+{
+    /* get_delayed_block() must be bit exact with get_delayed_sample(),
+     * including across delay changes and partial buffer resets */
+    delay_buffer_init(&ref_state, 0);
+    delay_buffer_init(&dut_state, 0);
+
+    for (int frame = 0; frame < TEST_FRAMES; frame++) {
+        if ((frame % 50) == 0) {
+            int32_t delay = random_delay();
+            update_delay_samples(&ref_state, delay);
+            update_delay_samples(&dut_state, delay);
+            for (int ch = 0; ch < MAX_DELAY_BUF_CHANNELS; ch++) {
+                reset_partial_delay_buffer(&ref_state, ch);
+                reset_partial_delay_buffer(&dut_state, ch);
+            }
+        }
+
+        fill_frame();
+
+        /* Odd sized blocks so that the write index is not always frame aligned */
+        int32_t len = (frame % 7 == 0) ? (AP_FRAME_ADVANCE - 13) : AP_FRAME_ADVANCE;
+        for (int ch = 0; ch < MAX_DELAY_BUF_CHANNELS; ch++) {
+            for (int i = 0; i < len; i++) {
+                get_delayed_sample(&ref_state, &ref_frame[ch][i], ch);
+            }
+            get_delayed_block(&dut_state, dut_frame[ch], len, ch);
+        }
+
+        xassert(memcmp(ref_frame, dut_frame, sizeof(ref_frame)) == 0);
+        xassert(memcmp(ref_state.curr_idx, dut_state.curr_idx, sizeof(ref_state.curr_idx)) == 0);
+    }
+    xassert(memcmp(ref_state.delay_buffer, dut_state.delay_buffer, sizeof(ref_state.delay_buffer)) == 0);
+    (void)verbose;
+}
+
+void test_write_read_spans(bool verbose)
+{
+    /* A separate write and delayed read gives the same result as get_delayed_block() */
+    delay_buffer_init(&ref_state, 0);
+    delay_buffer_init(&dut_state, 0);
+
+    for (int frame = 0; frame < TEST_FRAMES; frame++) {
+        if ((frame % 50) == 0) {
+            int32_t delay = rand() % (DELAY_BUF_MAX_DELAY_SAMPLES - AP_FRAME_ADVANCE);
+            update_delay_samples(&ref_state, delay);
+            update_delay_samples(&dut_state, delay);
+        }
+
+        fill_frame();
+
+        get_delayed_block(&ref_state, ref_frame[0], AP_FRAME_ADVANCE, 0);
+        delay_buffer_write_block(&dut_state, dut_frame[0], AP_FRAME_ADVANCE, 0);
+        delay_buffer_read_block(&dut_state, dut_frame[0], AP_FRAME_ADVANCE, 0);
+        xassert(memcmp(ref_frame[0], dut_frame[0], sizeof(ref_frame[0])) == 0);
+
+        /* The spans of the same samples are no more than two and hold the same data */
+        delay_buf_spans_t spans;
+        delay_buffer_get_spans(&dut_state, &spans, AP_FRAME_ADVANCE, dut_state.delay_samples, 0);
+        xassert(spans.len[0] + spans.len[1] == AP_FRAME_ADVANCE);
+        xassert(memcmp(spans.data[0], dut_frame[0], spans.len[0] * sizeof(int32_t)) == 0);
+        if (spans.len[1]) {
+            xassert(spans.data[1] == &dut_state.delay_buffer[0][0]);
+            xassert(memcmp(spans.data[1], &dut_frame[0][spans.len[0]], spans.len[1] * sizeof(int32_t)) == 0);
+        }
+    }
+    (void)verbose;
+}
+
+void test_fractional_delay(bool verbose)
+{
+    /* A fractional delay interpolates between the integer delays either side of it */
+    const int32_t frac = 1 << (DELAY_BUF_FRAC_BITS - 2);
+    static delay_buf_state_t next_state;
+    int32_t next_frame[AP_FRAME_ADVANCE];
+
+    delay_buffer_init(&ref_state, 0);
+    delay_buffer_init(&next_state, 0);
+    delay_buffer_init(&dut_state, 0);
+
+    for (int frame = 0; frame < TEST_FRAMES; frame++) {
+        if ((frame % 50) == 0) {
+            int32_t delay = rand() % (DELAY_BUF_MAX_DELAY_SAMPLES - 1);
+            update_delay_samples(&ref_state, delay);
+            update_delay_samples(&next_state, delay + 1);
+            update_delay_samples(&dut_state, delay);
+            update_fractional_delay(&dut_state, frac);
+        }
+
+        fill_frame();
+        memcpy(next_frame, ref_frame[0], sizeof(next_frame));
+
+        get_delayed_block(&ref_state, ref_frame[0], AP_FRAME_ADVANCE, 0);
+        get_delayed_block(&next_state, next_frame, AP_FRAME_ADVANCE, 0);
+        get_delayed_block(&dut_state, dut_frame[0], AP_FRAME_ADVANCE, 0);
+
+        for (int i = 0; i < AP_FRAME_ADVANCE; i++) {
+            int64_t expected = ref_frame[0][i] + ((((int64_t)next_frame[i] - ref_frame[0][i]) * frac) >> DELAY_BUF_FRAC_BITS);
+            xassert(dut_frame[0][i] == expected);
+        }
+    }
+    (void)verbose;
+}
+
+void test_cycles(bool verbose)
+{
+    /* Compare the cost of delaying one 2 channel frame */
+    uint32_t sample_ticks = 0;
+    uint32_t block_ticks = 0;
+
+    delay_buffer_init(&ref_state, 1000);
+    delay_buffer_init(&dut_state, 1000);
+
+    for (int frame = 0; frame < TEST_FRAMES; frame++) {
+        fill_frame();
+
+        uint32_t start = now_ticks();
+        for (int ch = 0; ch < MAX_DELAY_BUF_CHANNELS; ch++) {
+            for (int i = 0; i < AP_FRAME_ADVANCE; i++) {
+                get_delayed_sample(&ref_state, &ref_frame[ch][i], ch);
+            }
+        }
+        uint32_t mid = now_ticks();
+        for (int ch = 0; ch < MAX_DELAY_BUF_CHANNELS; ch++) {
+            get_delayed_block(&dut_state, dut_frame[ch], AP_FRAME_ADVANCE, ch);
+        }
+        uint32_t end = now_ticks();
+
+        sample_ticks += mid - start;
+        block_ticks += end - mid;
+    }
+
+    printf("delay 2ch frame: per sample %.3f us, block %.3f us\n",
+           (double)sample_ticks / TEST_FRAMES / TICKS_PER_US,
+           (double)block_ticks / TEST_FRAMES / TICKS_PER_US);
+    (void)verbose;
+}
+
+int main(int argc, char *argv[])
+{
+    bool verbose = false;
+
+    srand(1);
+
+    test_block_matches_per_sample(verbose);
+
+    test_write_read_spans(verbose);
+
+    test_fractional_delay(verbose);
+
+    test_cycles(verbose);
+
+    printf("PASS\n");
+    return 0;
+}
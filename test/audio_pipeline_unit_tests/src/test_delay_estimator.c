@@ -0,0 +1,231 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#if !X86_BUILD
+    #include <platform.h>
+    #include <xs1.h>
+    #include <xcore/assert.h>
+#else
+    #include <assert.h>
+    #define xassert assert
+#endif
+#include "delay_estimator.h"
+
+#define FRAME_ADVANCE       (240)
+#define INTERVAL_SAMPLES    (16000)
+#define MAX_LAG             (2400)
+#define HISTORY_LENGTH      (8192)
+#define NO_ECHO             (INT32_MAX)
+
+/* Half a decimated sample either side */
+#define LAG_TOLERANCE       (DELAY_ESTIMATOR_DECIMATION / 2)
+
+static const delay_estimator_config_t config = {
+    .min_lag = -MAX_LAG,
+    .max_lag = MAX_LAG,
+    .interval_samples = INTERVAL_SAMPLES,
+    .peak_ratio_threshold = 8.0f,
+    .smoothing = 0.5f,
+};
+
+static delay_estimator_t de;
+
+static int32_t noise(int32_t amplitude)
+{
+    return (int32_t)(((int64_t)(rand() % 65536) - 32768) * amplitude / 32768);
+}
+
+/* Reference of lowpass filtered noise, like speech or music in that most of
+ * its energy is at low frequencies, and a mic picking up its echo with the
+ * given delay, two reflections and near end noise. A lag of NO_ECHO gives a
+ * mic with only the noise. Frames are generated one at a time from a history
+ * of the reference. */
+typedef struct {
+    int32_t ref_history[HISTORY_LENGTH];
+    int idx;
+    float lp;
+} test_signal_t;
+
+static void test_signal_frame(test_signal_t *sig, int32_t lag, int32_t ref_amplitude, int32_t noise_amplitude,
+                              int32_t *mic, int32_t *ref)
+{
+    for (int i = 0; i < FRAME_ADVANCE; i++) {
+        sig->lp = 0.9f * sig->lp + 0.1f * (float)noise(ref_amplitude);
+        ref[i] = (int32_t)(sig->lp * 3);
+        sig->ref_history[sig->idx] = ref[i];
+
+        /* Negative lags put the echo ahead of the reference, so the reference
+         * is the one taken from the history */
+        int32_t direct = sig->ref_history[(sig->idx - (lag > 0 ? lag : 0) + HISTORY_LENGTH) % HISTORY_LENGTH];
+        int32_t reflection1 = sig->ref_history[(sig->idx - (lag > 0 ? lag : 0) - 37 + HISTORY_LENGTH) % HISTORY_LENGTH];
+        int32_t reflection2 = sig->ref_history[(sig->idx - (lag > 0 ? lag : 0) - 211 + HISTORY_LENGTH) % HISTORY_LENGTH];
+        mic[i] = noise(noise_amplitude);
+        if (lag != NO_ECHO) {
+            mic[i] += direct / 2 + reflection1 / 4 + reflection2 / 8;
+        }
+        if (lag < 0 && lag != NO_ECHO) {
+            ref[i] = sig->ref_history[(sig->idx + lag + HISTORY_LENGTH) % HISTORY_LENGTH];
+        }
+        sig->idx = (sig->idx + 1) % HISTORY_LENGTH;
+    }
+}
+
+/* Run until the given number of estimates have been made, processing each as
+ * it is due as a separate thread would. Returns the number of estimates made,
+ * which is less if the reference is not active enough. */
+static int run(test_signal_t *sig, int32_t lag, int32_t ref_amplitude, int32_t noise_amplitude,
+               int ref_active, int estimates, delay_estimate_t *last)
+{
+    int32_t mic[FRAME_ADVANCE];
+    int32_t ref[FRAME_ADVANCE];
+    int made = 0;
+    int frames = estimates * (INTERVAL_SAMPLES / FRAME_ADVANCE + 2);
+
+    for (int f = 0; f < frames && made < estimates; f++) {
+        test_signal_frame(sig, lag, ref_amplitude, noise_amplitude, mic, ref);
+        if (delay_estimator_push(&de, mic, ref, FRAME_ADVANCE, ref_active)) {
+            delay_estimator_process(&de);
+        }
+        if (delay_estimator_get(&de, last)) {
+            made++;
+        }
+    }
+    return made;
+}
+
+void test_lags(bool verbose)
+{
+    static test_signal_t sig;
+    const int32_t lags[] = {0, 5, 160, 1234, 2390, -3, -480, -2000};
+
+    for (int i = 0; i < (int)(sizeof(lags) / sizeof(lags[0])); i++) {
+        delay_estimate_t estimate;
+
+        memset(&sig, 0, sizeof(sig));
+        delay_estimator_init(&de, &config);
+        srand(i + 1);
+
+        /* The first estimate is never valid */
+        xassert(run(&sig, lags[i], 1 << 28, 1 << 22, 1, 1, &estimate) == 1);
+        xassert(!estimate.valid);
+        xassert(run(&sig, lags[i], 1 << 28, 1 << 22, 1, 2, &estimate) == 2);
+        xassert(estimate.valid);
+        xassert(abs(estimate.lag - lags[i]) <= LAG_TOLERANCE);
+
+        if (verbose) {
+            printf("lag %d: estimate %d peak ratio %.1f\n", (int)lags[i], (int)estimate.lag, estimate.peak_ratio);
+        }
+    }
+}
+
+void test_noise(bool verbose)
+{
+    static test_signal_t sig;
+    delay_estimate_t estimate;
+
+    /* Mic noise well above the echo still gives the delay */
+    memset(&sig, 0, sizeof(sig));
+    delay_estimator_init(&de, &config);
+    srand(10);
+    xassert(run(&sig, 800, 1 << 25, 1 << 27, 1, 4, &estimate) == 4);
+    xassert(estimate.valid);
+    xassert(abs(estimate.lag - 800) <= LAG_TOLERANCE);
+    if (verbose) {
+        printf("noisy: estimate %d peak ratio %.1f\n", (int)estimate.lag, estimate.peak_ratio);
+    }
+
+    /* Mic unrelated to the reference is not confident */
+    memset(&sig, 0, sizeof(sig));
+    delay_estimator_init(&de, &config);
+    srand(11);
+    xassert(run(&sig, NO_ECHO, 1 << 28, 1 << 27, 1, 4, &estimate) == 4);
+    xassert(!estimate.valid);
+    xassert(estimate.peak_ratio < config.peak_ratio_threshold);
+    if (verbose) {
+        printf("unrelated: peak ratio %.1f\n", estimate.peak_ratio);
+    }
+
+    /* No estimates while the reference is inactive, and a silent reference
+     * is not confident */
+    xassert(run(&sig, 800, 1 << 28, 1 << 22, 0, 4, &estimate) == 0);
+    memset(&sig, 0, sizeof(sig));
+    delay_estimator_init(&de, &config);
+    xassert(run(&sig, 800, 0, 1 << 22, 1, 2, &estimate) == 2);
+    xassert(!estimate.valid && estimate.peak_ratio == 0);
+}
+
+void test_delay_change(bool verbose)
+{
+    static test_signal_t sig;
+    delay_estimate_t estimate;
+    int estimates = 0;
+
+    memset(&sig, 0, sizeof(sig));
+    delay_estimator_init(&de, &config);
+    srand(20);
+    run(&sig, 300, 1 << 28, 1 << 22, 1, 3, &estimate);
+    xassert(estimate.valid && abs(estimate.lag - 300) <= LAG_TOLERANCE);
+
+    /* The smoothed cross spectrum follows a change in a few estimates */
+    do {
+        run(&sig, 1500, 1 << 28, 1 << 22, 1, 1, &estimate);
+        estimates++;
+        xassert(estimates < 6);
+    } while (!(estimate.valid && abs(estimate.lag - 1500) <= LAG_TOLERANCE));
+
+    if (verbose) {
+        printf("delay change followed after %d estimates\n", estimates);
+    }
+}
+
+void test_timing(bool verbose)
+{
+    static test_signal_t sig;
+    int32_t mic[FRAME_ADVANCE];
+    int32_t ref[FRAME_ADVANCE];
+
+    memset(&sig, 0, sizeof(sig));
+    delay_estimator_init(&de, &config);
+    test_signal_frame(&sig, 100, 1 << 28, 1 << 22, mic, ref);
+
+    clock_t start = clock();
+    for (int i = 0; i < 1000; i++) {
+        delay_estimator_push(&de, mic, ref, FRAME_ADVANCE, 1);
+        de.busy = 0;
+    }
+    clock_t push = clock() - start;
+
+    start = clock();
+    for (int i = 0; i < 100; i++) {
+        de.busy = 1;
+        delay_estimator_process(&de);
+    }
+    clock_t process = clock() - start;
+
+    if (verbose) {
+        printf("push %.2f us per frame, process %.1f us per estimate\n",
+               1e6 * push / CLOCKS_PER_SEC / 1000, 1e6 * process / CLOCKS_PER_SEC / 100);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    bool verbose = false;
+
+    test_lags(verbose);
+
+    test_noise(verbose);
+
+    test_delay_change(verbose);
+
+    test_timing(verbose);
+
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,242 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#if !X86_BUILD
+    #include <platform.h>
+    #include <xs1.h>
+    #include <xcore/assert.h>
+    #include <xcore/hwtimer.h>
+    #define TICKS_PER_US    (100)
+    static uint32_t now_ticks(void) { return get_reference_time(); }
+#else
+    #include <assert.h>
+    #include <time.h>
+    #define xassert assert
+    #define TICKS_PER_US    (1000)
+    static uint32_t now_ticks(void)
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint32_t)((ts.tv_sec * 1000000000ull) + ts.tv_nsec);
+    }
+#endif
+#include "frame_pool.h"
+
+/* Same size as the 2 channel, 240 sample reference pipeline frame_data_t */
+#define TEST_FRAME_SIZE     (3 * 2 * 240 * sizeof(int32_t) + 24)
+#define TEST_ITERATIONS     (1 << 14)
+
+/* uint64_t keeps the storage double word aligned */
+static uint64_t pool_storage[FRAME_POOL_STORAGE_SIZE(TEST_FRAME_SIZE, FRAME_POOL_MAX_DEPTH) / sizeof(uint64_t)];
+
+void test_exhaust_and_refill(bool verbose)
+{
+    frame_pool_t pool;
+    frame_pool_stats_t stats;
+    void *frames[FRAME_POOL_MAX_DEPTH];
+    void *frame;
+
+    for (uint32_t depth = 1; depth <= FRAME_POOL_MAX_DEPTH; depth++) {
+        frame_pool_init(&pool, pool_storage, TEST_FRAME_SIZE, depth);
+
+        for (uint32_t i = 0; i < depth; i++) {
+            frames[i] = frame_pool_alloc(&pool);
+            xassert(frames[i] != NULL);
+            xassert(frame_pool_owns(&pool, frames[i]));
+            xassert(((uintptr_t)frames[i] & 0x7) == 0);
+            for (uint32_t j = 0; j < i; j++) {
+                xassert(frames[i] != frames[j]);
+            }
+            /* Frames must not overlap */
+            memset(frames[i], (int)i, TEST_FRAME_SIZE);
+        }
+        for (uint32_t i = 0; i < depth; i++) {
+            xassert(((uint8_t *)frames[i])[0] == (uint8_t)i);
+            xassert(((uint8_t *)frames[i])[TEST_FRAME_SIZE - 1] == (uint8_t)i);
+        }
+
+        frame = frame_pool_alloc(&pool);
+        xassert(frame == NULL);
+
+        frame_pool_stats_get(&pool, &stats);
+        xassert(stats.depth == depth);
+        xassert(stats.in_use == depth);
+        xassert(stats.high_water_mark == depth);
+        xassert(stats.alloc_count == depth);
+        xassert(stats.alloc_fail_count == 1);
+
+        /* Release in reverse order, then everything must be available again */
+        for (int i = depth - 1; i >= 0; i--) {
+            frame_pool_release(&pool, frames[i]);
+        }
+        frame_pool_stats_get(&pool, &stats);
+        xassert(stats.in_use == 0);
+        xassert(stats.high_water_mark == depth);
+
+        for (uint32_t i = 0; i < depth; i++) {
+            frame = frame_pool_alloc(&pool);
+            xassert(frame != NULL);
+        }
+        frame = frame_pool_alloc(&pool);
+        xassert(frame == NULL);
+
+        if (verbose) {
+            printf("test_exhaust_and_refill: depth %u ok\n", depth);
+        }
+    }
+
+    int stack_var;
+    xassert(!frame_pool_owns(&pool, &stack_var));
+    xassert(!frame_pool_owns(&pool, (uint8_t *)pool_storage + 4));
+}
+
+void test_pipeline_pattern(bool verbose)
+{
+    /* Emulates a pipeline with a fixed number of frames in flight, where
+     * frames are released in the order they were allocated. The ring indices
+     * wrap many times over the run. */
+    const uint32_t depth = 8;
+    const uint32_t in_flight = 5;
+    frame_pool_t pool;
+    frame_pool_stats_t stats;
+    void *fifo[8];
+    uint32_t wr = 0, rd = 0;
+
+    frame_pool_init(&pool, pool_storage, TEST_FRAME_SIZE, depth);
+
+    for (uint32_t itt = 0; itt < TEST_ITERATIONS; itt++) {
+        void *frame = frame_pool_alloc(&pool);
+        xassert(frame != NULL);
+        *(uint32_t *)frame = itt;
+        fifo[wr++ % depth] = frame;
+
+        if (wr - rd == in_flight) {
+            void *done = fifo[rd % depth];
+            xassert(*(uint32_t *)done == rd);
+            rd++;
+            frame_pool_release(&pool, done);
+        }
+    }
+
+    frame_pool_stats_get(&pool, &stats);
+    if (verbose) {
+        printf("test_pipeline_pattern: in_use %u hwm %u allocs %u fails %u\n",
+               stats.in_use, stats.high_water_mark, stats.alloc_count, stats.alloc_fail_count);
+    }
+    xassert(stats.high_water_mark == in_flight);
+    xassert(stats.alloc_count == TEST_ITERATIONS);
+    xassert(stats.alloc_fail_count == 0);
+}
+
+void test_alloc_latency(bool verbose)
+{
+    /* The cost of an allocation must not depend on the pool depth or on how
+     * many frames are in use. Report the worst case for the smallest and
+     * largest pools, with the pool nearly full and nearly empty. */
+    frame_pool_t pool;
+    const uint32_t depths[] = {2, FRAME_POOL_MAX_DEPTH};
+
+    for (size_t d = 0; d < sizeof(depths) / sizeof(depths[0]); d++) {
+        uint32_t depth = depths[d];
+        uint32_t max_ticks = 0;
+        uint64_t total_ticks = 0;
+        void *held[FRAME_POOL_MAX_DEPTH];
+
+        frame_pool_init(&pool, pool_storage, TEST_FRAME_SIZE, depth);
+
+        for (uint32_t itt = 0; itt < TEST_ITERATIONS; itt++) {
+            uint32_t hold = itt % depth;
+            for (uint32_t i = 0; i < hold; i++) {
+                held[i] = frame_pool_alloc(&pool);
+            }
+
+            uint32_t start = now_ticks();
+            void *frame = frame_pool_alloc(&pool);
+            uint32_t ticks = now_ticks() - start;
+            xassert(frame != NULL);
+
+            total_ticks += ticks;
+            if (ticks > max_ticks) {
+                max_ticks = ticks;
+            }
+
+            frame_pool_release(&pool, frame);
+            for (uint32_t i = 0; i < hold; i++) {
+                frame_pool_release(&pool, held[i]);
+            }
+        }
+
+        printf("frame_pool_alloc: depth %2u avg %.3f us, max %.3f us\n", depth,
+               (double)total_ticks / TEST_ITERATIONS / TICKS_PER_US,
+               (double)max_ticks / TICKS_PER_US);
+    }
+    (void)verbose;
+}
+
+void test_alloc_vs_malloc(bool verbose)
+{
+    /* The pool replaces a heap allocation per frame, so it must be faster
+     * than malloc()/free() for the same pattern of frames held. Each pattern
+     * is timed as a whole, so the timer overhead is not counted per call. */
+    frame_pool_t pool;
+    void *held[FRAME_POOL_MAX_DEPTH];
+    uint32_t depth = FRAME_POOL_MAX_DEPTH;
+
+    frame_pool_init(&pool, pool_storage, TEST_FRAME_SIZE, depth);
+
+    uint32_t start = now_ticks();
+    for (uint32_t itt = 0; itt < TEST_ITERATIONS; itt++) {
+        uint32_t hold = 1 + itt % depth;
+        for (uint32_t i = 0; i < hold; i++) {
+            held[i] = frame_pool_alloc(&pool);
+            xassert(held[i] != NULL);
+        }
+        for (uint32_t i = 0; i < hold; i++) {
+            frame_pool_release(&pool, held[i]);
+        }
+    }
+    uint32_t pool_ticks = now_ticks() - start;
+
+    start = now_ticks();
+    for (uint32_t itt = 0; itt < TEST_ITERATIONS; itt++) {
+        uint32_t hold = 1 + itt % depth;
+        for (uint32_t i = 0; i < hold; i++) {
+            held[i] = malloc(TEST_FRAME_SIZE);
+            xassert(held[i] != NULL);
+            /* Touch the frame so that the allocation is not optimised out */
+            ((volatile uint8_t *)held[i])[0] = 0;
+        }
+        for (uint32_t i = 0; i < hold; i++) {
+            free(held[i]);
+        }
+    }
+    uint32_t malloc_ticks = now_ticks() - start;
+
+    if (verbose) {
+        printf("test_alloc_vs_malloc: frame_pool %.3f ms, malloc %.3f ms\n",
+               (double)pool_ticks / TICKS_PER_US / 1000,
+               (double)malloc_ticks / TICKS_PER_US / 1000);
+    }
+    xassert(pool_ticks < malloc_ticks);
+}
+
+int main(int argc, char *argv[])
+{
+    bool verbose = false;
+
+    test_exhaust_and_refill(verbose);
+
+    test_pipeline_pattern(verbose);
+
+    test_alloc_latency(verbose);
+
+    test_alloc_vs_malloc(verbose);
+
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,146 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#if !X86_BUILD
+    #include <platform.h>
+    #include <xs1.h>
+    #include <xcore/assert.h>
+#else
+    #include <assert.h>
+    #define xassert assert
+#endif
+#include "frame_trace.h"
+#include "profile.h"
+
+#define TEST_ITERATIONS     (1000)
+
+static int find_probe(const char *name, profile_stats_t *stats)
+{
+    for (unsigned i = 0; i < profile_probe_count(); i++) {
+        if (profile_stats_get(i, stats) == 0 && strcmp(stats->name, name) == 0) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/* Pass a frame from tile 1 to tile 0, whose timers are offset, returning its
+ * latency. The times are relative to the capture on each tile. */
+static uint32_t run_frame(uint32_t t1_capture, uint32_t t0_offset,
+                          uint32_t aec_end, uint32_t tx, uint32_t rx_start, uint32_t rx_end,
+                          uint32_t ns_end, uint32_t output, uint32_t budget)
+{
+    frame_trace_t trace;
+
+    frame_trace_capture(&trace, t1_capture);
+    frame_trace_stage(&trace, PIPELINE_STAGE_AEC, t1_capture + aec_end);
+    frame_trace_tx(&trace, t1_capture + tx);
+
+    /* Only the trace crosses to the other tile */
+    frame_trace_t sent = trace;
+    frame_trace_tx_done(&trace, t1_capture + rx_start + 10);
+
+    uint32_t t0_capture = t1_capture + t0_offset;
+    frame_trace_rx(&sent, t0_capture + rx_start, t0_capture + rx_end);
+    xassert(sent.capture_ticks == t0_capture + rx_start - tx);
+    xassert(sent.stage_ticks[PIPELINE_STAGE_AEC] == aec_end);
+    xassert(sent.rx_ticks == tx + (rx_end - rx_start));
+
+    frame_trace_stage(&sent, PIPELINE_STAGE_NS, t0_capture + ns_end);
+    xassert(sent.stage_ticks[PIPELINE_STAGE_NS] == tx + (ns_end - rx_start));
+    xassert(sent.stage_ticks[PIPELINE_STAGE_IC_VNR] == 0);
+
+    return frame_trace_output(&sent, t0_capture + output, budget);
+}
+
+void test_latency(bool verbose)
+{
+    profile_stats_t stats;
+
+    /* Timers far apart, and wrapping between capture and output */
+    const uint32_t captures[] = {0, 1000, UINT32_MAX - 500, 0x80000000};
+    const uint32_t offsets[] = {0, 12345678, UINT32_MAX - 100, 0x7FFFFFFF};
+
+    for (int c = 0; c < 4; c++) {
+        for (int o = 0; o < 4; o++) {
+            uint32_t latency = run_frame(captures[c], offsets[o], 500, 600, 700, 750, 900, 1000, 0);
+            /* tile 1 up to the send, then tile 0 from the start of the receive */
+            xassert(latency == 600 + (1000 - 700));
+        }
+    }
+    xassert(frame_trace_overrun_count() == 0);
+
+    xassert(find_probe("latency", &stats) == 0);
+    xassert(stats.count == 16);
+    xassert(stats.min_ticks == 900 && stats.max_ticks == 900);
+    xassert(find_probe("lat_hop", &stats) == 0);
+    xassert(stats.avg_ticks == 650);
+    xassert(find_probe("lat_tx_wait", &stats) == 0);
+    xassert(stats.avg_ticks == 110);
+
+    if (verbose) {
+        profile_dump();
+    }
+}
+
+void test_histogram(bool verbose)
+{
+    profile_stats_t stats;
+    uint32_t max = 0;
+
+    profile_reset();
+    srand(1);
+    for (int i = 0; i < TEST_ITERATIONS; i++) {
+        uint32_t output = 1000 + (rand() % 500);
+
+        run_frame(rand(), rand(), 100, 200, 250, 260, 300, output, 0);
+        max = (output - 50 > max) ? output - 50 : max;
+    }
+    xassert(find_probe("latency", &stats) == 0);
+    xassert(stats.count == TEST_ITERATIONS);
+    xassert(stats.min_ticks >= 950 && stats.max_ticks == max);
+    xassert(stats.avg_ticks > 1100 && stats.avg_ticks < 1300);
+    xassert(stats.p99_ticks <= stats.max_ticks && stats.p99_ticks > 1350);
+
+    if (verbose) {
+        printf("latency min=%u avg=%u p99=%u max=%u ticks\n", (unsigned)stats.min_ticks,
+               (unsigned)stats.avg_ticks, (unsigned)stats.p99_ticks, (unsigned)stats.max_ticks);
+    }
+}
+
+void test_budget(bool verbose)
+{
+    uint32_t overruns = frame_trace_overrun_count();
+
+    /* At the budget is not over it */
+    run_frame(5000, 77, 100, 200, 250, 260, 300, 1050, 1000);
+    xassert(frame_trace_overrun_count() == overruns);
+
+    /* A stall on tile 0 takes a frame over the budget, and is logged */
+    printf("Expect one frame over budget:\n");
+    run_frame(5000, 77, 100, 200, 250, 260, 300, 1051, 1000);
+    xassert(frame_trace_overrun_count() == overruns + 1);
+
+    if (verbose) {
+        printf("%u frames over budget\n", (unsigned)frame_trace_overrun_count());
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    bool verbose = false;
+
+    test_latency(verbose);
+
+    test_histogram(verbose);
+
+    test_budget(verbose);
+
+    printf("PASS\n");
+    return 0;
+}
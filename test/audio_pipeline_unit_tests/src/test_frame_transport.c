@@ -0,0 +1,158 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#if !X86_BUILD
+    #include <platform.h>
+    #include <xs1.h>
+    #include <xcore/assert.h>
+#else
+    #include <assert.h>
+    #define xassert assert
+#endif
+#include "frame_transport.h"
+
+#define TEST_CHANNELS       (2)
+#define TEST_FRAME_ADVANCE  (240)
+#define TEST_ITERATIONS     (100)
+
+/* Same layout as the reference pipeline frame_data_t */
+typedef struct {
+    int32_t samples[TEST_CHANNELS][TEST_FRAME_ADVANCE];
+    int32_t aec_reference_audio_samples[TEST_CHANNELS][TEST_FRAME_ADVANCE];
+    int32_t mic_samples_passthrough[TEST_CHANNELS][TEST_FRAME_ADVANCE];
+    int32_t vnr_pred_flag;
+    int32_t max_ref_energy[2];
+    int32_t aec_corr_factor[TEST_CHANNELS][2];
+    int32_t ref_active_flag;
+    int32_t proc_buf_active;
+    int32_t proc_buf[TEST_FRAME_ADVANCE];
+} test_frame_t;
+
+static const frame_transport_field_t all_fields[] = {
+    FRAME_TRANSPORT_FIELD(test_frame_t, samples, FRAME_TRANSPORT_RAW),
+    FRAME_TRANSPORT_FIELD(test_frame_t, aec_reference_audio_samples, FRAME_TRANSPORT_RAW),
+    FRAME_TRANSPORT_FIELD(test_frame_t, mic_samples_passthrough, FRAME_TRANSPORT_RAW),
+    FRAME_TRANSPORT_FIELD(test_frame_t, max_ref_energy, FRAME_TRANSPORT_RAW),
+    FRAME_TRANSPORT_FIELD(test_frame_t, aec_corr_factor, FRAME_TRANSPORT_RAW),
+    FRAME_TRANSPORT_FIELD(test_frame_t, ref_active_flag, FRAME_TRANSPORT_RAW),
+};
+
+static const frame_transport_field_t packed_fields[] = {
+    FRAME_TRANSPORT_FIELD(test_frame_t, samples, FRAME_TRANSPORT_RAW),
+    FRAME_TRANSPORT_FIELD(test_frame_t, aec_reference_audio_samples, FRAME_TRANSPORT_INT16),
+    FRAME_TRANSPORT_FIELD(test_frame_t, max_ref_energy, FRAME_TRANSPORT_RAW),
+    FRAME_TRANSPORT_FIELD(test_frame_t, aec_corr_factor, FRAME_TRANSPORT_RAW),
+    FRAME_TRANSPORT_FIELD(test_frame_t, ref_active_flag, FRAME_TRANSPORT_RAW),
+};
+
+static test_frame_t tx_frame;
+static test_frame_t rx_frame;
+static uint64_t msg[sizeof(test_frame_t) / sizeof(uint64_t) + 1];
+
+static void fill_random(void *buf, size_t len)
+{
+    uint8_t *p = buf;
+    for (size_t i = 0; i < len; i++) {
+        p[i] = (uint8_t)rand();
+    }
+}
+
+void test_raw_round_trip(bool verbose)
+{
+    const frame_transport_desc_t desc = {all_fields, sizeof(all_fields) / sizeof(all_fields[0])};
+    const size_t expected_len = offsetof(test_frame_t, proc_buf_active) - sizeof(int32_t);
+
+    xassert(frame_transport_size(&desc) == expected_len);
+
+    for (int itt = 0; itt < TEST_ITERATIONS; itt++) {
+        fill_random(&tx_frame, sizeof(tx_frame));
+        memset(&rx_frame, 0, sizeof(rx_frame));
+
+        size_t len = frame_transport_pack(&desc, msg, &tx_frame);
+        xassert(len == expected_len);
+        xassert(frame_transport_unpack(&desc, &rx_frame, msg) == len);
+
+        xassert(memcmp(rx_frame.samples, tx_frame.samples, sizeof(tx_frame.samples)) == 0);
+        xassert(memcmp(rx_frame.aec_reference_audio_samples, tx_frame.aec_reference_audio_samples, sizeof(tx_frame.aec_reference_audio_samples)) == 0);
+        xassert(memcmp(rx_frame.mic_samples_passthrough, tx_frame.mic_samples_passthrough, sizeof(tx_frame.mic_samples_passthrough)) == 0);
+        xassert(memcmp(rx_frame.max_ref_energy, tx_frame.max_ref_energy, sizeof(tx_frame.max_ref_energy)) == 0);
+        xassert(memcmp(rx_frame.aec_corr_factor, tx_frame.aec_corr_factor, sizeof(tx_frame.aec_corr_factor)) == 0);
+        xassert(rx_frame.ref_active_flag == tx_frame.ref_active_flag);
+
+        /* Fields not described must not be written */
+        xassert(rx_frame.vnr_pred_flag == 0);
+        xassert(rx_frame.proc_buf_active == 0);
+        for (int i = 0; i < TEST_FRAME_ADVANCE; i++) {
+            xassert(rx_frame.proc_buf[i] == 0);
+        }
+    }
+    if (verbose) {
+        printf("raw message %u bytes, frame %u bytes\n", (unsigned)expected_len, (unsigned)sizeof(test_frame_t));
+    }
+}
+
+void test_int16_round_trip(bool verbose)
+{
+    const frame_transport_desc_t desc = {packed_fields, sizeof(packed_fields) / sizeof(packed_fields[0])};
+    const size_t expected_len = sizeof(tx_frame.samples)
+                              + sizeof(tx_frame.aec_reference_audio_samples) / 2
+                              + sizeof(tx_frame.max_ref_energy)
+                              + sizeof(tx_frame.aec_corr_factor)
+                              + sizeof(tx_frame.ref_active_flag);
+
+    xassert(frame_transport_size(&desc) == expected_len);
+
+    for (int itt = 0; itt < TEST_ITERATIONS; itt++) {
+        fill_random(&tx_frame, sizeof(tx_frame));
+        memset(&rx_frame, 0, sizeof(rx_frame));
+
+        size_t len = frame_transport_pack(&desc, msg, &tx_frame);
+        xassert(len == expected_len);
+        xassert(frame_transport_unpack(&desc, &rx_frame, msg) == len);
+
+        xassert(memcmp(rx_frame.samples, tx_frame.samples, sizeof(tx_frame.samples)) == 0);
+        for (int ch = 0; ch < TEST_CHANNELS; ch++) {
+            for (int i = 0; i < TEST_FRAME_ADVANCE; i++) {
+                int32_t expected = (int32_t)((uint32_t)tx_frame.aec_reference_audio_samples[ch][i] & 0xFFFF0000);
+                xassert(rx_frame.aec_reference_audio_samples[ch][i] == expected);
+                xassert(rx_frame.mic_samples_passthrough[ch][i] == 0);
+            }
+        }
+        /* Raw fields after a packed field must still be bit exact */
+        xassert(memcmp(rx_frame.aec_corr_factor, tx_frame.aec_corr_factor, sizeof(tx_frame.aec_corr_factor)) == 0);
+        xassert(rx_frame.ref_active_flag == tx_frame.ref_active_flag);
+    }
+
+    /* Full scale values survive packing */
+    tx_frame.aec_reference_audio_samples[0][0] = INT32_MIN;
+    tx_frame.aec_reference_audio_samples[0][1] = (int32_t)0x7FFF0000;
+    tx_frame.aec_reference_audio_samples[0][2] = -65536;
+    frame_transport_pack(&desc, msg, &tx_frame);
+    frame_transport_unpack(&desc, &rx_frame, msg);
+    xassert(rx_frame.aec_reference_audio_samples[0][0] == INT32_MIN);
+    xassert(rx_frame.aec_reference_audio_samples[0][1] == (int32_t)0x7FFF0000);
+    xassert(rx_frame.aec_reference_audio_samples[0][2] == -65536);
+
+    if (verbose) {
+        printf("packed message %u bytes, frame %u bytes\n", (unsigned)expected_len, (unsigned)sizeof(test_frame_t));
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    bool verbose = false;
+
+    srand(1);
+
+    test_raw_round_trip(verbose);
+
+    test_int16_round_trip(verbose);
+
+    printf("PASS\n");
+    return 0;
+}
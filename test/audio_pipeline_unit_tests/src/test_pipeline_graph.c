@@ -0,0 +1,332 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#if !X86_BUILD
+    #include <platform.h>
+    #include <xs1.h>
+    #include <xcore/assert.h>
+#else
+    #include <assert.h>
+    #define xassert assert
+#endif
+#include "pipeline_graph.h"
+
+/* Each stage appends its ID to the frame, so that a run shows which stages ran
+ * and in what order */
+typedef struct {
+    uint8_t ran[PIPELINE_STAGE_COUNT];
+    size_t count;
+} test_frame_t;
+
+#define TEST_STAGE_DEFINE(id) \
+    PIPELINE_GRAPH_STAGE_FPTRGROUP \
+    static void stage_##id(void *frame) \
+    { \
+        test_frame_t *f = frame; \
+        f->ran[f->count++] = PIPELINE_STAGE_##id; \
+    }
+
+TEST_STAGE_DEFINE(DELAY)
+TEST_STAGE_DEFINE(AEC)
+TEST_STAGE_DEFINE(IC_VNR)
+TEST_STAGE_DEFINE(NS)
+TEST_STAGE_DEFINE(AGC)
+
+/* Stages of the tiles of the fixed delay reference pipeline */
+static const pipeline_graph_stage_t tile0_fns[PIPELINE_STAGE_COUNT] = {
+    [PIPELINE_STAGE_IC_VNR] = stage_IC_VNR,
+    [PIPELINE_STAGE_NS] = stage_NS,
+    [PIPELINE_STAGE_AGC] = stage_AGC,
+};
+
+static const pipeline_graph_stage_t tile1_fns[PIPELINE_STAGE_COUNT] = {
+    [PIPELINE_STAGE_DELAY] = stage_DELAY,
+    [PIPELINE_STAGE_AEC] = stage_AEC,
+};
+
+static const pipeline_graph_t default_graph = {
+    .entries = {
+        {PIPELINE_STAGE_DELAY,  1, 0, 0},
+        {PIPELINE_STAGE_AEC,    1, 1, 0},
+        {PIPELINE_STAGE_IC_VNR, 0, 0, 0},
+        {PIPELINE_STAGE_NS,     0, 1, 0},
+        {PIPELINE_STAGE_AGC,    0, 2, 0},
+    },
+    .count = 5,
+};
+
+PIPELINE_GRAPH_PLAN_DEFINE(test_plan)
+
+/* Run a frame through the threads of the plan and check the stages that ran */
+static void check_run(const uint8_t *expected, size_t expected_count)
+{
+    const pipeline_graph_stage_t threads[PIPELINE_GRAPH_MAX_THREADS] = {
+        test_plan_thread_0,
+        test_plan_thread_1,
+        test_plan_thread_2,
+        test_plan_thread_3,
+    };
+    test_frame_t frame = {0};
+
+    for (size_t t = 0; t < test_plan.thread_count; t++) {
+        threads[t](&frame);
+    }
+    xassert(frame.count == expected_count);
+    xassert(memcmp(frame.ran, expected, expected_count) == 0);
+}
+
+void test_plan_default(bool verbose)
+{
+    const uint8_t tile0[] = {PIPELINE_STAGE_IC_VNR, PIPELINE_STAGE_NS, PIPELINE_STAGE_AGC};
+    const uint8_t tile1[] = {PIPELINE_STAGE_DELAY, PIPELINE_STAGE_AEC};
+    int ret;
+
+    ret = pipeline_graph_plan(&test_plan, &default_graph, 0, tile0_fns);
+    xassert(ret == 0);
+    xassert(test_plan.thread_count == 3);
+    for (int t = 0; t < 3; t++) {
+        xassert(test_plan.threads[t].stage_count == 1);
+    }
+    check_run(tile0, sizeof(tile0));
+
+    ret = pipeline_graph_plan(&test_plan, &default_graph, 1, tile1_fns);
+    xassert(ret == 0);
+    xassert(test_plan.thread_count == 2);
+    check_run(tile1, sizeof(tile1));
+
+    if (verbose) {
+        printf("default graph OK\n");
+    }
+}
+
+void test_plan_merge_and_bypass(bool verbose)
+{
+    pipeline_graph_t graph = default_graph;
+    int ret;
+
+    /* IC/VNR and NS share a thread */
+    graph.entries[3].thread = 0;
+    ret = pipeline_graph_plan(&test_plan, &graph, 0, tile0_fns);
+    xassert(ret == 0);
+    xassert(test_plan.thread_count == 2);
+    xassert(test_plan.threads[0].stage_count == 2);
+    xassert(test_plan.threads[1].stage_count == 1);
+
+    /* Bypassing NS leaves the other stages running, and its thread is not
+     * created */
+    graph = default_graph;
+    graph.entries[3].bypass = 1;
+    ret = pipeline_graph_plan(&test_plan, &graph, 0, tile0_fns);
+    xassert(ret == 0);
+    xassert(test_plan.thread_count == 2);
+    {
+        const uint8_t expected[] = {PIPELINE_STAGE_IC_VNR, PIPELINE_STAGE_AGC};
+        check_run(expected, sizeof(expected));
+    }
+
+    /* Bypassing every stage of a tile leaves it no threads */
+    graph = default_graph;
+    graph.entries[0].bypass = 1;
+    graph.entries[1].bypass = 1;
+    ret = pipeline_graph_plan(&test_plan, &graph, 1, tile1_fns);
+    xassert(ret == 0);
+    xassert(test_plan.thread_count == 0);
+    check_run(NULL, 0);
+
+    /* A graph without the stages of a tile is valid for it */
+    graph = default_graph;
+    graph.count = 2;
+    ret = pipeline_graph_plan(&test_plan, &graph, 0, tile0_fns);
+    xassert(ret == 0);
+    xassert(test_plan.thread_count == 0);
+    check_run(NULL, 0);
+
+    if (verbose) {
+        printf("merge and bypass OK\n");
+    }
+}
+
+void test_plan_invalid(bool verbose)
+{
+    pipeline_graph_t graph;
+    int ret;
+
+    /* Repeated stage */
+    graph = default_graph;
+    graph.entries[4].stage = PIPELINE_STAGE_NS;
+    ret = pipeline_graph_plan(&test_plan, &graph, 0, tile0_fns);
+    xassert(ret == -1);
+
+    /* Stage on a tile that does not implement it, even when bypassed */
+    graph = default_graph;
+    graph.entries[1].tile = 0;
+    graph.entries[1].bypass = 1;
+    ret = pipeline_graph_plan(&test_plan, &graph, 0, tile0_fns);
+    xassert(ret == -1);
+    ret = pipeline_graph_plan(&test_plan, &graph, 1, tile1_fns);
+    xassert(ret == 0);
+
+    /* Threads out of order */
+    graph = default_graph;
+    graph.entries[4].thread = 0;
+    ret = pipeline_graph_plan(&test_plan, &graph, 0, tile0_fns);
+    xassert(ret == -1);
+
+    /* Thread and stage out of range */
+    graph = default_graph;
+    graph.entries[4].thread = PIPELINE_GRAPH_MAX_THREADS;
+    ret = pipeline_graph_plan(&test_plan, &graph, 0, tile0_fns);
+    xassert(ret == -1);
+    graph = default_graph;
+    graph.entries[4].stage = PIPELINE_STAGE_COUNT;
+    ret = pipeline_graph_plan(&test_plan, &graph, 0, tile0_fns);
+    xassert(ret == -1);
+
+    /* Too many entries */
+    graph = default_graph;
+    graph.count = PIPELINE_GRAPH_MAX_ENTRIES + 1;
+    ret = pipeline_graph_plan(&test_plan, &graph, 0, tile0_fns);
+    xassert(ret == -1);
+
+    if (verbose) {
+        printf("invalid graphs rejected\n");
+    }
+}
+
+void test_parse(bool verbose)
+{
+    pipeline_graph_t graph;
+    char text[256];
+    int ret;
+
+    strcpy(text, "# Fixed delay pipeline\n"
+                 "delay 1 0\n"
+                 "  aec\t1 1 \r\n"
+                 "\n"
+                 "ic_vnr 0 0\n"
+                 "ns 0 0 bypass\n"
+                 "agc 0 1");
+    ret = pipeline_graph_parse(text, &graph);
+    xassert(ret == 5);
+    xassert(graph.count == 5);
+    xassert(graph.entries[1].stage == PIPELINE_STAGE_AEC);
+    xassert(graph.entries[1].tile == 1 && graph.entries[1].thread == 1);
+    xassert(graph.entries[3].stage == PIPELINE_STAGE_NS && graph.entries[3].bypass == 1);
+    xassert(graph.entries[4].stage == PIPELINE_STAGE_AGC && graph.entries[4].thread == 1);
+    xassert(graph.entries[4].bypass == 0);
+
+    ret = pipeline_graph_plan(&test_plan, &graph, 0, tile0_fns);
+    xassert(ret == 0);
+    xassert(test_plan.thread_count == 2);
+
+    for (unsigned s = 0; s < PIPELINE_STAGE_COUNT; s++) {
+        char line[32];
+        sprintf(line, "%s 0 0", pipeline_graph_stage_name(s));
+        ret = pipeline_graph_parse(line, &graph);
+        xassert(ret == 1);
+        xassert(graph.entries[0].stage == s);
+    }
+    xassert(pipeline_graph_stage_name(PIPELINE_STAGE_COUNT) == NULL);
+
+    /* Errors give the line number */
+    strcpy(text, "aec 1 0\nbeamformer 0 0\n");
+    ret = pipeline_graph_parse(text, &graph);
+    xassert(ret == -2);
+    strcpy(text, "aec 1\n");
+    ret = pipeline_graph_parse(text, &graph);
+    xassert(ret == -1);
+    strcpy(text, "# comment\naec 1 0 bypas\n");
+    ret = pipeline_graph_parse(text, &graph);
+    xassert(ret == -2);
+    strcpy(text, "aec 1 0 bypass extra\n");
+    ret = pipeline_graph_parse(text, &graph);
+    xassert(ret == -1);
+    strcpy(text, "aec 1 256\n");
+    ret = pipeline_graph_parse(text, &graph);
+    xassert(ret == -1);
+    strcpy(text, "ns 0 0\nns 0 0\nns 0 0\nns 0 0\nns 0 0\nns 0 0\nns 0 0\nns 0 0\nns 0 0\n");
+    ret = pipeline_graph_parse(text, &graph);
+    xassert(ret == -(PIPELINE_GRAPH_MAX_ENTRIES + 1));
+
+    /* An empty file has no entries */
+    strcpy(text, "# nothing\n\n");
+    ret = pipeline_graph_parse(text, &graph);
+    xassert(ret == 0);
+
+    if (verbose) {
+        printf("parse OK\n");
+    }
+}
+
+void test_check(bool verbose)
+{
+    const uint32_t tile_stages[2] = {
+        pipeline_graph_tile_stages(&default_graph, 0),
+        pipeline_graph_tile_stages(&default_graph, 1),
+    };
+    pipeline_graph_t graph;
+    int ret;
+
+    xassert(tile_stages[0] == ((1u << PIPELINE_STAGE_IC_VNR) | (1u << PIPELINE_STAGE_NS) | (1u << PIPELINE_STAGE_AGC)));
+    xassert(tile_stages[1] == ((1u << PIPELINE_STAGE_DELAY) | (1u << PIPELINE_STAGE_AEC)));
+
+    ret = pipeline_graph_check(&default_graph, tile_stages, 2);
+    xassert(ret == 0);
+
+    /* A graph that is only invalid for tile 0 is invalid for both tiles */
+    graph = default_graph;
+    graph.entries[4].thread = 0;
+    ret = pipeline_graph_plan(&test_plan, &graph, 1, tile1_fns);
+    xassert(ret == 0);
+    ret = pipeline_graph_check(&graph, tile_stages, 2);
+    xassert(ret == -1);
+
+    /* And one that is only invalid for tile 1 */
+    graph = default_graph;
+    graph.entries[0].thread = 1;
+    graph.entries[1].thread = 0;
+    ret = pipeline_graph_plan(&test_plan, &graph, 0, tile0_fns);
+    xassert(ret == 0);
+    ret = pipeline_graph_check(&graph, tile_stages, 2);
+    xassert(ret == -1);
+
+    /* A stage on a tile the pipeline does not have */
+    graph = default_graph;
+    graph.entries[4].tile = 2;
+    ret = pipeline_graph_check(&graph, tile_stages, 2);
+    xassert(ret == -1);
+
+    /* Bypassing every stage of a tile is valid */
+    graph = default_graph;
+    graph.entries[0].bypass = 1;
+    graph.entries[1].bypass = 1;
+    ret = pipeline_graph_check(&graph, tile_stages, 2);
+    xassert(ret == 0);
+
+    if (verbose) {
+        printf("check OK\n");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    bool verbose = false;
+
+    test_plan_default(verbose);
+
+    test_plan_merge_and_bypass(verbose);
+
+    test_plan_invalid(verbose);
+
+    test_check(verbose);
+
+    test_parse(verbose);
+
+    printf("PASS\n");
+    return 0;
+}
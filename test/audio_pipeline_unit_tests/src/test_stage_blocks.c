@@ -0,0 +1,156 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#if !X86_BUILD
+    #include <platform.h>
+    #include <xs1.h>
+    #include <xcore/assert.h>
+#else
+    #include <assert.h>
+    #define xassert assert
+#endif
+#include "stage_blocks.h"
+
+#define MAX_FRAME_ADVANCE   (720)
+#define INPUT_CHANNELS      (3)
+#define OUTPUT_CHANNELS     (2)
+#define TEST_SAMPLES        (240 * 60)
+
+static int32_t input_storage[STAGE_BLOCKS_STORAGE_SIZE(MAX_FRAME_ADVANCE, INPUT_CHANNELS)];
+static int32_t output_storage[STAGE_BLOCKS_STORAGE_SIZE(MAX_FRAME_ADVANCE, OUTPUT_CHANNELS)];
+
+/* Sample n of channel ch of the test signal, never 0 */
+static int32_t test_signal(uint32_t ch, uint32_t n)
+{
+    return (int32_t)((ch + 1) * 100000 + n + 1);
+}
+
+/* Stand in for a DSP stage, which also checks that each block is the next
+ * STAGE_BLOCK_ADVANCE samples of the signal. Output channel ch is input
+ * channel ch + 1 negated. */
+static void process_block(stage_blocks_t *sb, uint32_t block, uint32_t block_count)
+{
+    for (uint32_t ch = 0; ch < INPUT_CHANNELS; ch++) {
+        const int32_t *in = stage_blocks_input(sb, block, ch);
+        for (uint32_t i = 0; i < STAGE_BLOCK_ADVANCE; i++) {
+            xassert(in[i] == test_signal(ch, block_count * STAGE_BLOCK_ADVANCE + i));
+        }
+    }
+    for (uint32_t ch = 0; ch < OUTPUT_CHANNELS; ch++) {
+        const int32_t *in = stage_blocks_input(sb, block, ch + 1);
+        int32_t *out = stage_blocks_output(sb, block, ch);
+        for (uint32_t i = 0; i < STAGE_BLOCK_ADVANCE; i++) {
+            out[i] = -in[i];
+        }
+    }
+}
+
+static void run(uint32_t frame_advance, bool verbose)
+{
+    stage_blocks_t sb;
+    int32_t frame[INPUT_CHANNELS][MAX_FRAME_ADVANCE];
+    uint32_t latency = STAGE_BLOCKS_LATENCY(frame_advance);
+    uint32_t block_count = 0;
+    uint32_t processing_frames = 0;
+
+    xassert(STAGE_BLOCKS_FRAME_ADVANCE_VALID(frame_advance));
+    stage_blocks_init(&sb, frame_advance, input_storage, INPUT_CHANNELS, output_storage, OUTPUT_CHANNELS);
+
+    for (uint32_t n = 0; n < TEST_SAMPLES; n += frame_advance) {
+        for (uint32_t ch = 0; ch < INPUT_CHANNELS; ch++) {
+            for (uint32_t i = 0; i < frame_advance; i++) {
+                frame[ch][i] = test_signal(ch, n + i);
+            }
+            stage_blocks_write(&sb, ch, frame[ch]);
+        }
+
+        uint32_t blocks = stage_blocks_advance(&sb);
+        for (uint32_t b = 0; b < blocks; b++) {
+            process_block(&sb, b, block_count++);
+        }
+        processing_frames += (blocks > 0);
+
+        /* The output is the processed input, delayed by the latency */
+        for (uint32_t ch = 0; ch < OUTPUT_CHANNELS; ch++) {
+            stage_blocks_read(&sb, ch, frame[ch]);
+            for (uint32_t i = 0; i < frame_advance; i++) {
+                int32_t expected = (n + i < latency) ? 0 : -test_signal(ch + 1, n + i - latency);
+                xassert(frame[ch][i] == expected);
+            }
+        }
+    }
+
+    /* Every frame processes when frames are at least a block long */
+    uint32_t frames = TEST_SAMPLES / frame_advance;
+    xassert(block_count == TEST_SAMPLES / STAGE_BLOCK_ADVANCE);
+    if (frame_advance >= STAGE_BLOCK_ADVANCE) {
+        xassert(processing_frames == frames);
+    } else {
+        xassert(processing_frames == frames * frame_advance / STAGE_BLOCK_ADVANCE);
+    }
+
+    if (verbose) {
+        printf("frame advance %u: latency %u samples, %u blocks in %u frames\n",
+               (unsigned)frame_advance, (unsigned)latency, (unsigned)block_count, (unsigned)frames);
+    }
+}
+
+void test_frame_advances(bool verbose)
+{
+    const uint32_t frame_advances[] = {60, 80, 120, 240, 480, 720};
+
+    for (int i = 0; i < (int)(sizeof(frame_advances) / sizeof(frame_advances[0])); i++) {
+        run(frame_advances[i], verbose);
+    }
+
+    xassert(!STAGE_BLOCKS_FRAME_ADVANCE_VALID(0));
+    xassert(!STAGE_BLOCKS_FRAME_ADVANCE_VALID(100));
+    xassert(!STAGE_BLOCKS_FRAME_ADVANCE_VALID(360));
+}
+
+void test_timing(bool verbose)
+{
+    const uint32_t frame_advances[] = {120, 480};
+    int32_t frame[INPUT_CHANNELS][MAX_FRAME_ADVANCE] = {{0}};
+
+    for (int i = 0; i < (int)(sizeof(frame_advances) / sizeof(frame_advances[0])); i++) {
+        stage_blocks_t sb;
+        stage_blocks_init(&sb, frame_advances[i], input_storage, INPUT_CHANNELS, output_storage, OUTPUT_CHANNELS);
+
+        clock_t start = clock();
+        for (int f = 0; f < 10000; f++) {
+            for (uint32_t ch = 0; ch < INPUT_CHANNELS; ch++) {
+                stage_blocks_write(&sb, ch, frame[ch]);
+            }
+            stage_blocks_advance(&sb);
+            for (uint32_t ch = 0; ch < OUTPUT_CHANNELS; ch++) {
+                stage_blocks_read(&sb, ch, frame[ch]);
+            }
+        }
+        clock_t ticks = clock() - start;
+
+        /* Per block, so that frame advances can be compared */
+        if (verbose) {
+            printf("frame advance %u: %.3f us per block\n", (unsigned)frame_advances[i],
+                   1e6 * ticks / CLOCKS_PER_SEC / (10000.0 * frame_advances[i] / STAGE_BLOCK_ADVANCE));
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    bool verbose = false;
+
+    test_frame_advances(verbose);
+
+    test_timing(verbose);
+
+    printf("PASS\n");
+    return 0;
+}
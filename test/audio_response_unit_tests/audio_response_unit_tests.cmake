@@ -0,0 +1,32 @@
+set(AUDIO_RESPONSE_PATH ${CMAKE_CURRENT_LIST_DIR}/../../modules/asr/intent_handler/audio_response)
+set(INTENT_HANDLER_PATH ${CMAKE_CURRENT_LIST_DIR}/../../modules/asr/intent_handler)
+
+## The audio response player is tested on the host, with its tasks as pthreads
+## and the files in memory
+if(NOT ${CMAKE_SYSTEM_NAME} STREQUAL XCORE_XS3A)
+    find_package(Threads REQUIRED)
+
+    add_executable(test_audio_response
+        ${CMAKE_CURRENT_LIST_DIR}/src/test_audio_response.c
+        ${CMAKE_CURRENT_LIST_DIR}/src/host_rtos.c
+        ${AUDIO_RESPONSE_PATH}/audio_response.c
+        ${INTENT_HANDLER_PATH}/barge_in/barge_in.c
+    )
+
+    ## The stubs directory comes first so that it stands in for FreeRTOS, FatFS
+    ## and the xcore headers
+    target_include_directories(test_audio_response
+        PRIVATE
+            ${CMAKE_CURRENT_LIST_DIR}/src/stubs
+            ${AUDIO_RESPONSE_PATH}
+            ${INTENT_HANDLER_PATH}
+            ${INTENT_HANDLER_PATH}/barge_in
+            ${CMAKE_CURRENT_LIST_DIR}/../../modules/profiling
+    )
+
+    target_compile_definitions(test_audio_response PRIVATE X86_BUILD=1)
+
+    target_compile_options(test_audio_response PRIVATE -Wno-unknown-pragmas)
+
+    target_link_libraries(test_audio_response PRIVATE Threads::Threads m)
+endif()
@@ -0,0 +1,127 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include "FreeRTOS.h"
+
+struct host_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    size_t item_size;
+    uint32_t length;
+    uint32_t count;
+    uint32_t head;
+    uint8_t *items;     // NULL for a semaphore
+};
+
+typedef struct {
+    TaskFunction_t fn;
+    void *arg;
+} host_task_t;
+
+static void *host_task_entry(void *arg)
+{
+    host_task_t task = *(host_task_t *)arg;
+
+    free(arg);
+    task.fn(task.arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                       void *arg, UBaseType_t priority, TaskHandle_t *handle)
+{
+    (void) name; (void) stack_depth; (void) priority;
+
+    host_task_t *task = malloc(sizeof(host_task_t));
+    pthread_t thread;
+
+    assert(task != NULL);
+    task->fn = fn;
+    task->arg = arg;
+    if (pthread_create(&thread, NULL, host_task_entry, task) != 0) {
+        free(task);
+        return pdFALSE;
+    }
+    pthread_detach(thread);
+    if (handle != NULL) {
+        *handle = NULL;
+    }
+    return pdPASS;
+}
+
+static QueueHandle_t host_queue_create(UBaseType_t length, UBaseType_t item_size, UBaseType_t count)
+{
+    QueueHandle_t queue = calloc(1, sizeof(struct host_queue));
+
+    assert(queue != NULL);
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->changed, NULL);
+    queue->item_size = item_size;
+    queue->length = length;
+    queue->count = count;
+    if (item_size > 0) {
+        queue->items = malloc(length * item_size);
+        assert(queue->items != NULL);
+    }
+    return queue;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    return host_queue_create(length, item_size, 0);
+}
+
+QueueHandle_t host_queue_create_counting(UBaseType_t max, UBaseType_t initial)
+{
+    return host_queue_create(max, 0, initial);
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t timeout)
+{
+    assert(timeout == 0 || timeout == portMAX_DELAY);
+
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == queue->length) {
+        if (timeout == 0) {
+            pthread_mutex_unlock(&queue->lock);
+            return pdFALSE;
+        }
+        pthread_cond_wait(&queue->changed, &queue->lock);
+    }
+    if (queue->items != NULL) {
+        uint32_t tail = (queue->head + queue->count) % queue->length;
+        memcpy(&queue->items[tail * queue->item_size], item, queue->item_size);
+    }
+    queue->count++;
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t timeout)
+{
+    assert(timeout == 0 || timeout == portMAX_DELAY);
+
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0) {
+        if (timeout == 0) {
+            pthread_mutex_unlock(&queue->lock);
+            return pdFALSE;
+        }
+        pthread_cond_wait(&queue->changed, &queue->lock);
+    }
+    if (queue->items != NULL) {
+        memcpy(item, &queue->items[queue->head * queue->item_size], queue->item_size);
+        queue->head = (queue->head + 1) % queue->length;
+    }
+    queue->count--;
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+    return pdTRUE;
+}
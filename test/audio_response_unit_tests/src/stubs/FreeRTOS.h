@@ -0,0 +1,60 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef FREERTOS_H_
+#define FREERTOS_H_
+
+/*
+ * The part of the FreeRTOS API used by the audio response player, for testing
+ * it on the host. Tasks run as pthreads, and queues and semaphores are built on
+ * a mutex and a condition variable. Only timeouts of 0 and portMAX_DELAY are
+ * supported.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "xcore/assert.h"
+
+#define configASSERT(x)             assert(x)
+#define configMAX_PRIORITIES        (32)
+#define RTOS_THREAD_STACK_SIZE(f)   (0)
+
+#define rtos_printf printf
+
+#define pvPortMalloc(size)  malloc(size)
+#define vPortFree(ptr)      free(ptr)
+
+#define pdFALSE         (0)
+#define pdTRUE          (1)
+#define pdPASS          (pdTRUE)
+#define portMAX_DELAY   (0xFFFFFFFFu)
+
+typedef uint32_t TickType_t;
+typedef int32_t BaseType_t;
+typedef uint32_t UBaseType_t;
+typedef void *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+typedef struct host_queue *QueueHandle_t;
+typedef struct host_queue *SemaphoreHandle_t;
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                       void *arg, UBaseType_t priority, TaskHandle_t *handle);
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t timeout);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t timeout);
+
+/* A semaphore is a queue of items with no data, as in FreeRTOS */
+#define xSemaphoreCreateCounting(max, initial)  host_queue_create_counting((max), (initial))
+#define xSemaphoreCreateBinary()                host_queue_create_counting(1, 0)
+#define xSemaphoreGive(sem)                     xQueueSend((sem), NULL, 0)
+#define xSemaphoreTake(sem, timeout)            xQueueReceive((sem), NULL, (timeout))
+
+QueueHandle_t host_queue_create_counting(UBaseType_t max, UBaseType_t initial);
+
+#endif /* FREERTOS_H_ */
@@ -0,0 +1,15 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef APP_CONF_H_
+#define APP_CONF_H_
+
+#define appconfAUDIO_PIPELINE_FRAME_ADVANCE     (240)
+
+#define appconfI2S_MODE_MASTER                  0
+#define appconfI2S_MODE_SLAVE                   1
+#define appconfI2S_MODE                         appconfI2S_MODE_MASTER
+
+#define appconfPROFILE_ENABLED                  0
+
+#endif /* APP_CONF_H_ */
@@ -0,0 +1,34 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef FF_H_
+#define FF_H_
+
+#include <stdint.h>
+
+/* The part of the FatFS API used by the audio response player. The files are
+ * provided by the test, see test_audio_response.c */
+typedef enum {
+    FR_OK = 0,
+    FR_NO_FILE = 4,
+} FRESULT;
+
+typedef uint32_t FSIZE_t;
+typedef unsigned int UINT;
+
+#define FA_READ     0x01
+
+typedef struct {
+    char name[16];
+    uint8_t *data;
+    FSIZE_t size;
+    FSIZE_t pos;
+} FIL;
+
+FRESULT f_open(FIL *fp, const char *path, uint8_t mode);
+FRESULT f_close(FIL *fp);
+FRESULT f_read(FIL *fp, void *buff, UINT btr, UINT *br);
+FRESULT f_lseek(FIL *fp, FSIZE_t ofs);
+FSIZE_t f_tell(FIL *fp);
+
+#endif /* FF_H_ */
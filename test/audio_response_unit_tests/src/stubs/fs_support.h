@@ -0,0 +1,9 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef FS_SUPPORT_H_
+#define FS_SUPPORT_H_
+
+/* Intentionally empty */
+
+#endif /* FS_SUPPORT_H_ */
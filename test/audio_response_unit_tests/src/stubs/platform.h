@@ -0,0 +1,9 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef PLATFORM_H_
+#define PLATFORM_H_
+
+/* Intentionally empty */
+
+#endif /* PLATFORM_H_ */
@@ -0,0 +1,9 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef DRIVER_INSTANCES_H_
+#define DRIVER_INSTANCES_H_
+
+/* The tests replace the output sink, so no driver is used */
+
+#endif /* DRIVER_INSTANCES_H_ */
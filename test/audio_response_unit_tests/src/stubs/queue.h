@@ -0,0 +1,9 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef QUEUE_H_
+#define QUEUE_H_
+
+#include "FreeRTOS.h"
+
+#endif /* QUEUE_H_ */
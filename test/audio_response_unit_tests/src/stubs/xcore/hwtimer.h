@@ -0,0 +1,19 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef XCORE_HWTIMER_H_
+#define XCORE_HWTIMER_H_
+
+#include <stdint.h>
+#include <time.h>
+
+/* The 100 MHz reference clock */
+static inline uint32_t get_reference_time(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 100000000 + ts.tv_nsec / 10);
+}
+
+#endif /* XCORE_HWTIMER_H_ */
@@ -0,0 +1,9 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef XS1_H_
+#define XS1_H_
+
+/* Intentionally empty */
+
+#endif /* XS1_H_ */
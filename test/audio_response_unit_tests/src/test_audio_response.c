@@ -0,0 +1,398 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "FreeRTOS.h"
+#include "app_conf.h"
+#include "ff.h"
+#include "audio_response.h"
+
+#define BLOCK_FRAMES    (appconfAUDIO_PIPELINE_FRAME_ADVANCE)
+#define LOG_FRAMES      (16 * 1024)
+#define WAIT_MS         (5000)
+
+/* The number in the file name of each response ID, as in audio_response.c */
+static const int file_num[] = {50, 1, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18};
+
+#define NUM_IDS         ((int)(sizeof(file_num) / sizeof(file_num[0])))
+#define MISSING_ID      (16)    // 17.wav cannot be opened
+
+/* Files whose length is a whole number of blocks, or less than a block */
+#define ONE_BLOCK_ID    (3)
+#define TWO_BLOCKS_ID   (4)
+#define SHORT_ID        (5)
+
+/* Opens and closes of each file */
+static int opens[64];
+static int closes[64];
+
+/* Samples written to the sink, and a gate that holds the sink in write() */
+static pthread_mutex_t sink_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sink_changed = PTHREAD_COND_INITIALIZER;
+static int16_t sink_log[LOG_FRAMES];
+static size_t sink_log_len;
+static bool sink_hold;
+static bool sink_waiting;
+
+static size_t file_frames(int num)
+{
+    switch (num) {
+    case 4: return BLOCK_FRAMES;
+    case 5: return 2 * BLOCK_FRAMES;
+    case 6: return 100;
+    }
+    return BLOCK_FRAMES + (num * 37) % 270;
+}
+
+/* Each sample holds its file number and frame, files are under 512 frames */
+static int16_t file_sample(int num, size_t frame)
+{
+    return (int16_t)((num << 9) | frame);
+}
+
+/* Each file is a mono 16 bit wav made when it is opened */
+FRESULT f_open(FIL *fp, const char *path, uint8_t mode)
+{
+    int num = atoi(path);
+    uint32_t frames = file_frames(num);
+    uint32_t data_size = frames * sizeof(int16_t);
+    uint8_t header[44] = {
+        'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E',
+        'f', 'm', 't', ' ', 16, 0, 0, 0, 1, 0, 1, 0,
+        0x80, 0x3E, 0, 0, 0, 0x7D, 0, 0, 2, 0, 16, 0,
+        'd', 'a', 't', 'a', 0, 0, 0, 0,
+    };
+
+    assert(mode == FA_READ);
+    if (num == file_num[MISSING_ID]) {
+        return FR_NO_FILE;
+    }
+    for (int i = 0; i < 4; i++) {
+        header[4 + i] = ((36 + data_size) >> (8 * i)) & 0xFF;
+        header[40 + i] = (data_size >> (8 * i)) & 0xFF;
+    }
+
+    snprintf(fp->name, sizeof(fp->name), "%s", path);
+    fp->size = sizeof(header) + data_size;
+    fp->pos = 0;
+    fp->data = malloc(fp->size);
+    assert(fp->data != NULL);
+    memcpy(fp->data, header, sizeof(header));
+    for (uint32_t i = 0; i < frames; i++) {
+        int16_t sample = file_sample(num, i);
+        memcpy(&fp->data[sizeof(header) + i * sizeof(int16_t)], &sample, sizeof(int16_t));
+    }
+    opens[num]++;
+    return FR_OK;
+}
+
+FRESULT f_close(FIL *fp)
+{
+    closes[atoi(fp->name)]++;
+    free(fp->data);
+    fp->data = NULL;
+    return FR_OK;
+}
+
+FRESULT f_read(FIL *fp, void *buff, UINT btr, UINT *br)
+{
+    UINT n = fp->size - fp->pos;
+
+    if (n > btr) {
+        n = btr;
+    }
+    memcpy(buff, &fp->data[fp->pos], n);
+    fp->pos += n;
+    *br = n;
+    return FR_OK;
+}
+
+FRESULT f_lseek(FIL *fp, FSIZE_t ofs)
+{
+    fp->pos = (ofs < fp->size) ? ofs : fp->size;
+    return FR_OK;
+}
+
+FSIZE_t f_tell(FIL *fp)
+{
+    return fp->pos;
+}
+
+AUDIO_RESPONSE_SINK_FPTRGROUP
+static void test_sink_write(void *ctx, const int16_t *samples, size_t frames)
+{
+    (void) ctx;
+
+    assert(frames > 0 && frames <= BLOCK_FRAMES);
+
+    pthread_mutex_lock(&sink_lock);
+    sink_waiting = true;
+    pthread_cond_broadcast(&sink_changed);
+    while (sink_hold) {
+        pthread_cond_wait(&sink_changed, &sink_lock);
+    }
+    sink_waiting = false;
+
+    assert(sink_log_len + frames <= LOG_FRAMES);
+    memcpy(&sink_log[sink_log_len], samples, frames * sizeof(int16_t));
+    sink_log_len += frames;
+    pthread_mutex_unlock(&sink_lock);
+}
+
+AUDIO_RESPONSE_SINK_FPTRGROUP
+static void unused_sink_write(void *ctx, const int16_t *samples, size_t frames)
+{
+    (void) ctx; (void) samples; (void) frames;
+    assert(0);
+}
+
+const audio_response_sink_t audio_response_sink_i2s = {unused_sink_write, NULL};
+const audio_response_sink_t audio_response_sink_intertile = {unused_sink_write, NULL};
+static const audio_response_sink_t test_sink = {test_sink_write, NULL};
+
+static void sink_hold_set(bool hold)
+{
+    pthread_mutex_lock(&sink_lock);
+    sink_hold = hold;
+    pthread_cond_broadcast(&sink_changed);
+    pthread_mutex_unlock(&sink_lock);
+}
+
+/* Wait until the sink task is held in write() */
+static void sink_wait_held(void)
+{
+    pthread_mutex_lock(&sink_lock);
+    while (!sink_waiting) {
+        pthread_cond_wait(&sink_changed, &sink_lock);
+    }
+    pthread_mutex_unlock(&sink_lock);
+}
+
+static void sink_log_reset(void)
+{
+    pthread_mutex_lock(&sink_lock);
+    sink_log_len = 0;
+    pthread_mutex_unlock(&sink_lock);
+}
+
+static void wait_not_busy(void)
+{
+    for (int ms = 0; audio_response_busy(); ms++) {
+        assert(ms < WAIT_MS);
+        usleep(1000);
+    }
+}
+
+/* Check that the sink log holds the first frames of a response at *pos */
+static void check_response(size_t *pos, int id, size_t frames)
+{
+    int num = file_num[id];
+
+    assert(*pos + frames <= sink_log_len);
+    for (size_t i = 0; i < frames; i++) {
+        assert(sink_log[*pos + i] == file_sample(num, i));
+    }
+    *pos += frames;
+}
+
+static void check_whole_response(size_t *pos, int id)
+{
+    check_response(pos, id, file_frames(file_num[id]));
+}
+
+void test_preload(bool verbose)
+{
+    audio_response_stats_t stats;
+
+    /* The startup preloads open the wakeup and sleep sounds without playing them */
+    for (int ms = 0; opens[file_num[1]] == 0 || opens[file_num[0]] == 0; ms++) {
+        assert(ms < WAIT_MS);
+        usleep(1000);
+    }
+    audio_response_stats_get(&stats);
+    assert(stats.cache_misses == 2);
+    assert(stats.play_count == 0);
+    assert(!audio_response_busy());
+    assert(sink_log_len == 0);
+
+    /* A cached response is played without opening its file again */
+    audio_response_play(1);
+    audio_response_stats_get(&stats);
+    assert(opens[file_num[1]] == 1);
+    assert(stats.cache_hits == 1);
+    assert(stats.play_count == 1);
+    sink_log_reset();
+
+    if (verbose) {
+        printf("preload ok\n");
+    }
+}
+
+void test_play(bool verbose)
+{
+    const int ids[] = {2, ONE_BLOCK_ID, TWO_BLOCKS_ID, SHORT_ID};
+    audio_response_stats_t before, after;
+    size_t pos = 0;
+
+    /* Every frame of each response is written in order, and nothing else */
+    audio_response_stats_get(&before);
+    for (int i = 0; i < sizeof(ids) / sizeof(ids[0]); i++) {
+        audio_response_play(ids[i]);
+        assert(!audio_response_busy());
+    }
+    for (int i = 0; i < sizeof(ids) / sizeof(ids[0]); i++) {
+        check_whole_response(&pos, ids[i]);
+    }
+    assert(pos == sink_log_len);
+    audio_response_stats_get(&after);
+    assert(after.play_count == before.play_count + 4);
+    assert(after.cache_misses == before.cache_misses + 4);
+
+    /* The cache holds the 4 most recently used files, the sleep sound was used last
+     * before them and is closed */
+    assert(closes[file_num[0]] == 1);
+    assert(closes[file_num[1]] == 1);
+    sink_log_reset();
+    audio_response_play(SHORT_ID);
+    audio_response_play(1);
+    audio_response_stats_get(&before);
+    assert(before.cache_hits == after.cache_hits + 1);
+    assert(before.cache_misses == after.cache_misses + 1);
+    assert(opens[file_num[1]] == 2);
+    pos = 0;
+    check_whole_response(&pos, SHORT_ID);
+    check_whole_response(&pos, 1);
+    assert(pos == sink_log_len);
+    sink_log_reset();
+
+    if (verbose) {
+        printf("play ok\n");
+    }
+}
+
+void test_queue(bool verbose)
+{
+    size_t pos = 0;
+
+    /* Started responses play in order, and play() waits for all of them */
+    audio_response_start(6);
+    audio_response_start(7);
+    audio_response_start(8);
+    audio_response_play(9);
+    assert(!audio_response_busy());
+
+    for (int id = 6; id <= 9; id++) {
+        check_whole_response(&pos, id);
+    }
+    assert(pos == sink_log_len);
+    sink_log_reset();
+
+    if (verbose) {
+        printf("queue ok\n");
+    }
+}
+
+void test_stop(bool verbose)
+{
+    size_t pos = 0;
+
+    /* Stop the playing and a queued response while the first block is written */
+    sink_hold_set(true);
+    audio_response_start(10);
+    audio_response_start(11);
+    sink_wait_held();
+    assert(audio_response_busy());
+    audio_response_stop();
+    sink_hold_set(false);
+    wait_not_busy();
+
+    check_response(&pos, 10, BLOCK_FRAMES);
+    assert(pos == sink_log_len);
+
+    /* Responses started after the stop play in full */
+    audio_response_play(12);
+    check_whole_response(&pos, 12);
+    assert(pos == sink_log_len);
+    sink_log_reset();
+
+    if (verbose) {
+        printf("stop ok\n");
+    }
+}
+
+void test_errors(bool verbose)
+{
+    audio_response_stats_t before, after;
+
+    /* Responses that cannot be played complete with no output */
+    audio_response_stats_get(&before);
+    audio_response_play(MISSING_ID);
+    audio_response_play(-1);
+    audio_response_play(NUM_IDS);
+    assert(!audio_response_busy());
+    assert(sink_log_len == 0);
+    audio_response_stats_get(&after);
+    assert(after.play_count == before.play_count);
+
+    if (verbose) {
+        printf("errors ok\n");
+    }
+}
+
+void test_preload_full(bool verbose)
+{
+    const int ids[] = {13, 2, ONE_BLOCK_ID, TWO_BLOCKS_ID, SHORT_ID};
+    audio_response_stats_t before, after;
+    size_t pos = 0;
+
+    /* Hold the player in the first response, then fill the queue behind it */
+    audio_response_stats_get(&before);
+    sink_hold_set(true);
+    audio_response_start(ids[0]);
+    sink_wait_held();
+    for (int i = 1; i < sizeof(ids) / sizeof(ids[0]); i++) {
+        audio_response_start(ids[i]);
+    }
+
+    /* A preload does not wait for the queue, it is dropped and counted */
+    audio_response_preload(6);
+    audio_response_stats_get(&after);
+    assert(after.preload_drops == before.preload_drops + 1);
+
+    sink_hold_set(false);
+    wait_not_busy();
+    for (int i = 0; i < sizeof(ids) / sizeof(ids[0]); i++) {
+        check_whole_response(&pos, ids[i]);
+    }
+    assert(pos == sink_log_len);
+    sink_log_reset();
+
+    if (verbose) {
+        printf("preload full ok\n");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bool verbose = argc > 1 && strcmp(argv[1], "-v") == 0;
+
+    audio_response_init();
+    audio_response_sink_set(&test_sink);
+
+    test_preload(verbose);
+    test_play(verbose);
+    test_queue(verbose);
+    test_stop(verbose);
+    test_errors(verbose);
+    test_preload_full(verbose);
+
+    printf("PASS\n");
+    return 0;
+}
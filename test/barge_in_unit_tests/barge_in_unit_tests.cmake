@@ -0,0 +1,20 @@
+set(BARGE_IN_PATH ${CMAKE_CURRENT_LIST_DIR}/../../modules/asr/intent_handler/barge_in)
+
+## The barge-in tests mix the playback and talk on the host
+if(NOT ${CMAKE_SYSTEM_NAME} STREQUAL XCORE_XS3A)
+    add_executable(test_barge_in
+        ${CMAKE_CURRENT_LIST_DIR}/src/test_barge_in.c
+        ${CMAKE_CURRENT_LIST_DIR}/../pipeline_host/src/host_wav.c
+        ${BARGE_IN_PATH}/barge_in.c
+    )
+
+    target_include_directories(test_barge_in
+        PRIVATE
+            ${BARGE_IN_PATH}
+            ${CMAKE_CURRENT_LIST_DIR}/../pipeline_host/src
+    )
+
+    target_compile_definitions(test_barge_in PRIVATE X86_BUILD=1)
+
+    target_link_libraries(test_barge_in PRIVATE m)
+endif()
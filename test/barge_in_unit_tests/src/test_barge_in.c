@@ -0,0 +1,268 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <math.h>
+
+#include "barge_in.h"
+#include "host_wav.h"
+
+#define xassert assert
+
+#define SAMPLE_RATE     (16000)
+#define BLOCK_LENGTH    (240)
+#define BLOCK_MS        (BLOCK_LENGTH * 1000 / SAMPLE_RATE)
+#define MAX_SAMPLES     (60 * SAMPLE_RATE)
+
+/* Microphone noise floor, about -66 dBFS */
+#define NOISE_LEVEL     (16)
+
+typedef struct {
+    int onset_ms;           // Start of the utterance
+    int response_end_ms;    // End of the echo of the response
+    int latency_ms;         // From the onset to the gate first hearing talk, -1 if never
+    float false_talk;       // Fraction of the echo before the onset taken for talk
+    barge_in_stats_t stats;
+} result_t;
+
+static int16_t response[MAX_SAMPLES];
+static int16_t utterance[MAX_SAMPLES];
+static int16_t mic[MAX_SAMPLES + 2 * SAMPLE_RATE];
+
+static int16_t saturate(float x)
+{
+    return x > INT16_MAX ? INT16_MAX : (x < INT16_MIN ? INT16_MIN : (int16_t)x);
+}
+
+static float uniform(void)
+{
+    return (float)rand() / RAND_MAX * 2.0f - 1.0f;
+}
+
+/* Low passed noise in syllables of 100 to 300 ms separated by 50 to 200 ms */
+static size_t speech_like(int16_t *buf, size_t n, float peak)
+{
+    size_t i = 0;
+    float lp = 0;
+
+    while (i < n) {
+        size_t syllable = SAMPLE_RATE * (100 + rand() % 200) / 1000;
+        size_t gap = SAMPLE_RATE * (50 + rand() % 150) / 1000;
+
+        for (size_t j = 0; j < syllable && i < n; j++, i++) {
+            float env = sinf((float)M_PI * j / syllable);
+            lp += 0.3f * (uniform() - lp);
+            buf[i] = saturate(peak * 3.0f * lp * env);
+        }
+        for (size_t j = 0; j < gap && i < n; j++, i++) {
+            buf[i] = 0;
+        }
+    }
+    return n;
+}
+
+static uint32_t block_level(const int16_t *buf, size_t len, size_t start)
+{
+    uint64_t sum = 0;
+
+    for (size_t i = start; i < start + BLOCK_LENGTH; i++) {
+        int32_t x = i < len ? buf[i] : 0;
+        sum += x * x;
+    }
+    return (uint32_t)(sum / BLOCK_LENGTH);
+}
+
+/*
+ * Play the response from time 0 and hear its echo, with a gain of echo_db and
+ * a delay and a weaker reflection, together with the utterance from offset_ms.
+ */
+static void run(const int16_t *resp, size_t resp_len, const int16_t *utt, size_t utt_len,
+                float echo_db, int delay_ms, int offset_ms, result_t *result, const char *out_path)
+{
+    const size_t delay = SAMPLE_RATE * delay_ms / 1000;
+    const size_t reflection = delay + SAMPLE_RATE * 23 / 1000;
+    const size_t offset = SAMPLE_RATE * offset_ms / 1000;
+    const float gain = powf(10.0f, echo_db / 20.0f);
+    size_t len = resp_len + reflection > offset + utt_len ? resp_len + reflection : offset + utt_len;
+    barge_in_t gate;
+    uint32_t utt_max = 0;
+    int onset_block = -1;
+    unsigned echo_blocks = 0;
+    unsigned false_blocks = 0;
+
+    len = (len + SAMPLE_RATE / 2) / BLOCK_LENGTH * BLOCK_LENGTH;
+    xassert(len <= sizeof(mic) / sizeof(mic[0]));
+
+    for (size_t i = 0; i < len; i++) {
+        float x = NOISE_LEVEL * uniform();
+
+        if (i >= delay && i - delay < resp_len) {
+            x += gain * resp[i - delay];
+        }
+        if (i >= reflection && i - reflection < resp_len) {
+            x += 0.3f * gain * resp[i - reflection];
+        }
+        if (i >= offset && i - offset < utt_len) {
+            x += utt[i - offset];
+        }
+        mic[i] = saturate(x);
+    }
+
+    /* The utterance starts with its first block within 20 dB of its loudest */
+    for (size_t i = 0; i < utt_len; i += BLOCK_LENGTH) {
+        uint32_t level = block_level(utt, utt_len, i);
+        utt_max = level > utt_max ? level : utt_max;
+    }
+    for (size_t i = 0; i < utt_len && onset_block < 0; i += BLOCK_LENGTH) {
+        if (block_level(utt, utt_len, i) > utt_max / 100) {
+            onset_block = (offset + i) / BLOCK_LENGTH;
+        }
+    }
+
+    if (onset_block < 0) {
+        onset_block = len / BLOCK_LENGTH;
+    }
+
+    memset(result, 0, sizeof(*result));
+    result->onset_ms = onset_block * BLOCK_MS;
+    result->response_end_ms = (resp_len + reflection) * 1000 / SAMPLE_RATE;
+    result->latency_ms = -1;
+
+    barge_in_init(&gate);
+    for (int b = 0; b < len / BLOCK_LENGTH; b++) {
+        size_t start = b * BLOCK_LENGTH;
+
+        if (start < resp_len) {
+            size_t n = resp_len - start < BLOCK_LENGTH ? resp_len - start : BLOCK_LENGTH;
+            barge_in_reference(&gate, &resp[start], n);
+        }
+        barge_in_decision_t decision = barge_in_process(&gate, &mic[start], BLOCK_LENGTH);
+
+        if (b < onset_block && decision != BARGE_IN_IDLE) {
+            echo_blocks++;
+            false_blocks += decision == BARGE_IN_TALK;
+        }
+        if (b >= onset_block && decision == BARGE_IN_TALK && result->latency_ms < 0) {
+            result->latency_ms = (b - onset_block) * BLOCK_MS;
+        }
+    }
+    result->false_talk = echo_blocks ? (float)false_blocks / echo_blocks : 0.0f;
+    barge_in_stats_get(&gate, &result->stats);
+
+    if (out_path != NULL) {
+        host_wav_t out;
+
+        if (host_wav_open_write(&out, out_path, 1, SAMPLE_RATE, len) != 0) {
+            printf("Cannot create %s\n", out_path);
+            exit(1);
+        }
+        for (size_t i = 0; i < len; i++) {
+            int32_t sample = (int32_t)mic[i] << 16;
+            host_wav_write(&out, &sample, 1);
+        }
+        host_wav_close(&out);
+    }
+}
+
+static void print_result(const char *name, const result_t *r)
+{
+    printf("%s: onset %d ms, response end %d ms, ", name, r->onset_ms, r->response_end_ms);
+    if (r->latency_ms < 0) {
+        printf("talk not heard over the response, ");
+    } else {
+        printf("talk heard after %d ms, %d ms before the response ends, ",
+               r->latency_ms, r->response_end_ms - r->onset_ms - r->latency_ms);
+    }
+    printf("false talk %.1f%%, coupling %.1f dB\n", 100.0f * r->false_talk, r->stats.coupling_db);
+}
+
+void test_synthetic(bool verbose)
+{
+    const size_t resp_len = 3 * SAMPLE_RATE;
+    const size_t utt_len = SAMPLE_RATE;
+    const float talk_db[] = {6, 12, 20};
+    result_t result;
+
+    speech_like(response, resp_len, 8000);
+
+    /* Echo only, the gate must not take it for talk */
+    run(response, resp_len, utterance, 0, -6, 40, 0, &result, NULL);
+    if (verbose) {
+        print_result("echo only", &result);
+    }
+    xassert(result.false_talk <= 0.02f);
+
+    /* A talker louder than the echo is heard soon after starting, when the
+     * coupling has settled during the first second of the response */
+    for (int i = 0; i < sizeof(talk_db) / sizeof(talk_db[0]); i++) {
+        char name[32];
+
+        speech_like(utterance, utt_len, 8000 * powf(10.0f, (talk_db[i] - 6) / 20.0f));
+        run(response, resp_len, utterance, utt_len, -6, 40, 1500, &result, NULL);
+        snprintf(name, sizeof(name), "talk %+.0f dB", talk_db[i]);
+        if (verbose) {
+            print_result(name, &result);
+        }
+        xassert(result.false_talk <= 0.05f);
+        if (talk_db[i] >= 12) {
+            xassert(result.latency_ms >= 0 && result.latency_ms <= 300);
+        }
+    }
+
+    /* Without playback the gate is idle */
+    speech_like(utterance, utt_len, 8000);
+    run(response, 0, utterance, utt_len, -6, 40, 0, &result, NULL);
+    xassert(result.stats.talk_count == 0 && result.stats.echo_count == 0);
+}
+
+static size_t load_mono(const char *path, int16_t *buf)
+{
+    host_wav_t wav;
+    int32_t sample;
+    size_t n = 0;
+
+    if (host_wav_open_read(&wav, path) != 0 || wav.channels != 1 || wav.sample_rate != SAMPLE_RATE) {
+        printf("%s: not a mono %d Hz wav file\n", path, SAMPLE_RATE);
+        exit(1);
+    }
+    while (n < MAX_SAMPLES && host_wav_read(&wav, &sample, 1) == 1) {
+        buf[n++] = sample >> 16;
+    }
+    host_wav_close(&wav);
+    return n;
+}
+
+/* test_barge_in mix <response.wav> <utterance.wav> [echo_db] [delay_ms] [offset_ms] [mixed.wav] */
+static void mix(int argc, char *argv[])
+{
+    size_t resp_len = load_mono(argv[2], response);
+    size_t utt_len = load_mono(argv[3], utterance);
+    float echo_db = argc > 4 ? strtof(argv[4], NULL) : -6.0f;
+    int delay_ms = argc > 5 ? atoi(argv[5]) : 40;
+    int offset_ms = argc > 6 ? atoi(argv[6]) : 500;
+    result_t result;
+
+    run(response, resp_len, utterance, utt_len, echo_db, delay_ms, offset_ms, &result,
+        argc > 7 ? argv[7] : NULL);
+    print_result(argv[3], &result);
+}
+
+int main(int argc, char *argv[])
+{
+    bool verbose = argc > 1 && strcmp(argv[1], "-v") == 0;
+
+    srand(1);
+
+    test_synthetic(verbose);
+
+    if (argc > 3 && strcmp(argv[1], "mix") == 0) {
+        mix(argc, argv);
+    }
+
+    printf("PASS\n");
+    return 0;
+}
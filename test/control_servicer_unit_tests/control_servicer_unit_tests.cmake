@@ -0,0 +1,17 @@
+set(CONTROL_PATH ${CMAKE_CURRENT_LIST_DIR}/../../examples/ffva/src/control)
+
+## The servicer is tested on the host against stubs of the device control headers
+if(NOT ${CMAKE_SYSTEM_NAME} STREQUAL XCORE_XS3A)
+    add_executable(test_servicer
+        ${CMAKE_CURRENT_LIST_DIR}/src/test_servicer.c
+        ${CONTROL_PATH}/servicer.c
+    )
+
+    target_include_directories(test_servicer
+        PRIVATE
+            ${CMAKE_CURRENT_LIST_DIR}/src/stubs
+            ${CONTROL_PATH}
+    )
+
+    target_compile_definitions(test_servicer PRIVATE X86_BUILD=1)
+endif()
@@ -0,0 +1,9 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef DEBUG_PRINT_H_
+#define DEBUG_PRINT_H_
+
+#define debug_printf(...)
+
+#endif /* DEBUG_PRINT_H_ */
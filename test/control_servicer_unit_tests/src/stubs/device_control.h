@@ -0,0 +1,18 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef DEVICE_CONTROL_H_
+#define DEVICE_CONTROL_H_
+
+/* The subset of the device control API used by the FFVA servicer */
+
+#include <stddef.h>
+#include "device_control_shared.h"
+
+#define DEVICE_CONTROL_CALLBACK_ATTR
+
+typedef struct {
+    int unused;
+} device_control_t;
+
+#endif /* DEVICE_CONTROL_H_ */
@@ -0,0 +1,9 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef DEVICE_CONTROL_I2C_H_
+#define DEVICE_CONTROL_I2C_H_
+
+#include "device_control.h"
+
+#endif /* DEVICE_CONTROL_I2C_H_ */
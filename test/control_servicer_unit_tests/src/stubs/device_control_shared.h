@@ -0,0 +1,29 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef DEVICE_CONTROL_SHARED_H_
+#define DEVICE_CONTROL_SHARED_H_
+
+/* The subset of the device control types used by the FFVA servicer */
+
+#include <stdint.h>
+
+typedef uint8_t control_resid_t;
+typedef uint8_t control_cmd_t;
+
+typedef enum {
+    CONTROL_SUCCESS = 0,
+    CONTROL_REGISTRATION_FAILED,
+    CONTROL_BAD_COMMAND,
+    CONTROL_DATA_LENGTH_ERROR,
+    CONTROL_OTHER_TRANSPORT_ERROR,
+    CONTROL_ERROR,
+    SERVICER_COMMAND_RETRY,
+    SERVICER_WRONG_COMMAND_ID,
+    SERVICER_WRONG_COMMAND_LEN,
+    SERVICER_WRONG_PAYLOAD,
+    SERVICER_QUEUE_FULL,
+    SERVICER_RESOURCE_ERROR,
+} control_ret_t;
+
+#endif /* DEVICE_CONTROL_SHARED_H_ */
@@ -0,0 +1,14 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef PLATFORM_H_
+#define PLATFORM_H_
+
+#include <assert.h>
+
+#define xassert assert
+
+#define THIS_XCORE_TILE 0
+#define ON_TILE(t) (t == THIS_XCORE_TILE)
+
+#endif /* PLATFORM_H_ */
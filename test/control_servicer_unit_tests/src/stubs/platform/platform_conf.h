@@ -0,0 +1,11 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef PLATFORM_CONF_H_
+#define PLATFORM_CONF_H_
+
+/* The servicer is tested without a transport */
+#define appconfI2C_DFU_ENABLED 0
+#define I2C_CTRL_TILE_NO 0
+
+#endif /* PLATFORM_CONF_H_ */
@@ -0,0 +1,237 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "servicer.h"
+
+#define xassert assert
+
+#define RESID_A     (240)
+#define RESID_B     (3)
+
+#define CMD_A_STATUS    (3)
+#define CMD_A_BLOCK     (65)
+#define CMD_A_RESET     (89)
+#define CMD_B_GAIN      (0)
+#define CMD_B_LEVELS    (127)
+
+/* Last command seen by the handlers */
+static control_resource_info_t *last_res_info;
+static control_cmd_t last_cmd;
+static size_t last_len;
+static uint8_t block[2];
+static int resets;
+
+/* Read responses are filled with the command ID plus the byte offset */
+CONTROL_CMD_READ_FPTRGROUP
+static control_ret_t test_read_cmd(control_resource_info_t *res_info, control_cmd_t cmd, uint8_t *payload, size_t payload_len)
+{
+    last_res_info = res_info;
+    last_cmd = cmd;
+    last_len = payload_len;
+
+    if (res_info->resource == RESID_A && CONTROL_CMD_CLEAR_READ(cmd) == CMD_A_BLOCK) {
+        memcpy(payload, block, sizeof(block));
+        return CONTROL_SUCCESS;
+    }
+    for (size_t i = 0; i < payload_len; i++) {
+        payload[i] = CONTROL_CMD_CLEAR_READ(cmd) + i;
+    }
+    return (res_info->resource == RESID_B && CONTROL_CMD_CLEAR_READ(cmd) == CMD_B_LEVELS) ? CONTROL_ERROR : CONTROL_SUCCESS;
+}
+
+CONTROL_CMD_WRITE_FPTRGROUP
+static control_ret_t test_write_cmd(control_resource_info_t *res_info, control_cmd_t cmd, const uint8_t *payload, size_t payload_len)
+{
+    last_res_info = res_info;
+    last_cmd = cmd;
+    last_len = payload_len;
+
+    if (CONTROL_CMD_CLEAR_READ(cmd) == CMD_A_BLOCK) {
+        memcpy(block, payload, sizeof(block));
+    } else if (CONTROL_CMD_CLEAR_READ(cmd) == CMD_A_RESET) {
+        resets++;
+    }
+    return CONTROL_SUCCESS;
+}
+
+static control_cmd_info_t res_a_cmd_map[] =
+{
+    { CMD_A_STATUS, 5, sizeof(uint8_t), CMD_READ_ONLY, test_read_cmd, NULL },
+    { CMD_A_BLOCK, 2, sizeof(uint8_t), CMD_READ_WRITE, test_read_cmd, test_write_cmd },
+    { CMD_A_RESET, 1, sizeof(uint8_t), CMD_WRITE_ONLY, NULL, test_write_cmd },
+};
+
+static control_cmd_info_t res_b_cmd_map[] =
+{
+    { CMD_B_GAIN, 1, sizeof(int32_t), CMD_READ_WRITE, test_read_cmd, test_write_cmd },
+    { CMD_B_LEVELS, 2, sizeof(uint8_t), CMD_READ_ONLY, test_read_cmd, NULL },
+};
+
+static control_resource_info_t res_info[2];
+static servicer_t servicer;
+
+static void setup(void)
+{
+    memset(&servicer, 0, sizeof(servicer));
+    servicer.num_resources = 2;
+    servicer.res_info = res_info;
+    res_info[0].resource = RESID_A;
+    res_info[0].command_map.num_commands = sizeof(res_a_cmd_map) / sizeof(res_a_cmd_map[0]);
+    res_info[0].command_map.commands = res_a_cmd_map;
+    res_info[1].resource = RESID_B;
+    res_info[1].command_map.num_commands = sizeof(res_b_cmd_map) / sizeof(res_b_cmd_map[0]);
+    res_info[1].command_map.commands = res_b_cmd_map;
+    servicer_index_init(&servicer);
+}
+
+void test_lookup(bool verbose)
+{
+    setup();
+
+    xassert(get_res_info(RESID_A, &servicer) == &res_info[0]);
+    xassert(get_res_info(RESID_B, &servicer) == &res_info[1]);
+    for (int resid = 0; resid < SERVICER_RESID_COUNT; resid++) {
+        if (resid != RESID_A && resid != RESID_B) {
+            xassert(get_res_info(resid, &servicer) == NULL);
+        }
+    }
+
+    for (int cmd_id = 0; cmd_id < 256; cmd_id++) {
+        control_cmd_info_t *expected = NULL;
+
+        for (int i = 0; i < res_info[0].command_map.num_commands; i++) {
+            if (res_a_cmd_map[i].cmd_id == cmd_id) {
+                expected = &res_a_cmd_map[i];
+            }
+        }
+        xassert(get_cmd_info(cmd_id, &res_info[0]) == expected);
+    }
+    xassert(get_cmd_info(CMD_B_LEVELS, &res_info[1]) == &res_b_cmd_map[1]);
+    xassert(get_cmd_info(CMD_B_GAIN, &res_info[1]) == &res_b_cmd_map[0]);
+
+    if (verbose) {
+        printf("lookup ok\n");
+    }
+}
+
+void test_dispatch(bool verbose)
+{
+    uint8_t payload[64];
+
+    setup();
+
+    /* Reads go to the read handler without the status byte */
+    xassert(read_cmd(RESID_A, CONTROL_CMD_SET_READ(CMD_A_STATUS), payload, 6, &servicer) == CONTROL_SUCCESS);
+    xassert(payload[0] == CONTROL_SUCCESS);
+    xassert(payload[1] == CMD_A_STATUS && payload[5] == CMD_A_STATUS + 4);
+    xassert(last_res_info == &res_info[0] && last_cmd == CONTROL_CMD_SET_READ(CMD_A_STATUS) && last_len == 5);
+
+    /* Writes go to the write handler */
+    payload[0] = 0x12;
+    payload[1] = 0x34;
+    xassert(write_cmd(RESID_A, CMD_A_BLOCK, payload, 2, &servicer) == CONTROL_SUCCESS);
+    xassert(read_cmd(RESID_A, CONTROL_CMD_SET_READ(CMD_A_BLOCK), payload, 3, &servicer) == CONTROL_SUCCESS);
+    xassert(payload[1] == 0x12 && payload[2] == 0x34);
+    xassert(write_cmd(RESID_A, CMD_A_RESET, payload, 1, &servicer) == CONTROL_SUCCESS);
+    xassert(resets == 1);
+
+    /* Unknown commands, wrong directions and wrong lengths are rejected before the handlers */
+    last_res_info = NULL;
+    xassert(read_cmd(RESID_A, CONTROL_CMD_SET_READ(4), payload, 2, &servicer) == SERVICER_WRONG_COMMAND_ID);
+    xassert(payload[0] == SERVICER_WRONG_COMMAND_ID);
+    xassert(read_cmd(RESID_A, CONTROL_CMD_SET_READ(CMD_A_RESET), payload, 2, &servicer) == SERVICER_WRONG_COMMAND_ID);
+    xassert(write_cmd(RESID_A, CMD_A_STATUS, payload, 5, &servicer) == SERVICER_WRONG_COMMAND_ID);
+    xassert(write_cmd(RESID_B, CMD_A_BLOCK, payload, 2, &servicer) == SERVICER_WRONG_COMMAND_ID);
+    xassert(read_cmd(RESID_A, CONTROL_CMD_SET_READ(CMD_A_STATUS), payload, 5, &servicer) == SERVICER_WRONG_COMMAND_LEN);
+    xassert(write_cmd(RESID_B, CMD_B_GAIN, payload, 1, &servicer) == SERVICER_WRONG_COMMAND_LEN);
+    xassert(last_res_info == NULL);
+    xassert(resets == 1);
+
+    if (verbose) {
+        printf("dispatch ok\n");
+    }
+}
+
+void test_batch(bool verbose)
+{
+    uint8_t payload[64];
+    uint8_t select[2 * (SERVICER_BATCH_MAX_CMDS + 1)];
+
+    setup();
+    block[0] = 0xAB;
+    block[1] = 0xCD;
+
+    /* Nothing can be read before commands are selected */
+    xassert(read_cmd(RESID_A, CONTROL_CMD_SET_READ(SERVICER_CMD_BATCH_READ), payload, 2, &servicer) == SERVICER_WRONG_COMMAND_LEN);
+
+    /* Commands of both resources, selected through either resource */
+    select[0] = RESID_B; select[1] = CMD_B_GAIN;
+    select[2] = RESID_A; select[3] = CMD_A_BLOCK;
+    select[4] = RESID_A; select[5] = CMD_A_STATUS;
+    xassert(write_cmd(RESID_B, SERVICER_CMD_BATCH_SELECT, select, 6, &servicer) == CONTROL_SUCCESS);
+    xassert(servicer.batch_payload_len == (1 + 4) + (1 + 2) + (1 + 5));
+
+    memset(payload, 0xEE, sizeof(payload));
+    xassert(read_cmd(RESID_A, CONTROL_CMD_SET_READ(SERVICER_CMD_BATCH_READ), payload, 1 + 14, &servicer) == CONTROL_SUCCESS);
+    xassert(payload[0] == CONTROL_SUCCESS);
+    xassert(payload[1] == CONTROL_SUCCESS);
+    xassert(payload[2] == CMD_B_GAIN && payload[5] == CMD_B_GAIN + 3);
+    xassert(payload[6] == CONTROL_SUCCESS);
+    xassert(payload[7] == 0xAB && payload[8] == 0xCD);
+    xassert(payload[9] == CONTROL_SUCCESS);
+    xassert(payload[10] == CMD_A_STATUS && payload[14] == CMD_A_STATUS + 4);
+    xassert(payload[15] == 0xEE);
+
+    /* The selection stays for the next reads, which must ask for its whole length */
+    xassert(read_cmd(RESID_A, CONTROL_CMD_SET_READ(SERVICER_CMD_BATCH_READ), payload, 1 + 13, &servicer) == SERVICER_WRONG_COMMAND_LEN);
+    block[0] = 0x01;
+    xassert(read_cmd(RESID_B, CONTROL_CMD_SET_READ(SERVICER_CMD_BATCH_READ), payload, 1 + 14, &servicer) == CONTROL_SUCCESS);
+    xassert(payload[7] == 0x01);
+
+    /* The first failing command gives the status of the batch, the others are still read */
+    select[0] = RESID_B; select[1] = CMD_B_LEVELS;
+    select[2] = RESID_A; select[3] = CMD_A_STATUS;
+    xassert(write_cmd(RESID_A, SERVICER_CMD_BATCH_SELECT, select, 4, &servicer) == CONTROL_SUCCESS);
+    xassert(read_cmd(RESID_A, CONTROL_CMD_SET_READ(SERVICER_CMD_BATCH_READ), payload, 1 + 3 + 6, &servicer) == CONTROL_ERROR);
+    xassert(payload[0] == CONTROL_ERROR);
+    xassert(payload[1] == CONTROL_ERROR);
+    xassert(payload[4] == CONTROL_SUCCESS);
+    xassert(payload[5] == CMD_A_STATUS);
+
+    /* Unknown and write only commands, and too many commands, are not selected */
+    select[0] = RESID_A; select[1] = CMD_A_RESET;
+    xassert(write_cmd(RESID_A, SERVICER_CMD_BATCH_SELECT, select, 2, &servicer) == SERVICER_WRONG_PAYLOAD);
+    xassert(servicer.num_batch_cmds == 0);
+    select[0] = 7; select[1] = CMD_A_STATUS;
+    xassert(write_cmd(RESID_A, SERVICER_CMD_BATCH_SELECT, select, 2, &servicer) == SERVICER_WRONG_PAYLOAD);
+    xassert(write_cmd(RESID_A, SERVICER_CMD_BATCH_SELECT, select, 3, &servicer) == SERVICER_WRONG_COMMAND_LEN);
+    for (int i = 0; i <= SERVICER_BATCH_MAX_CMDS; i++) {
+        select[2 * i] = RESID_A;
+        select[2 * i + 1] = CMD_A_BLOCK;
+    }
+    xassert(write_cmd(RESID_A, SERVICER_CMD_BATCH_SELECT, select, 2 * SERVICER_BATCH_MAX_CMDS, &servicer) == CONTROL_SUCCESS);
+    xassert(write_cmd(RESID_A, SERVICER_CMD_BATCH_SELECT, select, sizeof(select), &servicer) == SERVICER_WRONG_COMMAND_LEN);
+    xassert(read_cmd(RESID_A, CONTROL_CMD_SET_READ(SERVICER_CMD_BATCH_READ), payload, 2, &servicer) == SERVICER_WRONG_COMMAND_LEN);
+
+    if (verbose) {
+        printf("batch ok\n");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bool verbose = argc > 1 && strcmp(argv[1], "-v") == 0;
+
+    test_lookup(verbose);
+    test_dispatch(verbose);
+    test_batch(verbose);
+
+    printf("PASS\n");
+    return 0;
+}
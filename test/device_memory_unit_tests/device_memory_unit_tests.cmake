@@ -0,0 +1,36 @@
+set(DEVICE_MEMORY_PATH ${CMAKE_CURRENT_LIST_DIR}/../../modules/asr/device_memory)
+
+## The device memory tests run against a simulated flash on the host
+if(NOT ${CMAKE_SYSTEM_NAME} STREQUAL XCORE_XS3A)
+    find_package(Threads REQUIRED)
+
+    add_executable(test_devmem_async
+        ${CMAKE_CURRENT_LIST_DIR}/src/test_devmem_async.c
+        ${CMAKE_CURRENT_LIST_DIR}/src/devmem_async_port.c
+        ${CMAKE_CURRENT_LIST_DIR}/src/sim_flash.c
+        ${DEVICE_MEMORY_PATH}/devmem_async.c
+    )
+
+    target_include_directories(test_devmem_async
+        PRIVATE
+            ${CMAKE_CURRENT_LIST_DIR}/src
+            ${DEVICE_MEMORY_PATH}
+    )
+
+    target_compile_definitions(test_devmem_async PRIVATE X86_BUILD=1)
+
+    target_link_libraries(test_devmem_async PRIVATE Threads::Threads)
+
+    add_executable(test_devmem_cache
+        ${CMAKE_CURRENT_LIST_DIR}/src/test_devmem_cache.c
+        ${DEVICE_MEMORY_PATH}/devmem_cache.c
+    )
+
+    target_include_directories(test_devmem_cache
+        PRIVATE
+            ${CMAKE_CURRENT_LIST_DIR}/src
+            ${DEVICE_MEMORY_PATH}
+    )
+
+    target_compile_definitions(test_devmem_cache PRIVATE X86_BUILD=1)
+endif()
@@ -0,0 +1,65 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "devmem_async.h"
+#include "devmem_async_port.h"
+
+/* Completions seen by this thread since its devmem_async_port_wait_begin() */
+static _Thread_local unsigned done_seen;
+
+void devmem_async_port_init(devmem_async_port_t *port)
+{
+    sem_init(&port->work, 0, 0);
+    pthread_mutex_init(&port->lock, NULL);
+    pthread_cond_init(&port->done, NULL);
+    port->done_count = 0;
+}
+
+void devmem_async_port_signal_work(void *port_ctx)
+{
+    sem_post(&((devmem_async_port_t *)port_ctx)->work);
+}
+
+void devmem_async_port_wait_work(void *port_ctx)
+{
+    while (sem_wait(&((devmem_async_port_t *)port_ctx)->work) != 0) {
+    }
+}
+
+void devmem_async_port_signal_done(void *port_ctx)
+{
+    devmem_async_port_t *port = port_ctx;
+
+    pthread_mutex_lock(&port->lock);
+    port->done_count++;
+    pthread_cond_broadcast(&port->done);
+    pthread_mutex_unlock(&port->lock);
+}
+
+void devmem_async_port_wait_begin(void *port_ctx)
+{
+    devmem_async_port_t *port = port_ctx;
+
+    pthread_mutex_lock(&port->lock);
+    done_seen = port->done_count;
+    pthread_mutex_unlock(&port->lock);
+}
+
+void devmem_async_port_wait_done(void *port_ctx)
+{
+    devmem_async_port_t *port = port_ctx;
+
+    pthread_mutex_lock(&port->lock);
+    while (port->done_count == done_seen) {
+        pthread_cond_wait(&port->done, &port->lock);
+    }
+    done_seen = port->done_count;
+    pthread_mutex_unlock(&port->lock);
+}
+
+void devmem_async_port_wait_end(void *port_ctx)
+{
+    (void)port_ctx;
+}
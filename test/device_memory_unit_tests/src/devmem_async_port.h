@@ -0,0 +1,19 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#ifndef DEVMEM_ASYNC_PORT_H
+#define DEVMEM_ASYNC_PORT_H
+
+#include <pthread.h>
+#include <semaphore.h>
+
+/* POSIX implementation of the devmem_async signalling for host tests */
+typedef struct {
+    sem_t work;
+    pthread_mutex_t lock;
+    pthread_cond_t done;
+    unsigned done_count;    // Completions signalled
+} devmem_async_port_t;
+
+void devmem_async_port_init(devmem_async_port_t *port);
+
+#endif // DEVMEM_ASYNC_PORT_H
@@ -0,0 +1,67 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <sys/prctl.h>
+#include <assert.h>
+
+#include "sim_flash.h"
+
+static uint8_t *flash_image;
+static size_t flash_size;
+static unsigned flash_latency_ns;
+static unsigned flash_bytes_per_us;
+static sim_flash_stats_t flash_stats;
+
+void sim_flash_init(uint8_t *image, size_t size, unsigned latency_ns, unsigned bytes_per_us)
+{
+    assert(bytes_per_us > 0);
+    flash_image = image;
+    flash_size = size;
+    flash_latency_ns = latency_ns;
+    flash_bytes_per_us = bytes_per_us;
+    memset(&flash_stats, 0, sizeof(flash_stats));
+
+    /* Wake up from the simulated transfers on time */
+    prctl(PR_SET_TIMERSLACK, 1);
+}
+
+uint64_t sim_flash_time_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void sim_flash_spin_ns(uint64_t ns)
+{
+    uint64_t end = sim_flash_time_ns() + ns;
+
+    while (sim_flash_time_ns() < end) {
+    }
+}
+
+void sim_flash_read(void *dest, const void *src, size_t n)
+{
+    const uint8_t *s = src;
+    uint64_t end = sim_flash_time_ns() + flash_latency_ns + ((uint64_t)n * 1000) / flash_bytes_per_us;
+    struct timespec ts = {(time_t)(end / 1000000000ull), (long)(end % 1000000000ull)};
+
+    assert(s >= flash_image && s + n <= flash_image + flash_size);
+
+    /* The transfer is done by the flash controller, so sleep rather than
+     * spin. This leaves the CPU to the caller when the host has one core. */
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0) {
+    }
+    memcpy(dest, s, n);
+
+    flash_stats.read_count++;
+    flash_stats.read_bytes += n;
+}
+
+void sim_flash_stats_get(sim_flash_stats_t *stats)
+{
+    *stats = flash_stats;
+}
@@ -0,0 +1,31 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#ifndef SIM_FLASH_H
+#define SIM_FLASH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Simulated flash for host tests. Reads copy from an in memory image and
+ * block for the time a QSPI read of the same size would take: a fixed
+ * command latency plus the transfer at a given throughput.
+ */
+typedef struct {
+    uint32_t read_count;
+    uint64_t read_bytes;
+} sim_flash_stats_t;
+
+void sim_flash_init(uint8_t *image, size_t size, unsigned latency_ns, unsigned bytes_per_us);
+
+void sim_flash_read(void *dest, const void *src, size_t n);
+
+void sim_flash_stats_get(sim_flash_stats_t *stats);
+
+/* Monotonic time in nanoseconds */
+uint64_t sim_flash_time_ns(void);
+
+/* Busy wait for ns nanoseconds, as a stand in for computation or a transfer */
+void sim_flash_spin_ns(uint64_t ns);
+
+#endif // SIM_FLASH_H
@@ -0,0 +1,206 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <assert.h>
+
+#include "devmem_async.h"
+#include "devmem_async_port.h"
+#include "sim_flash.h"
+
+#define xassert assert
+
+#define TEST_FLASH_SIZE         (256 * 1024)
+#define TEST_PREFETCH_SIZE      (1024)
+#define TEST_ITERATIONS         (2000)
+
+/* Benchmark defaults, roughly a QSPI flash in fast read mode */
+#define BENCH_LATENCY_NS        (10000)
+#define BENCH_BYTES_PER_US      (25)
+#define BENCH_READ_SIZE         (256)
+#define BENCH_COMPUTE_NS        (15000)
+#define BENCH_READS             (2000)
+
+static uint8_t flash_image[TEST_FLASH_SIZE];
+static uint8_t prefetch_storage[2 * TEST_PREFETCH_SIZE];
+static uint8_t dest[TEST_FLASH_SIZE];
+
+static devmem_async_t ctx;
+static devmem_async_port_t port;
+static pthread_t reader;
+
+static void *reader_thread(void *arg)
+{
+    devmem_async_reader_run((devmem_async_t *)arg);
+    return NULL;
+}
+
+static void reader_start(bool prefetch)
+{
+    devmem_async_port_init(&port);
+    devmem_async_init(&ctx, sim_flash_read,
+                      prefetch ? prefetch_storage : NULL, TEST_PREFETCH_SIZE,
+                      flash_image, sizeof(flash_image), &port);
+    pthread_create(&reader, NULL, reader_thread, &ctx);
+}
+
+static void reader_stop(void)
+{
+    devmem_async_stop(&ctx);
+    pthread_join(reader, NULL);
+}
+
+void test_async_reads(bool verbose)
+{
+    int handle[DEVMEM_ASYNC_QUEUE_DEPTH * 2];
+    size_t offset[DEVMEM_ASYNC_QUEUE_DEPTH * 2];
+    size_t len[DEVMEM_ASYNC_QUEUE_DEPTH * 2];
+
+    sim_flash_init(flash_image, sizeof(flash_image), 0, 1000);
+    reader_start(false);
+
+    /* More requests than the queue holds, waited for out of order */
+    for (int itt = 0; itt < TEST_ITERATIONS / 100; itt++) {
+        memset(dest, 0, sizeof(dest));
+        for (int i = 0; i < DEVMEM_ASYNC_QUEUE_DEPTH * 2; i++) {
+            len[i] = 4 + (rand() % 512);
+            offset[i] = (rand() % (TEST_FLASH_SIZE - len[i])) & ~3;
+            handle[i] = devmem_async_read_start(&ctx, &dest[offset[i]], &flash_image[offset[i]], len[i]);
+        }
+        for (int i = DEVMEM_ASYNC_QUEUE_DEPTH * 2 - 1; i >= 0; i--) {
+            devmem_async_read_wait(&ctx, handle[i]);
+            int done = devmem_async_read_done(&ctx, handle[i]);
+            xassert(done);
+        }
+        for (int i = 0; i < DEVMEM_ASYNC_QUEUE_DEPTH * 2; i++) {
+            xassert(memcmp(&dest[offset[i]], &flash_image[offset[i]], len[i]) == 0);
+        }
+    }
+    reader_stop();
+
+    if (verbose) {
+        printf("async reads ok\n");
+    }
+}
+
+void test_prefetch_reads(bool verbose)
+{
+    devmem_async_stats_t stats;
+    uint8_t buf[TEST_PREFETCH_SIZE + 64];
+
+    sim_flash_init(flash_image, sizeof(flash_image), 0, 1000);
+    reader_start(true);
+
+    /* Sequential runs with random jumps, sizes either side of the buffer size */
+    size_t offset = 0;
+    for (int itt = 0; itt < TEST_ITERATIONS; itt++) {
+        size_t n = 4 * (1 + rand() % ((TEST_PREFETCH_SIZE + 64) / 4));
+        if ((rand() % 16) == 0 || offset + n > TEST_FLASH_SIZE) {
+            offset = (rand() % (TEST_FLASH_SIZE - n)) & ~3;
+        }
+        devmem_async_read(&ctx, buf, &flash_image[offset], n);
+        xassert(memcmp(buf, &flash_image[offset], n) == 0);
+        offset += n;
+    }
+
+    /* Reads up to the end of the region must not prefetch past it */
+    devmem_async_read(&ctx, buf, &flash_image[TEST_FLASH_SIZE - 128], 128);
+    xassert(memcmp(buf, &flash_image[TEST_FLASH_SIZE - 128], 128) == 0);
+
+    devmem_async_stats_get(&ctx, &stats);
+    reader_stop();
+
+    xassert(stats.read_count == TEST_ITERATIONS + 1);
+    xassert(stats.prefetch_hit_count > 0);
+    if (verbose) {
+        printf("prefetch reads %u hits %u waits %u\n",
+               (unsigned)stats.read_count, (unsigned)stats.prefetch_hit_count, (unsigned)stats.prefetch_wait_count);
+    }
+}
+
+/*
+ * Emulate a model evaluation: sequential reads of the model, each followed
+ * by some computation on the data read.
+ */
+static uint64_t bench_run(bool prefetch, unsigned latency_ns, unsigned bytes_per_us,
+                          unsigned read_size, unsigned compute_ns, devmem_async_stats_t *stats)
+{
+    uint8_t buf[BENCH_READ_SIZE * 16];
+    size_t offset = 0;
+
+    assert(read_size <= sizeof(buf));
+
+    sim_flash_init(flash_image, sizeof(flash_image), latency_ns, bytes_per_us);
+    reader_start(prefetch);
+
+    uint64_t start = sim_flash_time_ns();
+    for (int i = 0; i < BENCH_READS; i++) {
+        if (offset + read_size > TEST_FLASH_SIZE) {
+            offset = 0;
+        }
+        devmem_async_read(&ctx, buf, &flash_image[offset], read_size);
+        offset += read_size;
+        sim_flash_spin_ns(compute_ns);
+    }
+    uint64_t elapsed = sim_flash_time_ns() - start;
+
+    devmem_async_stats_get(&ctx, stats);
+    reader_stop();
+    return elapsed;
+}
+
+void bench_prefetch(unsigned latency_ns, unsigned bytes_per_us, unsigned read_size, unsigned compute_ns)
+{
+    devmem_async_stats_t stats;
+
+    printf("flash latency %u ns, %u bytes/us, %u byte reads, %u ns compute per read\n",
+           latency_ns, bytes_per_us, read_size, compute_ns);
+
+    uint64_t t_sync = bench_run(false, latency_ns, bytes_per_us, read_size, compute_ns, &stats);
+    printf("  no prefetch: %8.2f us per read\n", (double)t_sync / BENCH_READS / 1000);
+
+    uint64_t t_prefetch = bench_run(true, latency_ns, bytes_per_us, read_size, compute_ns, &stats);
+    printf("  prefetch:    %8.2f us per read, %u/%u hits, %u waits\n",
+           (double)t_prefetch / BENCH_READS / 1000,
+           (unsigned)stats.prefetch_hit_count, (unsigned)stats.read_count, (unsigned)stats.prefetch_wait_count);
+    printf("  speedup:     %8.2f\n", (double)t_sync / t_prefetch);
+}
+
+int main(int argc, char *argv[])
+{
+    bool verbose = false;
+    bool bench = false;
+    unsigned latency_ns = BENCH_LATENCY_NS;
+    unsigned bytes_per_us = BENCH_BYTES_PER_US;
+    unsigned read_size = BENCH_READ_SIZE;
+    unsigned compute_ns = BENCH_COMPUTE_NS;
+
+    /* test_devmem_async [bench [latency_ns [bytes_per_us [read_size [compute_ns]]]]] */
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        bench = true;
+        if (argc > 2) latency_ns = atoi(argv[2]);
+        if (argc > 3) bytes_per_us = atoi(argv[3]);
+        if (argc > 4) read_size = atoi(argv[4]);
+        if (argc > 5) compute_ns = atoi(argv[5]);
+    }
+
+    srand(1);
+    for (int i = 0; i < TEST_FLASH_SIZE; i++) {
+        flash_image[i] = (uint8_t)rand();
+    }
+
+    test_async_reads(verbose);
+
+    test_prefetch_reads(verbose);
+
+    if (bench) {
+        bench_prefetch(latency_ns, bytes_per_us, read_size, compute_ns);
+    }
+
+    printf("PASS\n");
+    return 0;
+}
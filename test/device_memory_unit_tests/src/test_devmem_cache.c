@@ -0,0 +1,293 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "devmem_cache.h"
+
+#define xassert assert
+
+#define TEST_FLASH_SIZE         (256 * 1024)
+#define TEST_ITERATIONS         (5000)
+
+/* Cost model of the flash for the trace replay, see test/device_memory_unit_tests/README.rst */
+#define TRACE_LATENCY_NS        (10000)
+#define TRACE_BYTES_PER_US      (25)
+#define TRACE_MAX_READS         (1 << 20)
+
+/* Synthetic trace: each frame reads a model in 512 byte chunks and looks up a small table */
+#define SYNTH_FRAMES            (20)
+#define SYNTH_MODEL_SIZE        (96 * 1024)
+#define SYNTH_MODEL_READ        (512)
+#define SYNTH_TABLE_OFFSET      (128 * 1024)
+#define SYNTH_TABLE_SIZE        (8 * 1024)
+#define SYNTH_TABLE_READ        (64)
+
+typedef struct {
+    uint32_t read_count;
+    uint64_t read_bytes;
+} fill_stats_t;
+
+typedef struct {
+    uint32_t offset;
+    uint32_t size;
+} trace_read_t;
+
+/* Aligned like the flash, so that blocks do not straddle the start of the region */
+static uint8_t flash_image[TEST_FLASH_SIZE] __attribute__((aligned(4096)));
+static uint8_t dest[TEST_FLASH_SIZE];
+static uint64_t storage[(TEST_FLASH_SIZE + 64 * 1024) / sizeof(uint64_t)];
+static trace_read_t trace[TRACE_MAX_READS];
+
+static void fill(void *fill_ctx, void *d, const void *src, size_t n)
+{
+    fill_stats_t *stats = fill_ctx;
+    const uint8_t *s = src;
+
+    xassert(s >= flash_image && s + n <= flash_image + TEST_FLASH_SIZE);
+    memcpy(d, s, n);
+    stats->read_count++;
+    stats->read_bytes += n;
+}
+
+void test_cache_reads(bool verbose)
+{
+    const unsigned num_blocks[] = {1, 4, 33, 256};
+    const size_t block_size[] = {64, 512, 1024, 256};
+
+    for (int cfg = 0; cfg < sizeof(num_blocks) / sizeof(num_blocks[0]); cfg++) {
+        devmem_cache_t cache;
+        devmem_cache_stats_t stats;
+        fill_stats_t fill_stats = {0};
+
+        xassert(devmem_cache_storage_size(num_blocks[cfg], block_size[cfg]) <= sizeof(storage));
+        devmem_cache_init(&cache, storage, num_blocks[cfg], block_size[cfg], fill, &fill_stats,
+                          flash_image, sizeof(flash_image));
+
+        /* Mostly local reads so that there are hits as well as misses */
+        size_t offset = 0;
+        for (int itt = 0; itt < TEST_ITERATIONS; itt++) {
+            size_t n = 4 * (1 + rand() % 300);
+            if ((rand() % 8) == 0) {
+                offset = (rand() % (TEST_FLASH_SIZE - n)) & ~3;
+            } else {
+                offset = (offset + 4 * (rand() % 64)) % (TEST_FLASH_SIZE - n);
+                offset &= ~3;
+            }
+            memset(dest, 0, n);
+            devmem_cache_read(&cache, dest, &flash_image[offset], n);
+            xassert(memcmp(dest, &flash_image[offset], n) == 0);
+        }
+
+        devmem_cache_stats_get(&cache, &stats);
+        xassert(stats.miss_count + stats.bypass_count <= fill_stats.read_count);
+        xassert(stats.eviction_count <= stats.miss_count);
+        xassert(stats.miss_count - stats.eviction_count <= num_blocks[cfg]);
+        if (verbose) {
+            printf("%u x %u byte blocks: hits %u misses %u evictions %u bypasses %u\n",
+                   num_blocks[cfg], (unsigned)block_size[cfg],
+                   (unsigned)stats.hit_count, (unsigned)stats.miss_count,
+                   (unsigned)stats.eviction_count, (unsigned)stats.bypass_count);
+        }
+    }
+}
+
+void test_lru_order(bool verbose)
+{
+    devmem_cache_t cache;
+    devmem_cache_stats_t stats;
+    fill_stats_t fill_stats = {0};
+    uint8_t buf[64];
+    const uint8_t *block[6];
+
+    for (int i = 0; i < 6; i++) {
+        block[i] = &flash_image[i * 1024];
+    }
+
+    devmem_cache_init(&cache, storage, 4, 64, fill, &fill_stats, flash_image, sizeof(flash_image));
+
+    for (int i = 0; i < 4; i++) {
+        devmem_cache_read(&cache, buf, block[i], 4);
+    }
+    devmem_cache_read(&cache, buf, block[0], 4);    // hit, block 1 is now the oldest
+    devmem_cache_read(&cache, buf, block[4], 4);    // evicts block 1
+    devmem_cache_read(&cache, buf, block[0], 4);    // hit
+    devmem_cache_read(&cache, buf, block[2], 4);    // hit
+    devmem_cache_read(&cache, buf, block[1], 4);    // evicts block 3
+    devmem_cache_read(&cache, buf, block[3], 4);    // evicts block 4
+
+    devmem_cache_stats_get(&cache, &stats);
+    xassert(stats.hit_count == 3);
+    xassert(stats.miss_count == 7);
+    xassert(stats.eviction_count == 3);
+    xassert(fill_stats.read_count == 7);
+    xassert(fill_stats.read_bytes == 7 * 64);
+
+    devmem_cache_read(&cache, buf, block[2], 4);    // hit, block 4 is gone
+    devmem_cache_read(&cache, buf, block[4], 4);
+    devmem_cache_stats_get(&cache, &stats);
+    xassert(stats.hit_count == 4);
+    xassert(stats.miss_count == 8);
+
+    /* Reads spanning blocks count each block */
+    devmem_cache_stats_reset(&cache);
+    devmem_cache_read(&cache, buf, block[5] + 32, 64);
+    devmem_cache_stats_get(&cache, &stats);
+    xassert(stats.miss_count == 2);
+    xassert(stats.eviction_count == 2);
+    xassert(memcmp(buf, block[5] + 32, 64) == 0);
+
+    /* Invalidated blocks are read again, without evicting */
+    devmem_cache_invalidate(&cache);
+    devmem_cache_read(&cache, buf, block[5] + 32, 64);
+    devmem_cache_stats_get(&cache, &stats);
+    xassert(stats.miss_count == 4);
+    xassert(stats.eviction_count == 2);
+
+    /* Reads of more than half the cache bypass it */
+    devmem_cache_read(&cache, dest, block[0], 256);
+    devmem_cache_stats_get(&cache, &stats);
+    xassert(stats.bypass_count == 1);
+    xassert(stats.miss_count == 4);
+    xassert(memcmp(dest, block[0], 256) == 0);
+
+    if (verbose) {
+        printf("lru order ok\n");
+    }
+}
+
+void test_region_end(bool verbose)
+{
+    devmem_cache_t cache;
+    fill_stats_t fill_stats = {0};
+    uint8_t buf[64];
+    const size_t region_size = TEST_FLASH_SIZE - 100;
+
+    /* The fill of the last block must stop at the end of the region */
+    devmem_cache_init(&cache, storage, 8, 256, fill, &fill_stats, flash_image, region_size);
+    devmem_cache_read(&cache, buf, &flash_image[region_size - 64], 64);
+    xassert(memcmp(buf, &flash_image[region_size - 64], 64) == 0);
+    xassert(fill_stats.read_bytes == 256 - 100);
+
+    if (verbose) {
+        printf("region end ok\n");
+    }
+}
+
+static size_t synth_trace(void)
+{
+    size_t count = 0;
+
+    for (int frame = 0; frame < SYNTH_FRAMES; frame++) {
+        for (uint32_t offset = 0; offset < SYNTH_MODEL_SIZE; offset += SYNTH_MODEL_READ) {
+            trace[count++] = (trace_read_t){offset, SYNTH_MODEL_READ};
+            uint32_t lookup = (rand() % (SYNTH_TABLE_SIZE / SYNTH_TABLE_READ)) * SYNTH_TABLE_READ;
+            trace[count++] = (trace_read_t){SYNTH_TABLE_OFFSET + lookup, SYNTH_TABLE_READ};
+        }
+    }
+    return count;
+}
+
+/* Reads lines of the form "devmem_trace: <hex offset> <size>", other lines are ignored */
+static size_t load_trace(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    char line[256];
+    size_t count = 0;
+
+    if (f == NULL) {
+        printf("Cannot open %s\n", path);
+        exit(1);
+    }
+    while (fgets(line, sizeof(line), f) != NULL && count < TRACE_MAX_READS) {
+        const char *p = strstr(line, "devmem_trace:");
+        unsigned offset, size;
+
+        if (p != NULL && sscanf(p, "devmem_trace: %x %u", &offset, &size) == 2) {
+            xassert(offset + size <= TEST_FLASH_SIZE);
+            trace[count++] = (trace_read_t){offset, size};
+        }
+    }
+    fclose(f);
+    return count;
+}
+
+static double flash_time_ms(const fill_stats_t *stats)
+{
+    return (stats->read_count * (double)TRACE_LATENCY_NS
+            + stats->read_bytes * 1000.0 / TRACE_BYTES_PER_US) / 1e6;
+}
+
+void bench_trace(const trace_read_t *t, size_t count)
+{
+    const size_t block_sizes[] = {256, 512, 1024};
+    const unsigned cache_kb[] = {4, 8, 16, 32, 64, 128};
+    fill_stats_t uncached = {0};
+
+    for (size_t i = 0; i < count; i++) {
+        uncached.read_count++;
+        uncached.read_bytes += t[i].size;
+    }
+    printf("%u reads, %llu bytes, %.2f ms of flash time uncached\n",
+           (unsigned)count, (unsigned long long)uncached.read_bytes, flash_time_ms(&uncached));
+    printf("cache_kb, block, sram_bytes, hit_rate, evictions, flash_bytes, flash_ms, speedup\n");
+
+    for (int b = 0; b < sizeof(block_sizes) / sizeof(block_sizes[0]); b++) {
+        for (int c = 0; c < sizeof(cache_kb) / sizeof(cache_kb[0]); c++) {
+            unsigned num_blocks = cache_kb[c] * 1024 / block_sizes[b];
+            size_t sram = devmem_cache_storage_size(num_blocks, block_sizes[b]);
+            devmem_cache_t cache;
+            devmem_cache_stats_t stats;
+            fill_stats_t fill_stats = {0};
+
+            if (sram > sizeof(storage)) {
+                continue;
+            }
+            devmem_cache_init(&cache, storage, num_blocks, block_sizes[b], fill, &fill_stats,
+                              flash_image, sizeof(flash_image));
+            for (size_t i = 0; i < count; i++) {
+                devmem_cache_read(&cache, dest, &flash_image[t[i].offset], t[i].size);
+            }
+            devmem_cache_stats_get(&cache, &stats);
+
+            uint32_t lookups = stats.hit_count + stats.miss_count;
+            printf("%u, %u, %u, %.3f, %u, %llu, %.2f, %.2f\n",
+                   cache_kb[c], (unsigned)block_sizes[b], (unsigned)sram,
+                   lookups ? (double)stats.hit_count / lookups : 0.0,
+                   (unsigned)stats.eviction_count,
+                   (unsigned long long)fill_stats.read_bytes,
+                   flash_time_ms(&fill_stats),
+                   flash_time_ms(&uncached) / flash_time_ms(&fill_stats));
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    bool verbose = false;
+
+    srand(1);
+    for (int i = 0; i < TEST_FLASH_SIZE; i++) {
+        flash_image[i] = (uint8_t)rand();
+    }
+
+    test_cache_reads(verbose);
+
+    test_lru_order(verbose);
+
+    test_region_end(verbose);
+
+    /* test_devmem_cache [bench | trace <file>] */
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        bench_trace(trace, synth_trace());
+    } else if (argc > 2 && strcmp(argv[1], "trace") == 0) {
+        bench_trace(trace, load_trace(argv[2]));
+    }
+
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,16 @@
+set(DFU_INT_PATH ${CMAKE_CURRENT_LIST_DIR}/../../examples/ffva/src/dfu_int)
+
+## The DFU flash writer is tested on the host against a simulated flash
+if(NOT ${CMAKE_SYSTEM_NAME} STREQUAL XCORE_XS3A)
+    add_executable(test_dfu_flash_writer
+        ${CMAKE_CURRENT_LIST_DIR}/src/test_dfu_flash_writer.c
+        ${DFU_INT_PATH}/dfu_flash_writer.c
+    )
+
+    target_include_directories(test_dfu_flash_writer
+        PRIVATE
+            ${DFU_INT_PATH}
+    )
+
+    target_compile_definitions(test_dfu_flash_writer PRIVATE X86_BUILD=1)
+endif()
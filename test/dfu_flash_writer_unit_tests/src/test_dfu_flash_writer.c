@@ -0,0 +1,376 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "dfu_flash_writer.h"
+
+#define xassert assert
+
+#define SECTOR_SIZE     (4096)
+#define PAGE_SIZE       (256)
+#define FLASH_SIZE      (2 * 1024 * 1024)
+#define NUM_SECTORS     (FLASH_SIZE / SECTOR_SIZE)
+#define PART_BASE       (256 * 1024)
+#define PART_SIZE       (1024 * 1024)
+#define IMAGE_SIZE      (600 * 1024)
+
+/* Typical timings of a QSPI NOR flash, in microseconds */
+#define ERASE_US        (45000.0)   // 4 KiB sector erase
+#define PROGRAM_US      (700.0)     // 256 byte page program
+#define READ_US         (160.0)     // 4 KiB quad read
+
+/* Simulated NOR flash: programming can only clear bits */
+typedef struct {
+    uint8_t mem[FLASH_SIZE];
+    double busy_us;             // Time taken by the operations so far
+    int overprogrammed;         // Programs that did not give the data written
+    uint32_t erases;
+    uint32_t reads;
+} sim_flash_t;
+
+static sim_flash_t flash;
+static uint8_t original[FLASH_SIZE];
+static uint8_t image[PART_SIZE];
+
+static void sim_read(void *ctx, uint8_t *data, unsigned address, size_t len)
+{
+    sim_flash_t *f = ctx;
+
+    xassert(address + len <= FLASH_SIZE);
+    memcpy(data, &f->mem[address], len);
+    f->busy_us += READ_US * len / SECTOR_SIZE;
+    f->reads++;
+}
+
+static void sim_write(void *ctx, const uint8_t *data, unsigned address, size_t len)
+{
+    sim_flash_t *f = ctx;
+
+    xassert(address + len <= FLASH_SIZE);
+    for (size_t i = 0; i < len; i++) {
+        f->mem[address + i] &= data[i];
+        f->overprogrammed += f->mem[address + i] != data[i];
+    }
+    f->busy_us += PROGRAM_US * ((address + len - 1) / PAGE_SIZE - address / PAGE_SIZE + 1);
+}
+
+static void sim_erase(void *ctx, unsigned address, size_t len)
+{
+    sim_flash_t *f = ctx;
+
+    xassert(address % SECTOR_SIZE == 0 && len % SECTOR_SIZE == 0);
+    xassert(address + len <= FLASH_SIZE);
+    memset(&f->mem[address], 0xFF, len);
+    f->busy_us += ERASE_US * len / SECTOR_SIZE;
+    f->erases += len / SECTOR_SIZE;
+}
+
+static const dfu_flash_ops_t sim_ops = {sim_read, sim_write, sim_erase, &flash};
+
+static dfu_flash_writer_t writer;
+static uint8_t sector_buf[SECTOR_SIZE];
+static uint32_t erased[DFU_FLASH_WRITER_BITMAP_WORDS(NUM_SECTORS)];
+
+/* Flash holding an old image, and a new image to download that may use the
+ * whole partition */
+static void setup(void)
+{
+    for (size_t i = 0; i < FLASH_SIZE; i++) {
+        original[i] = rand();
+    }
+    for (size_t i = 0; i < PART_SIZE; i++) {
+        image[i] = rand();
+    }
+    memcpy(flash.mem, original, FLASH_SIZE);
+    flash.busy_us = 0;
+    flash.overprogrammed = 0;
+    flash.erases = 0;
+    flash.reads = 0;
+
+    dfu_flash_writer_init(&writer, &sim_ops, SECTOR_SIZE, sector_buf, erased, NUM_SECTORS);
+    dfu_flash_writer_begin(&writer, PART_BASE, PART_SIZE);
+    dfu_flash_writer_expect(&writer, PART_SIZE);
+}
+
+/* The image is in the partition and nothing outside the partition changed */
+static void check_flash(size_t image_size)
+{
+    xassert(flash.overprogrammed == 0);
+    xassert(memcmp(&flash.mem[PART_BASE], image, image_size) == 0);
+    xassert(memcmp(flash.mem, original, PART_BASE) == 0);
+    xassert(memcmp(&flash.mem[PART_BASE + PART_SIZE], &original[PART_BASE + PART_SIZE],
+                   FLASH_SIZE - PART_BASE - PART_SIZE) == 0);
+}
+
+void test_sequential(bool verbose)
+{
+    int ret;
+
+    /* Whole sectors, erasing ahead between blocks */
+    setup();
+    for (size_t offset = 0; offset < IMAGE_SIZE; offset += SECTOR_SIZE) {
+        ret = dfu_flash_writer_write(&writer, offset, &image[offset], SECTOR_SIZE);
+        xassert(ret == 0);
+        dfu_flash_writer_erase_ahead(&writer);
+    }
+    check_flash(IMAGE_SIZE);
+    xassert(flash.reads == 0);
+    xassert(writer.stats.sector_erases == 1);
+    xassert(writer.stats.sectors_erased_ahead == IMAGE_SIZE / SECTOR_SIZE);
+    xassert(flash.erases == IMAGE_SIZE / SECTOR_SIZE + 1);
+
+    /* Whole sectors with no time to erase ahead */
+    setup();
+    for (size_t offset = 0; offset < IMAGE_SIZE; offset += SECTOR_SIZE) {
+        ret = dfu_flash_writer_write(&writer, offset, &image[offset], SECTOR_SIZE);
+        xassert(ret == 0);
+    }
+    check_flash(IMAGE_SIZE);
+    xassert(flash.reads == 0);
+    xassert(flash.erases == IMAGE_SIZE / SECTOR_SIZE);
+
+    /* Blocks smaller than a sector are programmed into the erased sectors */
+    setup();
+    for (size_t offset = 0; offset < IMAGE_SIZE; offset += 1024) {
+        ret = dfu_flash_writer_write(&writer, offset, &image[offset], 1024);
+        xassert(ret == 0);
+        dfu_flash_writer_erase_ahead(&writer);
+    }
+    check_flash(IMAGE_SIZE);
+    xassert(writer.stats.sector_reads <= 4);
+    xassert(flash.erases <= IMAGE_SIZE / SECTOR_SIZE + 5);
+
+    if (verbose) {
+        printf("sequential ok\n");
+    }
+}
+
+void test_rewrite(bool verbose)
+{
+    int ret;
+
+    /* A block written again, as when the host retries */
+    setup();
+    for (size_t offset = 0; offset < 8 * SECTOR_SIZE; offset += SECTOR_SIZE) {
+        memset(&image[offset], 0x55, SECTOR_SIZE);
+        ret = dfu_flash_writer_write(&writer, offset, &image[offset], SECTOR_SIZE);
+        xassert(ret == 0);
+        dfu_flash_writer_erase_ahead(&writer);
+        for (size_t i = 0; i < SECTOR_SIZE; i++) {
+            image[offset + i] = rand();
+        }
+        ret = dfu_flash_writer_write(&writer, offset, &image[offset], SECTOR_SIZE);
+        xassert(ret == 0);
+        dfu_flash_writer_erase_ahead(&writer);
+    }
+    check_flash(8 * SECTOR_SIZE);
+    xassert(flash.reads == 0);
+
+    /* Part of a sector that holds other data keeps the rest of the sector */
+    setup();
+    memcpy(image, &original[PART_BASE], PART_SIZE);
+    memset(&image[SECTOR_SIZE + 100], 0, 1000);
+    ret = dfu_flash_writer_write(&writer, SECTOR_SIZE + 100, &image[SECTOR_SIZE + 100], 1000);
+    xassert(ret == 0);
+    xassert(flash.reads == 1);
+    check_flash(PART_SIZE);
+
+    /* Writes across sector boundaries, in and out of order */
+    setup();
+    memcpy(image, &original[PART_BASE], PART_SIZE);
+    for (int n = 0; n < 200; n++) {
+        size_t offset = rand() % (PART_SIZE - 3 * SECTOR_SIZE);
+        size_t len = 1 + rand() % (3 * SECTOR_SIZE);
+
+        for (size_t i = 0; i < len; i++) {
+            image[offset + i] = rand();
+        }
+        ret = dfu_flash_writer_write(&writer, offset, &image[offset], len);
+        xassert(ret == 0);
+        if (rand() % 2 && dfu_flash_writer_erase_ahead(&writer)) {
+            /* An erase ahead loses whatever was in the next sector */
+            size_t next = (size_t)writer.cur_sector + 1;
+            memset(&image[next * SECTOR_SIZE], 0xFF, SECTOR_SIZE);
+        }
+    }
+    check_flash(PART_SIZE);
+
+    /* Data must fit the partition */
+    ret = dfu_flash_writer_write(&writer, PART_SIZE - 10, image, 11);
+    xassert(ret == -1);
+    ret = dfu_flash_writer_write(&writer, PART_SIZE + 1, image, 0);
+    xassert(ret == -1);
+    ret = dfu_flash_writer_write(&writer, PART_SIZE - 10, image, 10);
+    xassert(ret == 0);
+
+    /* Nothing is erased past the end of the partition */
+    setup();
+    for (size_t offset = 0; offset < PART_SIZE; offset += SECTOR_SIZE) {
+        ret = dfu_flash_writer_write(&writer, offset, &image[offset], SECTOR_SIZE);
+        xassert(ret == 0);
+        dfu_flash_writer_erase_ahead(&writer);
+    }
+    ret = dfu_flash_writer_erase_ahead(&writer);
+    xassert(ret == 0);
+    check_flash(PART_SIZE);
+
+    if (verbose) {
+        printf("rewrite ok\n");
+    }
+}
+
+void test_expected(bool verbose)
+{
+    int ret;
+
+    /* With no expected length nothing is erased ahead, so a shorter download
+     * keeps the rest of the partition as it was */
+    setup();
+    dfu_flash_writer_expect(&writer, 0);
+    memcpy(image, &original[PART_BASE], PART_SIZE);
+    for (size_t offset = 0; offset < IMAGE_SIZE; offset += SECTOR_SIZE) {
+        for (size_t i = 0; i < SECTOR_SIZE; i++) {
+            image[offset + i] = rand();
+        }
+        ret = dfu_flash_writer_write(&writer, offset, &image[offset], SECTOR_SIZE);
+        xassert(ret == 0);
+        ret = dfu_flash_writer_erase_ahead(&writer);
+        xassert(ret == 0);
+    }
+    check_flash(PART_SIZE);
+    xassert(flash.erases == IMAGE_SIZE / SECTOR_SIZE);
+
+    /* Sectors are only erased ahead up to the expected length, and not a
+     * sector that the expected length only covers part of */
+    setup();
+    dfu_flash_writer_expect(&writer, IMAGE_SIZE + SECTOR_SIZE / 2);
+    memcpy(image, &original[PART_BASE], PART_SIZE);
+    for (size_t offset = 0; offset < IMAGE_SIZE; offset += SECTOR_SIZE) {
+        for (size_t i = 0; i < SECTOR_SIZE; i++) {
+            image[offset + i] = rand();
+        }
+        ret = dfu_flash_writer_write(&writer, offset, &image[offset], SECTOR_SIZE);
+        xassert(ret == 0);
+        ret = dfu_flash_writer_erase_ahead(&writer);
+        xassert(ret == (offset + SECTOR_SIZE < IMAGE_SIZE));
+    }
+    check_flash(PART_SIZE);
+    xassert(writer.stats.sectors_erased_ahead == IMAGE_SIZE / SECTOR_SIZE - 1);
+
+    if (verbose) {
+        printf("expected ok\n");
+    }
+}
+
+/*
+ * Time a download of the image in whole sector blocks, where each block takes
+ * bus_us to transfer. The original write did a read-back, erase and program
+ * for each block while the host waited. The DFU flash task writes each block
+ * while the next is transferred, with two block buffers, and erases ahead
+ * when it has no block to write.
+ */
+static double download_us(double bus_us, bool pipelined, bool verbose, const char *bus)
+{
+    const size_t num_blocks = IMAGE_SIZE / SECTOR_SIZE;
+    double done[num_blocks];
+    double accepted = 0;    // Time the last block was accepted
+    double flash_free = 0;  // Time the flash task is next free
+    double total = 0;
+    int ret;
+
+    setup();
+    for (size_t k = 0; k < num_blocks; k++) {
+        size_t offset = k * SECTOR_SIZE;
+        double arrived = accepted + bus_us;
+
+        if (!pipelined) {
+            /* Read-back, erase and program with the host waiting */
+            double start = flash.busy_us;
+            sim_read(&flash, sector_buf, PART_BASE + offset, SECTOR_SIZE);
+            sim_erase(&flash, PART_BASE + offset, SECTOR_SIZE);
+            sim_write(&flash, &image[offset], PART_BASE + offset, SECTOR_SIZE);
+            accepted = arrived + flash.busy_us - start;
+            total = accepted;
+            continue;
+        }
+
+        /* The block waits for a free buffer */
+        accepted = arrived;
+        if (k >= 2 && done[k - 2] > accepted) {
+            accepted = done[k - 2];
+        }
+
+        double start = accepted > flash_free ? accepted : flash_free;
+        double before = flash.busy_us;
+        ret = dfu_flash_writer_write(&writer, offset, &image[offset], SECTOR_SIZE);
+        xassert(ret == 0);
+        done[k] = start + flash.busy_us - before;
+        flash_free = done[k];
+
+        /* Erase ahead if the next block is still being transferred */
+        if (k + 1 < num_blocks && accepted + bus_us > done[k]) {
+            before = flash.busy_us;
+            dfu_flash_writer_erase_ahead(&writer);
+            flash_free += flash.busy_us - before;
+        }
+        total = done[k];
+    }
+    check_flash(IMAGE_SIZE);
+
+    if (verbose) {
+        printf("%s, %s: %.0f ms, %.1f ms per block, bus %.1f ms per block\n",
+               bus, pipelined ? "pipelined" : "original",
+               total / 1000, total / 1000 / num_blocks, bus_us / 1000);
+    }
+    return total;
+}
+
+void test_timing(bool verbose)
+{
+    const double num_blocks = IMAGE_SIZE / SECTOR_SIZE;
+
+    /* I2C at 400 kHz: 32 fragments of 128 bytes, with command overhead */
+    const double i2c_us = 32 * (128 + 8) * 9 / 0.4;
+    double i2c_original = download_us(i2c_us, false, verbose, "I2C");
+    double i2c_pipelined = download_us(i2c_us, true, verbose, "I2C");
+
+    /* The flash keeps up with I2C, so the download is bus bound */
+    xassert(i2c_pipelined < num_blocks * i2c_us * 1.02 + ERASE_US + 16 * PROGRAM_US);
+    xassert(i2c_pipelined < i2c_original * 0.7);
+
+    /* USB full speed DFU control transfers of 4 KiB */
+    const double usb_us = 14000;
+    double usb_original = download_us(usb_us, false, verbose, "USB");
+    double usb_pipelined = download_us(usb_us, true, verbose, "USB");
+
+    /* The flash is the bottleneck, but the transfers are hidden behind it */
+    xassert(usb_pipelined < num_blocks * (ERASE_US + 16 * PROGRAM_US) * 1.02 + usb_us);
+    xassert(usb_pipelined < usb_original * 0.85);
+
+    if (verbose) {
+        printf("timing ok\n");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    bool verbose = argc > 1 && (strcmp(argv[1], "-v") == 0 || strcmp(argv[1], "bench") == 0);
+
+    srand(1);
+
+    test_sequential(verbose);
+
+    test_rewrite(verbose);
+
+    test_expected(verbose);
+
+    test_timing(verbose);
+
+    printf("PASS\n");
+    return 0;
+}
@@ -87,16 +87,16 @@ void vApplicationDaemonTaskStartup(void *arg)
 
 #if ON_TILE(0)
     // Setup and wait for "host" to be in initial state
-    QueueHandle_t q_intent = xQueueCreate(1, sizeof(int32_t));
+    QueueHandle_t q_intent = xQueueCreate(1, sizeof(intent_message_t));
     intent_handler_create(1, q_intent);
 
     vTaskDelay(1); // Provide some time for proc_keyword_res() to set up
     sync(other_tile_c);
 
     // Send intent
-    int32_t test_val = 50;
+    intent_message_t test_msg = {50, 50};
     test_printf("Send dummy intent");
-    xQueueSend(q_intent, &test_val, (TickType_t)0);
+    xQueueSend(q_intent, &test_msg, (TickType_t)0);
     test_printf("Sent dummy intent");
 
     test_printf("PASS GPIO");
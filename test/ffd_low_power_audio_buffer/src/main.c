@@ -1,4 +1,4 @@
-// Copyright 2023 XMOS LIMITED.
+// Copyright 2023-2024 XMOS LIMITED.
 // This Software is subject to the terms of the XMOS Public Licence: Version 1.
 
 /* System headers */
@@ -77,6 +77,12 @@ static asr_sample_t *intent_engine_sample_push_expected_buf;
 static size_t intent_engine_sample_push_total_frames;
 static uint32_t intent_engine_sample_push_error_count;
 
+/* Every call to intent_engine_sample_push() and the samples it was passed */
+static asr_sample_t *pushed_bufs[2 * TOTAL_SAMPLES];
+static size_t push_count;
+static asr_sample_t pushed_samples[2 * TOTAL_SAMPLES];
+static size_t pushed_sample_count;
+
 void setup_intent_engine_sample_push(char *expected_start_address)
 {
     // Catch potential issues in test logic.
@@ -86,17 +92,24 @@ void setup_intent_engine_sample_push(char *expected_start_address)
     intent_engine_sample_push_error_count = error_count;
     intent_engine_sample_push_skip_verify = 1;
     intent_engine_sample_push_total_frames = 0;
+    push_count = 0;
+    pushed_sample_count = 0;
 }
 
 void verify_intent_engine_sample_push_args(asr_sample_t *buf, size_t frames)
 {
     const uint32_t tail_addr = ((uint32_t)ring_buf.buf + ring_buf.size);
 
+    assert(pushed_sample_count + frames <= 2 * TOTAL_SAMPLES);
+    pushed_bufs[push_count++] = buf;
+    memcpy(&pushed_samples[pushed_sample_count], buf, frames * sizeof(asr_sample_t));
+    pushed_sample_count += frames;
+
     if (intent_engine_sample_push_skip_verify)
         return;
 
     TEST_ASSERT_PTRS_ARE_EQUAL(intent_engine_sample_push_expected_buf, buf);
-    TEST_ASSERT_LONGS_ARE_EQUAL((uint32_t)appconfAUDIO_PIPELINE_FRAME_ADVANCE, (uint32_t)frames);
+    TEST_ASSERT_LONGS_ARE_EQUAL(0UL, (uint32_t)frames % appconfAUDIO_PIPELINE_FRAME_ADVANCE);
     intent_engine_sample_push_expected_buf += frames;
 
     if ((uint32_t)intent_engine_sample_push_expected_buf >= tail_addr)
@@ -225,7 +238,7 @@ void verify_get_pointer_wraps_around(void)
     uint32_t expected_frame_count = 0;
     uint32_t expected_frames_dequeued = sample_count;
     char *expected_set_ptr = (char *)(sample_buf);
-    char *expected_get_ptr = (char *)(sample_buf);
+    char *expected_get_ptr = (char *)(sample_buf + sample_count - 1);
     char *expected_get_ptr_start = (char *)(sample_buf + LAST_SAMPLE_INDEX);
     uint32_t starting_sample_index_to_verify = 0;
 
@@ -248,6 +261,14 @@ void verify_get_pointer_wraps_around(void)
     TEST_ASSERT_PTRS_ARE_EQUAL(expected_set_ptr, ring_buf.set_ptr);
     TEST_ASSERT_PTRS_ARE_EQUAL(expected_get_ptr, ring_buf.get_ptr);
 
+    // The frame that wraps around is passed on whole, in order.
+    TEST_ASSERT_LONGS_ARE_EQUAL((size_t)1, push_count);
+    TEST_ASSERT_LONGS_ARE_EQUAL((size_t)sample_count, pushed_sample_count);
+    TEST_ASSERT_INTS_ARE_EQUAL(LAST_SAMPLE_INDEX, pushed_samples[0]);
+    for (uint32_t i = 1; i < sample_count; i++) {
+        TEST_ASSERT_INTS_ARE_EQUAL(i - 1, pushed_samples[i]);
+    }
+
     // No samples in buffer should have been modified.
     verify_sample_buffer_state(&starting_sample_index_to_verify, 0, TOTAL_SAMPLES);
 }
@@ -529,6 +550,159 @@ void verify_dequeuing_all_frames_reports_empty(uint32_t frame_index)
     verify_sample_buffer_state(&starting_sample_index_to_verify, 0, TOTAL_SAMPLES);
 }
 
+void verify_peek_returns_contiguous_samples(uint32_t frame_index, uint32_t buffer_count)
+{
+    const uint8_t expected_full_state = (buffer_count == TOTAL_SAMPLES);
+    const uint8_t expected_empty_state = (buffer_count == 0);
+    uint32_t expected_peek_count = TOTAL_SAMPLES - frame_index;
+    char *expected_set_ptr = (char *)(sample_buf + ((frame_index + buffer_count) % TOTAL_SAMPLES));
+    char *expected_get_ptr = (char *)(sample_buf + frame_index);
+    const asr_sample_t *span = NULL;
+    uint32_t starting_sample_index_to_verify = 0;
+
+    if (buffer_count < expected_peek_count)
+        expected_peek_count = buffer_count;
+
+    TEST_CASE_PRINTF(": Peeking %ld buffered samples at sample index %ld.",
+                     buffer_count,
+                     frame_index);
+    init_sample_buffer(); // Reinitialize to decouple test cases.
+    set_ring_buffer_state(expected_set_ptr,
+                          expected_get_ptr,
+                          buffer_count,
+                          expected_full_state,
+                          expected_empty_state);
+
+    size_t peek_count = low_power_audio_buffer_peek(&span);
+
+    TEST_ASSERT_LONGS_ARE_EQUAL((size_t)expected_peek_count, peek_count);
+    TEST_ASSERT_PTRS_ARE_EQUAL((const asr_sample_t *)expected_get_ptr, span);
+
+    // Peeking does not remove samples.
+    TEST_ASSERT_INTS_ARE_EQUAL(expected_full_state, ring_buf.full);
+    TEST_ASSERT_INTS_ARE_EQUAL(expected_empty_state, ring_buf.empty);
+    TEST_ASSERT_LONGS_ARE_EQUAL(buffer_count, ring_buf.count);
+    TEST_ASSERT_PTRS_ARE_EQUAL(expected_set_ptr, ring_buf.set_ptr);
+    TEST_ASSERT_PTRS_ARE_EQUAL(expected_get_ptr, ring_buf.get_ptr);
+
+    // No samples in buffer should have been modified.
+    verify_sample_buffer_state(&starting_sample_index_to_verify, 0, TOTAL_SAMPLES);
+}
+
+void verify_commit_removes_samples_and_wraps_around(uint32_t frame_index, uint32_t samples_to_commit)
+{
+    const uint32_t init_buf_count = TOTAL_SAMPLES;
+    const uint8_t expected_full_state = (samples_to_commit == 0);
+    const uint8_t expected_empty_state = (samples_to_commit == TOTAL_SAMPLES);
+    const uint32_t expected_frame_count = TOTAL_SAMPLES - samples_to_commit;
+    char *expected_set_ptr = (char *)(sample_buf + frame_index);
+    char *expected_get_ptr = (char *)(sample_buf + ((frame_index + samples_to_commit) % TOTAL_SAMPLES));
+    uint32_t starting_sample_index_to_verify = 0;
+
+    TEST_CASE_PRINTF(": Committing %ld of the buffered samples at sample index %ld.",
+                     samples_to_commit,
+                     frame_index);
+    init_sample_buffer(); // Reinitialize to decouple test cases.
+    set_ring_buffer_state(expected_set_ptr,
+                          expected_set_ptr,
+                          init_buf_count,
+                          1,
+                          0);
+
+    low_power_audio_buffer_commit(samples_to_commit);
+
+    TEST_ASSERT_INTS_ARE_EQUAL(expected_full_state, ring_buf.full);
+    TEST_ASSERT_INTS_ARE_EQUAL(expected_empty_state, ring_buf.empty);
+    TEST_ASSERT_LONGS_ARE_EQUAL(expected_frame_count, ring_buf.count);
+    TEST_ASSERT_PTRS_ARE_EQUAL(expected_set_ptr, ring_buf.set_ptr);
+    TEST_ASSERT_PTRS_ARE_EQUAL(expected_get_ptr, ring_buf.get_ptr);
+
+    // No samples in buffer should have been modified.
+    verify_sample_buffer_state(&starting_sample_index_to_verify, 0, TOTAL_SAMPLES);
+}
+
+void verify_dequeuing_passes_contiguous_frames_in_place(uint32_t frame_index)
+{
+    const uint32_t max_dequeue_frames = appconfAUDIO_PIPELINE_BUFFER_NUM_FRAMES;
+    const size_t expected_push_count = (frame_index == 0) ? 1 : 2;
+    char *expected_set_ptr = (char *)(sample_buf + frame_index);
+    uint32_t starting_sample_index_to_verify = 0;
+
+    TEST_CASE_PRINTF(": Dequeuing all %ld enqueued frames at sample index %ld.",
+                     max_dequeue_frames,
+                     frame_index);
+    init_sample_buffer(); // Reinitialize to decouple test cases.
+    setup_intent_engine_sample_push(expected_set_ptr);
+    set_ring_buffer_state(expected_set_ptr,
+                          expected_set_ptr,
+                          TOTAL_SAMPLES,
+                          1,
+                          0);
+
+    uint32_t frames_dequeued = low_power_audio_buffer_dequeue(max_dequeue_frames);
+
+    TEST_ASSERT_LONGS_ARE_EQUAL((uint32_t)TOTAL_SAMPLES, frames_dequeued);
+    TEST_ASSERT_INTS_ARE_EQUAL(1, ring_buf.empty);
+
+    // The intent engine is passed the buffer itself, once for the samples up
+    // to the end of the buffer and once for the samples from its start.
+    TEST_ASSERT_LONGS_ARE_EQUAL(expected_push_count, push_count);
+    TEST_ASSERT_PTRS_ARE_EQUAL(sample_buf + frame_index, pushed_bufs[0]);
+    if (expected_push_count == 2) {
+        TEST_ASSERT_PTRS_ARE_EQUAL(sample_buf, pushed_bufs[1]);
+    }
+    TEST_ASSERT_LONGS_ARE_EQUAL((size_t)TOTAL_SAMPLES, pushed_sample_count);
+    for (uint32_t i = 0; i < TOTAL_SAMPLES; i++) {
+        TEST_ASSERT_INTS_ARE_EQUAL((frame_index + i) % TOTAL_SAMPLES, pushed_samples[i]);
+    }
+
+    // No samples in buffer should have been modified.
+    verify_sample_buffer_state(&starting_sample_index_to_verify, 0, TOTAL_SAMPLES);
+}
+
+void verify_fast_drain_catches_up(uint32_t dequeue_frames)
+{
+    const uint32_t backlog_frames = appconfAUDIO_PIPELINE_BUFFER_NUM_FRAMES;
+    const uint32_t expected_periods = (backlog_frames - dequeue_frames) / (dequeue_frames - 1) + 2;
+    const uint32_t max_dequeued_samples = dequeue_frames * appconfAUDIO_PIPELINE_FRAME_ADVANCE;
+    uint32_t next_value = TOTAL_SAMPLES;
+    uint32_t periods = 0;
+
+    TEST_CASE_PRINTF(": Draining a full buffer at %ld frames per frame.", dequeue_frames);
+    init_sample_buffer(); // Reinitialize to decouple test cases.
+    setup_intent_engine_sample_push((char *)sample_buf);
+    set_ring_buffer_state((char *)sample_buf,
+                          (char *)sample_buf,
+                          TOTAL_SAMPLES,
+                          1,
+                          0);
+
+    /* As the pipeline output does after waking: the buffered audio is
+     * dequeued faster than real time, and each new frame is queued behind it
+     * until the buffer has drained. */
+    while (periods <= TOTAL_SAMPLES) {
+        fill_frames(appconfAUDIO_PIPELINE_FRAME_ADVANCE, next_value);
+        next_value += appconfAUDIO_PIPELINE_FRAME_ADVANCE;
+        periods++;
+        if (low_power_audio_buffer_dequeue(dequeue_frames) == max_dequeued_samples) {
+            low_power_audio_buffer_enqueue(samples, appconfAUDIO_PIPELINE_FRAME_ADVANCE);
+        } else {
+            verify_intent_engine_sample_push_args(samples, appconfAUDIO_PIPELINE_FRAME_ADVANCE);
+            break;
+        }
+    }
+
+    TEST_ASSERT_LONGS_ARE_EQUAL(expected_periods, periods);
+
+    // Every sample reaches the intent engine once, in order.
+    TEST_ASSERT_LONGS_ARE_EQUAL((size_t)next_value, pushed_sample_count);
+    for (uint32_t i = 0; i < pushed_sample_count; i++) {
+        TEST_ASSERT_INTS_ARE_EQUAL((asr_sample_t)i, pushed_samples[i]);
+        if (pushed_samples[i] != (asr_sample_t)i)
+            break;
+    }
+}
+
 int main(void)
 {
     TEST_PRINTF("CONFIGURATION:\n");
@@ -609,6 +783,41 @@ int main(void)
     verify_dequeuing_all_frames_reports_empty(appconfAUDIO_PIPELINE_FRAME_ADVANCE * (appconfAUDIO_PIPELINE_BUFFER_NUM_FRAMES - 2));
     verify_dequeuing_all_frames_reports_empty(appconfAUDIO_PIPELINE_FRAME_ADVANCE * (appconfAUDIO_PIPELINE_BUFFER_NUM_FRAMES - 1));
 
+    /*
+     * Peeking returns the oldest samples that are contiguous in the buffer,
+     * up to the end of the buffer, without removing them.
+     */
+    verify_peek_returns_contiguous_samples(0, 0);
+    verify_peek_returns_contiguous_samples(0, TOTAL_SAMPLES);
+    verify_peek_returns_contiguous_samples(appconfAUDIO_PIPELINE_FRAME_ADVANCE, TOTAL_SAMPLES);
+    verify_peek_returns_contiguous_samples(appconfAUDIO_PIPELINE_FRAME_ADVANCE, appconfAUDIO_PIPELINE_FRAME_ADVANCE);
+    verify_peek_returns_contiguous_samples(LAST_SAMPLE_INDEX, appconfAUDIO_PIPELINE_FRAME_ADVANCE);
+
+    /*
+     * Committing removes samples, wrapping the get pointer around the end of
+     * the buffer.
+     */
+    verify_commit_removes_samples_and_wraps_around(0, 0);
+    verify_commit_removes_samples_and_wraps_around(0, 1);
+    verify_commit_removes_samples_and_wraps_around(appconfAUDIO_PIPELINE_FRAME_ADVANCE, TOTAL_SAMPLES - appconfAUDIO_PIPELINE_FRAME_ADVANCE);
+    verify_commit_removes_samples_and_wraps_around(LAST_SAMPLE_INDEX, 2);
+    verify_commit_removes_samples_and_wraps_around(appconfAUDIO_PIPELINE_FRAME_ADVANCE, TOTAL_SAMPLES);
+
+    /*
+     * Dequeuing passes runs of frames to the intent engine without copying
+     * them out of the buffer.
+     */
+    verify_dequeuing_passes_contiguous_frames_in_place(0);
+    verify_dequeuing_passes_contiguous_frames_in_place(appconfAUDIO_PIPELINE_FRAME_ADVANCE);
+    verify_dequeuing_passes_contiguous_frames_in_place(appconfAUDIO_PIPELINE_FRAME_ADVANCE * (appconfAUDIO_PIPELINE_BUFFER_NUM_FRAMES - 1));
+
+    /*
+     * Dequeuing more than one frame for each frame enqueued drains the
+     * buffered audio, without losing or reordering samples.
+     */
+    verify_fast_drain_catches_up(appconfAUDIO_PIPELINE_LP_BUF_DEQUEUE_FRAMES);
+    verify_fast_drain_catches_up(appconfAUDIO_PIPELINE_LP_BUF_DEQUEUE_FRAMES + 2);
+
     if (error_count == 0) {
         TEST_PRINTF("\nTEST: PASS\n");
     } else {
@@ -0,0 +1,16 @@
+set(INTENT_ENGINE_PATH ${CMAKE_CURRENT_LIST_DIR}/../../modules/asr/intent_engine)
+
+## The intent table has no device dependencies, so it is tested on the host
+if(NOT ${CMAKE_SYSTEM_NAME} STREQUAL XCORE_XS3A)
+    add_executable(test_intent_table
+        ${CMAKE_CURRENT_LIST_DIR}/src/test_intent_table.c
+        ${INTENT_ENGINE_PATH}/intent_table.c
+    )
+
+    target_include_directories(test_intent_table
+        PRIVATE
+            ${INTENT_ENGINE_PATH}
+    )
+
+    target_compile_definitions(test_intent_table PRIVATE X86_BUILD=1)
+endif()
@@ -0,0 +1,257 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <time.h>
+
+#include "intent_table.h"
+
+#define xassert assert
+
+#define MAX_ENTRIES     (1000)
+#define SPARSE_MAX_ID   (1000000)
+#define BENCH_LOOKUPS   (10000000)
+
+static intent_entry_t entries[MAX_ENTRIES];
+static uint16_t index_storage[2 * MAX_ENTRIES];
+
+/* Entries with IDs from first_id, in shuffled order */
+static void make_entries(size_t count, int32_t first_id, int32_t stride)
+{
+    for (size_t i = 0; i < count; i++) {
+        entries[i] = (intent_entry_t){first_id + i * stride, i, 0x100 + i,
+                                      i == 0 ? INTENT_TYPE_KEYWORD : INTENT_TYPE_COMMAND, 1, "intent"};
+    }
+    for (size_t i = count - 1; i > 0; i--) {
+        size_t j = rand() % (i + 1);
+        intent_entry_t tmp = entries[i];
+        entries[i] = entries[j];
+        entries[j] = tmp;
+    }
+}
+
+static void check_lookups(const intent_table_t *table, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        const intent_entry_t *entry = intent_table_lookup(table, entries[i].asr_id);
+        xassert(entry == &entries[i]);
+    }
+}
+
+void test_direct(bool verbose)
+{
+    intent_table_t table;
+    int ret;
+
+    /* IDs 1 to 17, like the Cyberon and Sensory models */
+    make_entries(17, 1, 1);
+    ret = intent_table_init(&table, entries, 17, index_storage, 17);
+    xassert(ret == 0);
+    xassert(table.direct);
+    check_lookups(&table, 17);
+    xassert(intent_table_lookup(&table, 0) == NULL);
+    xassert(intent_table_lookup(&table, 18) == NULL);
+    xassert(intent_table_lookup(&table, -1) == NULL);
+    xassert(intent_table_lookup(&table, INT32_MIN) == NULL);
+    xassert(intent_table_lookup(&table, INT32_MAX) == NULL);
+
+    /* Hundreds of IDs with gaps still fit a direct index */
+    make_entries(500, 1000, 3);
+    ret = intent_table_init(&table, entries, 500, index_storage, 2 * MAX_ENTRIES);
+    xassert(ret == 0);
+    xassert(table.direct);
+    check_lookups(&table, 500);
+    xassert(intent_table_lookup(&table, 1001) == NULL);
+    xassert(intent_table_lookup(&table, 999) == NULL);
+
+    /* Repeated IDs are rejected */
+    entries[10].asr_id = entries[20].asr_id;
+    ret = intent_table_init(&table, entries, 500, index_storage, 2 * MAX_ENTRIES);
+    xassert(ret == -1);
+
+    if (verbose) {
+        printf("direct index ok\n");
+    }
+}
+
+void test_sorted(bool verbose)
+{
+    intent_table_t table;
+    int ret;
+
+    /* IDs spread too widely for a direct index */
+    for (int i = 0; i < MAX_ENTRIES; i++) {
+        bool unique;
+        do {
+            entries[i] = (intent_entry_t){rand() % SPARSE_MAX_ID - SPARSE_MAX_ID / 2, i, i,
+                                          INTENT_TYPE_COMMAND, 1, "intent"};
+            unique = true;
+            for (int j = 0; j < i; j++) {
+                unique &= entries[j].asr_id != entries[i].asr_id;
+            }
+        } while (!unique);
+    }
+    ret = intent_table_init(&table, entries, MAX_ENTRIES, index_storage, 2 * MAX_ENTRIES);
+    xassert(ret == 0);
+    xassert(!table.direct);
+    check_lookups(&table, MAX_ENTRIES);
+    for (int i = 0; i < 10000; i++) {
+        int32_t id = rand() % SPARSE_MAX_ID - SPARSE_MAX_ID / 2;
+        const intent_entry_t *entry = intent_table_lookup(&table, id);
+        xassert(entry == NULL || entry->asr_id == id);
+    }
+
+    /* The index must hold the entries */
+    ret = intent_table_init(&table, entries, MAX_ENTRIES, index_storage, MAX_ENTRIES - 1);
+    xassert(ret == -1);
+
+    /* Repeated IDs are rejected */
+    entries[MAX_ENTRIES - 1].asr_id = entries[0].asr_id;
+    ret = intent_table_init(&table, entries, MAX_ENTRIES, index_storage, 2 * MAX_ENTRIES);
+    xassert(ret == -1);
+
+    /* An empty table has no entries */
+    ret = intent_table_init(&table, entries, 0, index_storage, 0);
+    xassert(ret == 0);
+    xassert(intent_table_lookup(&table, 0) == NULL);
+
+    if (verbose) {
+        printf("sorted index ok\n");
+    }
+}
+
+void test_parse(bool verbose)
+{
+    char text[] =
+        "# asr_id type wav_id code enabled text\n"
+        "1 keyword 1 0x10 1 Hello XMOS\r\n"
+        "\n"
+        "  2\tcommand 2 0x20 1 Switch on the TV  \n"
+        "300 command -1 0x300 0 Disabled\n"
+        "4 command 4 4 1";
+    intent_table_t table;
+    int ret;
+
+    ret = intent_table_parse(text, entries, MAX_ENTRIES);
+    xassert(ret == 4);
+    xassert(entries[0].asr_id == 1 && entries[0].type == INTENT_TYPE_KEYWORD && entries[0].code == 0x10);
+    xassert(strcmp(entries[0].text, "Hello XMOS") == 0);
+    xassert(entries[1].asr_id == 2 && entries[1].type == INTENT_TYPE_COMMAND && entries[1].wav_id == 2);
+    xassert(strcmp(entries[1].text, "Switch on the TV") == 0);
+    xassert(entries[2].wav_id == -1 && entries[2].enabled == 0);
+    xassert(entries[3].asr_id == 4 && strcmp(entries[3].text, "") == 0);
+
+    ret = intent_table_init(&table, entries, 4, index_storage, 2 * MAX_ENTRIES);
+    xassert(ret == 0);
+    xassert(intent_table_lookup(&table, 300) == &entries[2]);
+
+    /* Errors give the line number */
+    char bad_type[] = "1 keyword 1 1 1 a\n2 phrase 2 2 1 b\n";
+    ret = intent_table_parse(bad_type, entries, MAX_ENTRIES);
+    xassert(ret == -2);
+    char missing[] = "# comment\n\n1 command 1 1\n";
+    ret = intent_table_parse(missing, entries, MAX_ENTRIES);
+    xassert(ret == -3);
+    char too_many[] = "1 command 1 1 1 a\n2 command 2 2 1 b\n";
+    ret = intent_table_parse(too_many, entries, 1);
+    xassert(ret == -2);
+
+    if (verbose) {
+        printf("parse ok\n");
+    }
+}
+
+void test_active(bool verbose)
+{
+    intent_table_t a;
+    intent_table_t b;
+    int ret;
+    static intent_entry_t b_entries[] = {{7, 7, 7, INTENT_TYPE_KEYWORD, 1, "seven"}};
+    static uint16_t b_index[1];
+
+    make_entries(17, 1, 1);
+    ret = intent_table_init(&a, entries, 17, index_storage, 17);
+    xassert(ret == 0);
+    ret = intent_table_init(&b, b_entries, 1, b_index, 1);
+    xassert(ret == 0);
+
+    xassert(intent_table_lookup(intent_table_active(), 1) == NULL);
+    intent_table_set(&a);
+    xassert(intent_table_lookup(intent_table_active(), 7)->code != 7);
+    intent_table_set(&b);
+    xassert(intent_table_lookup(intent_table_active(), 7) == &b_entries[0]);
+    xassert(intent_table_lookup(intent_table_active(), 1) == NULL);
+
+    if (verbose) {
+        printf("active table ok\n");
+    }
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Compare with the linear search the table replaces */
+void bench(size_t count, int32_t stride)
+{
+    intent_table_t table;
+    volatile int32_t sink = 0;
+    double start;
+    int ret;
+
+    make_entries(count, 1, stride);
+    ret = intent_table_init(&table, entries, count, index_storage, 2 * MAX_ENTRIES);
+    xassert(ret == 0);
+
+    start = now_ns();
+    for (size_t n = 0; n < BENCH_LOOKUPS / count; n++) {
+        int32_t id = entries[n % count].asr_id;
+        for (size_t i = 0; i < count; i++) {
+            if (entries[i].asr_id == id) {
+                sink += entries[i].code;
+            }
+        }
+    }
+    double linear = (now_ns() - start) / (BENCH_LOOKUPS / count);
+
+    start = now_ns();
+    for (int n = 0; n < BENCH_LOOKUPS; n++) {
+        sink += intent_table_lookup(&table, entries[n % count].asr_id)->code;
+    }
+    double indexed = (now_ns() - start) / BENCH_LOOKUPS;
+
+    printf("%u entries, %s index: linear %.1f ns, indexed %.1f ns per lookup\n",
+           (unsigned)count, table.direct ? "direct" : "sorted", linear, indexed);
+}
+
+int main(int argc, char *argv[])
+{
+    bool verbose = argc > 1 && strcmp(argv[1], "-v") == 0;
+
+    srand(1);
+
+    test_direct(verbose);
+
+    test_sorted(verbose);
+
+    test_parse(verbose);
+
+    test_active(verbose);
+
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        bench(17, 1);
+        bench(500, 1);
+        bench(500, 5000);
+    }
+
+    printf("PASS\n");
+    return 0;
+}
@@ -68,6 +68,8 @@ mkdir -p ${OUTPUT_DIR}
 # fresh logs
 RESULTS="${OUTPUT_DIR}/results.csv"
 rm -rf ${RESULTS}
+PROFILE_LOG="${OUTPUT_DIR}/profile.log"
+rm -rf ${PROFILE_LOG}
 
 # fresh list.txt for amazon_ww_filesim
 rm -f "${OUTPUT_DIR}/list.txt"
@@ -134,7 +136,7 @@ for ((j = 0; j < ${#INPUT_ARRAY[@]}; j += 1)); do
     # run xscope host in directory where the XSCOPE_FILEIO_INPUT_WAV resides
     #   xscope_host_endpoint is run in a subshell (inside parentheses) so when 
     #   it exits, the xrun command above will also exit
-    (cd ${OUTPUT_DIR} ; ${DIST_HOST}/xscope_host_endpoint 12345)
+    (cd ${OUTPUT_DIR} ; ${DIST_HOST}/xscope_host_endpoint 12345 2>&1 | tee ${OUTPUT_DIR}/${FILE_NAME}_device.log)
 
     # wait for xrun to exit
     sleep 1
@@ -158,6 +160,8 @@ for ((j = 0; j < ${#INPUT_ARRAY[@]}; j += 1)); do
     DETECTIONS="${DETECTIONS//[[:space:]]/}"
     # log results
     echo "filename=${INPUT_WAV}, keyword=alexa, detected=${DETECTIONS}, min=${MIN}, max=${MAX}" >> ${RESULTS}
+    # record the per stage timing reported by the firmware
+    grep "profile:\|aec_switch:" ${OUTPUT_DIR}/${FILE_NAME}_device.log | sed "s|^|${FILE_NAME}: |" >> ${PROFILE_LOG} || true
 
     # clean up
     rm "${OUTPUT_DIR}/${AMAZON_WAV}"
@@ -171,3 +175,6 @@ rm "${OUTPUT_DIR}/list.txt"
 
 # print results
 cat ${RESULTS}
+if [ -f ${PROFILE_LOG} ]; then
+    cat ${PROFILE_LOG}
+fi
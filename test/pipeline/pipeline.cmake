@@ -43,6 +43,18 @@ else()
     message(FATAL_ERROR "Unable to build ${TEST_PIPELINE} pipeline test")
 endif()
 
+# Set TEST_PIPELINE_AEC_THREADS to the number of threads sharing the AEC work
+# to check the threaded AEC against the same reference output
+if(NOT DEFINED TEST_PIPELINE_AEC_THREADS)
+    set(TEST_PIPELINE_AEC_THREADS 1)
+endif()
+
+# Set TEST_PIPELINE_AEC_RETAIN_FILTER=0 to discard the AEC filter while ADEC is
+# in delay estimation mode and compare the aec_switch reports
+if(NOT DEFINED TEST_PIPELINE_AEC_RETAIN_FILTER)
+    set(TEST_PIPELINE_AEC_RETAIN_FILTER 1)
+endif()
+
 #**********************
 # Flags
 #**********************
@@ -67,6 +79,10 @@ set(APP_COMPILE_DEFINITIONS
     appconfAUDIO_PIPELINE_INPUT_TILE_NO=${AUDIO_PIPELINE_INPUT_TILE_NO}
     appconfAUDIO_PIPELINE_OUTPUT_TILE_NO=${AUDIO_PIPELINE_OUTPUT_TILE_NO}
     appconfAUDIO_PIPELINE_SUPPORTS_TRACE=${AUDIO_PIPELINE_SUPPORTS_TRACE}
+    appconfAUDIO_PIPELINE_AEC_THREADS=${TEST_PIPELINE_AEC_THREADS}
+    appconfAEC_DE_SWITCH_RETAIN_FILTER=${TEST_PIPELINE_AEC_RETAIN_FILTER}
+    appconfPROFILE_ENABLED=1
+    appconfPROFILE_REPORT_INTERVAL=1000
 )
 
 set(APP_LINK_OPTIONS
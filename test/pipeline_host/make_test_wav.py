@@ -0,0 +1,54 @@
+# Copyright 2024 XMOS LIMITED.
+# This Software is subject to the terms of the XMOS Public Licence: Version 1.
+# XMOS Public License: Version 1
+
+"""Write a 4 channel 16 kHz wav file for pipeline_host smoke tests.
+
+The channels are reference 0, reference 1, microphone 0 and microphone 1.
+The references are lowpass filtered noise, played for the first half of the
+file and then silent. The microphones pick up a delayed, attenuated echo of
+reference 0, with low level near end noise throughout.
+"""
+
+import argparse
+import random
+import struct
+import wave
+
+SAMPLE_RATE = 16000
+ECHO_DELAY = 160
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("output", help="wav file to write")
+    parser.add_argument("--seconds", type=float, default=10.0)
+    args = parser.parse_args()
+
+    random.seed(1)
+    num_samples = int(args.seconds * SAMPLE_RATE)
+    history = [0.0] * (ECHO_DELAY + 1)
+    lp = [0.0, 0.0]
+    frames = bytearray()
+
+    for n in range(num_samples):
+        active = n < num_samples // 2
+        ref = []
+        for ch in range(2):
+            lp[ch] = 0.9 * lp[ch] + 0.1 * random.uniform(-1, 1)
+            ref.append(lp[ch] * 3 * 8000 if active else 0.0)
+        history = history[1:] + [ref[0]]
+        echo = history[0] / 2
+        mic = [echo + random.uniform(-100, 100) for _ in range(2)]
+        samples = [int(max(-32768, min(32767, s))) for s in ref + mic]
+        frames += struct.pack("<4h", *samples)
+
+    with wave.open(args.output, "wb") as w:
+        w.setnchannels(4)
+        w.setsampwidth(2)
+        w.setframerate(SAMPLE_RATE)
+        w.writeframes(bytes(frames))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,119 @@
+## Host build of the ADEC reference pipeline (AEC+ADEC on tile 1, IC/VNR, NS
+## and AGC on tile 0) with an offline wav runner. The voice libraries are only
+## built for the host when XCORE_VOICE_HOST_PIPELINE is ON.
+if(${CMAKE_SYSTEM_NAME} STREQUAL XCORE_XS3A OR NOT TARGET fwk_voice::aec)
+    return()
+endif()
+
+set(AUDIO_PIPELINES_PATH ${CMAKE_CURRENT_LIST_DIR}/../../modules/audio_pipelines)
+set(PROFILING_PATH ${CMAKE_CURRENT_LIST_DIR}/../../modules/profiling)
+
+add_executable(pipeline_host
+    ${CMAKE_CURRENT_LIST_DIR}/src/main.c
+    ${CMAKE_CURRENT_LIST_DIR}/src/host_wav.c
+    ${CMAKE_CURRENT_LIST_DIR}/src/shim/host_shim.c
+    ${AUDIO_PIPELINES_PATH}/common/frame_pool.c
+    ${AUDIO_PIPELINES_PATH}/common/frame_trace.c
+    ${AUDIO_PIPELINES_PATH}/common/frame_transport.c
+    ${AUDIO_PIPELINES_PATH}/common/pipeline_graph.c
+    ${AUDIO_PIPELINES_PATH}/common/stage_blocks.c
+    ${AUDIO_PIPELINES_PATH}/reference/audio_pipeline_graph.c
+    ${AUDIO_PIPELINES_PATH}/reference/adec/audio_pipeline_t0.c
+    ${AUDIO_PIPELINES_PATH}/reference/adec/audio_pipeline_t1.c
+    ${AUDIO_PIPELINES_PATH}/reference/adec/stage1/stage_1.c
+    ${AUDIO_PIPELINES_PATH}/reference/adec/aec/aec_process_frame_1thread.c
+    ${AUDIO_PIPELINES_PATH}/reference/aec/aec_process_frame_threads.c
+    ${AUDIO_PIPELINES_PATH}/reference/aec/aec_idle_gate.c
+    ${AUDIO_PIPELINES_PATH}/reference/aec/aec_switch.c
+    ${AUDIO_PIPELINES_PATH}/reference/aec/delay_alignment.c
+    ${AUDIO_PIPELINES_PATH}/reference/aec/delay_buffer.c
+    ${AUDIO_PIPELINES_PATH}/reference/aec/delay_estimator.c
+    ${PROFILING_PATH}/profile.c
+)
+
+## Both tiles are linked into one program, so the public functions of the
+## tile 1 pipeline are renamed
+set_source_files_properties(${AUDIO_PIPELINES_PATH}/reference/adec/audio_pipeline_t0.c
+    PROPERTIES COMPILE_DEFINITIONS "THIS_XCORE_TILE=0"
+)
+set_source_files_properties(${AUDIO_PIPELINES_PATH}/reference/adec/audio_pipeline_t1.c
+    PROPERTIES COMPILE_DEFINITIONS
+        "THIS_XCORE_TILE=1;audio_pipeline_init=audio_pipeline_init_tile1;audio_pipeline_frame_release=audio_pipeline_frame_release_tile1;audio_pipeline_frame_pool_stats_get=audio_pipeline_frame_pool_stats_get_tile1"
+)
+
+## The shim directory comes first so that it stands in for FreeRTOS, the
+## intertile driver and the xcore headers
+target_include_directories(pipeline_host
+    PRIVATE
+        ${CMAKE_CURRENT_LIST_DIR}/src/shim
+        ${CMAKE_CURRENT_LIST_DIR}/src
+        ${AUDIO_PIPELINES_PATH}/common
+        ${PROFILING_PATH}
+        ${AUDIO_PIPELINES_PATH}/reference
+        ${AUDIO_PIPELINES_PATH}/reference/aec
+        ${AUDIO_PIPELINES_PATH}/reference/adec
+        ${AUDIO_PIPELINES_PATH}/reference/adec/aec
+        ${AUDIO_PIPELINES_PATH}/reference/adec/stage1
+)
+
+# Set PIPELINE_HOST_PROFILE=1 to print the time spent in each stage after each file
+if(NOT DEFINED PIPELINE_HOST_PROFILE)
+    set(PIPELINE_HOST_PROFILE 0)
+endif()
+
+# Set PIPELINE_HOST_LATENCY_TRACE=1 to also print the frame latency statistics
+if(NOT DEFINED PIPELINE_HOST_LATENCY_TRACE)
+    set(PIPELINE_HOST_LATENCY_TRACE 0)
+endif()
+
+# Set PIPELINE_HOST_AEC_IDLE_GATE=1 to skip the AEC while the reference is quiet
+if(NOT DEFINED PIPELINE_HOST_AEC_IDLE_GATE)
+    set(PIPELINE_HOST_AEC_IDLE_GATE 0)
+endif()
+
+# Set PIPELINE_HOST_DELAY_ESTIMATOR=1 to align the mic and reference with the
+# standalone delay estimator. There are no tasks on the host, so the estimates
+# are made in the pipeline stage
+if(NOT DEFINED PIPELINE_HOST_DELAY_ESTIMATOR)
+    set(PIPELINE_HOST_DELAY_ESTIMATOR 0)
+endif()
+
+# Set PIPELINE_HOST_AEC_THREADS to share the AEC between that many threads
+if(NOT DEFINED PIPELINE_HOST_AEC_THREADS)
+    set(PIPELINE_HOST_AEC_THREADS 1)
+endif()
+
+# Set PIPELINE_HOST_FRAME_ADVANCE to run the pipeline with another frame
+# advance, a divisor or a multiple of 240 samples
+if(NOT DEFINED PIPELINE_HOST_FRAME_ADVANCE)
+    set(PIPELINE_HOST_FRAME_ADVANCE 240)
+endif()
+
+target_compile_definitions(pipeline_host
+    PRIVATE
+        X86_BUILD=1
+        appconfAUDIO_PIPELINE_FRAME_ADVANCE=${PIPELINE_HOST_FRAME_ADVANCE}
+        appconfAUDIO_PIPELINE_AEC_THREADS=${PIPELINE_HOST_AEC_THREADS}
+        appconfPROFILE_ENABLED=${PIPELINE_HOST_PROFILE}
+        appconfAUDIO_PIPELINE_LATENCY_TRACE=${PIPELINE_HOST_LATENCY_TRACE}
+        appconfAEC_IDLE_GATE_ENABLED=${PIPELINE_HOST_AEC_IDLE_GATE}
+        appconfDELAY_ESTIMATOR_ENABLED=${PIPELINE_HOST_DELAY_ESTIMATOR}
+        appconfDELAY_ESTIMATOR_TASK=0
+)
+
+target_compile_options(pipeline_host PRIVATE -O3)
+
+find_package(Threads REQUIRED)
+
+target_link_libraries(pipeline_host
+    PRIVATE
+        fwk_voice::adec
+        fwk_voice::aec
+        fwk_voice::agc
+        fwk_voice::ic
+        fwk_voice::ns
+        fwk_voice::vnr::features
+        fwk_voice::vnr::inference
+        Threads::Threads
+        m
+)
@@ -0,0 +1,155 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "host_wav.h"
+
+#define WAV_FORMAT_PCM          (1)
+#define WAV_FORMAT_EXTENSIBLE   (0xFFFE)
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = v; p[1] = v >> 8;
+}
+
+int host_wav_open_read(host_wav_t *wav, const char *path)
+{
+    uint8_t hdr[12];
+    uint8_t chunk[8];
+    int have_fmt = 0;
+
+    memset(wav, 0, sizeof(*wav));
+    wav->fp = fopen(path, "rb");
+    if (wav->fp == NULL) {
+        return -1;
+    }
+    if (fread(hdr, 1, sizeof(hdr), wav->fp) != sizeof(hdr) ||
+        memcmp(hdr, "RIFF", 4) != 0 || memcmp(&hdr[8], "WAVE", 4) != 0) {
+        goto error;
+    }
+
+    /* Walk the chunks up to the data */
+    while (fread(chunk, 1, sizeof(chunk), wav->fp) == sizeof(chunk)) {
+        uint32_t size = get_u32(&chunk[4]);
+
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            uint8_t fmt[16];
+
+            if (size < sizeof(fmt) || fread(fmt, 1, sizeof(fmt), wav->fp) != sizeof(fmt)) {
+                goto error;
+            }
+            uint16_t format = get_u16(&fmt[0]);
+            if (format != WAV_FORMAT_PCM && format != WAV_FORMAT_EXTENSIBLE) {
+                goto error;
+            }
+            wav->channels = get_u16(&fmt[2]);
+            wav->sample_rate = get_u32(&fmt[4]);
+            wav->bit_depth = get_u16(&fmt[14]);
+            /* Also keeps the frame size used to count the frames non-zero */
+            if (wav->channels == 0 || (wav->bit_depth != 16 && wav->bit_depth != 32)) {
+                goto error;
+            }
+            fseek(wav->fp, (size - sizeof(fmt) + 1) & ~1u, SEEK_CUR);
+            have_fmt = 1;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (!have_fmt) {
+                goto error;
+            }
+            wav->num_frames = size / (wav->channels * (wav->bit_depth / 8));
+            return 0;
+        } else {
+            fseek(wav->fp, (size + 1) & ~1u, SEEK_CUR);
+        }
+    }
+
+error:
+    fclose(wav->fp);
+    wav->fp = NULL;
+    return -1;
+}
+
+uint32_t host_wav_read(host_wav_t *wav, int32_t *samples, uint32_t num_frames)
+{
+    size_t n = (size_t)num_frames * wav->channels;
+
+    if (wav->bit_depth == 32) {
+        return (uint32_t)(fread(samples, sizeof(int32_t), n, wav->fp) / wav->channels);
+    }
+
+    /* Widen 16 bit samples in place, from the end */
+    int16_t *s16 = (int16_t *)samples;
+    size_t got = fread(s16, sizeof(int16_t), n, wav->fp);
+    for (size_t i = got; i-- > 0;) {
+        samples[i] = (int32_t)s16[i] << 16;
+    }
+    return (uint32_t)(got / wav->channels);
+}
+
+int host_wav_open_write(host_wav_t *wav, const char *path, unsigned channels,
+                        unsigned sample_rate, uint32_t num_frames)
+{
+    uint8_t hdr[44];
+    uint32_t data_bytes = num_frames * channels * sizeof(int32_t);
+
+    memset(wav, 0, sizeof(*wav));
+    wav->fp = fopen(path, "wb");
+    if (wav->fp == NULL) {
+        return -1;
+    }
+    wav->channels = channels;
+    wav->sample_rate = sample_rate;
+    wav->bit_depth = 32;
+    wav->num_frames = num_frames;
+
+    memcpy(&hdr[0], "RIFF", 4);
+    put_u32(&hdr[4], 36 + data_bytes);
+    memcpy(&hdr[8], "WAVEfmt ", 8);
+    put_u32(&hdr[16], 16);
+    put_u16(&hdr[20], WAV_FORMAT_PCM);
+    put_u16(&hdr[22], channels);
+    put_u32(&hdr[24], sample_rate);
+    put_u32(&hdr[28], sample_rate * channels * sizeof(int32_t));
+    put_u16(&hdr[32], channels * sizeof(int32_t));
+    put_u16(&hdr[34], 32);
+    memcpy(&hdr[36], "data", 4);
+    put_u32(&hdr[40], data_bytes);
+
+    if (fwrite(hdr, 1, sizeof(hdr), wav->fp) != sizeof(hdr)) {
+        host_wav_close(wav);
+        return -1;
+    }
+    return 0;
+}
+
+int host_wav_write(host_wav_t *wav, const int32_t *samples, uint32_t num_frames)
+{
+    size_t n = (size_t)num_frames * wav->channels;
+
+    return fwrite(samples, sizeof(int32_t), n, wav->fp) == n ? 0 : -1;
+}
+
+void host_wav_close(host_wav_t *wav)
+{
+    if (wav->fp != NULL) {
+        fclose(wav->fp);
+        wav->fp = NULL;
+    }
+}
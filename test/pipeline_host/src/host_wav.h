@@ -0,0 +1,34 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef HOST_WAV_H_
+#define HOST_WAV_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+typedef struct {
+    FILE *fp;
+    unsigned channels;
+    unsigned sample_rate;
+    unsigned bit_depth;
+    uint32_t num_frames;
+} host_wav_t;
+
+/* Open a 16 or 32 bit PCM wav file for reading. Returns 0 on success. */
+int host_wav_open_read(host_wav_t *wav, const char *path);
+
+/* Read up to num_frames interleaved frames as 32 bit samples. Returns the
+ * number of frames read. */
+uint32_t host_wav_read(host_wav_t *wav, int32_t *samples, uint32_t num_frames);
+
+/* Create a 32 bit PCM wav file of num_frames frames. Returns 0 on success. */
+int host_wav_open_write(host_wav_t *wav, const char *path, unsigned channels,
+                        unsigned sample_rate, uint32_t num_frames);
+
+/* Write num_frames interleaved 32 bit frames. Returns 0 on success. */
+int host_wav_write(host_wav_t *wav, const int32_t *samples, uint32_t num_frames);
+
+void host_wav_close(host_wav_t *wav);
+
+#endif /* HOST_WAV_H_ */
@@ -0,0 +1,304 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <libgen.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "app_conf.h"
+#include "audio_pipeline.h"
+#include "generic_pipeline.h"
+#include "host_wav.h"
+#include "profile.h"
+
+/* The tile 1 pipeline, renamed in pipeline_host.cmake so that both tiles can
+ * be linked into one program */
+void audio_pipeline_init_tile1(void *input_app_data, void *output_app_data);
+
+#define FRAME_ADVANCE   (appconfAUDIO_PIPELINE_FRAME_ADVANCE)
+#define IN_CHANNELS     (appconfAUDIO_PIPELINE_INPUT_CHANNELS)
+#define OUT_CHANNELS    (appconfOUTPUT_CHANNELS)
+
+#define MAX_FILES       (4096)
+
+/* One frame in the pipeline channel order: reference channels then microphone
+ * channels in, processed channels out. Same as test/pipeline. */
+static int32_t in_frame[IN_CHANNELS][FRAME_ADVANCE];
+static int32_t out_frame[OUT_CHANNELS][FRAME_ADVANCE];
+
+void audio_pipeline_input(void *input_app_data,
+                          int32_t **input_audio_frames,
+                          size_t ch_count,
+                          size_t frame_count)
+{
+    (void) input_app_data;
+    (void) frame_count;
+
+    memcpy(input_audio_frames, in_frame, ch_count * sizeof(in_frame[0]));
+}
+
+int audio_pipeline_output(void *output_app_data,
+                          int32_t **output_audio_frames,
+                          size_t ch_count,
+                          size_t frame_count)
+{
+    (void) output_app_data;
+    (void) ch_count;
+    (void) frame_count;
+
+    memcpy(out_frame, output_audio_frames, sizeof(out_frame));
+    return AUDIO_PIPELINE_FREE_FRAME;
+}
+
+static double time_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Runs in a worker process, so each file starts from a fresh pipeline */
+static int process_file(const char *in_path, const char *out_path)
+{
+    host_wav_t in_wav;
+    host_wav_t out_wav;
+    int32_t raw[FRAME_ADVANCE * IN_CHANNELS];
+    int32_t interleaved[FRAME_ADVANCE * OUT_CHANNELS];
+
+    if (host_wav_open_read(&in_wav, in_path) != 0) {
+        printf("%s: cannot read wav file\n", in_path);
+        return 1;
+    }
+    if (in_wav.channels != IN_CHANNELS || in_wav.sample_rate != appconfAUDIO_PIPELINE_SAMPLE_RATE) {
+        printf("%s: %u channels at %u Hz, expected %u channels at %u Hz\n", in_path,
+               in_wav.channels, in_wav.sample_rate, IN_CHANNELS, appconfAUDIO_PIPELINE_SAMPLE_RATE);
+        host_wav_close(&in_wav);
+        return 1;
+    }
+
+    uint32_t frame_count = in_wav.num_frames / FRAME_ADVANCE;
+    if (host_wav_open_write(&out_wav, out_path, OUT_CHANNELS, in_wav.sample_rate, frame_count * FRAME_ADVANCE) != 0) {
+        printf("%s: cannot create %s\n", in_path, out_path);
+        host_wav_close(&in_wav);
+        return 1;
+    }
+
+    audio_pipeline_init_tile1(NULL, NULL);
+    audio_pipeline_init(NULL, NULL);
+
+    double start = time_s();
+    for (uint32_t f = 0; f < frame_count; f++) {
+        if (host_wav_read(&in_wav, raw, FRAME_ADVANCE) != FRAME_ADVANCE) {
+            printf("%s: read error\n", in_path);
+            break;
+        }
+
+        // wav files are in frame-major order, the pipeline expects sample-major order
+        for (unsigned i = 0; i < FRAME_ADVANCE; i++) {
+            for (unsigned ch = 0; ch < IN_CHANNELS; ch++) {
+                in_frame[ch][i] = raw[i * IN_CHANNELS + ch];
+            }
+        }
+
+        generic_pipeline_host_run_frame();
+
+        for (unsigned ch = 0; ch < OUT_CHANNELS; ch++) {
+            for (unsigned i = 0; i < FRAME_ADVANCE; i++) {
+                interleaved[i * OUT_CHANNELS + ch] = out_frame[ch][i];
+            }
+        }
+        host_wav_write(&out_wav, interleaved, FRAME_ADVANCE);
+    }
+    double elapsed = time_s() - start;
+    double audio_s = (double)frame_count * FRAME_ADVANCE / appconfAUDIO_PIPELINE_SAMPLE_RATE;
+
+    printf("%s: %u frames, %.1f s of audio in %.2f s, %.1fx real time\n",
+           in_path, (unsigned)frame_count, audio_s, elapsed, elapsed > 0 ? audio_s / elapsed : 0.0);
+    profile_dump();
+
+    host_wav_close(&in_wav);
+    host_wav_close(&out_wav);
+    return 0;
+}
+
+static int is_wav(const char *name)
+{
+    size_t len = strlen(name);
+
+    return len > 4 && strcasecmp(&name[len - 4], ".wav") == 0;
+}
+
+static int compare_paths(const void *a, const void *b)
+{
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+/* Add a file, or the wav files in a directory, to the list */
+static int add_input(char **files, int count, const char *path)
+{
+    struct stat st;
+
+    if (stat(path, &st) != 0) {
+        printf("%s: %s\n", path, strerror(errno));
+        exit(1);
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        if (count < MAX_FILES) {
+            files[count++] = strdup(path);
+        }
+        return count;
+    }
+
+    DIR *dir = opendir(path);
+    struct dirent *entry;
+    int first = count;
+
+    while (dir != NULL && (entry = readdir(dir)) != NULL && count < MAX_FILES) {
+        if (is_wav(entry->d_name)) {
+            char *file = malloc(strlen(path) + strlen(entry->d_name) + 2);
+            sprintf(file, "%s/%s", path, entry->d_name);
+            files[count++] = file;
+        }
+    }
+    if (dir != NULL) {
+        closedir(dir);
+    }
+    qsort(&files[first], count - first, sizeof(char *), compare_paths);
+    return count;
+}
+
+/* Load a pipeline graph file, see pipeline_graph.h for the format */
+static int load_graph(const char *path, pipeline_graph_t *graph)
+{
+    FILE *f = fopen(path, "rb");
+    long size;
+    char *text;
+    int count = -1;
+
+    if (f == NULL) {
+        printf("%s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    text = malloc(size + 1);
+    if (text != NULL && fread(text, 1, size, f) == (size_t)size) {
+        text[size] = '\0';
+        count = pipeline_graph_parse(text, graph);
+        if (count < 0) {
+            printf("%s: error on line %d\n", path, -count);
+        }
+    }
+    free(text);
+    fclose(f);
+    return count;
+}
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s [-j jobs] [-o output_dir] [-g graph_file] <wav file or directory>...\n", prog);
+    printf("\n");
+    printf("Runs each %u channel wav file (reference 0, reference 1, mic 0, mic 1) through the\n", IN_CHANNELS);
+    printf("reference audio pipeline and writes the %u processed channels to output_dir,\n", OUT_CHANNELS);
+    printf("under the same file name. Files are processed by up to jobs worker processes.\n");
+    printf("\n");
+    printf("  -j jobs        number of files processed in parallel (default: number of CPUs)\n");
+    printf("  -o output_dir  output directory (default: pipeline_host_out)\n");
+    printf("  -g graph_file  pipeline graph to run in place of the default graph\n");
+}
+
+int main(int argc, char *argv[])
+{
+    static char *files[MAX_FILES];
+    static pipeline_graph_t graph;
+    const char *out_dir = "pipeline_host_out";
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    int file_count = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "j:o:g:h")) != -1) {
+        switch (opt) {
+        case 'j':
+            jobs = strtol(optarg, NULL, 0);
+            break;
+        case 'o':
+            out_dir = optarg;
+            break;
+        case 'g':
+            if (load_graph(optarg, &graph) <= 0) {
+                return 1;
+            }
+            audio_pipeline_graph_set(&graph);
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (optind >= argc || jobs < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    for (int i = optind; i < argc; i++) {
+        file_count = add_input(files, file_count, argv[i]);
+    }
+    if (mkdir(out_dir, 0777) != 0 && errno != EEXIST) {
+        printf("%s: %s\n", out_dir, strerror(errno));
+        return 1;
+    }
+
+    /* The pipelines keep their state in static variables, so files are run
+     * in separate processes rather than threads */
+    double start = time_s();
+    int running = 0;
+    int failed = 0;
+    int next = 0;
+
+    while (next < file_count || running > 0) {
+        if (next < file_count && running < jobs) {
+            char *in_path = files[next++];
+            char *base = basename(strdup(in_path));
+            char *out_path = malloc(strlen(out_dir) + strlen(base) + 2);
+            sprintf(out_path, "%s/%s", out_dir, base);
+
+            fflush(stdout);
+            pid_t pid = fork();
+            if (pid == 0) {
+                int ret = process_file(in_path, out_path);
+                fflush(stdout);
+                _exit(ret);
+            } else if (pid < 0) {
+                printf("%s: fork failed\n", in_path);
+                failed++;
+            } else {
+                running++;
+            }
+            free(out_path);
+            continue;
+        }
+
+        int status;
+        if (wait(&status) > 0) {
+            running--;
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                failed++;
+            }
+        }
+    }
+
+    printf("%d files in %.2f s with %ld jobs, %d failed\n", file_count, time_s() - start, jobs, failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,55 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef HOST_SHIM_FREERTOS_H_
+#define HOST_SHIM_FREERTOS_H_
+
+/*
+ * The part of the FreeRTOS API used by the reference audio pipelines, for
+ * running them on the host. The pipeline stages are driven by
+ * generic_pipeline_host_run_frame() rather than by tasks. Only the AEC worker
+ * tasks of the multi-threaded AEC run as threads of their own.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "rtos_printf.h"
+#include "xcore/assert.h"
+
+#ifndef DWORD_ALIGNED
+#define DWORD_ALIGNED   __attribute__ ((aligned(8)))
+#endif
+
+#define configASSERT(x)             assert(x)
+#define configMAX_PRIORITIES        (32)
+#define configMINIMAL_STACK_SIZE    (256)
+#define configSTACK_DEPTH_TYPE      uint32_t
+#define RTOS_THREAD_STACK_SIZE(f)   (0)
+
+#define pdFALSE         (0)
+#define pdTRUE          (1)
+#define pdPASS          (pdTRUE)
+#define portMAX_DELAY   (0xFFFFFFFFu)
+
+typedef uint32_t TickType_t;
+typedef int32_t BaseType_t;
+typedef uint32_t UBaseType_t;
+typedef uint32_t EventBits_t;
+typedef void *TaskHandle_t;
+typedef void *EventGroupHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define pvPortMalloc(size)  malloc(size)
+#define vPortFree(ptr)      free(ptr)
+
+/* Tasks and event groups are only used by the multi-threaded AEC. Tasks run
+ * as pthreads, and event groups only support xEventGroupSync(). */
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, configSTACK_DEPTH_TYPE stack_depth,
+                       void *arg, UBaseType_t priority, TaskHandle_t *handle);
+EventGroupHandle_t xEventGroupCreate(void);
+EventBits_t xEventGroupSync(EventGroupHandle_t group, EventBits_t set, EventBits_t wait, TickType_t timeout);
+
+#endif /* HOST_SHIM_FREERTOS_H_ */
@@ -0,0 +1,9 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef HOST_SHIM_EVENT_GROUPS_H_
+#define HOST_SHIM_EVENT_GROUPS_H_
+
+#include "FreeRTOS.h"
+
+#endif /* HOST_SHIM_EVENT_GROUPS_H_ */
@@ -0,0 +1,28 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef HOST_SHIM_GENERIC_PIPELINE_H_
+#define HOST_SHIM_GENERIC_PIPELINE_H_
+
+#include <stddef.h>
+
+typedef void *(*pipeline_input_t)(void *input_app_data);
+typedef int (*pipeline_output_t)(void *frame, void *output_app_data);
+typedef void (*pipeline_stage_t)(void *frame);
+
+/* Register a pipeline. Instead of starting a task per stage, the stages are
+ * run in order on the caller's thread by generic_pipeline_host_run_frame(). */
+void generic_pipeline_init(const pipeline_input_t input,
+                           const pipeline_output_t output,
+                           void * const input_data,
+                           void * const output_data,
+                           const pipeline_stage_t * const stage_functions,
+                           const size_t * const stage_stack_sizes,
+                           const int pipeline_priority,
+                           const int stage_count);
+
+/* Pass one frame through each registered pipeline, in the order they were
+ * registered. Register the pipeline of the input tile first. */
+void generic_pipeline_host_run_frame(void);
+
+#endif /* HOST_SHIM_GENERIC_PIPELINE_H_ */
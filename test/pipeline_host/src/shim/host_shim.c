@@ -0,0 +1,192 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include "FreeRTOS.h"
+#include "generic_pipeline.h"
+#include "platform/driver_instances.h"
+
+#define HOST_MAX_PIPELINES          (2)
+#define HOST_MAX_STAGES             (8)
+#define HOST_INTERTILE_PORTS        (8)
+#define HOST_INTERTILE_MAX_BYTES    (32 * 1024)
+
+/* generic_pipeline frees the frame when the output returns this */
+#define HOST_PIPELINE_FREE_FRAME    (1)
+
+typedef struct {
+    pipeline_input_t input;
+    pipeline_output_t output;
+    void *input_data;
+    void *output_data;
+    pipeline_stage_t stages[HOST_MAX_STAGES];
+    int stage_count;
+} host_pipeline_t;
+
+struct rtos_intertile_struct {
+    uint8_t msg[HOST_INTERTILE_PORTS][HOST_INTERTILE_MAX_BYTES];
+    size_t len[HOST_INTERTILE_PORTS];
+    int rx_port;
+};
+
+static host_pipeline_t pipelines[HOST_MAX_PIPELINES];
+static int pipeline_count;
+
+static rtos_intertile_t host_intertile = { .rx_port = -1 };
+rtos_intertile_t *intertile_ctx = &host_intertile;
+
+void generic_pipeline_init(const pipeline_input_t input,
+                           const pipeline_output_t output,
+                           void * const input_data,
+                           void * const output_data,
+                           const pipeline_stage_t * const stage_functions,
+                           const size_t * const stage_stack_sizes,
+                           const int pipeline_priority,
+                           const int stage_count)
+{
+    (void) stage_stack_sizes;
+    (void) pipeline_priority;
+
+    assert(pipeline_count < HOST_MAX_PIPELINES);
+    assert(stage_count <= HOST_MAX_STAGES);
+
+    host_pipeline_t *p = &pipelines[pipeline_count++];
+    p->input = input;
+    p->output = output;
+    p->input_data = input_data;
+    p->output_data = output_data;
+    memcpy(p->stages, stage_functions, stage_count * sizeof(pipeline_stage_t));
+    p->stage_count = stage_count;
+}
+
+void generic_pipeline_host_run_frame(void)
+{
+    for (int i = 0; i < pipeline_count; i++) {
+        host_pipeline_t *p = &pipelines[i];
+        void *frame = p->input(p->input_data);
+
+        for (int s = 0; s < p->stage_count; s++) {
+            p->stages[s](frame);
+        }
+        if (p->output(frame, p->output_data) == HOST_PIPELINE_FREE_FRAME) {
+            vPortFree(frame);
+        }
+    }
+}
+
+void rtos_intertile_tx(rtos_intertile_t *ctx, uint8_t port, void *msg, size_t len)
+{
+    assert(port < HOST_INTERTILE_PORTS);
+    assert(len <= HOST_INTERTILE_MAX_BYTES);
+    assert(ctx->len[port] == 0);
+
+    memcpy(ctx->msg[port], msg, len);
+    ctx->len[port] = len;
+}
+
+size_t rtos_intertile_rx_len(rtos_intertile_t *ctx, uint8_t port, unsigned timeout)
+{
+    (void) timeout;
+
+    /* Nothing can arrive while waiting, the sender runs on this thread */
+    assert(port < HOST_INTERTILE_PORTS);
+    assert(ctx->len[port] != 0);
+
+    ctx->rx_port = port;
+    return ctx->len[port];
+}
+
+size_t rtos_intertile_rx_data(rtos_intertile_t *ctx, void *data, size_t len)
+{
+    assert(ctx->rx_port >= 0);
+    assert(len == ctx->len[ctx->rx_port]);
+
+    memcpy(data, ctx->msg[ctx->rx_port], len);
+    ctx->len[ctx->rx_port] = 0;
+    ctx->rx_port = -1;
+    return len;
+}
+
+typedef struct {
+    TaskFunction_t fn;
+    void *arg;
+} host_task_t;
+
+static void *host_task_entry(void *arg)
+{
+    host_task_t task = *(host_task_t *)arg;
+
+    free(arg);
+    task.fn(task.arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, configSTACK_DEPTH_TYPE stack_depth,
+                       void *arg, UBaseType_t priority, TaskHandle_t *handle)
+{
+    (void) name; (void) stack_depth; (void) priority;
+
+    host_task_t *task = malloc(sizeof(host_task_t));
+    pthread_t thread;
+
+    assert(task != NULL);
+    task->fn = fn;
+    task->arg = arg;
+    if (pthread_create(&thread, NULL, host_task_entry, task) != 0) {
+        free(task);
+        return pdFALSE;
+    }
+    pthread_detach(thread);
+    if (handle != NULL) {
+        *handle = NULL;
+    }
+    return pdPASS;
+}
+
+/* Event groups only support xEventGroupSync(), as a barrier of the threads
+ * whose bits are waited for */
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    EventBits_t bits;
+    uint32_t generation;    // Incremented each time the barrier is passed
+} host_event_group_t;
+
+EventGroupHandle_t xEventGroupCreate(void)
+{
+    host_event_group_t *group = calloc(1, sizeof(host_event_group_t));
+
+    if (group != NULL) {
+        pthread_mutex_init(&group->lock, NULL);
+        pthread_cond_init(&group->cond, NULL);
+    }
+    return group;
+}
+
+EventBits_t xEventGroupSync(EventGroupHandle_t group, EventBits_t set, EventBits_t wait, TickType_t timeout)
+{
+    host_event_group_t *g = group;
+
+    /* Only used to wait for the other threads with no timeout */
+    assert(timeout == portMAX_DELAY);
+
+    pthread_mutex_lock(&g->lock);
+    g->bits |= set;
+    if ((g->bits & wait) == wait) {
+        /* The last thread to arrive clears the bits and releases the others */
+        g->bits &= ~wait;
+        g->generation++;
+        pthread_cond_broadcast(&g->cond);
+    } else {
+        uint32_t generation = g->generation;
+        while (generation == g->generation) {
+            pthread_cond_wait(&g->cond, &g->lock);
+        }
+    }
+    pthread_mutex_unlock(&g->lock);
+    return wait;
+}
@@ -0,0 +1,29 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef HOST_SHIM_DRIVER_INSTANCES_H_
+#define HOST_SHIM_DRIVER_INSTANCES_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* The sources of each tile are compiled with THIS_XCORE_TILE set to the tile
+ * number, see pipeline_host.cmake */
+#ifndef THIS_XCORE_TILE
+#define THIS_XCORE_TILE     0
+#endif
+#define ON_TILE(t)          (THIS_XCORE_TILE == (t))
+
+/*
+ * Intertile transfers between the tiles of the same process. Each port holds
+ * one message, which must be received before the next is sent.
+ */
+typedef struct rtos_intertile_struct rtos_intertile_t;
+
+extern rtos_intertile_t *intertile_ctx;
+
+void rtos_intertile_tx(rtos_intertile_t *ctx, uint8_t port, void *msg, size_t len);
+size_t rtos_intertile_rx_len(rtos_intertile_t *ctx, uint8_t port, unsigned timeout);
+size_t rtos_intertile_rx_data(rtos_intertile_t *ctx, void *data, size_t len);
+
+#endif /* HOST_SHIM_DRIVER_INSTANCES_H_ */
@@ -0,0 +1,11 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef HOST_SHIM_RTOS_PRINTF_H_
+#define HOST_SHIM_RTOS_PRINTF_H_
+
+#include <stdio.h>
+
+#define rtos_printf     printf
+
+#endif /* HOST_SHIM_RTOS_PRINTF_H_ */
@@ -0,0 +1,21 @@
+set(PROFILING_PATH ${CMAKE_CURRENT_LIST_DIR}/../../modules/profiling)
+
+## The profiling tests record times directly, so only run on the host
+if(NOT ${CMAKE_SYSTEM_NAME} STREQUAL XCORE_XS3A)
+    add_executable(test_profile
+        ${CMAKE_CURRENT_LIST_DIR}/src/test_profile.c
+        ${PROFILING_PATH}/profile.c
+    )
+
+    target_include_directories(test_profile
+        PRIVATE
+            ${PROFILING_PATH}
+    )
+
+    target_compile_definitions(test_profile
+        PRIVATE
+            X86_BUILD=1
+            appconfPROFILE_MAX_PROBES=4
+            appconfPROFILE_RING_SIZE=256
+    )
+endif()
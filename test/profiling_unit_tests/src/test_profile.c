@@ -0,0 +1,140 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "profile.h"
+
+#define xassert assert
+
+#define TEST_RECORDS    (1000)
+
+static profile_probe_t probe_a = { .name = "a" };
+static profile_probe_t probe_b = { .name = "b" };
+static profile_probe_t probe_c = { .name = "c" };
+static profile_probe_t probe_d = { .name = "d" };
+static profile_probe_t probe_e = { .name = "e" };
+
+static uint32_t times[TEST_RECORDS];
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/* The value with fewer than 1% of the window above it */
+static uint32_t expected_p99(const uint32_t *t, size_t n)
+{
+    uint32_t sorted[appconfPROFILE_RING_SIZE];
+    size_t window = n < appconfPROFILE_RING_SIZE ? n : appconfPROFILE_RING_SIZE;
+
+    memcpy(sorted, &t[n - window], window * sizeof(uint32_t));
+    qsort(sorted, window, sizeof(uint32_t), compare_u32);
+    return sorted[window - 1 - window / 100];
+}
+
+static void check_stats(unsigned index, const uint32_t *t, size_t n, bool verbose)
+{
+    profile_stats_t stats;
+    uint32_t min = UINT32_MAX;
+    uint32_t max = 0;
+    uint64_t total = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        min = t[i] < min ? t[i] : min;
+        max = t[i] > max ? t[i] : max;
+        total += t[i];
+    }
+
+    xassert(profile_stats_get(index, &stats) == 0);
+    if (verbose) {
+        printf("%s: count=%u min=%u avg=%u max=%u p99=%u expected p99=%u\n", stats.name,
+               (unsigned)stats.count, (unsigned)stats.min_ticks, (unsigned)stats.avg_ticks,
+               (unsigned)stats.max_ticks, (unsigned)stats.p99_ticks, (unsigned)expected_p99(t, n));
+    }
+    xassert(stats.count == n);
+    xassert(stats.min_ticks == min);
+    xassert(stats.avg_ticks == (uint32_t)(total / n));
+    xassert(stats.max_ticks == max);
+    xassert(stats.p99_ticks == expected_p99(t, n));
+}
+
+void test_stats(bool verbose)
+{
+    /* Mostly steady times with occasional spikes, like a pipeline stage */
+    for (int i = 0; i < TEST_RECORDS; i++) {
+        times[i] = 10000 + rand() % 500;
+        if ((rand() % 50) == 0) {
+            times[i] += 20000 + rand() % 10000;
+        }
+    }
+
+    /* Check while the ring fills, when it is full, and after it has wrapped */
+    const size_t checkpoints[] = {1, 2, 99, 100, 101, appconfPROFILE_RING_SIZE - 1,
+                                  appconfPROFILE_RING_SIZE, appconfPROFILE_RING_SIZE + 1,
+                                  2 * appconfPROFILE_RING_SIZE, TEST_RECORDS};
+    size_t n = 0;
+
+    for (int c = 0; c < sizeof(checkpoints) / sizeof(checkpoints[0]); c++) {
+        while (n < checkpoints[c]) {
+            profile_probe_record(&probe_a, times[n++]);
+        }
+        check_stats(0, times, n, verbose);
+    }
+}
+
+void test_registration(bool verbose)
+{
+    profile_stats_t stats;
+
+    /* Probe a is registered by test_stats(), b registers on its first record */
+    xassert(profile_probe_count() == 1);
+    profile_probe_record(&probe_b, 5);
+    profile_probe_record(&probe_b, 7);
+    xassert(profile_probe_count() == 2);
+    xassert(profile_stats_get(1, &stats) == 0);
+    xassert(strcmp(stats.name, "b") == 0);
+    xassert(stats.count == 2 && stats.min_ticks == 5 && stats.max_ticks == 7 && stats.p99_ticks == 7);
+
+    /* Registration stops when the table is full, the extra probe still records */
+    profile_probe_record(&probe_c, 1);
+    profile_probe_record(&probe_d, 1);
+    profile_probe_record(&probe_e, 1);
+    xassert(profile_probe_count() == appconfPROFILE_MAX_PROBES);
+    xassert(profile_stats_get(appconfPROFILE_MAX_PROBES, &stats) == -1);
+    xassert(probe_e.count == 1);
+
+    /* A reset clears the counts but keeps the probes and the recent times */
+    profile_reset();
+    xassert(profile_probe_count() == appconfPROFILE_MAX_PROBES);
+    xassert(profile_stats_get(1, &stats) == 0);
+    xassert(stats.count == 0 && stats.min_ticks == 0 && stats.max_ticks == 0);
+    profile_probe_record(&probe_b, 3);
+    xassert(profile_stats_get(1, &stats) == 0);
+    xassert(stats.count == 1 && stats.min_ticks == 3 && stats.avg_ticks == 3);
+
+    if (verbose) {
+        profile_dump();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    bool verbose = argc > 1 && strcmp(argv[1], "-v") == 0;
+
+    srand(1);
+
+    test_stats(verbose);
+
+    test_registration(verbose);
+
+    printf("PASS\n");
+    return 0;
+}
@@ -1,4 +1,14 @@
 include(${CMAKE_CURRENT_LIST_DIR}/asrc_unit_tests/asrc_unit_tests.cmake)
+include(${CMAKE_CURRENT_LIST_DIR}/audio_pipeline_unit_tests/audio_pipeline_unit_tests.cmake)
+include(${CMAKE_CURRENT_LIST_DIR}/audio_response_unit_tests/audio_response_unit_tests.cmake)
+include(${CMAKE_CURRENT_LIST_DIR}/barge_in_unit_tests/barge_in_unit_tests.cmake)
+include(${CMAKE_CURRENT_LIST_DIR}/control_servicer_unit_tests/control_servicer_unit_tests.cmake)
+include(${CMAKE_CURRENT_LIST_DIR}/device_memory_unit_tests/device_memory_unit_tests.cmake)
+include(${CMAKE_CURRENT_LIST_DIR}/dfu_flash_writer_unit_tests/dfu_flash_writer_unit_tests.cmake)
+include(${CMAKE_CURRENT_LIST_DIR}/intent_table_unit_tests/intent_table_unit_tests.cmake)
+include(${CMAKE_CURRENT_LIST_DIR}/pipeline_host/pipeline_host.cmake)
+include(${CMAKE_CURRENT_LIST_DIR}/profiling_unit_tests/profiling_unit_tests.cmake)
+include(${CMAKE_CURRENT_LIST_DIR}/usb_sample_ring_unit_tests/usb_sample_ring_unit_tests.cmake)
 if(${CMAKE_SYSTEM_NAME} STREQUAL XCORE_XS3A)
     include(${CMAKE_CURRENT_LIST_DIR}/asr/asr.cmake)
     include(${CMAKE_CURRENT_LIST_DIR}/ffd_gpio/gpio.cmake)
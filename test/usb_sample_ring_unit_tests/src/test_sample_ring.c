@@ -0,0 +1,344 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "sample_ring.h"
+
+#define xassert assert
+
+#define FRAME_ADVANCE   (240)
+#define USB_FRAME       (16)
+#define NUM_CHANS       (2)
+#define CAPACITY        (3 * FRAME_ADVANCE)
+#define AMPLITUDE       (1 << 20)
+
+static sample_ring_t ring;
+static int32_t storage[CAPACITY * NUM_CHANS];
+
+/* Frames counting up from start, with the negated count in the second channel */
+static void counting_frames(int32_t *frames, uint32_t start, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        frames[i * NUM_CHANS] = start + i;
+        frames[i * NUM_CHANS + 1] = -(int32_t)(start + i);
+    }
+}
+
+static void check_counting(const int32_t *frames, uint32_t start, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        xassert(frames[i * NUM_CHANS] == (int32_t)(start + i));
+        xassert(frames[i * NUM_CHANS + 1] == -(int32_t)(start + i));
+    }
+}
+
+static int32_t sine(double phase)
+{
+    return (int32_t)(AMPLITUDE * sin(phase));
+}
+
+void test_fifo(bool verbose)
+{
+    int32_t frames[CAPACITY * NUM_CHANS];
+    uint32_t written = 0;
+    uint32_t read = 0;
+    size_t n;
+
+    /* No slips, start at one USB frame */
+    sample_ring_init(&ring, storage, CAPACITY, NUM_CHANS, USB_FRAME, 0, CAPACITY);
+
+    /* Silence until the start level */
+    counting_frames(frames, written, USB_FRAME - 1);
+    n = sample_ring_write(&ring, frames, USB_FRAME - 1);
+    xassert(n == USB_FRAME - 1);
+    written += USB_FRAME - 1;
+    n = sample_ring_read(&ring, frames, USB_FRAME);
+    xassert(n == 0);
+    for (int i = 0; i < USB_FRAME * NUM_CHANS; i++) {
+        xassert(frames[i] == 0);
+    }
+
+    /* Output starts with a fade in of the first read */
+    counting_frames(frames, written, 1);
+    n = sample_ring_write(&ring, frames, 1);
+    xassert(n == 1);
+    written += 1;
+    xassert(sample_ring_level(&ring) == USB_FRAME);
+    n = sample_ring_read(&ring, frames, USB_FRAME);
+    xassert(n == USB_FRAME);
+    xassert(frames[(USB_FRAME - 1) * NUM_CHANS] == USB_FRAME - 1);
+    xassert(abs(frames[0]) <= 1);
+    read += USB_FRAME;
+
+    /* Then frames come out as written, across the end of the ring */
+    for (int i = 0; i < 1000; i++) {
+        size_t w = 2 + rand() % (CAPACITY - sample_ring_level(&ring) - 1);
+        size_t r = 2 + rand() % (sample_ring_level(&ring) + w - 1);
+
+        counting_frames(frames, written, w);
+        n = sample_ring_write(&ring, frames, w);
+        xassert(n == w);
+        written += w;
+        n = sample_ring_read(&ring, frames, r);
+        xassert(n == r);
+        check_counting(frames, read, r);
+        read += r;
+        xassert(sample_ring_level(&ring) == written - read);
+    }
+
+    /* Frames written into a full ring are dropped */
+    size_t space = CAPACITY - sample_ring_level(&ring);
+    counting_frames(frames, written, space + 10);
+    n = sample_ring_write(&ring, frames, space + 10);
+    xassert(n == space);
+    written += space;
+    xassert(ring.overflow_frames == 10);
+    xassert(sample_ring_level(&ring) == CAPACITY);
+    n = sample_ring_read(&ring, frames, FRAME_ADVANCE);
+    xassert(n == FRAME_ADVANCE);
+    check_counting(frames, read, FRAME_ADVANCE);
+    read += FRAME_ADVANCE;
+
+    if (verbose) {
+        printf("fifo ok\n");
+    }
+}
+
+void test_underflow_and_flush(bool verbose)
+{
+    int32_t frames[CAPACITY * NUM_CHANS];
+    const int32_t dc = AMPLITUDE;
+    size_t n;
+
+    sample_ring_init(&ring, storage, CAPACITY, NUM_CHANS, FRAME_ADVANCE, 0, CAPACITY);
+
+    for (int i = 0; i < FRAME_ADVANCE * NUM_CHANS; i++) {
+        frames[i] = dc;
+    }
+    sample_ring_write(&ring, frames, FRAME_ADVANCE);
+    n = sample_ring_read(&ring, frames, FRAME_ADVANCE - 8);
+    xassert(n == FRAME_ADVANCE - 8);
+    xassert(frames[(FRAME_ADVANCE - 9) * NUM_CHANS] == dc);
+
+    /* Running out fades the rest of the read to silence instead of stepping to zero */
+    n = sample_ring_read(&ring, frames, 64);
+    xassert(n == 8);
+    xassert(ring.underflow_count == 1);
+    for (int i = 0; i < 8; i++) {
+        xassert(frames[i * NUM_CHANS] == dc);
+    }
+    for (int i = 8; i < 64; i++) {
+        xassert(frames[i * NUM_CHANS] < frames[(i - 1) * NUM_CHANS]);
+        xassert(frames[(i - 1) * NUM_CHANS] - frames[i * NUM_CHANS] <= dc / (64 - 8) + 1);
+    }
+    xassert(frames[63 * NUM_CHANS] == 0);
+
+    /* Silence until the start level is reached again */
+    for (int i = 0; i < FRAME_ADVANCE * NUM_CHANS; i++) {
+        frames[i] = dc;
+    }
+    sample_ring_write(&ring, frames, FRAME_ADVANCE - 1);
+    n = sample_ring_read(&ring, frames, 16);
+    xassert(n == 0);
+    xassert(frames[15 * NUM_CHANS] == 0);
+    sample_ring_write(&ring, frames, 17);
+    n = sample_ring_read(&ring, frames, 16);
+    xassert(n == 16);
+    xassert(frames[0] < dc / 8 && frames[15 * NUM_CHANS] == dc);
+
+    /* A flush discards the frames and fades out */
+    sample_ring_flush(&ring);
+    n = sample_ring_read(&ring, frames, 16);
+    xassert(n == 0);
+    xassert(frames[0] > frames[15 * NUM_CHANS] && frames[15 * NUM_CHANS] == 0);
+    xassert(sample_ring_level(&ring) == 0);
+
+    if (verbose) {
+        printf("underflow and flush ok\n");
+    }
+}
+
+/*
+ * The pipeline writes a frame every 15 ms and the USB callback reads 16
+ * samples every 1 ms. With the pipeline clock off by ppm parts per million,
+ * the level drifts until frames are dropped or inserted. The sine must stay
+ * continuous, with no step larger than the sine's own plus the slip.
+ */
+static void run_drift(int ppm, bool verbose)
+{
+    int32_t frames[FRAME_ADVANCE * NUM_CHANS];
+    const double step = 2 * M_PI * 440 / 16000;
+    const double max_delta = AMPLITUDE * step * (1.0 + 2.0 / USB_FRAME) + 2;
+    const int reads = 600000;
+    double produced = 0;
+    uint32_t written = 0;
+    int32_t prev = 0;
+    bool started = false;
+    sample_ring_stats_t stats;
+
+    sample_ring_init(&ring, storage, CAPACITY, NUM_CHANS,
+                     2 * FRAME_ADVANCE, 3 * FRAME_ADVANCE / 2, FRAME_ADVANCE / 2);
+
+    for (int r = 0; r < reads; r++) {
+        /* Frames due from the pipeline by the time of this read */
+        produced += USB_FRAME * (1.0 + ppm * 1e-6);
+        while (produced >= written + FRAME_ADVANCE) {
+            for (int i = 0; i < FRAME_ADVANCE; i++) {
+                frames[i * NUM_CHANS] = sine((written + i) * step);
+                frames[i * NUM_CHANS + 1] = 0;
+            }
+            size_t n = sample_ring_write(&ring, frames, FRAME_ADVANCE);
+            xassert(n == FRAME_ADVANCE);
+            written += FRAME_ADVANCE;
+        }
+
+        size_t consumed = sample_ring_read(&ring, frames, USB_FRAME);
+        if (consumed > 0 && !started) {
+            /* Skip the fade in */
+            started = true;
+            prev = frames[(USB_FRAME - 1) * NUM_CHANS];
+            continue;
+        }
+        if (started) {
+            xassert(consumed >= USB_FRAME - 1 && consumed <= USB_FRAME + 1);
+            for (int i = 0; i < USB_FRAME; i++) {
+                xassert(fabs((double)frames[i * NUM_CHANS] - prev) <= max_delta);
+                prev = frames[i * NUM_CHANS];
+            }
+        }
+    }
+
+    sample_ring_stats_get(&ring, &stats);
+    xassert(stats.overflow_frames == 0);
+    xassert(stats.underflow_count == 0);
+    xassert(stats.max_level <= CAPACITY);
+    /* Each slip moves the smoothed level back inside the slack, give or take the jitter of the writes */
+    xassert(abs(stats.avg_level_q16 / 65536 - 3 * FRAME_ADVANCE / 2) <= FRAME_ADVANCE / 2 + FRAME_ADVANCE / 16);
+    if (ppm > 0) {
+        xassert(stats.drop_count > 0 && stats.insert_count == 0);
+    } else if (ppm < 0) {
+        xassert(stats.insert_count > 0 && stats.drop_count == 0);
+    }
+    /* About one slip per 1e6 / ppm frames, after the level has drifted to the slack */
+    xassert(fabs(stats.drop_count + stats.insert_count - abs(ppm) * 1e-6 * reads * USB_FRAME) <= FRAME_ADVANCE);
+
+    if (verbose) {
+        printf("drift %+d ppm: level %u..%u avg %.1f, %u dropped %u inserted\n",
+               ppm, stats.min_level, stats.max_level, stats.avg_level_q16 / 65536.0,
+               stats.drop_count, stats.insert_count);
+    }
+}
+
+void test_drift(bool verbose)
+{
+    run_drift(0, verbose);
+    run_drift(500, verbose);
+    run_drift(-500, verbose);
+    run_drift(5000, verbose);
+    run_drift(-5000, verbose);
+}
+
+/*
+ * A producer and a consumer thread, each running in jittery bursts. The
+ * producer writes a count, retrying what does not fit. Every frame the
+ * consumer gets outside of a fade must be the next one in the count.
+ */
+#define STRESS_FRAMES   (4000000)
+
+static sample_ring_t stress_ring;
+static int32_t stress_storage[1024 * NUM_CHANS];
+static volatile int producer_done;
+
+static void *producer_thread(void *arg)
+{
+    unsigned seed = 1;
+    int32_t frames[64 * NUM_CHANS];
+    uint32_t written = 0;
+
+    (void)arg;
+    while (written < STRESS_FRAMES) {
+        size_t n = 1 + rand_r(&seed) % 64;
+        size_t done = 0;
+
+        if (n > STRESS_FRAMES - written) {
+            n = STRESS_FRAMES - written;
+        }
+        counting_frames(frames, written, n);
+        while (done < n) {
+            done += sample_ring_write(&stress_ring, &frames[done * NUM_CHANS], n - done);
+        }
+        written += n;
+        if (rand_r(&seed) % 8 == 0) {
+            usleep(rand_r(&seed) % 200);
+        }
+    }
+    __atomic_store_n(&producer_done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+void test_threads(bool verbose)
+{
+    pthread_t producer;
+    unsigned seed = 2;
+    int32_t frames[64 * NUM_CHANS];
+    uint32_t expected = 0;
+    uint32_t exact_reads = 0;
+
+    sample_ring_init(&stress_ring, stress_storage, 1024, NUM_CHANS, 256, 0, 1024);
+    producer_done = 0;
+    pthread_create(&producer, NULL, producer_thread, NULL);
+
+    for (;;) {
+        int done = __atomic_load_n(&producer_done, __ATOMIC_ACQUIRE);
+        size_t n = 2 + rand_r(&seed) % 63;
+
+        /* Once the producer has finished, frames below the start level are never output */
+        if (done && (sample_ring_level(&stress_ring) == 0 || !stress_ring.running)) {
+            break;
+        }
+
+        int was_running = stress_ring.running;
+        uint32_t underflows = stress_ring.underflow_count;
+        size_t consumed = sample_ring_read(&stress_ring, frames, n);
+
+        if (was_running && stress_ring.underflow_count == underflows) {
+            xassert(consumed == n);
+            check_counting(frames, expected, n);
+            exact_reads++;
+        }
+        expected += consumed;
+        if (rand_r(&seed) % 8 == 0) {
+            usleep(rand_r(&seed) % 200);
+        }
+    }
+    pthread_join(producer, NULL);
+
+    xassert(expected + sample_ring_level(&stress_ring) == STRESS_FRAMES);
+    xassert(stress_ring.frames_written == STRESS_FRAMES);
+    xassert(exact_reads > 0);
+
+    if (verbose) {
+        printf("threads ok: %u exact reads, %u underflows\n", exact_reads, stress_ring.underflow_count);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bool verbose = argc > 1 && (strcmp(argv[1], "-v") == 0 || strcmp(argv[1], "bench") == 0);
+
+    test_fifo(verbose);
+    test_underflow_and_flush(verbose);
+    test_drift(verbose);
+    test_threads(verbose);
+
+    printf("PASS\n");
+    return 0;
+}
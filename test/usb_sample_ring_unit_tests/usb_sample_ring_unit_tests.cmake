@@ -0,0 +1,20 @@
+set(USB_PATH ${CMAKE_CURRENT_LIST_DIR}/../../examples/ffva/src/usb)
+
+## The sample ring has no RTOS dependencies and is tested on the host
+if(NOT ${CMAKE_SYSTEM_NAME} STREQUAL XCORE_XS3A)
+    find_package(Threads REQUIRED)
+
+    add_executable(test_sample_ring
+        ${CMAKE_CURRENT_LIST_DIR}/src/test_sample_ring.c
+        ${USB_PATH}/sample_ring.c
+    )
+
+    target_include_directories(test_sample_ring
+        PRIVATE
+            ${USB_PATH}
+    )
+
+    target_compile_definitions(test_sample_ring PRIVATE X86_BUILD=1)
+
+    target_link_libraries(test_sample_ring PRIVATE m Threads::Threads)
+endif()
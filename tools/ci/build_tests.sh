@@ -25,6 +25,7 @@ fi
 # row format is: "name app_target run_data_partition_target flag BOARD toolchain"
 tests=(
     "test_asrc_div   test_asrc_div   NONE   NONE   XCORE_AI_EXPLORER   xmos_cmake_toolchain/xs3a.cmake"
+    "test_asrc_mc_bench   test_asrc_mc_bench   NONE   NONE   XCORE_AI_EXPLORER   xmos_cmake_toolchain/xs3a.cmake"
     "test_ffva_dfu   example_ffva_ua_adec_altarch   example_ffva_ua_adec_altarch   NONE   XK_VOICE_L71   xmos_cmake_toolchain/xs3a.cmake"
     "test_pipeline_ffd   test_pipeline_ffd   NONE   TEST_PIPELINE=FFD   XK_VOICE_L71   xmos_cmake_toolchain/xs3a.cmake"
     "test_pipeline_ffva_adec_altarch   test_pipeline_ffva_adec_altarch   NONE   TEST_PIPELINE=FFVA_ALT_ARCH   XK_VOICE_L71   xmos_cmake_toolchain/xs3a.cmake"